@@ -0,0 +1,156 @@
+#include "alarm_heap.hpp"
+
+#include <utility>
+
+namespace phosphor
+{
+namespace time
+{
+
+AlarmHeap::Id AlarmHeap::add(const std::string& client,
+                             const std::chrono::microseconds& deadline)
+{
+    auto id = nextId++;
+    heap.push_back(Alarm{deadline, id, client});
+    positions.emplace(id, heap.size() - 1);
+    siftUp(heap.size() - 1);
+    ++clients[client];
+    return id;
+}
+
+bool AlarmHeap::insert(Id id, const std::string& client,
+                       const std::chrono::microseconds& deadline)
+{
+    if (positions.find(id) != positions.end())
+    {
+        return false;
+    }
+    heap.push_back(Alarm{deadline, id, client});
+    positions.emplace(id, heap.size() - 1);
+    siftUp(heap.size() - 1);
+    ++clients[client];
+    setNextId(id + 1);
+    return true;
+}
+
+bool AlarmHeap::remove(const std::string& client, Id id)
+{
+    auto it = positions.find(id);
+    if (it == positions.end() || heap[it->second].client != client)
+    {
+        return false;
+    }
+    erase(it->second);
+    return true;
+}
+
+size_t AlarmHeap::removeClient(const std::string& client)
+{
+    auto c = clients.find(client);
+    if (c == clients.end())
+    {
+        return 0;
+    }
+    auto removed = c->second;
+
+    // Erasing moves the last alarm to i, which is checked again
+    for (size_t i = 0; i < heap.size();)
+    {
+        if (heap[i].client == client)
+        {
+            erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    return removed;
+}
+
+size_t AlarmHeap::count(const std::string& client) const
+{
+    auto c = clients.find(client);
+    return c == clients.end() ? 0 : c->second;
+}
+
+bool AlarmHeap::before(size_t i, size_t j) const
+{
+    // Alarms with the same deadline fire in the order of scheduling
+    if (heap[i].deadline != heap[j].deadline)
+    {
+        return heap[i].deadline < heap[j].deadline;
+    }
+    return heap[i].id < heap[j].id;
+}
+
+void AlarmHeap::swap(size_t i, size_t j)
+{
+    std::swap(heap[i], heap[j]);
+    positions[heap[i].id] = i;
+    positions[heap[j].id] = j;
+}
+
+void AlarmHeap::siftUp(size_t i)
+{
+    while (i > 0)
+    {
+        auto parent = (i - 1) / 2;
+        if (!before(i, parent))
+        {
+            break;
+        }
+        swap(i, parent);
+        i = parent;
+    }
+}
+
+void AlarmHeap::siftDown(size_t i)
+{
+    while (true)
+    {
+        auto first = i;
+        auto left = 2 * i + 1;
+        auto right = left + 1;
+        if (left < heap.size() && before(left, first))
+        {
+            first = left;
+        }
+        if (right < heap.size() && before(right, first))
+        {
+            first = right;
+        }
+        if (first == i)
+        {
+            break;
+        }
+        swap(i, first);
+        i = first;
+    }
+}
+
+void AlarmHeap::erase(size_t i)
+{
+    auto c = clients.find(heap[i].client);
+    if (--c->second == 0)
+    {
+        clients.erase(c);
+    }
+    positions.erase(heap[i].id);
+
+    auto last = heap.size() - 1;
+    if (i != last)
+    {
+        heap[i] = std::move(heap[last]);
+        positions[heap[i].id] = i;
+    }
+    heap.pop_back();
+    if (i < heap.size())
+    {
+        siftUp(i);
+        siftDown(i);
+    }
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class AlarmHeap
+ *  @brief The wall clock alarms of clients, in a min-heap of deadlines.
+ *  @details The earliest deadline is at the top, so one timer armed to it
+ *  serves all the alarms. The position of each alarm in the heap is
+ *  indexed by id, so an alarm is cancelled in O(log n).
+ */
+class AlarmHeap
+{
+    public:
+        using Id = uint64_t;
+
+        /** @brief Add an alarm
+         *
+         * @param[in] client - The bus name of the client
+         * @param[in] deadline - The wall clock time since UTC to fire at
+         *
+         * @return The id of the alarm
+         */
+        Id add(const std::string& client,
+               const std::chrono::microseconds& deadline);
+
+        /** @brief Add an alarm with the id it was given before, e.g. by the
+         *  running process on a live restart
+         *
+         * @param[in] id - The id of the alarm
+         * @param[in] client - The bus name of the client
+         * @param[in] deadline - The wall clock time since UTC to fire at
+         *
+         * @return false if the id is in use
+         */
+        bool insert(Id id, const std::string& client,
+                    const std::chrono::microseconds& deadline);
+
+        /** @brief Get the id of the next alarm */
+        Id getNextId() const
+        {
+            return nextId;
+        }
+
+        /** @brief Set the id of the next alarm, the ids before it are not
+         *  given again
+         *
+         * @param[in] id - The id of the next alarm
+         */
+        void setNextId(Id id)
+        {
+            nextId = std::max(nextId, id);
+        }
+
+        /** @brief Call the function for each alarm, in no order
+         *
+         * @param[in] func - The function to call with the id, the client
+         *                   and the deadline of the alarm
+         */
+        template <typename Func>
+        void forEach(Func&& func) const
+        {
+            for (const auto& alarm : heap)
+            {
+                func(alarm.id, alarm.client, alarm.deadline);
+            }
+        }
+
+        /** @brief Remove an alarm of the client
+         *
+         * @param[in] client - The bus name of the client
+         * @param[in] id - The id of the alarm
+         *
+         * @return true if the alarm is removed, false if there is no such
+         *         alarm of the client
+         */
+        bool remove(const std::string& client, Id id);
+
+        /** @brief Remove all alarms of the client
+         *
+         * @param[in] client - The bus name of the client
+         *
+         * @return The number of removed alarms
+         */
+        size_t removeClient(const std::string& client);
+
+        /** @brief Get the number of alarms of the client */
+        size_t count(const std::string& client) const;
+
+        /** @brief Get the number of all alarms */
+        size_t size() const
+        {
+            return heap.size();
+        }
+
+        /** @brief Get the earliest deadline, the heap shall not be empty */
+        std::chrono::microseconds next() const
+        {
+            return heap.front().deadline;
+        }
+
+        /** @brief Remove the alarms with the deadline not later than now,
+         *  and call the function for each of them, earliest first
+         *
+         * @param[in] now - The current wall clock time since UTC
+         * @param[in] func - The function to call with the id, the client
+         *                   and the deadline of the alarm
+         *
+         * @return The number of expired alarms
+         */
+        template <typename Func>
+        size_t expire(const std::chrono::microseconds& now, Func&& func)
+        {
+            size_t expired = 0;
+            while (!heap.empty() && heap.front().deadline <= now)
+            {
+                auto alarm = heap.front();
+                erase(0);
+                func(alarm.id, alarm.client, alarm.deadline);
+                ++expired;
+            }
+            return expired;
+        }
+
+    private:
+        /** @brief An alarm */
+        struct Alarm
+        {
+            std::chrono::microseconds deadline;
+            Id id;
+            std::string client;
+        };
+
+        /** @brief The alarms, a binary min-heap of the deadlines */
+        std::vector<Alarm> heap;
+
+        /** @brief The positions in the heap by id */
+        std::map<Id, size_t> positions;
+
+        /** @brief The number of alarms of each client */
+        std::map<std::string, size_t> clients;
+
+        /** @brief The id of the next alarm */
+        Id nextId = 1;
+
+        /** @brief Check if the alarm at i fires before the one at j */
+        bool before(size_t i, size_t j) const;
+
+        /** @brief Swap two alarms in the heap and their positions */
+        void swap(size_t i, size_t j);
+
+        /** @brief Move the alarm at i up to its place */
+        void siftUp(size_t i);
+
+        /** @brief Move the alarm at i down to its place */
+        void siftDown(size_t i);
+
+        /** @brief Remove the alarm at i from the heap and the indexes */
+        void erase(size_t i);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,279 @@
+#include "alarm_service.hpp"
+#include "utils.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace // anonymous
+{
+constexpr auto ALARM_INTERFACE = "xyz.openbmc_project.Time.Internal.Alarm";
+constexpr auto SIGNAL_ALARM_FIRED = "AlarmFired";
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using Alarm = sdbusplus::xyz::openbmc_project::Time::Internal::server::Alarm;
+using InternalFailure =
+    sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+AlarmService::AlarmService(sdbusplus::bus::bus& bus,
+                           const char* objPath,
+                           ClientTracker& tracker)
+    : sdbusplus::server::object::object<Alarm>(bus, objPath),
+      bus(bus),
+      objPath(objPath),
+      clients(tracker),
+      user(tracker.addUser(
+          [this](const std::string& client)
+          {
+              alarms.removeClient(client);
+              arm();
+          }))
+{
+    // Not CANCEL_ON_SET, an absolute realtime timer expires at its wall
+    // clock time after the time is set
+    timerFd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == -1)
+    {
+        log<level::ERR>("Failed to create timerfd",
+                        entry("ERRNO=%d", errno),
+                        entry("ERR=%s", strerror(errno)));
+        elog<InternalFailure>();
+        return;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(bus.get_event(), &es,
+                             timerFd, EPOLLIN, onTimer, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        elog<InternalFailure>();
+        return;
+    }
+    timerSource.reset(es);
+}
+
+AlarmService::~AlarmService()
+{
+    timerSource.reset();
+    if (timerFd >= 0)
+    {
+        close(timerFd);
+    }
+}
+
+uint64_t AlarmService::scheduleAlarm(uint64_t deadline)
+{
+    auto client = getCaller();
+    auto max = static_cast<uint64_t>(microseconds::max().count());
+    auto id = alarms.add(client, microseconds(std::min(deadline, max)));
+    clients.add(user, client);
+    arm();
+    return id;
+}
+
+void AlarmService::cancelAlarm(uint64_t id)
+{
+    auto client = getCaller();
+    if (!alarms.remove(client, id))
+    {
+        using InvalidArgumentError =
+            sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+        using namespace xyz::openbmc_project::Common;
+        elog<InvalidArgumentError>(
+            InvalidArgument::ARGUMENT_NAME("Id"),
+            InvalidArgument::ARGUMENT_VALUE(std::to_string(id).c_str()));
+        return;
+    }
+    if (alarms.count(client) == 0)
+    {
+        clients.remove(user, client);
+    }
+    arm();
+}
+
+void AlarmService::onBmcTimeChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::BmcTimeJumped))
+    {
+        rearm();
+    }
+}
+
+void AlarmService::save(HandoffState& saved) const
+{
+    saved.alarms.clear();
+    alarms.forEach(
+        [&saved](AlarmHeap::Id id,
+                 const std::string& client,
+                 const microseconds& deadline)
+        {
+            saved.alarms.push_back({id, client, deadline});
+        });
+    saved.nextAlarmId = alarms.getNextId();
+}
+
+void AlarmService::restore(const HandoffState& handed)
+{
+    alarms.forEach(
+        [this](AlarmHeap::Id, const std::string& client, const microseconds&)
+        {
+            clients.remove(user, client);
+        });
+    alarms = AlarmHeap();
+    for (const auto& alarm : handed.alarms)
+    {
+        if (alarms.insert(alarm.id, alarm.client, alarm.deadline))
+        {
+            clients.add(user, alarm.client);
+        }
+    }
+    alarms.setNextId(handed.nextAlarmId);
+
+    // The passed deadlines fire right away
+    arm();
+}
+
+std::string AlarmService::getCaller()
+{
+    auto msg = sd_bus_get_current_message(bus.get());
+    auto sender = msg ? sd_bus_message_get_sender(msg) : nullptr;
+    if (!sender)
+    {
+        log<level::ERR>("Failed to get the sender of the method call");
+        elog<InternalFailure>();
+        return {};
+    }
+    return sender;
+}
+
+void AlarmService::arm()
+{
+    auto next = alarms.size() == 0 ? microseconds::min() : alarms.next();
+    if (next == armed)
+    {
+        return;
+    }
+
+    // A zero it_value disarms the timer, so a passed deadline of 0 is
+    // armed as 1ns, which expires right away as well
+    itimerspec value{};
+    if (alarms.size() != 0)
+    {
+        auto sec = duration_cast<seconds>(next);
+        if (sec.count() >= std::numeric_limits<time_t>::max())
+        {
+            value.it_value.tv_sec = std::numeric_limits<time_t>::max();
+        }
+        else
+        {
+            value.it_value.tv_sec = sec.count();
+            value.it_value.tv_nsec =
+                duration_cast<nanoseconds>(next - sec).count();
+        }
+        if (value.it_value.tv_sec == 0 && value.it_value.tv_nsec == 0)
+        {
+            value.it_value.tv_nsec = 1;
+        }
+    }
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &value, nullptr) != 0)
+    {
+        log<level::ERR>("Failed to set timerfd",
+                        entry("ERRNO=%d", errno),
+                        entry("ERR=%s", strerror(errno)));
+        return;
+    }
+    armed = next;
+}
+
+size_t AlarmService::rearm()
+{
+    auto fired = alarms.expire(
+        utils::now(ClockRead::Precise),
+        [this](AlarmHeap::Id id,
+               const std::string& client,
+               const microseconds& deadline)
+        {
+            fire(id, client, deadline);
+            if (alarms.count(client) == 0)
+            {
+                clients.remove(user, client);
+            }
+        });
+    arm();
+    return fired;
+}
+
+void AlarmService::fire(AlarmHeap::Id id,
+                        const std::string& client,
+                        const microseconds& deadline)
+{
+    // The signal is sent to the client of the alarm only
+    sd_bus_message* m = nullptr;
+    auto r = sd_bus_message_new_signal(bus.get(), &m,
+                                       objPath.c_str(),
+                                       ALARM_INTERFACE,
+                                       SIGNAL_ALARM_FIRED);
+    if (r >= 0)
+    {
+        r = sd_bus_message_set_destination(m, client.c_str());
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(m, "tt", static_cast<uint64_t>(id),
+                                  static_cast<uint64_t>(deadline.count()));
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_send(bus.get(), m, nullptr);
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to send AlarmFired",
+                        entry("CLIENT=%s", client.c_str()),
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+    sd_bus_message_unref(m);
+}
+
+int AlarmService::onTimer(sd_event_source* /* es */, int fd,
+                          uint32_t /* revents */, void* userdata)
+{
+    auto service = static_cast<AlarmService*>(userdata);
+
+    // Drain the expirations, the alarms are checked against the clock
+    std::array<char, 64> buf {};
+    while (read(fd, buf.data(), buf.size()) > 0)
+    {
+    }
+
+    // The timer has expired, so it is not armed any more
+    service->armed = microseconds::min();
+    auto fired = service->rearm();
+    wakeup::count(wakeup::Source::Alarm, fired != 0);
+
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
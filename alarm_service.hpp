@@ -0,0 +1,162 @@
+#pragma once
+
+#include "alarm_heap.hpp"
+#include "client_tracker.hpp"
+#include "handoff.hpp"
+#include "time_state_change.hpp"
+#include "xyz/openbmc_project/Time/Internal/Alarm/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class AlarmService
+ *  @brief OpenBMC wall clock alarm implementation.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.Alarm DBus API.
+ *  The alarms of all clients are kept in a min-heap of deadlines, and one
+ *  realtime timerfd is armed to the earliest one, so thousands of alarms
+ *  cost one kernel timer. An alarm fires by the AlarmFired signal sent to
+ *  its client only.
+ */
+class AlarmService : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::Alarm >
+{
+    public:
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] tracker - The tracker of the clients, shared with the
+         *                      other services
+         */
+        AlarmService(sdbusplus::bus::bus& bus,
+                     const char* objPath,
+                     ClientTracker& tracker);
+        AlarmService(const AlarmService&) = delete;
+        AlarmService& operator=(const AlarmService&) = delete;
+        AlarmService(AlarmService&&) = delete;
+        AlarmService& operator=(AlarmService&&) = delete;
+        ~AlarmService();
+
+        /** @brief Schedule an alarm of the calling client
+         *
+         * @param[in] deadline - The BMC elapsed microseconds since UTC to
+         *                       fire at
+         *
+         * @return The id of the alarm
+         */
+        uint64_t scheduleAlarm(uint64_t deadline) override;
+
+        /** @brief Cancel an alarm of the calling client
+         *
+         * @param[in] id - The id of the alarm
+         */
+        void cancelAlarm(uint64_t id) override;
+
+        /** @brief Notified on BMC time change
+         *  @details The timer is rearmed, and the alarms that a forward
+         *  step has passed fire.
+         *
+         * @param[in] change - The changed time state of BmcEpoch
+         */
+        void onBmcTimeChanged(const TimeStateChange& change);
+
+        /** @brief Save the alarms to hand them over to a new process
+         *
+         * @param[out] saved - The state to save to
+         */
+        void save(HandoffState& saved) const;
+
+        /** @brief Replace the alarms with the ones handed over by the
+         *  running process, and arm the timer to them
+         *
+         * @param[in] handed - The handed state
+         */
+        void restore(const HandoffState& handed);
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The object path of this object */
+        std::string objPath;
+
+        /** @brief The alarms of the clients */
+        AlarmHeap alarms;
+
+        /** @brief The tracker of the clients with alarms */
+        ClientTracker& clients;
+
+        /** @brief The id of this service in the tracker */
+        ClientTracker::User user;
+
+        /** @brief The timerfd armed to the earliest deadline */
+        int timerFd = -1;
+
+        /** @brief The deadline the timer is armed to, min() if disarmed */
+        std::chrono::microseconds armed = std::chrono::microseconds::min();
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The event source of the timerfd */
+        SdEventSource timerSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief Get the bus name of the client of current method call */
+        std::string getCaller();
+
+        /** @brief Arm the timer to the earliest deadline, or disarm it if
+         *  there is no alarm
+         *  @details An alarm with a passed deadline makes the timer expire
+         *  right away, so it fires from the timer event, after the reply
+         *  of the call that scheduled it.
+         */
+        void arm();
+
+        /** @brief Fire the expired alarms, and arm the timer to the rest
+         *
+         * @return The number of fired alarms
+         */
+        size_t rearm();
+
+        /** @brief Send AlarmFired signal to the client of an alarm
+         *
+         * @param[in] id - The id of the alarm
+         * @param[in] client - The bus name of the client
+         * @param[in] deadline - The deadline of the alarm
+         */
+        void fire(AlarmHeap::Id id,
+                  const std::string& client,
+                  const std::chrono::microseconds& deadline);
+
+        /** @brief The callback function on the timerfd
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the timer
+         * @param[in] revents - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onTimer(sd_event_source* es, int fd,
+                           uint32_t revents, void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,41 @@
+#include "budgets.hpp"
+
+#include <fstream>
+#include <sstream>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+bool loadBudgets(const std::string& file, Budgets& budgets)
+{
+    std::ifstream fs(file);
+    if (!fs.is_open())
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(fs, line))
+    {
+        std::istringstream is(line);
+        std::string name;
+        uint64_t budget = 0;
+        if (!(is >> name) || name[0] == '#')
+        {
+            continue;
+        }
+        if (!(is >> budget))
+        {
+            return false;
+        }
+        budgets[name] = budget;
+    }
+    return true;
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
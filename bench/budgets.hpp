@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @brief The budgets of the measurements, by their names */
+using Budgets = std::map<std::string, uint64_t>;
+
+/** @brief Load the budgets, a "name budget" line per measurement, and
+ *  the comments start with '#'
+ *
+ * @param[in] file - The file of the budgets
+ * @param[out] budgets - The budgets by the name of the measurement
+ *
+ * @return true if the file is read
+ */
+bool loadBudgets(const std::string& file, Budgets& budgets);
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,138 @@
+/**
+ * Measure the cost and the resolution of each way to read the clock on the
+ * Elapsed gets, as utils::now() reads it.
+ *
+ *   clock_read [--count N]
+ */
+#include "types.hpp"
+#include "utils.hpp"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::time;
+
+/** @brief The default number of reads of each way */
+constexpr size_t DEFAULT_COUNT = 10000000;
+
+constexpr size_t READ_COUNT = 2;
+constexpr ClockRead READS[READ_COUNT] = {
+    ClockRead::Precise,
+    ClockRead::Coarse,
+};
+constexpr const char* READ_NAMES[READ_COUNT] = {
+    "Precise",
+    "Coarse",
+};
+constexpr clockid_t READ_CLOCKS[READ_COUNT] = {
+    CLOCK_REALTIME,
+    CLOCK_REALTIME_COARSE,
+};
+
+constexpr auto NAME_WIDTH = 10;
+constexpr auto NUMBER_WIDTH = 14;
+
+/** @brief The cost and resolution of a way to read the clock */
+struct Result
+{
+    /** @brief The mean cost of a read */
+    duration<double, std::nano> cost{0};
+
+    /** @brief The resolution reported by clock_getres() */
+    nanoseconds resolution{0};
+
+    /** @brief The smallest step between two different reads */
+    microseconds step = microseconds::max();
+};
+
+Result measure(size_t index, size_t count)
+{
+    Result result;
+    timespec res;
+    clock_getres(READ_CLOCKS[index], &res);
+    result.resolution = seconds(res.tv_sec) + nanoseconds(res.tv_nsec);
+
+    auto read = READS[index];
+    auto last = utils::now(read);
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto now = utils::now(read);
+        if (now != last)
+        {
+            if (now > last && now - last < result.step)
+            {
+                result.step = now - last;
+            }
+            last = now;
+        }
+    }
+    result.cost = duration<double, std::nano>(steady_clock::now() - start) /
+                  count;
+    return result;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--count N]\n"
+              << "  --count    The number of reads of each way\n";
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[])
+{
+    size_t count = DEFAULT_COUNT;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::cout << count << " reads of each way\n"
+              << std::left << std::setw(NAME_WIDTH) << "Read" << std::right
+              << std::setw(NUMBER_WIDTH) << "ns/read"
+              << std::setw(NUMBER_WIDTH) << "getres (ns)"
+              << std::setw(NUMBER_WIDTH) << "step (us)" << "\n";
+    for (size_t i = 0; i < READ_COUNT; ++i)
+    {
+        auto result = measure(i, count);
+        std::cout << std::left << std::setw(NAME_WIDTH) << READ_NAMES[i]
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(NUMBER_WIDTH) << result.cost.count()
+                  << std::setw(NUMBER_WIDTH) << result.resolution.count()
+                  << std::setw(NUMBER_WIDTH);
+        if (result.step == microseconds::max())
+        {
+            std::cout << "-";
+        }
+        else
+        {
+            std::cout << result.step.count();
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "daemon_stack.hpp"
+
+#include "config.h"
+#include "bmc_epoch.hpp"
+#include "change_notifier.hpp"
+#include "host_epoch.hpp"
+#include "manager.hpp"
+#include "published_state.hpp"
+#include "query_server.hpp"
+#include "time_snapshot.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/manager.hpp>
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+namespace // anonymous
+{
+
+int onStop(sd_event_source* es, int fd, uint32_t /* revents */,
+           void* /* userdata */)
+{
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0);
+
+    sd_event_exit(sd_event_source_get_event(es), 0);
+    return 0;
+}
+
+} // namespace anonymous
+
+DaemonStack::DaemonStack(const char* querySocket)
+    : querySocket(querySocket ? querySocket : "")
+{
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd == -1)
+    {
+        throw std::runtime_error(std::string("eventfd: ") + strerror(errno));
+    }
+
+    std::promise<void> ready;
+    auto started = ready.get_future();
+    thread = std::thread(&DaemonStack::run, this, std::ref(ready));
+    try
+    {
+        started.get();
+    }
+    catch (...)
+    {
+        thread.join();
+        close(stopFd);
+        throw;
+    }
+}
+
+DaemonStack::~DaemonStack()
+{
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) == sizeof(one) && thread.joinable())
+    {
+        thread.join();
+    }
+    close(stopFd);
+}
+
+clockid_t DaemonStack::cpuClock()
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0)
+    {
+        throw std::runtime_error("Failed to get the CPU clock of the stack");
+    }
+    return clock;
+}
+
+void DaemonStack::run(std::promise<void>& ready)
+{
+    sd_event* event = nullptr;
+    sd_event_source* es = nullptr;
+    try
+    {
+        auto r = sd_event_new(&event);
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to create event loop");
+        }
+        r = sd_event_add_io(event, &es, stopFd, EPOLLIN, onStop, nullptr);
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to add event");
+        }
+
+        auto bus = sdbusplus::bus::new_default();
+        bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+        {
+            sdbusplus::server::manager::manager bmcObjManager(bus,
+                                                              OBJPATH_BMC);
+            sdbusplus::server::manager::manager hostObjManager(bus,
+                                                               OBJPATH_HOST);
+            Manager manager(bus);
+            BmcEpoch bmc(bus, OBJPATH_BMC);
+            HostEpoch host(bus, OBJPATH_HOST);
+
+            std::vector<TimeStateDispatcher::Subscription> subscriptions;
+            subscriptions.emplace_back(manager.subscribe(
+                [&bmc](const TimeStateChange& change)
+                {
+                    bmc.onTimeStateChanged(change);
+                }));
+            subscriptions.emplace_back(manager.subscribe(
+                [&host](const TimeStateChange& change)
+                {
+                    host.onTimeStateChanged(change);
+                }));
+            subscriptions.emplace_back(bmc.subscribe(
+                [&host](const TimeStateChange& change)
+                {
+                    host.onTimeStateChanged(change);
+                }));
+
+            PublishedState state;
+            auto publish = [&state](const TimeStateChange& change)
+            {
+                state.publish(change);
+            };
+            subscriptions.emplace_back(manager.subscribe(publish));
+            subscriptions.emplace_back(host.subscribe(publish));
+            TimeSnapshot snapshot(bus, OBJPATH_TIME, state);
+
+            ClientTracker clients(bus);
+            ChangeNotifier notifier(bus, OBJPATH_TIME, clients);
+            subscriptions.emplace_back(bmc.subscribe(
+                [&notifier](const TimeStateChange& change)
+                {
+                    notifier.onBmcTimeChanged(change);
+                }));
+            subscriptions.emplace_back(host.subscribe(
+                [&notifier](const TimeStateChange& change)
+                {
+                    notifier.onHostOffsetChanged(change);
+                }));
+
+            std::unique_ptr<QueryServer> queryServer;
+            if (!querySocket.empty())
+            {
+                queryServer = std::make_unique<QueryServer>(
+                    event, querySocket.c_str(), bmc, host, state);
+            }
+
+            bus.request_name(BUSNAME);
+            ready.set_value();
+
+            sd_event_loop(event);
+        }
+        bus.detach_event();
+    }
+    catch (...)
+    {
+        try
+        {
+            ready.set_exception(std::current_exception());
+        }
+        catch (const std::future_error&)
+        {
+            // Already started, nobody is waiting for the error
+        }
+    }
+
+    sd_event_source_unref(es);
+    sd_event_unref(event);
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <future>
+#include <string>
+#include <thread>
+
+#include <time.h>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @class DaemonStack
+ *  @brief The time manager objects from libtimemanager, wired as in
+ *  phosphor-timemanager, serving the bus name on their own thread.
+ */
+class DaemonStack
+{
+    public:
+        /** @brief Start the stack and wait until it owns the bus name
+         *
+         * @param[in] querySocket - The path to serve the query socket on,
+         *                          or nullptr not to serve it
+         */
+        explicit DaemonStack(const char* querySocket = nullptr);
+
+        DaemonStack(const DaemonStack&) = delete;
+        DaemonStack& operator=(const DaemonStack&) = delete;
+        DaemonStack(DaemonStack&&) = delete;
+        DaemonStack& operator=(DaemonStack&&) = delete;
+        ~DaemonStack();
+
+        /** @brief The CPU time clock of the stack thread */
+        clockid_t cpuClock();
+
+    private:
+        /** @brief The path of the query socket, empty if not served */
+        std::string querySocket;
+
+        /** @brief The eventfd to stop the thread */
+        int stopFd = -1;
+
+        /** @brief The thread of the stack */
+        std::thread thread;
+
+        /** @brief The body of the thread
+         *
+         * @param[in] ready - Set when the stack owns the bus name
+         */
+        void run(std::promise<void>& ready);
+};
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
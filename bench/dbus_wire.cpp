@@ -0,0 +1,437 @@
+#include "dbus_wire.hpp"
+
+#include <endian.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+namespace // anonymous
+{
+
+constexpr auto MAX_DEPTH = 64;
+constexpr uint32_t MAX_ARRAY_SIZE = 64 * 1024 * 1024;
+
+enum HeaderField : uint8_t
+{
+    PATH = 1,
+    INTERFACE = 2,
+    MEMBER = 3,
+    ERROR_NAME = 4,
+    REPLY_SERIAL = 5,
+    DESTINATION = 6,
+    SENDER = 7,
+    SIGNATURE = 8,
+};
+
+/** @brief Get the length of the single complete type at pos
+ *
+ * @return The length, or 0 if the signature is invalid
+ */
+size_t completeTypeLength(const std::string& sig, size_t pos)
+{
+    if (pos >= sig.size())
+    {
+        return 0;
+    }
+    switch (sig[pos])
+    {
+        case 'a':
+        {
+            auto len = completeTypeLength(sig, pos + 1);
+            return len == 0 ? 0 : len + 1;
+        }
+        case '(':
+        case '{':
+        {
+            auto close = sig[pos] == '(' ? ')' : '}';
+            auto i = pos + 1;
+            while (i < sig.size() && sig[i] != close)
+            {
+                auto len = completeTypeLength(sig, i);
+                if (len == 0)
+                {
+                    return 0;
+                }
+                i += len;
+            }
+            return i < sig.size() ? i - pos + 1 : 0;
+        }
+        case 'y': case 'b': case 'n': case 'q': case 'i': case 'u':
+        case 'x': case 't': case 'd': case 'h': case 's': case 'o':
+        case 'g': case 'v':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+size_t alignment(char type)
+{
+    switch (type)
+    {
+        case 'n': case 'q':
+            return 2;
+        case 'b': case 'i': case 'u': case 'h': case 's': case 'o':
+        case 'a':
+            return 4;
+        case 'x': case 't': case 'd': case '(': case '{':
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+/** @class Reader
+ *  @brief Read the values in the wire format.
+ */
+class Reader
+{
+    public:
+        Reader(const uint8_t* data, size_t size, bool bigEndian)
+            : data(data), size(size), bigEndian(bigEndian)
+        {
+        }
+
+        size_t pos = 0;
+
+        bool align(size_t n)
+        {
+            pos = (pos + n - 1) & ~(n - 1);
+            return pos <= size;
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (!align(sizeof(T)) || pos + sizeof(T) > size)
+            {
+                return false;
+            }
+            std::memcpy(&value, data + pos, sizeof(T));
+            pos += sizeof(T);
+            if (bigEndian != (__BYTE_ORDER == __BIG_ENDIAN))
+            {
+                auto p = reinterpret_cast<uint8_t*>(&value);
+                for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                {
+                    std::swap(p[i], p[sizeof(T) - 1 - i]);
+                }
+            }
+            return true;
+        }
+
+        bool readString(std::string& str, uint32_t len)
+        {
+            if (pos + len + 1 > size || data[pos + len] != '\0')
+            {
+                return false;
+            }
+            str.assign(reinterpret_cast<const char*>(data + pos), len);
+            pos += len + 1;
+            return true;
+        }
+
+        bool readValue(const std::string& sig, size_t& i, Value& v, int depth)
+        {
+            auto len = completeTypeLength(sig, i);
+            if (len == 0 || depth > MAX_DEPTH)
+            {
+                return false;
+            }
+            v.type = sig[i];
+            v.signature = sig.substr(i, len);
+            i += len;
+
+            switch (v.type)
+            {
+                case 'y':
+                {
+                    uint8_t x;
+                    if (!read(x))
+                    {
+                        return false;
+                    }
+                    v.number = x;
+                    return true;
+                }
+                case 'n':
+                {
+                    int16_t x;
+                    if (!read(x))
+                    {
+                        return false;
+                    }
+                    v.number = static_cast<uint64_t>(static_cast<int64_t>(x));
+                    return true;
+                }
+                case 'q':
+                {
+                    uint16_t x;
+                    if (!read(x))
+                    {
+                        return false;
+                    }
+                    v.number = x;
+                    return true;
+                }
+                case 'i':
+                {
+                    int32_t x;
+                    if (!read(x))
+                    {
+                        return false;
+                    }
+                    v.number = static_cast<uint64_t>(static_cast<int64_t>(x));
+                    return true;
+                }
+                case 'b': case 'u': case 'h':
+                {
+                    uint32_t x;
+                    if (!read(x))
+                    {
+                        return false;
+                    }
+                    v.number = x;
+                    return true;
+                }
+                case 'x': case 't': case 'd':
+                    return read(v.number);
+                case 's': case 'o':
+                {
+                    uint32_t n;
+                    return read(n) && readString(v.str, n);
+                }
+                case 'g':
+                {
+                    uint8_t n;
+                    return read(n) && readString(v.str, n);
+                }
+                case 'v':
+                {
+                    uint8_t n;
+                    std::string inner;
+                    if (!read(n) || !readString(inner, n))
+                    {
+                        return false;
+                    }
+                    size_t j = 0;
+                    v.items.resize(1);
+                    return readValue(inner, j, v.items[0], depth + 1) &&
+                           j == inner.size();
+                }
+                case 'a':
+                {
+                    uint32_t n;
+                    auto element = v.signature.substr(1);
+                    if (!read(n) || n > MAX_ARRAY_SIZE ||
+                        !align(alignment(element[0])) || pos + n > size)
+                    {
+                        return false;
+                    }
+                    auto end = pos + n;
+                    while (pos < end)
+                    {
+                        size_t j = 0;
+                        v.items.emplace_back();
+                        if (!readValue(element, j, v.items.back(), depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                    return pos == end;
+                }
+                case '(':
+                case '{':
+                {
+                    if (!align(8))
+                    {
+                        return false;
+                    }
+                    auto fields = v.signature.substr(1, len - 2);
+                    size_t j = 0;
+                    while (j < fields.size())
+                    {
+                        v.items.emplace_back();
+                        if (!readValue(fields, j, v.items.back(), depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        bool bigEndian;
+};
+
+int appendValue(sd_bus_message* m, const Value& v)
+{
+    switch (v.type)
+    {
+        case 'y':
+        {
+            uint8_t x = v.number;
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'n':
+        {
+            int16_t x = static_cast<int16_t>(v.number);
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'q':
+        {
+            uint16_t x = v.number;
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'b':
+        {
+            int x = v.number != 0;
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'i':
+        {
+            int32_t x = static_cast<int32_t>(v.number);
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'u':
+        {
+            uint32_t x = v.number;
+            return sd_bus_message_append_basic(m, v.type, &x);
+        }
+        case 'x': case 't': case 'd':
+            return sd_bus_message_append_basic(m, v.type, &v.number);
+        case 's': case 'o': case 'g':
+            return sd_bus_message_append_basic(m, v.type, v.str.c_str());
+        case 'v':
+        case 'a':
+        case '(':
+        case '{':
+        {
+            char type;
+            std::string contents;
+            if (v.type == 'v')
+            {
+                type = SD_BUS_TYPE_VARIANT;
+                contents = v.items.empty() ? "" : v.items[0].signature;
+            }
+            else if (v.type == 'a')
+            {
+                type = SD_BUS_TYPE_ARRAY;
+                contents = v.signature.substr(1);
+            }
+            else
+            {
+                type = v.type == '(' ? SD_BUS_TYPE_STRUCT
+                                     : SD_BUS_TYPE_DICT_ENTRY;
+                contents = v.signature.substr(1, v.signature.size() - 2);
+            }
+            auto r = sd_bus_message_open_container(m, type, contents.c_str());
+            if (r < 0)
+            {
+                return r;
+            }
+            r = append(m, v.items);
+            if (r < 0)
+            {
+                return r;
+            }
+            return sd_bus_message_close_container(m);
+        }
+        default:
+            // Unix fds are not able to be replayed
+            return -EOPNOTSUPP;
+    }
+}
+
+} // namespace anonymous
+
+bool decode(const uint8_t* data, size_t size, Message& msg)
+{
+    // The fixed part of the header, then the header fields array
+    constexpr size_t FIXED_HEADER_SIZE = 12;
+    if (size < FIXED_HEADER_SIZE || (data[0] != 'l' && data[0] != 'B'))
+    {
+        return false;
+    }
+    Reader reader(data, size, data[0] == 'B');
+    msg = Message();
+    msg.type = data[1];
+    msg.flags = data[2];
+    reader.pos = 4;
+
+    uint32_t bodySize;
+    if (!reader.read(bodySize) || !reader.read(msg.serial))
+    {
+        return false;
+    }
+
+    Value fields;
+    size_t i = 0;
+    if (!reader.readValue("a(yv)", i, fields, 0))
+    {
+        return false;
+    }
+    for (const auto& field : fields.items)
+    {
+        const auto& value = field.items[1].items[0];
+        switch (field.items[0].number)
+        {
+            case PATH: msg.path = value.str; break;
+            case INTERFACE: msg.interface = value.str; break;
+            case MEMBER: msg.member = value.str; break;
+            case ERROR_NAME: msg.errorName = value.str; break;
+            case REPLY_SERIAL: msg.replySerial = value.number; break;
+            case DESTINATION: msg.destination = value.str; break;
+            case SENDER: msg.sender = value.str; break;
+            case SIGNATURE: msg.signature = value.str; break;
+            default: break;
+        }
+    }
+
+    if (!reader.align(8) || reader.pos + bodySize > size)
+    {
+        return false;
+    }
+    Reader body(data, reader.pos + bodySize, data[0] == 'B');
+    body.pos = reader.pos;
+    i = 0;
+    while (i < msg.signature.size())
+    {
+        msg.body.emplace_back();
+        if (!body.readValue(msg.signature, i, msg.body.back(), 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int append(sd_bus_message* m, const std::vector<Value>& values)
+{
+    for (const auto& v : values)
+    {
+        auto r = appendValue(m, v);
+        if (r < 0)
+        {
+            return r;
+        }
+    }
+    return 0;
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <systemd/sd-bus.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @struct Value
+ *  @brief A D-Bus value decoded from the wire.
+ */
+struct Value
+{
+    /** @brief The D-Bus type code, '(' and '{' for struct and dict entry */
+    char type = 0;
+
+    /** @brief The signature of the value */
+    std::string signature;
+
+    /** @brief The integers, booleans, and the bits of doubles */
+    uint64_t number = 0;
+
+    /** @brief The strings, object paths and signatures */
+    std::string str;
+
+    /** @brief The array elements, struct fields, the key and value of a dict
+     *  entry, or the content of a variant
+     */
+    std::vector<Value> items;
+};
+
+/** @struct Message
+ *  @brief A D-Bus message decoded from the wire.
+ */
+struct Message
+{
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint32_t serial = 0;
+    uint32_t replySerial = 0;
+    std::string path;
+    std::string interface;
+    std::string member;
+    std::string errorName;
+    std::string destination;
+    std::string sender;
+    std::string signature;
+    std::vector<Value> body;
+};
+
+/** @brief Decode a D-Bus message in the wire format
+ *
+ * @param[in] data - The message bytes
+ * @param[in] size - The number of bytes
+ * @param[out] msg - The decoded message
+ *
+ * @return true if the bytes are a valid message
+ */
+bool decode(const uint8_t* data, size_t size, Message& msg);
+
+/** @brief Append the decoded values to a message
+ *
+ * @param[in] m - The message to append to
+ * @param[in] values - The values to append
+ *
+ * @return 0 on success, or a negative errno
+ */
+int append(sd_bus_message* m, const std::vector<Value>& values);
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
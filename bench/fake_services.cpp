@@ -0,0 +1,390 @@
+#include "fake_services.hpp"
+
+#include "settings.hpp"
+#include "utils.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/server/object.hpp>
+#include <sdbusplus/vtable.hpp>
+#include <xyz/openbmc_project/State/Host/server.hpp>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+namespace // anonymous
+{
+
+constexpr auto MAPPER_PATH = "/xyz/openbmc_project/object_mapper";
+constexpr auto MAPPER_INTERFACE = "xyz.openbmc_project.ObjectMapper";
+constexpr auto TIMEDATE_PATH = "/org/freedesktop/timedate1";
+constexpr auto TIMEDATE_INTERFACE = "org.freedesktop.timedate1";
+
+constexpr auto PROPERTY_TIME_OWNER = "TimeOwner";
+constexpr auto PROPERTY_TIME_SYNC_METHOD = "TimeSyncMethod";
+
+struct Object
+{
+    std::string path;
+    const char* service;
+    const char* interface;
+};
+
+/** @brief Get the objects that the mapper knows
+ *
+ * @param[in] settings - The served settings
+ */
+std::vector<Object> objectsOf(const FakeServices::Settings& settings)
+{
+    return {
+        {settings.ownerPath, SETTINGS_SERVICE, settings::timeOwnerIntf},
+        {settings.syncMethodPath, SETTINGS_SERVICE, settings::timeSyncIntf},
+        {HOST_STATE_PATH, HOST_STATE_SERVICE, settings::hostStateIntf},
+    };
+}
+
+using Interfaces = std::vector<std::string>;
+using HostState = sdbusplus::xyz::openbmc_project::State::server::Host;
+
+int onStop(sd_event_source* es, int fd, uint32_t /* revents */,
+           void* /* userdata */)
+{
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0);
+
+    sd_event_exit(sd_event_source_get_event(es), 0);
+    return 0;
+}
+
+} // namespace anonymous
+
+FakeServices::FakeServices(const Settings& settings)
+    : served(settings)
+{
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    requestFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd == -1 || requestFd == -1)
+    {
+        auto error = std::string("eventfd: ") + strerror(errno);
+        close(stopFd);
+        close(requestFd);
+        throw std::runtime_error(error);
+    }
+
+    std::promise<void> ready;
+    auto started = ready.get_future();
+    thread = std::thread(&FakeServices::run, this, std::ref(ready));
+    try
+    {
+        started.get();
+    }
+    catch (...)
+    {
+        thread.join();
+        close(stopFd);
+        close(requestFd);
+        throw;
+    }
+}
+
+FakeServices::~FakeServices()
+{
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) == sizeof(one) && thread.joinable())
+    {
+        thread.join();
+    }
+    close(stopFd);
+    close(requestFd);
+}
+
+void FakeServices::restartSettings(const Settings& settings)
+{
+    runOnThread([this, settings]()
+    {
+        auto r = sd_bus_release_name(bus->get(), SETTINGS_SERVICE);
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to release the name");
+        }
+        auto hostOn = served.hostOn;
+        served = settings;
+        served.hostOn = hostOn;
+        serveSettings();
+        bus->request_name(SETTINGS_SERVICE);
+    });
+}
+
+void FakeServices::setOwner(Owner owner)
+{
+    runOnThread([this, owner]()
+    {
+        served.owner = owner;
+        ownerSetting->property_changed(PROPERTY_TIME_OWNER);
+    });
+}
+
+void FakeServices::runOnThread(std::function<void()> function)
+{
+    std::packaged_task<void()> task(std::move(function));
+    auto done = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(requestLock);
+        requests.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    if (write(requestFd, &one, sizeof(one)) != sizeof(one))
+    {
+        throw std::runtime_error(std::string("write: ") + strerror(errno));
+    }
+    done.get();
+}
+
+int FakeServices::onRequest(sd_event_source* /* es */, int fd,
+                            uint32_t /* revents */, void* userdata)
+{
+    auto services = static_cast<FakeServices*>(userdata);
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0);
+
+    std::vector<std::packaged_task<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(services->requestLock);
+        tasks.swap(services->requests);
+    }
+    for (auto& task : tasks)
+    {
+        // An exception is passed to the waiting caller
+        task();
+    }
+    return 0;
+}
+
+void FakeServices::serveSettings()
+{
+    using namespace sdbusplus::vtable;
+    static const vtable_t ownerVtable[] = {
+        start(),
+        property(PROPERTY_TIME_OWNER, "s", onGetOwner,
+                 property_::emits_change),
+        end()
+    };
+    static const vtable_t syncMethodVtable[] = {
+        start(),
+        property(PROPERTY_TIME_SYNC_METHOD, "s", onGetSyncMethod,
+                 property_::emits_change),
+        end()
+    };
+    using sdbusplus::server::interface::interface;
+    ownerSetting.reset();
+    syncMethodSetting.reset();
+    ownerSetting = std::make_unique<interface>(
+        *bus, served.ownerPath.c_str(), settings::timeOwnerIntf,
+        ownerVtable, this);
+    syncMethodSetting = std::make_unique<interface>(
+        *bus, served.syncMethodPath.c_str(), settings::timeSyncIntf,
+        syncMethodVtable, this);
+}
+
+int FakeServices::onGetOwner(sd_bus* /* bus */, const char* /* path */,
+                             const char* /* interface */,
+                             const char* /* property */,
+                             sd_bus_message* reply, void* userdata,
+                             sd_bus_error* /* error */)
+{
+    auto services = static_cast<FakeServices*>(userdata);
+    auto owner = utils::ownerToStr(services->served.owner);
+    return sd_bus_message_append(reply, "s", owner.c_str());
+}
+
+int FakeServices::onGetSyncMethod(sd_bus* /* bus */, const char* /* path */,
+                                  const char* /* interface */,
+                                  const char* /* property */,
+                                  sd_bus_message* reply, void* userdata,
+                                  sd_bus_error* /* error */)
+{
+    auto services = static_cast<FakeServices*>(userdata);
+    auto mode = utils::modeToStr(services->served.mode);
+    return sd_bus_message_append(reply, "s", mode.c_str());
+}
+
+void FakeServices::run(std::promise<void>& ready)
+{
+    sd_event* event = nullptr;
+    sd_event_source* es = nullptr;
+    sd_event_source* requestSource = nullptr;
+    try
+    {
+        auto r = sd_event_new(&event);
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to create event loop");
+        }
+        r = sd_event_add_io(event, &es, stopFd, EPOLLIN, onStop, nullptr);
+        if (r >= 0)
+        {
+            r = sd_event_add_io(event, &requestSource, requestFd, EPOLLIN,
+                                onRequest, this);
+        }
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to add event");
+        }
+
+        auto bus = sdbusplus::bus::new_default();
+        bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+        this->bus = &bus;
+        {
+            using namespace sdbusplus::vtable;
+            static const vtable_t mapperVtable[] = {
+                start(),
+                method("GetSubTree", "sias", "a{sa{sas}}", onGetSubTree),
+                method("GetObject", "sas", "a{sas}", onGetObject),
+                end()
+            };
+            static const vtable_t timedateVtable[] = {
+                start(),
+                method("SetTime", "xbb", "", onSetTime),
+                method("SetNTP", "bb", "", onSetNtp),
+                end()
+            };
+            sdbusplus::server::interface::interface mapper(
+                bus, MAPPER_PATH, MAPPER_INTERFACE, mapperVtable, this);
+            sdbusplus::server::interface::interface timedate(
+                bus, TIMEDATE_PATH, TIMEDATE_INTERFACE, timedateVtable, this);
+
+            // The settings are served by plain properties, so they can
+            // change without a signal
+            serveSettings();
+            sdbusplus::server::object::object<HostState> host(
+                bus, HOST_STATE_PATH);
+            host.currentHostState(served.hostOn
+                                  ? HostState::HostState::Running
+                                  : HostState::HostState::Off);
+
+            for (auto name : {MAPPER_SERVICE, SETTINGS_SERVICE,
+                              HOST_STATE_SERVICE, TIMEDATE_SERVICE})
+            {
+                bus.request_name(name);
+            }
+            ready.set_value();
+
+            sd_event_loop(event);
+            ownerSetting.reset();
+            syncMethodSetting.reset();
+        }
+        this->bus = nullptr;
+        bus.detach_event();
+    }
+    catch (...)
+    {
+        try
+        {
+            ready.set_exception(std::current_exception());
+        }
+        catch (const std::future_error&)
+        {
+            // Already started, nobody is waiting for the error
+        }
+    }
+
+    ownerSetting.reset();
+    syncMethodSetting.reset();
+    sd_event_source_unref(requestSource);
+    sd_event_source_unref(es);
+    sd_event_unref(event);
+}
+
+int FakeServices::onGetSubTree(sd_bus_message* m, void* userdata,
+                               sd_bus_error* /* error */)
+{
+    sdbusplus::message::message msg(m);
+    std::string root;
+    int32_t depth;
+    Interfaces interfaces;
+    msg.read(root, depth, interfaces);
+
+    auto services = static_cast<FakeServices*>(userdata);
+    std::map<std::string, std::map<std::string, Interfaces>> result;
+    for (const auto& o : objectsOf(services->served))
+    {
+        if (std::find(interfaces.begin(), interfaces.end(), o.interface) !=
+            interfaces.end())
+        {
+            result[o.path][o.service] = {o.interface};
+        }
+    }
+
+    auto reply = msg.new_method_return();
+    reply.append(result);
+    reply.method_return();
+    return 0;
+}
+
+int FakeServices::onGetObject(sd_bus_message* m, void* userdata,
+                              sd_bus_error* /* error */)
+{
+    sdbusplus::message::message msg(m);
+    std::string path;
+    Interfaces interfaces;
+    msg.read(path, interfaces);
+
+    auto services = static_cast<FakeServices*>(userdata);
+    std::map<std::string, Interfaces> result;
+    for (const auto& o : objectsOf(services->served))
+    {
+        if (path == o.path)
+        {
+            result[o.service] = {o.interface};
+        }
+    }
+
+    auto reply = msg.new_method_return();
+    reply.append(result);
+    reply.method_return();
+    return 0;
+}
+
+int FakeServices::onSetTime(sd_bus_message* m, void* userdata,
+                            sd_bus_error* /* error */)
+{
+    auto services = static_cast<FakeServices*>(userdata);
+    ++services->setTimes;
+
+    sdbusplus::message::message msg(m);
+    auto reply = msg.new_method_return();
+    reply.method_return();
+    return 0;
+}
+
+int FakeServices::onSetNtp(sd_bus_message* m, void* userdata,
+                           sd_bus_error* /* error */)
+{
+    auto services = static_cast<FakeServices*>(userdata);
+    ++services->setNtps;
+
+    sdbusplus::message::message msg(m);
+    auto reply = msg.new_method_return();
+    reply.method_return();
+    return 0;
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+constexpr auto MAPPER_SERVICE = "xyz.openbmc_project.ObjectMapper";
+constexpr auto SETTINGS_SERVICE = "xyz.openbmc_project.Settings";
+constexpr auto HOST_STATE_SERVICE = "xyz.openbmc_project.State.Host";
+constexpr auto TIMEDATE_SERVICE = "org.freedesktop.timedate1";
+
+constexpr auto TIME_OWNER_PATH = "/xyz/openbmc_project/time/owner";
+constexpr auto TIME_SYNC_METHOD_PATH = "/xyz/openbmc_project/time/sync_method";
+constexpr auto HOST_STATE_PATH = "/xyz/openbmc_project/state/host0";
+
+/** @class FakeServices
+ *  @brief The services that the time manager depends on, faked on their own
+ *  connection and thread: the object mapper, the time settings, the host
+ *  state and systemd-timedated. The fake timedated does not change the
+ *  system time. The settings service can be restarted with the settings
+ *  changed and moved, as phosphor-settingsd may be.
+ */
+class FakeServices
+{
+    public:
+        /** @brief The initial values of the settings */
+        struct Settings
+        {
+            Mode mode = Mode::Manual;
+            Owner owner = Owner::Both;
+            bool hostOn = false;
+
+            /** @brief The path of the time owner setting */
+            std::string ownerPath = TIME_OWNER_PATH;
+
+            /** @brief The path of the time sync method setting */
+            std::string syncMethodPath = TIME_SYNC_METHOD_PATH;
+        };
+
+        /** @brief Start the services and wait until they own their names
+         *
+         * @param[in] settings - The initial values of the settings
+         */
+        explicit FakeServices(const Settings& settings);
+
+        FakeServices(const FakeServices&) = delete;
+        FakeServices& operator=(const FakeServices&) = delete;
+        FakeServices(FakeServices&&) = delete;
+        FakeServices& operator=(FakeServices&&) = delete;
+        ~FakeServices();
+
+        /** @brief Restart the settings service with other settings
+         *  @details Its name is released, the settings are served at their
+         *  paths with their values, without a PropertiesChanged or
+         *  InterfacesAdded signal, as if they are changed while it is down,
+         *  and the name is owned again. The host state is not changed.
+         *  It returns once the name is owned again.
+         *
+         * @param[in] settings - The settings after the restart
+         */
+        void restartSettings(const Settings& settings);
+
+        /** @brief Change the time owner setting and signal it, as
+         *  phosphor-settingsd does on a set
+         *
+         * @param[in] owner - The new time owner
+         */
+        void setOwner(Owner owner);
+
+        /** @brief The number of timedated SetTime calls */
+        size_t setTimeCalls() const
+        {
+            return setTimes;
+        }
+
+        /** @brief The number of timedated SetNTP calls */
+        size_t setNtpCalls() const
+        {
+            return setNtps;
+        }
+
+    private:
+        /** @brief The served settings, used on the thread of the services */
+        Settings served;
+
+        /** @brief The number of timedated SetTime calls */
+        std::atomic<size_t> setTimes{0};
+
+        /** @brief The number of timedated SetNTP calls */
+        std::atomic<size_t> setNtps{0};
+
+        /** @brief The eventfd to stop the thread */
+        int stopFd = -1;
+
+        /** @brief The eventfd to run the requests on the thread */
+        int requestFd = -1;
+
+        /** @brief The requests to run on the thread */
+        std::vector<std::packaged_task<void()>> requests;
+
+        /** @brief The lock of the requests */
+        std::mutex requestLock;
+
+        /** @brief The connection of the services, used on their thread */
+        sdbusplus::bus::bus* bus = nullptr;
+
+        /** @brief The served time owner setting */
+        std::unique_ptr<sdbusplus::server::interface::interface> ownerSetting;
+
+        /** @brief The served time sync method setting */
+        std::unique_ptr<sdbusplus::server::interface::interface>
+            syncMethodSetting;
+
+        /** @brief The thread of the services */
+        std::thread thread;
+
+        /** @brief The body of the thread
+         *
+         * @param[in] ready - Set when the services own their names
+         */
+        void run(std::promise<void>& ready);
+
+        /** @brief Serve the settings at their paths, replacing the served
+         *  ones, on the thread of the services
+         */
+        void serveSettings();
+
+        /** @brief Run a function on the thread of the services, and wait
+         *  for it
+         *
+         * @param[in] function - The function to run
+         */
+        void runOnThread(std::function<void()> function);
+
+        /** @brief The callback function of the requests to the thread
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - The eventfd of the requests
+         * @param[in] revents - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onRequest(sd_event_source* es, int fd, uint32_t revents,
+                             void* userdata);
+
+        static int onGetOwner(sd_bus* bus, const char* path,
+                              const char* interface, const char* property,
+                              sd_bus_message* reply, void* userdata,
+                              sd_bus_error* error);
+        static int onGetSyncMethod(sd_bus* bus, const char* path,
+                                   const char* interface,
+                                   const char* property,
+                                   sd_bus_message* reply, void* userdata,
+                                   sd_bus_error* error);
+
+        static int onGetSubTree(sd_bus_message* m, void* userdata,
+                                sd_bus_error* error);
+        static int onGetObject(sd_bus_message* m, void* userdata,
+                               sd_bus_error* error);
+        static int onSetTime(sd_bus_message* m, void* userdata,
+                             sd_bus_error* error);
+        static int onSetNtp(sd_bus_message* m, void* userdata,
+                            sd_bus_error* error);
+};
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,728 @@
+/**
+ * Measure the memory footprint of the time manager: the objects of
+ * phosphor-timemanager are started by the Daemon of main.cpp in a child
+ * process, against the fake services on a private bus, and a fixed
+ * workload of Elapsed gets and sets and time owner changes is driven on
+ * them. The RSS, the heap high-water mark, and the allocations of each
+ * subsystem are reported, and checked against the checked-in budgets.
+ *
+ * The heap is the memory allocated by operator new, which is attributed
+ * to the subsystem being constructed, or to the dispatch of the bus and
+ * the event loop otherwise. The allocations of the C libraries, e.g. of
+ * sd-bus, are only in the RSS.
+ *
+ *   footprint [--budgets FILE] [--rounds N] [--print]
+ */
+#include "budgets.hpp"
+#include "config.h"
+#include "daemon.hpp"
+#include "fake_services.hpp"
+#include "private_bus.hpp"
+#include "settings.hpp"
+#include "utils.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace // anonymous
+{
+
+using namespace phosphor::time;
+using namespace phosphor::time::bench;
+
+/** @brief The default number of rounds of the workload */
+constexpr size_t DEFAULT_ROUNDS = 1000;
+
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto OBJECT_MANAGER_INTERFACE =
+    "org.freedesktop.DBus.ObjectManager";
+constexpr auto EPOCH_INTERFACE = "xyz.openbmc_project.Time.EpochTime";
+constexpr auto PROPERTY_ELAPSED = "Elapsed";
+
+constexpr auto NAME_WIDTH = 28;
+constexpr auto NUMBER_WIDTH = 12;
+
+/** @brief The subsystems the heap is attributed to */
+enum class Scope : uint8_t
+{
+    Dispatch,
+    ObjectManagers,
+    Settings,
+    Manager,
+    BmcEpoch,
+    HostEpoch,
+    Others,
+    Count,
+    Untracked = Count,
+};
+
+constexpr size_t SCOPE_COUNT = static_cast<size_t>(Scope::Count);
+
+/** @brief The names of the scopes in the budgets */
+constexpr const char* SCOPE_NAMES[SCOPE_COUNT] = {
+    "dispatch",
+    "object_managers",
+    "settings",
+    "manager",
+    "bmc_epoch",
+    "host_epoch",
+    "others",
+};
+
+/** @brief The heap of a scope */
+struct Heap
+{
+    /** @brief The number of allocations */
+    uint64_t allocations = 0;
+
+    /** @brief The bytes allocated and not freed */
+    uint64_t live = 0;
+
+    /** @brief The high-water mark of the live bytes */
+    uint64_t peak = 0;
+
+    void allocate(size_t size)
+    {
+        ++allocations;
+        live += size;
+        peak = std::max(peak, live);
+    }
+
+    void deallocate(size_t size)
+    {
+        live -= size;
+    }
+};
+
+/** @brief The header of each allocation by operator new
+ *  @details It keeps the max alignment of malloc() for the memory after it.
+ */
+struct alignas(16) Header
+{
+    size_t size;
+    Scope scope;
+};
+
+/** @brief Indicate if the allocations are tracked, which is only set in
+ *  the child that runs the daemon objects, on its only thread
+ */
+bool tracking = false;
+
+/** @brief The scope the allocations are attributed to */
+Scope current = Scope::Dispatch;
+
+std::array<Heap, SCOPE_COUNT> heaps;
+Heap total;
+
+void* allocate(size_t size) noexcept
+{
+    auto header = static_cast<Header*>(malloc(sizeof(Header) + size));
+    if (!header)
+    {
+        return nullptr;
+    }
+    header->size = size;
+    header->scope = tracking ? current : Scope::Untracked;
+    if (header->scope != Scope::Untracked)
+    {
+        heaps[static_cast<size_t>(header->scope)].allocate(size);
+        total.allocate(size);
+    }
+    return header + 1;
+}
+
+void release(void* p) noexcept
+{
+    if (!p)
+    {
+        return;
+    }
+    auto header = static_cast<Header*>(p) - 1;
+    if (header->scope != Scope::Untracked)
+    {
+        heaps[static_cast<size_t>(header->scope)].deallocate(header->size);
+        total.deallocate(header->size);
+    }
+    ::free(header);
+}
+
+/** @class Attribute
+ *  @brief Attribute the allocations to a scope while it is alive.
+ */
+class Attribute
+{
+    public:
+        explicit Attribute(Scope scope)
+            : saved(current)
+        {
+            current = scope;
+        }
+        Attribute(const Attribute&) = delete;
+        Attribute& operator=(const Attribute&) = delete;
+        Attribute(Attribute&&) = delete;
+        Attribute& operator=(Attribute&&) = delete;
+
+        ~Attribute()
+        {
+            current = saved;
+        }
+
+    private:
+        Scope saved;
+};
+
+/** @brief Get the scope of a part of the daemon */
+Scope partScope(Daemon::Part part)
+{
+    switch (part)
+    {
+        case Daemon::Part::ObjectManagers:
+            return Scope::ObjectManagers;
+        case Daemon::Part::Manager:
+            return Scope::Manager;
+        case Daemon::Part::BmcEpoch:
+            return Scope::BmcEpoch;
+        case Daemon::Part::HostEpoch:
+            return Scope::HostEpoch;
+        case Daemon::Part::Others:
+            break;
+    }
+    return Scope::Others;
+}
+
+/** @brief Read a size in kB from /proc/self/status
+ *
+ * @param[in] key - The key of the size, e.g. "VmRSS:"
+ *
+ * @return The size in kB, or 0 if it is not found
+ */
+uint64_t statusKb(const std::string& key)
+{
+    std::ifstream fs("/proc/self/status");
+    std::string line;
+    while (std::getline(fs, line))
+    {
+        if (line.compare(0, key.size(), key) == 0)
+        {
+            return strtoull(line.c_str() + key.size(), nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+void closeFd(int& fd)
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+uint64_t toKb(uint64_t bytes)
+{
+    return (bytes + 1023) / 1024;
+}
+
+int onStop(sd_event_source* es, int fd, uint32_t /* revents */,
+           void* /* userdata */)
+{
+    // A byte or the end of the pipe stops the daemon, the pipe is
+    // blocking so it is read once
+    char c;
+    if (read(fd, &c, sizeof(c)) >= 0)
+    {
+        sd_event_exit(sd_event_source_get_event(es), 0);
+    }
+    return 0;
+}
+
+/** @brief The pipes between the bench and the child of the daemon */
+struct Pipes
+{
+    /** @brief The bench starts the daemon when the services are up */
+    int go[2] = {-1, -1};
+
+    /** @brief The daemon is ready when it owns the bus name */
+    int ready[2] = {-1, -1};
+
+    /** @brief The bench stops the daemon after the workload */
+    int stop[2] = {-1, -1};
+
+    /** @brief The daemon reports the measurements, and closes it */
+    int report[2] = {-1, -1};
+};
+
+/** @brief Construct the objects of main.cpp, serve the workload
+ *  until it is stopped, and report the measurements
+ *
+ * @param[in] pipes - The child ends of the pipes are used
+ * @param[in] dir - The directory of the files of the objects
+ */
+void runDaemon(const Pipes& pipes, const std::string& dir)
+{
+    char c;
+    if (read(pipes.go[0], &c, sizeof(c)) != sizeof(c))
+    {
+        throw std::runtime_error("The bench is gone");
+    }
+
+    tracking = true;
+    sd_event* event = nullptr;
+    sd_event_new(&event);
+    sd_event_source* es = nullptr;
+    auto r = sd_event_add_io(event, &es, pipes.stop[0], EPOLLIN, onStop,
+                             nullptr);
+    if (r < 0)
+    {
+        throw std::runtime_error("Failed to add event");
+    }
+
+    auto bus = sdbusplus::bus::new_default();
+    bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+
+    // The manager keeps its own settings objects, these are only to
+    // measure them apart from it
+    std::unique_ptr<settings::Objects> settingsObjects;
+    {
+        Attribute attribute(Scope::Settings);
+        settingsObjects = std::make_unique<settings::Objects>(bus);
+    }
+
+    auto file = [&dir](const char* name)
+    {
+        return dir + "/" + name;
+    };
+    auto telemetryFile = file("telemetry");
+    auto hostOffsetFile = file("host_offset");
+    auto modeFile = file("mode");
+    auto ownerFile = file("owner");
+    Daemon::Paths paths;
+#ifdef TIME_FLOOR
+    auto timeFloorFile = file("time_floor");
+    paths.timeFloorFile = timeFloorFile.c_str();
+#endif
+#ifdef FREQUENCY_KEEPER
+    auto frequencyFile = file("frequency");
+    paths.frequencyFile = frequencyFile.c_str();
+#endif
+    paths.telemetryFile = telemetryFile.c_str();
+    paths.hostOffsetFile = hostOffsetFile.c_str();
+    paths.modeFile = modeFile.c_str();
+    paths.ownerFile = ownerFile.c_str();
+#ifdef QUERY_SOCKET
+    auto querySocket = file("query.sock");
+    paths.querySocket = querySocket.c_str();
+#endif
+#ifdef REPLICATION
+    auto replicationSocket = file("replication.sock");
+    paths.replicationSocket = replicationSocket.c_str();
+#endif
+
+    // The objects are wired as main.cpp does, with the allocations of
+    // each part attributed to its scope
+    std::unique_ptr<Daemon> daemon;
+    {
+        Attribute attribute(Scope::Others);
+        daemon = std::make_unique<Daemon>(
+            bus, nullptr, paths,
+            [](Daemon::Part part)
+            {
+                current = partScope(part);
+            });
+    }
+
+    std::array<Heap, SCOPE_COUNT> startup;
+    {
+        Attribute attribute(Scope::Dispatch);
+        startup = heaps;
+        bus.request_name(BUSNAME);
+    }
+    auto rssStartup = statusKb("VmRSS:");
+
+    if (write(pipes.ready[1], &c, sizeof(c)) != sizeof(c))
+    {
+        throw std::runtime_error("The bench is gone");
+    }
+    {
+        Attribute attribute(Scope::Dispatch);
+        sd_event_loop(event);
+    }
+
+    std::ostringstream report;
+    report << "rss_startup_kb " << rssStartup << "\n"
+           << "rss_kb " << statusKb("VmRSS:") << "\n"
+           << "rss_peak_kb " << statusKb("VmHWM:") << "\n"
+           << "heap_peak_kb " << toKb(total.peak) << "\n"
+           << "allocations " << total.allocations << "\n";
+    for (size_t s = 0; s < SCOPE_COUNT; ++s)
+    {
+        report << SCOPE_NAMES[s] << "_startup_kb "
+               << toKb(startup[s].live) << "\n"
+               << SCOPE_NAMES[s] << "_kb " << toKb(heaps[s].live) << "\n"
+               << SCOPE_NAMES[s] << "_allocations "
+               << heaps[s].allocations << "\n";
+    }
+    auto text = report.str();
+    if (write(pipes.report[1], text.data(), text.size()) !=
+        static_cast<ssize_t>(text.size()))
+    {
+        throw std::runtime_error("The bench is gone");
+    }
+}
+
+/** @brief Call a method of a service on the bus
+ *
+ * @return true if the call succeeds
+ */
+template <typename... Args>
+bool call(sdbusplus::bus::bus& bus, const char* service, const char* path,
+          const char* interface, const char* member, const char* types,
+          Args&&... args)
+{
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_call_method(bus.get(), service, path, interface, member,
+                                &error, &reply, types,
+                                std::forward<Args>(args)...);
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return r >= 0;
+}
+
+/** @brief Drive the fixed workload on the daemon: per round, the BMC and
+ *  host Elapsed gets, a host Elapsed set, a time owner change, and a
+ *  GetManagedObjects of the host time
+ *
+ * @param[in] bus - The bus to call the daemon on
+ * @param[in] services - The fake services to change the owner on
+ * @param[in] rounds - The number of rounds
+ *
+ * @return The number of failed calls
+ */
+size_t drive(sdbusplus::bus::bus& bus, FakeServices& services,
+             size_t rounds)
+{
+    size_t failed = 0;
+    auto count = [&failed](bool ok)
+    {
+        if (!ok)
+        {
+            ++failed;
+        }
+    };
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        count(call(bus, BUSNAME, OBJPATH_BMC, PROPERTIES_INTERFACE, "Get",
+                   "ss", EPOCH_INTERFACE, PROPERTY_ELAPSED));
+        count(call(bus, BUSNAME, OBJPATH_HOST, PROPERTIES_INTERFACE, "Get",
+                   "ss", EPOCH_INTERFACE, PROPERTY_ELAPSED));
+        uint64_t now = utils::now(ClockRead::Precise).count();
+        count(call(bus, BUSNAME, OBJPATH_HOST, PROPERTIES_INTERFACE, "Set",
+                   "ssv", EPOCH_INTERFACE, PROPERTY_ELAPSED, "t", now));
+        // The setting is read-only on the bus, it is changed and
+        // signaled by the services as phosphor-settingsd does
+        services.setOwner(i % 2 ? Owner::Both : Owner::Split);
+        count(call(bus, BUSNAME, OBJPATH_HOST, OBJECT_MANAGER_INTERFACE,
+                   "GetManagedObjects", ""));
+    }
+
+    // The changes of the owner are handled before this reply
+    count(call(bus, BUSNAME, OBJPATH_HOST, PROPERTIES_INTERFACE, "Get",
+               "ss", EPOCH_INTERFACE, PROPERTY_ELAPSED));
+    return failed;
+}
+
+/** @brief Parse the "name value" lines of the report
+ *
+ * @param[in] text - The report
+ * @param[out] values - The values by name, in the order of the report
+ */
+void parseReport(const std::string& text,
+                 std::vector<std::pair<std::string, uint64_t>>& values)
+{
+    std::istringstream is(text);
+    std::string name;
+    uint64_t value;
+    while (is >> name >> value)
+    {
+        values.emplace_back(name, value);
+    }
+}
+
+std::string readAll(int fd)
+{
+    std::string text;
+    std::array<char, 4096> buf;
+    ssize_t n;
+    while ((n = read(fd, buf.data(), buf.size())) > 0 ||
+           (n < 0 && errno == EINTR))
+    {
+        if (n > 0)
+        {
+            text.append(buf.data(), n);
+        }
+    }
+    return text;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name
+              << " [--budgets FILE] [--rounds N] [--print]\n"
+              << "  --budgets  The file of the budgets\n"
+              << "  --rounds   The number of rounds of the workload\n"
+              << "  --print    Print the measurements as the budgets file\n";
+}
+
+} // namespace anonymous
+
+void* operator new(std::size_t size)
+{
+    auto p = allocate(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string budgetsFile = BUDGETS_FILE;
+    size_t rounds = DEFAULT_ROUNDS;
+    bool print = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--budgets") == 0 && i + 1 < argc)
+        {
+            budgetsFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+        {
+            rounds = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--print") == 0)
+        {
+            print = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Budgets budgets;
+    if (!print && !loadBudgets(budgetsFile, budgets))
+    {
+        std::cerr << "Failed to read the budgets in " << budgetsFile << "\n";
+        return 1;
+    }
+
+    char dir[] = "/tmp/footprintXXXXXX";
+    if (!mkdtemp(dir))
+    {
+        std::cerr << "mkdtemp: " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    int rc = 0;
+    pid_t pid = -1;
+    Pipes pipes;
+    try
+    {
+        PrivateBus privateBus;
+
+        for (auto p : {pipes.go, pipes.ready, pipes.stop, pipes.report})
+        {
+            if (pipe2(p, O_CLOEXEC) != 0)
+            {
+                throw std::runtime_error(std::string("pipe2: ") +
+                                         strerror(errno));
+            }
+        }
+
+        // Fork before the services start their thread, the daemon runs
+        // on the only thread of the child as it does in its own process
+        pid = fork();
+        if (pid < 0)
+        {
+            throw std::runtime_error(std::string("fork: ") + strerror(errno));
+        }
+        if (pid == 0)
+        {
+            closeFd(pipes.go[1]);
+            closeFd(pipes.ready[0]);
+            closeFd(pipes.stop[1]);
+            closeFd(pipes.report[0]);
+            try
+            {
+                runDaemon(pipes, dir);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Daemon failed: " << e.what() << "\n";
+                _exit(1);
+            }
+            _exit(0);
+        }
+        closeFd(pipes.go[0]);
+        closeFd(pipes.ready[1]);
+        closeFd(pipes.stop[0]);
+        closeFd(pipes.report[1]);
+
+        FakeServices services(FakeServices::Settings{});
+        char c = 0;
+        if (write(pipes.go[1], &c, sizeof(c)) != sizeof(c) ||
+            read(pipes.ready[0], &c, sizeof(c)) != sizeof(c))
+        {
+            throw std::runtime_error("The daemon failed to start");
+        }
+
+        auto bus = sdbusplus::bus::new_default();
+        auto failed = drive(bus, services, rounds);
+        if (write(pipes.stop[1], &c, sizeof(c)) != sizeof(c))
+        {
+            throw std::runtime_error("The daemon is gone");
+        }
+
+        std::vector<std::pair<std::string, uint64_t>> values;
+        parseReport(readAll(pipes.report[0]), values);
+        if (values.empty())
+        {
+            throw std::runtime_error("The daemon did not report");
+        }
+        if (failed != 0)
+        {
+            std::cerr << failed << " calls of the workload failed\n";
+            rc = 1;
+        }
+
+        if (!print)
+        {
+            std::cout << rounds << " rounds of the workload\n"
+                      << std::left << std::setw(NAME_WIDTH) << "Measurement"
+                      << std::right << std::setw(NUMBER_WIDTH) << "value"
+                      << std::setw(NUMBER_WIDTH) << "budget" << "\n";
+        }
+        for (const auto& v : values)
+        {
+            if (print)
+            {
+                std::cout << v.first << " " << v.second << "\n";
+                continue;
+            }
+            std::cout << std::left << std::setw(NAME_WIDTH) << v.first
+                      << std::right << std::setw(NUMBER_WIDTH) << v.second
+                      << std::setw(NUMBER_WIDTH);
+            auto budget = budgets.find(v.first);
+            if (budget == budgets.end())
+            {
+                std::cout << "-" << "\n";
+                continue;
+            }
+            std::cout << budget->second;
+            if (v.second > budget->second)
+            {
+                std::cout << "  OVER BUDGET";
+                rc = 1;
+            }
+            std::cout << "\n";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        rc = 1;
+    }
+
+    // Closing the pipes stops the daemon if the bench failed
+    for (auto p : {pipes.go, pipes.ready, pipes.stop, pipes.report})
+    {
+        closeFd(p[0]);
+        closeFd(p[1]);
+    }
+    if (pid > 0)
+    {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            rc = 1;
+        }
+    }
+    for (auto file : {"/frequency", "/time_floor", "/telemetry",
+                      "/host_offset", "/mode", "/owner", "/query.sock",
+                      "/replication.sock"})
+    {
+        unlink((std::string(dir) + file).c_str());
+    }
+    rmdir(dir);
+    return rc;
+}
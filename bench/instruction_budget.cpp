@@ -0,0 +1,718 @@
+/**
+ * Count the instructions retired per call of the hot paths of the daemon,
+ * and check them against the checked-in budgets, so a regression fails
+ * `make check` the same way on any runner, unlike the wall clock.
+ *
+ * The instructions are counted by the hardware counter with
+ * perf_event_open(), or, where the runner does not expose it, by single
+ * stepping the path, traced by a helper child. The budgets are kept per
+ * counting method, "method/path budget" lines. It exits with 77, the
+ * automake skip, if neither method is available or the budgets have none
+ * counted by the available one.
+ *
+ *   instruction_budget [--budgets FILE] [--tolerance PCT] [--print]
+ */
+#include "bmc_epoch.hpp"
+#include "budgets.hpp"
+#include "config.h"
+#include "handoff.hpp"
+#include "host_epoch.hpp"
+#include "manager.hpp"
+#include "settings.hpp"
+#include "system_clock.hpp"
+#include "utils.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+
+#include <linux/perf_event.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace // anonymous
+{
+
+/** @brief The number of calls of a path per count */
+constexpr size_t ITERATIONS = 10;
+
+/** @brief The number of counts of a path, the smallest one is taken */
+constexpr size_t REPEATS = 5;
+
+/** @brief The number of calls of a path before counting, so the lazy
+ *  bindings and the first-use paths are not counted
+ */
+constexpr size_t WARMUP_COUNT = 3;
+
+/** @brief The default allowed increase over a budget, in percent */
+constexpr unsigned DEFAULT_TOLERANCE = 10;
+
+/** @brief The exit code that automake takes as a skipped test */
+constexpr int EXIT_SKIP = 77;
+
+constexpr auto NAME_WIDTH = 22;
+constexpr auto NUMBER_WIDTH = 12;
+
+/** @class InstructionCounter
+ *  @brief Count the user space instructions retired by a function.
+ */
+class InstructionCounter
+{
+    public:
+        using Function = std::function<void()>;
+
+        InstructionCounter()
+        {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+                         PERF_FLAG_FD_CLOEXEC);
+        }
+        InstructionCounter(const InstructionCounter&) = delete;
+        InstructionCounter& operator=(const InstructionCounter&) = delete;
+        InstructionCounter(InstructionCounter&&) = delete;
+        InstructionCounter& operator=(InstructionCounter&&) = delete;
+
+        ~InstructionCounter()
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+
+        /** @brief The way the instructions are counted, the budgets are
+         *  kept per way, as they count e.g. a repeated string instruction
+         *  differently
+         */
+        const char* method() const
+        {
+            return fd >= 0 ? "perf" : "single_step";
+        }
+
+        /** @brief Count the instructions of a function
+         *
+         * @param[in] function - The function to count
+         * @param[out] instructions - The instructions retired
+         *
+         * @return true if it is counted
+         */
+        bool count(const Function& function, uint64_t& instructions)
+        {
+            return fd >= 0 ? countPerf(function, instructions)
+                           : countSteps(function, instructions);
+        }
+
+    private:
+        /** @brief The perf event fd, or -1 if the counter is unavailable */
+        int fd = -1;
+
+        bool countPerf(const Function& function, uint64_t& instructions)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            function();
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            return read(fd, &instructions, sizeof(instructions)) ==
+                   sizeof(instructions);
+        }
+
+        /** @brief Single step the function in this process, traced by a
+         *  helper child, so it runs on the same bus and objects as with
+         *  the hardware counter
+         *  @details The function runs between two SIGSTOPs that the helper
+         *  takes as the start and the end of the count and suppresses.
+         *  Running it in a child instead is not comparable, sd-bus fails
+         *  every call there with -ECHILD.
+         */
+        bool countSteps(const Function& function, uint64_t& instructions)
+        {
+            int fds[2];
+            if (pipe2(fds, O_CLOEXEC) != 0)
+            {
+                return false;
+            }
+            // Let the helper trace this process where Yama only allows
+            // the tracing of the descendants
+            prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+
+            auto parent = getpid();
+            auto pid = fork();
+            if (pid == 0)
+            {
+                close(fds[0]);
+                traceParent(parent, fds[1]);
+                _exit(0);
+            }
+            close(fds[1]);
+
+            bool counted = false;
+            bool seized = false;
+            if (pid > 0 && readAll(fds[0], &seized, sizeof(seized)) && seized)
+            {
+                raise(SIGSTOP);
+                function();
+                raise(SIGSTOP);
+                counted = readAll(fds[0], &counted, sizeof(counted)) &&
+                          counted &&
+                          readAll(fds[0], &instructions,
+                                  sizeof(instructions));
+            }
+            close(fds[0]);
+            if (pid > 0)
+            {
+                int status = 0;
+                waitpid(pid, &status, 0);
+            }
+            prctl(PR_SET_PTRACER, 0, 0, 0, 0);
+            return counted;
+        }
+
+        /** @brief Trace the parent from its first SIGSTOP to its second
+         *  one, and write the instructions stepped in between
+         *
+         * @param[in] parent - The process to trace
+         * @param[in] fd - The pipe to the parent, a bool that it is
+         *                 seized, then a bool that it is counted and the
+         *                 instructions
+         */
+        static void traceParent(pid_t parent, int fd)
+        {
+            bool seized = ptrace(PTRACE_SEIZE, parent, nullptr,
+                                 nullptr) == 0;
+            if (!writeAll(fd, &seized, sizeof(seized)) || !seized)
+            {
+                return;
+            }
+
+            // The SIGSTOPs stop the parent, the steps trap, and any other
+            // signal is delivered and fails the count, but the tracing
+            // goes on to the second SIGSTOP, so the parent is not left
+            // stopped by it
+            uint64_t instructions = 0;
+            bool started = false;
+            bool counted = true;
+            int status = 0;
+            while (waitpid(parent, &status, __WALL) == parent &&
+                   WIFSTOPPED(status))
+            {
+                auto sig = WSTOPSIG(status);
+                auto request = PTRACE_SINGLESTEP;
+                long deliver = 0;
+                if (sig == SIGSTOP && started)
+                {
+                    break;
+                }
+                if (sig == SIGSTOP)
+                {
+                    started = true;
+                }
+                else if (sig == SIGTRAP && started && counted)
+                {
+                    ++instructions;
+                }
+                else
+                {
+                    counted = false;
+                    deliver = sig;
+                }
+                if (!counted)
+                {
+                    request = PTRACE_CONT;
+                }
+                if (ptrace(request, parent, nullptr,
+                           reinterpret_cast<void*>(deliver)) != 0)
+                {
+                    counted = false;
+                    break;
+                }
+            }
+            ptrace(PTRACE_DETACH, parent, nullptr, nullptr);
+            writeAll(fd, &counted, sizeof(counted));
+            writeAll(fd, &instructions, sizeof(instructions));
+        }
+
+        static bool readAll(int fd, void* data, size_t size)
+        {
+            auto p = static_cast<char*>(data);
+            while (size > 0)
+            {
+                auto n = read(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return false;
+                }
+                p += n;
+                size -= n;
+            }
+            return true;
+        }
+
+        static bool writeAll(int fd, const void* data, size_t size)
+        {
+            auto p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                auto n = write(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return false;
+                }
+                p += n;
+                size -= n;
+            }
+            return true;
+        }
+};
+
+/** @class SteppingClock
+ *  @brief The real clocks, with the realtime clock stepped back and forth
+ *  by an hour, so every check of the BMC time sees a jump without setting
+ *  the system time.
+ */
+class SteppingClock : public phosphor::time::SystemClock
+{
+    public:
+        std::chrono::microseconds realtime() const override
+        {
+            using phosphor::time::ClockRead;
+            return phosphor::time::utils::now(ClockRead::Precise) + offset;
+        }
+
+        std::chrono::microseconds steady() const override
+        {
+            using namespace std::chrono;
+            return duration_cast<microseconds>(
+                steady_clock::now().time_since_epoch());
+        }
+
+        bool setTime(const std::chrono::microseconds& /* time */) override
+        {
+            return false;
+        }
+
+        bool setNtp(bool /* enabled */) override
+        {
+            return false;
+        }
+
+        /** @brief Step the realtime clock forward, or back again */
+        void step()
+        {
+            offset = (offset.count() == 0) ? std::chrono::hours(1)
+                                           : std::chrono::microseconds(0);
+        }
+
+    private:
+        /** @brief The step applied to the real clock */
+        std::chrono::microseconds offset{0};
+};
+
+/** @brief Make a properties changed signal of the time settings, sealed
+ *  as if it is received from the bus
+ *  @details It is sent on a connection to one end of a socket pair that
+ *  is never authenticated, so no bus daemon is needed.
+ *
+ * @param[out] signal - The sealed signal
+ *
+ * @return 0 on success, or a negative errno
+ */
+int makeSettingsSignal(sd_bus_message** signal)
+{
+    using namespace phosphor::time;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                   0, fds) != 0)
+    {
+        return -errno;
+    }
+    sd_bus* b = nullptr;
+    auto r = sd_bus_new(&b);
+    if (r >= 0)
+    {
+        r = sd_bus_set_fd(b, fds[0], fds[0]);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_start(b);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_new_signal(b, signal,
+                                      "/xyz/openbmc_project/time/sync_method",
+                                      "org.freedesktop.DBus.Properties",
+                                      "PropertiesChanged");
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(*signal, "sa{sv}as",
+                                  settings::timeSyncIntf,
+                                  2,
+                                  "TimeSyncMethod", "s",
+                                  utils::modeToStr(Mode::Manual).c_str(),
+                                  "TimeOwner", "s",
+                                  utils::ownerToStr(Owner::Both).c_str(),
+                                  0);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_send(b, *signal, nullptr);
+    }
+    sd_bus_unref(b);
+    close(fds[1]);
+    return r < 0 ? r : 0;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name
+              << " [--budgets FILE] [--tolerance PCT] [--print]\n"
+              << "  --budgets    The file of the budgets\n"
+              << "  --tolerance  The allowed increase over a budget, "
+              << "in percent\n"
+              << "  --print      Print the counts as the budgets file\n";
+}
+
+} // namespace anonymous
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class HotPaths
+ *  @brief The daemon objects on a bus that is never started, so the
+ *  signals they emit fail early, and the paths that are counted on them.
+ */
+class HotPaths
+{
+    public:
+        /** @brief A path to count */
+        struct Path
+        {
+            /** @brief The name in the budgets */
+            const char* name;
+
+            /** @brief A call of the path */
+            std::function<void()> call;
+        };
+
+        HotPaths()
+        {
+            sd_event_new(&event);
+            sd_bus* b = nullptr;
+            sd_bus_new(&b);
+            bus = std::make_unique<sdbusplus::bus::bus>(b);
+            bus->attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+
+            dataFile = makeFile("instruction_budget");
+            utils::writeData(dataFile.c_str(), 1234567890123L);
+
+            // The offset is saved as the daemon does, but not to the file
+            // of the daemon
+            offsetFile = makeFile("instruction_budget_offset");
+
+            HandoffState state;
+            manager = std::make_unique<Manager>(*bus, state);
+            bmc = std::make_unique<BmcEpoch>(*bus, OBJPATH_BMC, &clock);
+            host = std::make_unique<HostEpoch>(*bus, OBJPATH_HOST, nullptr,
+                                               offsetFile.c_str());
+            subscription = bmc->subscribe(
+                [this](const TimeStateChange& change)
+                {
+                    host->onTimeStateChanged(change);
+                });
+
+            // Split owner, so the host time is the BMC time with an offset,
+            // and a set or a BMC time step stores the offset
+            host->onOwnerChanged(Owner::Split);
+
+            auto r = makeSettingsSignal(&settingsSignal);
+            if (r < 0)
+            {
+                throw std::runtime_error(std::string("Failed to make the "
+                                                     "settings signal: ") +
+                                         strerror(-r));
+            }
+        }
+        HotPaths(const HotPaths&) = delete;
+        HotPaths& operator=(const HotPaths&) = delete;
+        HotPaths(HotPaths&&) = delete;
+        HotPaths& operator=(HotPaths&&) = delete;
+
+        ~HotPaths()
+        {
+            unlink(dataFile.c_str());
+            unlink(offsetFile.c_str());
+            sd_bus_message_unref(settingsSignal);
+            subscription.reset();
+            host.reset();
+            bmc.reset();
+            manager.reset();
+            bus->detach_event();
+            bus.reset();
+            sd_event_unref(event);
+        }
+
+        /** @brief The paths to count, in the order of the report */
+        std::vector<Path> paths()
+        {
+            return {
+                {"host_elapsed_get", [this]()
+                    {
+                        volatile auto elapsed = host->elapsed();
+                        (void)elapsed;
+                    }},
+                {"host_elapsed_set", [this]()
+                    {
+                        host->elapsed(host->elapsed());
+                    }},
+                {"bmc_time_change", [this]()
+                    {
+                        // A step as a canceled timerfd read finds it: the
+                        // jump is checked, logged and notified, and the
+                        // host offset is saved
+                        clock.step();
+                        bmc->checkTimeJump();
+                    }},
+                {"settings_changed", [this]()
+                    {
+                        // The same values as the current ones, so only the
+                        // decoding and the comparisons are counted
+                        sd_bus_message_rewind(settingsSignal, 1);
+                        sdbusplus::message::message msg(settingsSignal);
+                        manager->onSettingsChanged(msg);
+                    }},
+                {"read_data", [this]()
+                    {
+                        volatile auto data =
+                            utils::readData<long>(dataFile.c_str());
+                        (void)data;
+                    }},
+            };
+        }
+
+    private:
+        sd_event* event = nullptr;
+        std::unique_ptr<sdbusplus::bus::bus> bus;
+        SteppingClock clock;
+        std::unique_ptr<Manager> manager;
+        std::unique_ptr<BmcEpoch> bmc;
+        std::unique_ptr<HostEpoch> host;
+        TimeStateDispatcher::Subscription subscription;
+        sd_bus_message* settingsSignal = nullptr;
+        std::string dataFile;
+        std::string offsetFile;
+
+        /** @brief Create a temporary file
+         *
+         * @param[in] prefix - The prefix of the file name
+         *
+         * @return The path of the file
+         */
+        static std::string makeFile(const std::string& prefix)
+        {
+            auto name = "/tmp/" + prefix + "XXXXXX";
+            auto fd = mkstemp(&name[0]);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Failed to create " + name);
+            }
+            close(fd);
+            return name;
+        }
+};
+
+} // namespace time
+} // namespace phosphor
+
+int main(int argc, char* argv[])
+{
+    using namespace phosphor::time;
+    using namespace phosphor::time::bench;
+
+    std::string budgetsFile = BUDGETS_FILE;
+    unsigned tolerance = DEFAULT_TOLERANCE;
+    bool print = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--budgets") == 0 && i + 1 < argc)
+        {
+            budgetsFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--print") == 0)
+        {
+            print = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Budgets budgets;
+    if (!print && !loadBudgets(budgetsFile, budgets))
+    {
+        std::cerr << "Failed to read the budgets in " << budgetsFile << "\n";
+        return 1;
+    }
+
+    try
+    {
+        HotPaths hotPaths;
+        InstructionCounter counter;
+
+        auto countCalls = [&counter](const std::function<void()>& call,
+                                     uint64_t& instructions)
+        {
+            uint64_t best = std::numeric_limits<uint64_t>::max();
+            for (size_t r = 0; r < REPEATS; ++r)
+            {
+                uint64_t counted = 0;
+                if (!counter.count([&call]()
+                                   {
+                                       for (size_t i = 0; i < ITERATIONS; ++i)
+                                       {
+                                           call();
+                                       }
+                                   },
+                                   counted))
+                {
+                    return false;
+                }
+                best = std::min(best, counted);
+            }
+            instructions = best;
+            return true;
+        };
+
+        // The loop and the counting itself, taken off each path
+        uint64_t overhead = 0;
+        if (!countCalls([]() {}, overhead))
+        {
+            std::cerr << "No instruction counter, skipped\n";
+            return EXIT_SKIP;
+        }
+
+        // The budgets of this counting method, the counts of the other
+        // one are not comparable
+        auto prefix = std::string(counter.method()) + "/";
+        if (!print &&
+            std::none_of(budgets.begin(), budgets.end(),
+                         [&prefix](const Budgets::value_type& b)
+                         {
+                             return b.first.compare(0, prefix.size(),
+                                                    prefix) == 0;
+                         }))
+        {
+            std::cerr << "No budgets counted by " << counter.method()
+                      << ", skipped\n";
+            return EXIT_SKIP;
+        }
+
+        if (!print)
+        {
+            std::cout << "Instructions per call, counted by "
+                      << counter.method() << "\n"
+                      << std::left << std::setw(NAME_WIDTH) << "Path"
+                      << std::right << std::setw(NUMBER_WIDTH) << "counted"
+                      << std::setw(NUMBER_WIDTH) << "budget" << "\n";
+        }
+
+        bool failed = false;
+        for (const auto& path : hotPaths.paths())
+        {
+            for (size_t i = 0; i < WARMUP_COUNT; ++i)
+            {
+                path.call();
+            }
+            uint64_t counted = 0;
+            if (!countCalls(path.call, counted))
+            {
+                std::cerr << "Failed to count " << path.name << "\n";
+                return 1;
+            }
+            auto perCall = (std::max(counted, overhead) - overhead) /
+                           ITERATIONS;
+
+            if (print)
+            {
+                std::cout << prefix << path.name << " " << perCall << "\n";
+                continue;
+            }
+
+            std::cout << std::left << std::setw(NAME_WIDTH) << path.name
+                      << std::right << std::setw(NUMBER_WIDTH) << perCall
+                      << std::setw(NUMBER_WIDTH);
+            auto budget = budgets.find(prefix + path.name);
+            if (budget == budgets.end())
+            {
+                // A path without a budget is not guarded at all
+                std::cout << "-" << "  NO BUDGET\n";
+                failed = true;
+                continue;
+            }
+            std::cout << budget->second;
+            if (perCall * 100 > budget->second * (100 + tolerance))
+            {
+                std::cout << "  OVER BUDGET\n";
+                failed = true;
+            }
+            else if (perCall * 100 < budget->second * (100 - std::min(
+                         tolerance, 100u)))
+            {
+                // Not a failure, but the budget no longer guards the path
+                std::cout << "  under budget, lower it\n";
+            }
+            else
+            {
+                std::cout << "\n";
+            }
+        }
+        return failed ? 1 : 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,275 @@
+#include "pcap.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+namespace // anonymous
+{
+
+constexpr uint32_t MAGIC_USEC = 0xa1b2c3d4;
+constexpr uint32_t MAGIC_NSEC = 0xa1b23c4d;
+constexpr uint32_t LINKTYPE_DBUS = 231;
+constexpr uint32_t MAX_PACKET_SIZE = 128 * 1024 * 1024;
+
+constexpr uint32_t BLOCK_SECTION_HEADER = 0x0a0d0d0a;
+constexpr uint32_t BLOCK_INTERFACE_DESCRIPTION = 1;
+constexpr uint32_t BLOCK_ENHANCED_PACKET = 6;
+constexpr uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+constexpr uint16_t OPTION_END = 0;
+constexpr uint16_t OPTION_TSRESOL = 9;
+
+uint32_t swap32(uint32_t v)
+{
+    return ((v & 0xff) << 24) | ((v & 0xff00) << 8) |
+           ((v >> 8) & 0xff00) | (v >> 24);
+}
+
+bool readPcap(std::ifstream& fs,
+              std::vector<Packet>& packets,
+              std::string& error)
+{
+    struct
+    {
+        uint32_t magic;
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        int32_t thisZone;
+        uint32_t sigFigs;
+        uint32_t snapLen;
+        uint32_t linkType;
+    } header;
+    if (!fs.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        error = "Truncated pcap header";
+        return false;
+    }
+
+    bool swapped = header.magic != MAGIC_USEC && header.magic != MAGIC_NSEC;
+    auto get = [swapped](uint32_t v)
+    {
+        return swapped ? swap32(v) : v;
+    };
+    auto nsec = get(header.magic) == MAGIC_NSEC;
+    if (!nsec && get(header.magic) != MAGIC_USEC)
+    {
+        error = "Not a pcap file";
+        return false;
+    }
+    if (get(header.linkType) != LINKTYPE_DBUS)
+    {
+        error = "Not a D-Bus capture";
+        return false;
+    }
+
+    struct
+    {
+        uint32_t sec;
+        uint32_t fraction;
+        uint32_t inclLen;
+        uint32_t origLen;
+    } record;
+    while (fs.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        auto len = get(record.inclLen);
+        if (len > MAX_PACKET_SIZE)
+        {
+            error = "Invalid packet length";
+            return false;
+        }
+        Packet packet;
+        auto fraction = get(record.fraction);
+        packet.timestamp = std::chrono::seconds(get(record.sec)) +
+                           std::chrono::microseconds(nsec ? fraction / 1000
+                                                          : fraction);
+        packet.data.resize(len);
+        if (!fs.read(reinterpret_cast<char*>(packet.data.data()), len))
+        {
+            error = "Truncated packet";
+            return false;
+        }
+        // A packet cut by the snap length is not able to be replayed
+        if (get(record.origLen) == len)
+        {
+            packets.push_back(std::move(packet));
+        }
+    }
+    return true;
+}
+
+bool readPcapng(std::ifstream& fs,
+                std::vector<Packet>& packets,
+                std::string& error)
+{
+    bool swapped = false;
+    auto get = [&swapped](uint32_t v)
+    {
+        return swapped ? swap32(v) : v;
+    };
+    // The timestamp units per second of each interface
+    std::vector<uint64_t> resolutions;
+
+    uint32_t head[2];
+    while (fs.read(reinterpret_cast<char*>(head), sizeof(head)))
+    {
+        auto type = head[0];
+        uint32_t len = head[1];
+        std::vector<uint8_t> block;
+        if (type == BLOCK_SECTION_HEADER)
+        {
+            // The byte order of the section is given by its magic
+            uint32_t magic;
+            if (!fs.read(reinterpret_cast<char*>(&magic), sizeof(magic)))
+            {
+                break;
+            }
+            swapped = magic != BYTE_ORDER_MAGIC;
+            if (get(magic) != BYTE_ORDER_MAGIC)
+            {
+                error = "Not a pcapng file";
+                return false;
+            }
+            len = get(len);
+            if (len < 28 || len > MAX_PACKET_SIZE)
+            {
+                error = "Invalid block length";
+                return false;
+            }
+            resolutions.clear();
+            fs.seekg(len - 12, std::ios::cur);
+            continue;
+        }
+
+        type = get(type);
+        len = get(len);
+        if (len < 12 || len % 4 != 0 || len > MAX_PACKET_SIZE)
+        {
+            error = "Invalid block length";
+            return false;
+        }
+        block.resize(len - 12);
+        uint32_t trailer;
+        if (!fs.read(reinterpret_cast<char*>(block.data()), block.size()) ||
+            !fs.read(reinterpret_cast<char*>(&trailer), sizeof(trailer)))
+        {
+            error = "Truncated block";
+            return false;
+        }
+        auto word = [&block, &get](size_t offset)
+        {
+            uint32_t v;
+            std::memcpy(&v, block.data() + offset, sizeof(v));
+            return get(v);
+        };
+
+        if (type == BLOCK_INTERFACE_DESCRIPTION && block.size() >= 8)
+        {
+            uint16_t linkType;
+            std::memcpy(&linkType, block.data(), sizeof(linkType));
+            if (swapped)
+            {
+                linkType = (linkType << 8) | (linkType >> 8);
+            }
+            if (linkType != LINKTYPE_DBUS)
+            {
+                error = "Not a D-Bus capture";
+                return false;
+            }
+            // Look for if_tsresol in the options, microseconds by default
+            uint64_t resolution = 1000000;
+            for (size_t i = 8; i + 4 <= block.size();)
+            {
+                uint16_t code;
+                uint16_t size;
+                std::memcpy(&code, block.data() + i, sizeof(code));
+                std::memcpy(&size, block.data() + i + 2, sizeof(size));
+                if (swapped)
+                {
+                    code = (code << 8) | (code >> 8);
+                    size = (size << 8) | (size >> 8);
+                }
+                if (code == OPTION_END || i + 4 + size > block.size())
+                {
+                    break;
+                }
+                if (code == OPTION_TSRESOL && size == 1)
+                {
+                    auto value = block[i + 4];
+                    auto exponent = value & 0x7f;
+                    resolution = 1;
+                    for (auto e = 0; e < exponent && e < 18; ++e)
+                    {
+                        resolution *= (value & 0x80) ? 2 : 10;
+                    }
+                }
+                i += 4 + ((size + 3) & ~3u);
+            }
+            resolutions.push_back(resolution);
+        }
+        else if (type == BLOCK_ENHANCED_PACKET && block.size() >= 20)
+        {
+            auto interface = word(0);
+            uint64_t ts = (static_cast<uint64_t>(word(4)) << 32) | word(8);
+            auto capLen = word(12);
+            auto origLen = word(16);
+            if (interface >= resolutions.size() ||
+                capLen > block.size() - 20)
+            {
+                error = "Invalid packet block";
+                return false;
+            }
+            auto resolution = resolutions[interface];
+            Packet packet;
+            packet.timestamp = std::chrono::microseconds(
+                ts / resolution * 1000000 +
+                ts % resolution * 1000000 / resolution);
+            packet.data.assign(block.begin() + 20,
+                               block.begin() + 20 + capLen);
+            // A packet cut by the snap length is not able to be replayed
+            if (origLen == capLen)
+            {
+                packets.push_back(std::move(packet));
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace anonymous
+
+bool readCapture(const char* path,
+                 std::vector<Packet>& packets,
+                 std::string& error)
+{
+    std::ifstream fs(path, std::ios::binary);
+    if (!fs.is_open())
+    {
+        error = "Failed to open the capture";
+        return false;
+    }
+
+    // busctl writes pcap in older systemd, and pcapng in newer ones
+    uint32_t magic;
+    if (!fs.read(reinterpret_cast<char*>(&magic), sizeof(magic)))
+    {
+        error = "Empty capture";
+        return false;
+    }
+    fs.seekg(0);
+    packets.clear();
+    if (magic == BLOCK_SECTION_HEADER)
+    {
+        return readPcapng(fs, packets, error);
+    }
+    return readPcap(fs, packets, error);
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
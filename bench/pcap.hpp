@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @struct Packet
+ *  @brief A captured packet.
+ */
+struct Packet
+{
+    /** @brief The capture time */
+    std::chrono::microseconds timestamp;
+
+    /** @brief The captured bytes */
+    std::vector<uint8_t> data;
+};
+
+/** @brief Read the packets of a D-Bus capture, as written by busctl capture
+ *
+ * @param[in] path - The path of the pcap file
+ * @param[out] packets - The captured packets
+ * @param[out] error - The reason if it fails
+ *
+ * @return true if the file is a valid D-Bus capture
+ */
+bool readCapture(const char* path,
+                 std::vector<Packet>& packets,
+                 std::string& error);
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
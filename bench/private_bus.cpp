@@ -0,0 +1,83 @@
+#include "private_bus.hpp"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+PrivateBus::PrivateBus()
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        throw std::runtime_error(std::string("pipe: ") + strerror(errno));
+    }
+
+    pid = fork();
+    if (pid == -1)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error(std::string("fork: ") + strerror(errno));
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        auto printAddress = "--print-address=" + std::to_string(fds[1]);
+        execlp("dbus-daemon", "dbus-daemon", "--session", "--nofork",
+               "--nopidfile", printAddress.c_str(), nullptr);
+        _exit(127);
+    }
+    close(fds[1]);
+
+    // The daemon prints the address once it is listening
+    char c;
+    while (read(fds[0], &c, 1) == 1 && c != '\n')
+    {
+        busAddress.push_back(c);
+    }
+    close(fds[0]);
+    if (busAddress.empty())
+    {
+        throw std::runtime_error("Failed to start dbus-daemon");
+    }
+    use();
+}
+
+PrivateBus::PrivateBus(const std::string& address)
+    : busAddress(address)
+{
+    use();
+}
+
+PrivateBus::~PrivateBus()
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+void PrivateBus::use()
+{
+    // sd_bus_open() connects to the starter bus if it is set
+    setenv("DBUS_STARTER_BUS_TYPE", "system", 1);
+    setenv("DBUS_STARTER_ADDRESS", busAddress.c_str(), 1);
+    setenv("DBUS_SYSTEM_BUS_ADDRESS", busAddress.c_str(), 1);
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+
+#include <sys/types.h>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @class PrivateBus
+ *  @brief A private D-Bus daemon that the bench runs on.
+ *  @details The default bus of this process, as opened by
+ *  sdbusplus::bus::new_default(), is pointed to the private bus, so the
+ *  daemon code and the fake services connect to it unchanged.
+ */
+class PrivateBus
+{
+    public:
+        /** @brief Start a private dbus-daemon and use it */
+        PrivateBus();
+
+        /** @brief Use a running bus instead of starting one
+         *
+         * @param[in] address - The address of the bus
+         */
+        explicit PrivateBus(const std::string& address);
+
+        PrivateBus(const PrivateBus&) = delete;
+        PrivateBus& operator=(const PrivateBus&) = delete;
+        PrivateBus(PrivateBus&&) = delete;
+        PrivateBus& operator=(PrivateBus&&) = delete;
+
+        /** @brief Stop the started dbus-daemon */
+        ~PrivateBus();
+
+        /** @brief The address of the bus */
+        const std::string& address() const
+        {
+            return busAddress;
+        }
+
+    private:
+        /** @brief The address of the bus */
+        std::string busAddress;
+
+        /** @brief The pid of the started dbus-daemon */
+        pid_t pid = -1;
+
+        /** @brief Point the default bus to the address */
+        void use();
+};
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,236 @@
+/**
+ * Compare the latency of the time queries on DBus and on the query socket,
+ * served by the time manager objects on a private bus, and report the CPU
+ * time of the daemon per query.
+ *
+ *   query_latency [--count N] [--address ADDRESS]
+ */
+#include "config.h"
+#include "daemon_stack.hpp"
+#include "fake_services.hpp"
+#include "private_bus.hpp"
+#include "query_server.hpp"
+#include "stats.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::time;
+using namespace phosphor::time::bench;
+
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto EPOCH_INTERFACE = "xyz.openbmc_project.Time.EpochTime";
+constexpr auto SNAPSHOT_INTERFACE =
+    "xyz.openbmc_project.Time.Internal.Snapshot";
+constexpr auto PROPERTY_ELAPSED = "Elapsed";
+
+/** @brief The default number of queries of each kind */
+constexpr size_t DEFAULT_COUNT = 10000;
+
+/** @brief The number of queries of each kind before measuring */
+constexpr size_t WARMUP_COUNT = 100;
+
+constexpr size_t KIND_COUNT = 4;
+constexpr const char* KIND_NAMES[KIND_COUNT] = {
+    "DBus host Elapsed",
+    "DBus Snapshot",
+    "Socket host time",
+    "Socket Snapshot",
+};
+
+/** @class QueryClient
+ *  @brief A client of the query socket.
+ */
+class QueryClient
+{
+    public:
+        explicit QueryClient(const std::string& socketPath)
+        {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, socketPath.c_str(),
+                    sizeof(addr.sun_path) - 1);
+            fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (fd < 0 ||
+                connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                        sizeof(addr)) != 0)
+            {
+                throw std::runtime_error(std::string("connect: ") +
+                                         strerror(errno));
+            }
+        }
+        QueryClient(const QueryClient&) = delete;
+        QueryClient& operator=(const QueryClient&) = delete;
+        ~QueryClient()
+        {
+            close(fd);
+        }
+
+        bool query(query::Op op)
+        {
+            query::Request request{query::PROTOCOL_VERSION, op, 0, ++id};
+            query::Response response;
+            return send(fd, &request, sizeof(request), 0) ==
+                       sizeof(request) &&
+                   recv(fd, &response, sizeof(response), 0) ==
+                       sizeof(response) &&
+                   response.status == 0 &&
+                   response.id == id;
+        }
+
+    private:
+        int fd = -1;
+        uint64_t id = 0;
+};
+
+bool dbusHostTime(sdbusplus::bus::bus& bus)
+{
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_call_method(bus.get(), BUSNAME, OBJPATH_HOST,
+                                PROPERTIES_INTERFACE, "Get", &error, &reply,
+                                "ss", EPOCH_INTERFACE, PROPERTY_ELAPSED);
+    uint64_t elapsed;
+    if (r >= 0)
+    {
+        r = sd_bus_message_read(reply, "v", "t", &elapsed);
+    }
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return r >= 0;
+}
+
+bool dbusSnapshot(sdbusplus::bus::bus& bus)
+{
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_call_method(bus.get(), BUSNAME, OBJPATH_TIME,
+                                SNAPSHOT_INTERFACE, "Get", &error, &reply,
+                                "");
+    const char* mode;
+    const char* owner;
+    int64_t offset;
+    uint64_t bmcTime;
+    uint64_t hostTime;
+    if (r >= 0)
+    {
+        r = sd_bus_message_read(reply, "ssxtt", &mode, &owner, &offset,
+                                &bmcTime, &hostTime);
+    }
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return r >= 0;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--count N] [--address ADDRESS]\n"
+              << "  --count    The number of queries of each kind\n"
+              << "  --address  Use a running bus instead of a private one\n";
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[])
+{
+    size_t count = DEFAULT_COUNT;
+    const char* address = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--address") == 0 && i + 1 < argc)
+        {
+            address = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char dir[] = "/tmp/query_latencyXXXXXX";
+    if (!mkdtemp(dir))
+    {
+        std::cerr << "mkdtemp: " << strerror(errno) << "\n";
+        return 1;
+    }
+    auto socketPath = std::string(dir) + "/query.sock";
+
+    int rc = 0;
+    try
+    {
+        auto privateBus = address ? std::make_unique<PrivateBus>(address)
+                                  : std::make_unique<PrivateBus>();
+        FakeServices services(FakeServices::Settings{});
+        DaemonStack stack(socketPath.c_str());
+        auto cpuClock = stack.cpuClock();
+        auto bus = sdbusplus::bus::new_default();
+        QueryClient client(socketPath);
+
+        std::array<std::function<bool()>, KIND_COUNT> queries = {
+            [&bus]() { return dbusHostTime(bus); },
+            [&bus]() { return dbusSnapshot(bus); },
+            [&client]() { return client.query(query::Op::GetHostTime); },
+            [&client]() { return client.query(query::Op::Snapshot); },
+        };
+
+        std::array<LatencyStats, KIND_COUNT> stats;
+        for (size_t k = 0; k < KIND_COUNT; ++k)
+        {
+            for (size_t i = 0; i < WARMUP_COUNT; ++i)
+            {
+                queries[k]();
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto cpu = cpuTime(cpuClock);
+                auto sent = steady_clock::now();
+                auto ok = queries[k]();
+                auto latency = steady_clock::now() - sent;
+                stats[k].add(latency, cpuTime(cpuClock) - cpu, !ok);
+            }
+        }
+
+        std::cout << count << " queries of each kind, "
+                  << "latency and CPU/query in us\n";
+        LatencyStats::printHeader(std::cout);
+        for (size_t k = 0; k < KIND_COUNT; ++k)
+        {
+            stats[k].print(std::cout, KIND_NAMES[k]);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        rc = 1;
+    }
+    unlink(socketPath.c_str());
+    rmdir(dir);
+    return rc;
+}
@@ -0,0 +1,309 @@
+/**
+ * Replay a busctl capture of time manager traffic against the time manager
+ * objects on a private bus, and report the latency and the CPU time of the
+ * daemon per kind of message.
+ *
+ *   busctl capture > capture.pcap
+ *   replay [--fast] [--address ADDRESS] capture.pcap
+ */
+#include "config.h"
+#include "daemon_stack.hpp"
+#include "dbus_wire.hpp"
+#include "fake_services.hpp"
+#include "pcap.hpp"
+#include "private_bus.hpp"
+#include "settings.hpp"
+#include "stats.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::time::bench;
+
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto PEER_INTERFACE = "org.freedesktop.DBus.Peer";
+constexpr auto PROPERTY_ELAPSED = "Elapsed";
+
+enum class Kind
+{
+    GetElapsed,
+    SetElapsed,
+    OtherCall,
+    SettingChanged,
+    HostStateChanged,
+};
+constexpr size_t KIND_COUNT = 5;
+constexpr const char* KIND_NAMES[KIND_COUNT] = {
+    "Get Elapsed",
+    "Set Elapsed",
+    "Other call",
+    "Setting changed",
+    "Host state changed",
+};
+
+struct Replayed
+{
+    Kind kind;
+    microseconds timestamp;
+    Message msg;
+};
+
+bool isTimeManagerPath(const std::string& path)
+{
+    return path == OBJPATH_BMC || path == OBJPATH_HOST || path == OBJPATH_TIME;
+}
+
+/** @brief Select the messages that the time manager receives */
+bool select(Message& msg, Kind& kind)
+{
+    auto firstArg = [&msg](size_t i) -> const std::string&
+    {
+        static const std::string none;
+        return msg.body.size() > i ? msg.body[i].str : none;
+    };
+
+    if (msg.type == SD_BUS_MESSAGE_METHOD_CALL)
+    {
+        if (msg.destination != BUSNAME && !isTimeManagerPath(msg.path))
+        {
+            return false;
+        }
+        kind = Kind::OtherCall;
+        if (msg.interface == PROPERTIES_INTERFACE &&
+            firstArg(1) == PROPERTY_ELAPSED)
+        {
+            if (msg.member == "Get")
+            {
+                kind = Kind::GetElapsed;
+            }
+            else if (msg.member == "Set")
+            {
+                kind = Kind::SetElapsed;
+            }
+        }
+        return true;
+    }
+
+    if (msg.type == SD_BUS_MESSAGE_SIGNAL &&
+        msg.interface == PROPERTIES_INTERFACE &&
+        msg.member == "PropertiesChanged")
+    {
+        // The objects may be on other paths in the capture,
+        // send the signals from the paths of the fake services
+        const auto& interface = firstArg(0);
+        if (interface == settings::timeOwnerIntf)
+        {
+            msg.path = TIME_OWNER_PATH;
+            kind = Kind::SettingChanged;
+            return true;
+        }
+        if (interface == settings::timeSyncIntf)
+        {
+            msg.path = TIME_SYNC_METHOD_PATH;
+            kind = Kind::SettingChanged;
+            return true;
+        }
+        if (interface == settings::hostStateIntf)
+        {
+            msg.path = HOST_STATE_PATH;
+            kind = Kind::HostStateChanged;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Send a message and wait until the daemon processes it
+ *
+ * @return true if the daemon replies without error
+ */
+bool replay(sdbusplus::bus::bus& bus, const Replayed& replayed)
+{
+    const auto& msg = replayed.msg;
+    sd_bus_message* m = nullptr;
+    int r;
+    if (replayed.kind == Kind::SettingChanged ||
+        replayed.kind == Kind::HostStateChanged)
+    {
+        r = sd_bus_message_new_signal(bus.get(), &m, msg.path.c_str(),
+                                      msg.interface.c_str(),
+                                      msg.member.c_str());
+    }
+    else
+    {
+        r = sd_bus_message_new_method_call(bus.get(), &m, BUSNAME,
+                                           msg.path.c_str(),
+                                           msg.interface.c_str(),
+                                           msg.member.c_str());
+    }
+    if (r >= 0)
+    {
+        r = append(m, msg.body);
+    }
+    if (r < 0)
+    {
+        sd_bus_message_unref(m);
+        return false;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    if (replayed.kind == Kind::SettingChanged ||
+        replayed.kind == Kind::HostStateChanged)
+    {
+        // A signal has no reply, the daemon has processed it once it
+        // replies a ping sent after it on the same connection
+        r = sd_bus_send(bus.get(), m, nullptr);
+        sd_bus_message_unref(m);
+        m = nullptr;
+        if (r >= 0)
+        {
+            r = sd_bus_message_new_method_call(bus.get(), &m, BUSNAME,
+                                               OBJPATH_BMC, PEER_INTERFACE,
+                                               "Ping");
+        }
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_call(bus.get(), m, 0, &error, nullptr);
+    }
+    sd_bus_message_unref(m);
+    sd_bus_error_free(&error);
+    return r >= 0;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name
+              << " [--fast] [--address ADDRESS] capture.pcap\n"
+              << "  --fast     Replay as fast as possible instead of 1x\n"
+              << "  --address  Use a running bus instead of a private one\n";
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[])
+{
+    bool fast = false;
+    const char* address = nullptr;
+    const char* capture = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--fast") == 0)
+        {
+            fast = true;
+        }
+        else if (strcmp(argv[i], "--address") == 0 && i + 1 < argc)
+        {
+            address = argv[++i];
+        }
+        else if (!capture && argv[i][0] != '-')
+        {
+            capture = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!capture)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Packet> packets;
+    std::string error;
+    if (!readCapture(capture, packets, error))
+    {
+        std::cerr << capture << ": " << error << "\n";
+        return 1;
+    }
+    std::vector<Replayed> messages;
+    size_t invalid = 0;
+    for (const auto& packet : packets)
+    {
+        Replayed replayed;
+        if (!decode(packet.data.data(), packet.data.size(), replayed.msg))
+        {
+            ++invalid;
+            continue;
+        }
+        if (select(replayed.msg, replayed.kind))
+        {
+            replayed.timestamp = packet.timestamp;
+            messages.push_back(std::move(replayed));
+        }
+    }
+    std::cout << packets.size() << " packets, " << messages.size()
+              << " to replay, " << invalid << " not decoded\n";
+    if (messages.empty())
+    {
+        return 0;
+    }
+
+    try
+    {
+        auto privateBus = address ? std::make_unique<PrivateBus>(address)
+                                  : std::make_unique<PrivateBus>();
+        FakeServices services(FakeServices::Settings{});
+        DaemonStack stack;
+        auto cpuClock = stack.cpuClock();
+        auto bus = sdbusplus::bus::new_default();
+
+        std::array<LatencyStats, KIND_COUNT> stats;
+        auto start = steady_clock::now();
+        auto cpuStart = cpuTime(cpuClock);
+        auto firstTimestamp = messages.front().timestamp;
+        for (const auto& replayed : messages)
+        {
+            if (!fast)
+            {
+                std::this_thread::sleep_until(
+                    start + (replayed.timestamp - firstTimestamp));
+            }
+            auto cpu = cpuTime(cpuClock);
+            auto sent = steady_clock::now();
+            auto ok = ::replay(bus, replayed);
+            auto latency = steady_clock::now() - sent;
+            stats[static_cast<size_t>(replayed.kind)].add(
+                latency, cpuTime(cpuClock) - cpu, !ok);
+        }
+        auto elapsed = steady_clock::now() - start;
+        auto cpuTotal = cpuTime(cpuClock) - cpuStart;
+
+        std::cout << "Replayed in "
+                  << duration_cast<milliseconds>(elapsed).count()
+                  << " ms, daemon CPU "
+                  << duration_cast<microseconds>(cpuTotal).count()
+                  << " us, latency and CPU/msg in us\n";
+        LatencyStats::printHeader(std::cout);
+        for (size_t i = 0; i < KIND_COUNT; ++i)
+        {
+            if (stats[i].count() != 0)
+            {
+                stats[i].print(std::cout, KIND_NAMES[i]);
+            }
+        }
+        std::cout << "timedated SetTime " << services.setTimeCalls()
+                  << ", SetNTP " << services.setNtpCalls() << "\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Replay failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * Restart the fake settings service under the time manager, on a private
+ * bus, and check that the manager follows it: with the settings changed
+ * while the service is down, at the same paths and at a moved path, and
+ * that the settings changed after the move are still watched.
+ *
+ * It exits with 77, the automake skip, if dbus-daemon cannot be started.
+ *
+ *   service_restart
+ */
+#include "fake_services.hpp"
+#include "manager.hpp"
+#include "private_bus.hpp"
+#include "time_state_change.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::time;
+using namespace phosphor::time::bench;
+
+/** @brief The exit code that automake takes as a skipped test */
+constexpr int EXIT_SKIP = 77;
+
+/** @brief The max time to wait for the manager to follow a change */
+constexpr auto WAIT_TIMEOUT = seconds(5);
+
+/** @brief The time owner setting at another path after a restart */
+constexpr auto MOVED_OWNER_PATH = "/xyz/openbmc_project/time/owner_moved";
+
+/** @brief Run the event loop until a condition holds, or it times out
+ *
+ * @param[in] event - The event loop of the manager
+ * @param[in] condition - The condition to wait for
+ *
+ * @return true if the condition holds
+ */
+bool waitFor(sd_event* event, std::function<bool()> condition)
+{
+    auto deadline = steady_clock::now() + WAIT_TIMEOUT;
+    while (!condition())
+    {
+        if (steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        sd_event_run(event, duration_cast<microseconds>(
+                                milliseconds(100)).count());
+    }
+    return true;
+}
+
+/** @brief Report a step of the check
+ *
+ * @param[in] name - The name of the step
+ * @param[in] ok - Indicate if it passes
+ *
+ * @return ok
+ */
+bool report(const char* name, bool ok)
+{
+    std::cout << (ok ? "PASS: " : "FAIL: ") << name << "\n";
+    return ok;
+}
+
+} // namespace anonymous
+
+int main()
+{
+    std::unique_ptr<PrivateBus> privateBus;
+    try
+    {
+        privateBus = std::make_unique<PrivateBus>();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Skipped: " << e.what() << "\n";
+        return EXIT_SKIP;
+    }
+
+    char dir[] = "/tmp/service_restartXXXXXX";
+    if (!mkdtemp(dir))
+    {
+        std::cerr << "mkdtemp: " << strerror(errno) << "\n";
+        return 1;
+    }
+    auto modeFile = std::string(dir) + "/mode";
+    auto ownerFile = std::string(dir) + "/owner";
+
+    bool ok = true;
+    try
+    {
+        FakeServices::Settings settings;
+        settings.mode = Mode::Manual;
+        settings.owner = Owner::Both;
+        FakeServices services(settings);
+
+        sd_event* event = nullptr;
+        sd_event_new(&event);
+        auto bus = sdbusplus::bus::new_default();
+        bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+        {
+            Manager manager(bus, modeFile.c_str(), ownerFile.c_str());
+            Mode mode = Mode::Manual;
+            Owner owner = Owner::Both;
+            auto subscription = manager.subscribe(
+                [&mode, &owner](const TimeStateChange& change)
+                {
+                    mode = change.mode;
+                    owner = change.owner;
+                });
+            auto is = [&mode, &owner](Mode m, Owner o)
+            {
+                return [&mode, &owner, m, o]()
+                {
+                    return mode == m && owner == o;
+                };
+            };
+
+            // The settings are read again from the same paths
+            settings.mode = Mode::NTP;
+            settings.owner = Owner::Split;
+            services.restartSettings(settings);
+            ok &= report("restart at the same paths",
+                         waitFor(event, is(Mode::NTP, Owner::Split)));
+
+            // The moved setting is discovered again, and read from there
+            settings.owner = Owner::Host;
+            settings.ownerPath = MOVED_OWNER_PATH;
+            services.restartSettings(settings);
+            ok &= report("restart at a moved path",
+                         waitFor(event, is(Mode::NTP, Owner::Host)));
+
+            // The matches follow the moved setting
+            services.setOwner(Owner::BMC);
+            ok &= report("change at the moved path",
+                         waitFor(event, is(Mode::NTP, Owner::BMC)));
+        }
+        bus.detach_event();
+        sd_event_unref(event);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Check failed: " << e.what() << "\n";
+        ok = false;
+    }
+
+    unlink(modeFile.c_str());
+    unlink(ownerFile.c_str());
+    rmdir(dir);
+    return ok ? 0 : 1;
+}
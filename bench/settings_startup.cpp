@@ -0,0 +1,185 @@
+/**
+ * Compare the settings lookups of the time manager startup on one shared
+ * connection against a new connection per call, against the fake services
+ * on a private bus, and report the CPU time of the caller per startup.
+ *
+ *   settings_startup [--count N] [--address ADDRESS]
+ */
+#include "fake_services.hpp"
+#include "private_bus.hpp"
+#include "settings.hpp"
+#include "stats.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <stdlib.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::time::bench;
+
+/** @brief The default number of startups of each kind */
+constexpr size_t DEFAULT_COUNT = 1000;
+
+/** @brief The number of startups of each kind before measuring */
+constexpr size_t WARMUP_COUNT = 10;
+
+constexpr size_t KIND_COUNT = 2;
+constexpr const char* KIND_NAMES[KIND_COUNT] = {
+    "Shared connection",
+    "Connection per call",
+};
+
+/** @brief Make a call on the shared bus, or on a new connection that is
+ *  closed after the call, as settings::Objects did before it took the bus
+ *  @details The new connection is opened by new_system(), which points
+ *  to the private bus as well. new_default() would return the default
+ *  connection of the thread, which is the shared one.
+ *
+ * @param[in] shared - The shared bus, or nullptr to open a new connection
+ * @param[in] call - The call to make
+ */
+template <typename Call>
+void withBus(sdbusplus::bus::bus* shared, Call call)
+{
+    if (shared)
+    {
+        call(*shared);
+        return;
+    }
+    auto bus = sdbusplus::bus::new_system();
+    call(bus);
+}
+
+/** @brief Look the settings up as the time manager does on startup: the
+ *  discovery, and the mapper lookup of the service of each object
+ *
+ * @param[in] shared - The shared bus, or nullptr to open a connection per
+ *                     call
+ *
+ * @return true if all the lookups succeed
+ */
+bool startup(sdbusplus::bus::bus* shared)
+{
+    try
+    {
+        settings::Path timeOwner;
+        settings::Path timeSyncMethod;
+        settings::Path hostState;
+        withBus(shared, [&](sdbusplus::bus::bus& bus)
+        {
+            settings::Objects objects(bus);
+            timeOwner = objects.timeOwner;
+            timeSyncMethod = objects.timeSyncMethod;
+            hostState = objects.hostState;
+        });
+
+        const std::array<std::pair<settings::Path, settings::Interface>, 3>
+            lookups = {{
+                {timeOwner, settings::timeOwnerIntf},
+                {timeSyncMethod, settings::timeSyncIntf},
+                {hostState, settings::hostStateIntf},
+            }};
+        for (const auto& lookup : lookups)
+        {
+            withBus(shared, [&](sdbusplus::bus::bus& bus)
+            {
+                // Without the discovered services, so the mapper is called
+                settings::Objects objects(bus, timeOwner, timeSyncMethod,
+                                          hostState, {});
+                objects.service(lookup.first, lookup.second);
+            });
+        }
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [--count N] [--address ADDRESS]\n"
+              << "  --count    The number of startups of each kind\n"
+              << "  --address  Use a running bus instead of a private one\n";
+}
+
+} // namespace anonymous
+
+int main(int argc, char* argv[])
+{
+    size_t count = DEFAULT_COUNT;
+    const char* address = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--address") == 0 && i + 1 < argc)
+        {
+            address = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto privateBus = address ? std::make_unique<PrivateBus>(address)
+                                  : std::make_unique<PrivateBus>();
+        FakeServices services(FakeServices::Settings{});
+        auto bus = sdbusplus::bus::new_default();
+        std::array<sdbusplus::bus::bus*, KIND_COUNT> kinds = {&bus, nullptr};
+
+        std::array<LatencyStats, KIND_COUNT> stats;
+        for (size_t k = 0; k < KIND_COUNT; ++k)
+        {
+            for (size_t i = 0; i < WARMUP_COUNT; ++i)
+            {
+                startup(kinds[k]);
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto cpu = cpuTime(CLOCK_THREAD_CPUTIME_ID);
+                auto start = steady_clock::now();
+                auto ok = startup(kinds[k]);
+                auto latency = steady_clock::now() - start;
+                stats[k].add(latency, cpuTime(CLOCK_THREAD_CPUTIME_ID) - cpu,
+                             !ok);
+            }
+        }
+
+        std::cout << count << " startups of each kind, "
+                  << "latency and CPU/startup in us\n";
+        LatencyStats::printHeader(std::cout);
+        for (size_t k = 0; k < KIND_COUNT; ++k)
+        {
+            stats[k].print(std::cout, KIND_NAMES[k]);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "stats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+using namespace std::chrono;
+
+namespace // anonymous
+{
+
+constexpr auto NAME_WIDTH = 20;
+constexpr auto NUMBER_WIDTH = 10;
+
+double toUsec(const nanoseconds& ns)
+{
+    return duration_cast<duration<double, std::micro>>(ns).count();
+}
+
+} // namespace anonymous
+
+nanoseconds cpuTime(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+}
+
+void LatencyStats::add(const nanoseconds& latency,
+                       const nanoseconds& cpu,
+                       bool failed)
+{
+    latencies.push_back(latency);
+    cpuTime += cpu;
+    if (failed)
+    {
+        ++errors;
+    }
+}
+
+void LatencyStats::printHeader(std::ostream& os)
+{
+    os << std::left << std::setw(NAME_WIDTH) << "Message" << std::right;
+    for (auto column : {"Count", "Errors", "Min", "P50", "P90", "P99",
+                        "Max", "CPU/msg"})
+    {
+        os << std::setw(NUMBER_WIDTH) << column;
+    }
+    os << "\n";
+}
+
+void LatencyStats::print(std::ostream& os, const std::string& name)
+{
+    os << std::left << std::setw(NAME_WIDTH) << name << std::right
+       << std::setw(NUMBER_WIDTH) << latencies.size()
+       << std::setw(NUMBER_WIDTH) << errors;
+    if (latencies.empty())
+    {
+        os << "\n";
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [this](size_t p)
+    {
+        auto i = (latencies.size() - 1) * p / 100;
+        return toUsec(latencies[i]);
+    };
+    os << std::fixed << std::setprecision(1)
+       << std::setw(NUMBER_WIDTH) << toUsec(latencies.front())
+       << std::setw(NUMBER_WIDTH) << percentile(50)
+       << std::setw(NUMBER_WIDTH) << percentile(90)
+       << std::setw(NUMBER_WIDTH) << percentile(99)
+       << std::setw(NUMBER_WIDTH) << toUsec(latencies.back())
+       << std::setw(NUMBER_WIDTH) << toUsec(cpuTime) / latencies.size()
+       << "\n";
+}
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+namespace phosphor
+{
+namespace time
+{
+namespace bench
+{
+
+/** @class LatencyStats
+ *  @brief The latency distribution and CPU time of a kind of message.
+ */
+class LatencyStats
+{
+    public:
+        /** @brief Add a sample
+         *
+         * @param[in] latency - The latency of the message
+         * @param[in] cpu - The CPU time spent by the daemon on the message
+         * @param[in] failed - Indicate if the message got an error
+         */
+        void add(const std::chrono::nanoseconds& latency,
+                 const std::chrono::nanoseconds& cpu,
+                 bool failed);
+
+        /** @brief The number of samples */
+        size_t count() const
+        {
+            return latencies.size();
+        }
+
+        /** @brief Print the header of the rows */
+        static void printHeader(std::ostream& os);
+
+        /** @brief Print a row of the stats
+         *
+         * @param[in] os - The stream to print to
+         * @param[in] name - The name of the kind of message
+         */
+        void print(std::ostream& os, const std::string& name);
+
+    private:
+        /** @brief The latencies of the samples */
+        std::vector<std::chrono::nanoseconds> latencies;
+
+        /** @brief The total CPU time of the samples */
+        std::chrono::nanoseconds cpuTime{0};
+
+        /** @brief The number of samples that got an error */
+        size_t errors = 0;
+};
+
+/** @brief Get the CPU time of a clock
+ *
+ * @param[in] clock - The CPU time clock, e.g. of a thread
+ *
+ * @return The CPU time spent so far
+ */
+std::chrono::nanoseconds cpuTime(clockid_t clock);
+
+} // namespace bench
+} // namespace time
+} // namespace phosphor
@@ -1,4 +1,5 @@
 #include "bmc_epoch.hpp"
+#include "wakeup_audit.hpp"
 
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -25,11 +26,26 @@ namespace time
 namespace server = sdbusplus::xyz::openbmc_project::Time::server;
 using namespace phosphor::logging;
 
+namespace // anonymous
+{
+
+/** @brief The min step of BMC time to notify on time change, a smaller
+ *  one is the error of reading the clocks, e.g. after a set by elapsed()
+ *  that is notified already
+ */
+constexpr microseconds JUMP_TOLERANCE{1000};
+
+} // namespace anonymous
+
 BmcEpoch::BmcEpoch(sdbusplus::bus::bus& bus,
-                   const char* objPath)
-    : EpochBase(bus, objPath),
+                   const char* objPath,
+                   SystemClock* systemClock)
+    : EpochBase(bus, objPath, systemClock),
       bus(bus)
 {
+    auto steadyTime = getSteadyTime();
+    diffToSteadyClock = getTime() - steadyTime;
+
     initialize();
 }
 
@@ -45,7 +61,8 @@ void BmcEpoch::initialize()
         {TIME_T_MAX, 0}, //it_value
     };
 
-    timeFd = timerfd_create(CLOCK_REALTIME, 0);
+    // Non blocking, so that draining it never blocks the event loop
+    timeFd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
     if (timeFd == -1)
     {
         log<level::ERR>("Failed to create timerfd",
@@ -87,52 +104,78 @@ BmcEpoch::~BmcEpoch()
 uint64_t BmcEpoch::elapsed() const
 {
     // It does not needs to check owner when getting time
-    return getTime().count();
+    return readTime().count();
 }
 
 uint64_t BmcEpoch::elapsed(uint64_t value)
 {
-    /*
-        Mode  | Owner | Set BMC Time
-        ----- | ----- | -------------
-        NTP   | BMC   | Fail to set
-        NTP   | HOST  | Not allowed
-        NTP   | SPLIT | Fail to set
-        NTP   | BOTH  | Fail to set
-        MANUAL| BMC   | OK
-        MANUAL| HOST  | Not allowed
-        MANUAL| SPLIT | OK
-        MANUAL| BOTH  | OK
-    */
-    if (timeOwner == Owner::Host)
-    {
-        log<level::ERR>("Setting BmcTime with HOST owner is not allowed");
-        // TODO: throw NotAllowed exception
-        return 0;
-    }
+    // Stamp the request before anything else delays it
+    setElapsed(value, getReceivedTime(), nullptr);
+    return value;
+}
+
+void BmcEpoch::setElapsed(uint64_t value, const microseconds& received,
+                          SetDone done)
+{
+    // Raise NotAllowed if setting BMC time is not allowed,
+    // otherwise the only action is to set the system time
+    getSetAction(Clock::BMC);
 
     auto time = microseconds(value);
-    if (setTime(time))
+    if (pipeline)
     {
-        notifyBmcTimeChange(time);
+        // The time may be replaced by a later set before it is set, so
+        // the change is checked against the clock when it is done, and the
+        // property is the time that is set at last
+        pipeline->submit(time, received,
+                         [this, done](bool ok, const microseconds& set)
+                         {
+                             if (ok)
+                             {
+                                 checkTimeJump();
+                                 server::EpochTime::elapsed(set.count());
+                             }
+                             if (done)
+                             {
+                                 done(ok);
+                             }
+                         });
+        return;
     }
 
+    auto ok = setRequestedTime(time, received);
+    if (ok)
+    {
+        // A compensated time is ahead of the requested one by now
+        notifyBmcTimeChange(latency ? getTime() : time);
+    }
     server::EpochTime::elapsed(value);
-    return value;
+    if (done)
+    {
+        done(ok);
+    }
 }
 
-void BmcEpoch::setBmcTimeChangeListener(BmcTimeChangeListener* listener)
+TimeStateDispatcher::Subscription BmcEpoch::subscribe(
+    TimeStateDispatcher::Handler handler)
 {
-    timeChangeListener = listener;
+    return dispatcher.subscribe(std::move(handler));
 }
 
 void BmcEpoch::notifyBmcTimeChange(const microseconds& time)
 {
-    // Notify listener if it exists
-    if (timeChangeListener)
-    {
-        timeChangeListener->onBmcTimeChanged(time);
-    }
+    auto steadyTime = getSteadyTime();
+    auto diff = time - steadyTime;
+
+    TimeStateChange change;
+    change.changed = TimeStateChange::BmcTimeJumped;
+    change.mode = timeMode;
+    change.owner = timeOwner;
+    change.bmcTime = time;
+    change.jump = diff - diffToSteadyClock;
+    diffToSteadyClock = diff;
+
+    dispatcher.dispatch(change);
 }
 
 int BmcEpoch::onTimeChange(sd_event_source* es, int fd,
@@ -143,15 +186,45 @@ int BmcEpoch::onTimeChange(sd_event_source* es, int fd,
     std::array<char, 64> time {};
 
     // We are not interested in the data here.
-    // So read until there is no new data here in the FD
-    while (read(fd, time.data(), time.max_size()) > 0);
+    // So read until there is no new data here in the FD, the time is
+    // set only if a read is canceled
+    bool canceled = false;
+    while (true)
+    {
+        auto r = read(fd, time.data(), time.max_size());
+        if (r < 0 && errno == ECANCELED)
+        {
+            canceled = true;
+        }
+        else if (r <= 0)
+        {
+            break;
+        }
+    }
 
-    log<level::INFO>("BMC system time is changed");
-    bmcEpoch->notifyBmcTimeChange(bmcEpoch->getTime());
+    bool jumped = canceled && bmcEpoch->checkTimeJump();
+    wakeup::count(wakeup::Source::BmcTimeChange, jumped);
 
     return 0;
 }
 
+bool BmcEpoch::checkTimeJump()
+{
+    // The time set by elapsed() is notified already, only notify it
+    // here if the time is set by others
+    auto now = getTime();
+    auto steadyTime = getSteadyTime();
+    auto jump = now - steadyTime - diffToSteadyClock;
+    if (jump < JUMP_TOLERANCE && jump > -JUMP_TOLERANCE)
+    {
+        return false;
+    }
+
+    log<level::INFO>("BMC system time is changed");
+    notifyBmcTimeChange(now);
+    return true;
+}
+
 } // namespace time
 } // namespace phosphor
 
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "bmc_time_change_listener.hpp"
 #include "epoch_base.hpp"
+#include "time_state_change.hpp"
 
 #include <chrono>
 
@@ -21,8 +21,19 @@ class BmcEpoch : public EpochBase
 {
     public:
         friend class TestBmcEpoch;
+        friend class Simulation;
+        friend class HotPaths;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] systemClock - The clocks to read and set, or nullptr
+         *                          for the real ones
+         */
         BmcEpoch(sdbusplus::bus::bus& bus,
-                 const char* objPath);
+                 const char* objPath,
+                 SystemClock* systemClock = nullptr);
         ~BmcEpoch();
 
         /**
@@ -40,11 +51,19 @@ class BmcEpoch : public EpochBase
          **/
         uint64_t elapsed(uint64_t value) override;
 
-        /** @brief Set the listner for bmc time change
+        /** @brief Subscribe to bmc time change
          *
-         * @param[in] listener - The pointer to the listener
+         * @param[in] handler - The function called when bmc time is changed
+         *
+         * @return The subscription that keeps the handler subscribed
          */
-        void setBmcTimeChangeListener(BmcTimeChangeListener* listener);
+        TimeStateDispatcher::Subscription subscribe(
+            TimeStateDispatcher::Handler handler);
+
+    protected:
+        /** @brief Apply an Elapsed set of the BMC time */
+        void setElapsed(uint64_t value, const microseconds& received,
+                        SetDone done) override;
 
     private:
         /** @brief The fd for time change event */
@@ -53,12 +72,23 @@ class BmcEpoch : public EpochBase
         /** @brief Initialize timerFd related resource */
         void initialize();
 
-        /** @brief Notify the listeners that bmc time is changed
+        /** @brief The diff between BMC time and steady clock
+         *  @details It is used to calculate how far BMC time steps.
+         */
+        microseconds diffToSteadyClock;
+
+        /** @brief Notify the subscribers that bmc time is changed
          *
          * @param[in] time - The epoch time in microseconds to notify
          */
         void notifyBmcTimeChange(const microseconds& time);
 
+        /** @brief Notify the subscribers if BMC time steps
+         *
+         * @return true if BMC time steps and it is notified
+         */
+        bool checkTimeJump();
+
         /** @brief The callback function on system time change
          *
          * @param[in] es - Source of the event
@@ -86,8 +116,8 @@ class BmcEpoch : public EpochBase
         /** @brief The event source on system time change */
         SdEventSource timeChangeEventSource {nullptr, sdEventSourceDeleter};
 
-        /** @brief The listener for bmc time change */
-        BmcTimeChangeListener* timeChangeListener = nullptr;
+        /** @brief The dispatcher of bmc time change */
+        TimeStateDispatcher dispatcher;
 };
 
 } // namespace time
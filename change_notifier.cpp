@@ -0,0 +1,185 @@
+#include "change_notifier.hpp"
+
+#include "config.h"
+
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <cstring>
+
+namespace // anonymous
+{
+constexpr auto NOTIFICATION_INTERFACE =
+    "xyz.openbmc_project.Time.Internal.ChangeNotification";
+constexpr auto SIGNAL_TIME_CHANGED = "TimeChanged";
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using ChangeNotification =
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::
+        ChangeNotification;
+
+ChangeNotifier::ChangeNotifier(sdbusplus::bus::bus& bus,
+                               const char* objPath,
+                               ClientTracker& tracker)
+    : sdbusplus::server::object::object<ChangeNotification>(bus, objPath),
+      bus(bus),
+      objPath(objPath),
+      clients(tracker),
+      user(tracker.addUser(
+          [this](const std::string& client)
+          {
+              subscriptions.removeClient(client);
+          }))
+{
+}
+
+uint64_t ChangeNotifier::subscribe(uint64_t threshold)
+{
+    auto client = getCaller();
+    auto id = subscriptions.add(client, microseconds(threshold));
+    clients.add(user, client);
+    return id;
+}
+
+void ChangeNotifier::unsubscribe(uint64_t id)
+{
+    auto client = getCaller();
+    if (!subscriptions.remove(client, id))
+    {
+        using InvalidArgumentError =
+            sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+        using namespace xyz::openbmc_project::Common;
+        elog<InvalidArgumentError>(
+            InvalidArgument::ARGUMENT_NAME("Id"),
+            InvalidArgument::ARGUMENT_VALUE(std::to_string(id).c_str()));
+        return;
+    }
+    if (subscriptions.count(client) == 0)
+    {
+        clients.remove(user, client);
+    }
+}
+
+void ChangeNotifier::onBmcTimeChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::BmcTimeJumped))
+    {
+        notify(OBJPATH_BMC, change.jump);
+    }
+}
+
+void ChangeNotifier::onHostOffsetChanged(const TimeStateChange& change)
+{
+    if (!change.has(TimeStateChange::OffsetChanged))
+    {
+        return;
+    }
+    auto delta = change.offset - lastOffset;
+    auto known = offsetKnown;
+    lastOffset = change.offset;
+    offsetKnown = true;
+    if (known)
+    {
+        notify(OBJPATH_HOST, delta);
+    }
+}
+
+void ChangeNotifier::save(HandoffState& saved) const
+{
+    saved.subscriptions.clear();
+    subscriptions.forEach(
+        [&saved](ThresholdSubscriptions::Id id,
+                 const std::string& client,
+                 const microseconds& threshold)
+        {
+            saved.subscriptions.push_back({id, client, threshold});
+        });
+    saved.nextSubscriptionId = subscriptions.getNextId();
+}
+
+void ChangeNotifier::restore(const HandoffState& handed)
+{
+    subscriptions.forEach(
+        [this](ThresholdSubscriptions::Id,
+               const std::string& client,
+               const microseconds&)
+        {
+            clients.remove(user, client);
+        });
+    subscriptions.clear();
+    for (const auto& sub : handed.subscriptions)
+    {
+        if (subscriptions.insert(sub.id, sub.client, sub.threshold))
+        {
+            clients.add(user, sub.client);
+        }
+    }
+    subscriptions.setNextId(handed.nextSubscriptionId);
+}
+
+std::string ChangeNotifier::getCaller()
+{
+    auto msg = sd_bus_get_current_message(bus.get());
+    auto sender = msg ? sd_bus_message_get_sender(msg) : nullptr;
+    if (!sender)
+    {
+        using InternalFailure = sdbusplus::xyz::openbmc_project::Common::
+                                    Error::InternalFailure;
+        log<level::ERR>("Failed to get the sender of the method call");
+        elog<InternalFailure>();
+        return {};
+    }
+    return sender;
+}
+
+void ChangeNotifier::notify(const char* clock, const microseconds& delta)
+{
+    if (subscriptions.size() == 0)
+    {
+        return;
+    }
+    subscriptions.forEachClient(
+        delta,
+        [this, clock, &delta](const std::string& client)
+        {
+            // The signal is sent to the subscribed client only
+            sd_bus_message* m = nullptr;
+            auto r = sd_bus_message_new_signal(bus.get(), &m,
+                                               objPath.c_str(),
+                                               NOTIFICATION_INTERFACE,
+                                               SIGNAL_TIME_CHANGED);
+            if (r >= 0)
+            {
+                r = sd_bus_message_set_destination(m, client.c_str());
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_append(m, "ox", clock,
+                                          static_cast<int64_t>(delta.count()));
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_send(bus.get(), m, nullptr);
+            }
+            if (r < 0)
+            {
+                log<level::ERR>("Failed to send TimeChanged",
+                                entry("CLIENT=%s", client.c_str()),
+                                entry("ERRNO=%d", -r),
+                                entry("ERR=%s", strerror(-r)));
+            }
+            sd_bus_message_unref(m);
+        });
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "client_tracker.hpp"
+#include "handoff.hpp"
+#include "threshold_subscriptions.hpp"
+#include "time_state_change.hpp"
+#include "xyz/openbmc_project/Time/Internal/ChangeNotification/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class ChangeNotifier
+ *  @brief OpenBMC time change notification implementation.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.ChangeNotification DBus API.
+ *  A client subscribes with a threshold, and gets the TimeChanged signal
+ *  sent to itself only, when BMC time steps or host offset changes by more
+ *  than the threshold. Small changes wake no client up.
+ */
+class ChangeNotifier : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::
+        ChangeNotification >
+{
+    public:
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] tracker - The tracker of the clients, shared with the
+         *                      other services
+         */
+        ChangeNotifier(sdbusplus::bus::bus& bus,
+                       const char* objPath,
+                       ClientTracker& tracker);
+
+        /** @brief Subscribe the calling client to time changes
+         *
+         * @param[in] threshold - The threshold of the change in microseconds
+         *
+         * @return The id of the subscription
+         */
+        uint64_t subscribe(uint64_t threshold) override;
+
+        /** @brief Remove a subscription of the calling client
+         *
+         * @param[in] id - The id of the subscription
+         */
+        void unsubscribe(uint64_t id) override;
+
+        /** @brief Notified on BMC time change
+         *
+         * @param[in] change - The changed time state of BmcEpoch
+         */
+        void onBmcTimeChanged(const TimeStateChange& change);
+
+        /** @brief Notified on host offset change
+         *
+         * @param[in] change - The changed time state of HostEpoch
+         */
+        void onHostOffsetChanged(const TimeStateChange& change);
+
+        /** @brief Save the subscriptions to hand them over to a new process
+         *
+         * @param[out] saved - The state to save to
+         */
+        void save(HandoffState& saved) const;
+
+        /** @brief Replace the subscriptions with the ones handed over by
+         *  the running process
+         *
+         * @param[in] handed - The handed state
+         */
+        void restore(const HandoffState& handed);
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The object path of this object */
+        std::string objPath;
+
+        /** @brief The subscriptions of the clients */
+        ThresholdSubscriptions subscriptions;
+
+        /** @brief The tracker of the subscribed clients */
+        ClientTracker& clients;
+
+        /** @brief The id of this service in the tracker */
+        ClientTracker::User user;
+
+        /** @brief The last known host offset */
+        std::chrono::microseconds lastOffset{0};
+
+        /** @brief Indicate if the host offset is known */
+        bool offsetKnown = false;
+
+        /** @brief Get the bus name of the client of current method call */
+        std::string getCaller();
+
+        /** @brief Send TimeChanged signal to the clients with a smaller
+         *  threshold than the change
+         *
+         * @param[in] clock - The object path of the changed clock
+         * @param[in] delta - The change
+         */
+        void notify(const char* clock, const std::chrono::microseconds& delta);
+};
+
+} // namespace time
+} // namespace phosphor
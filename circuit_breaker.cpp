@@ -0,0 +1,309 @@
+#include "circuit_breaker.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace // anonymous
+{
+constexpr auto SYSTEMD_TIME_SERVICE = "org.freedesktop.timedate1";
+constexpr auto SYSTEMD_TIME_PATH = "/org/freedesktop/timedate1";
+constexpr auto SYSTEMD_TIME_INTERFACE = "org.freedesktop.timedate1";
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto METHOD_GET = "Get";
+constexpr auto PROPERTY_NTP = "NTP";
+
+/** @brief The errors of a call that timedated does not reply to */
+constexpr const char* NO_REPLY_ERRORS[] = {
+    SD_BUS_ERROR_NO_REPLY,
+    SD_BUS_ERROR_TIMEOUT,
+    SD_BUS_ERROR_SERVICE_UNKNOWN,
+    SD_BUS_ERROR_NAME_HAS_NO_OWNER,
+    SD_BUS_ERROR_DISCONNECTED,
+};
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+
+constexpr seconds CircuitBreaker::minTimeout;
+constexpr seconds CircuitBreaker::maxTimeout;
+constexpr seconds CircuitBreaker::initialTimeout;
+constexpr unsigned CircuitBreaker::failureThreshold;
+constexpr seconds CircuitBreaker::probeInterval;
+
+CircuitBreaker::CircuitBreaker(sdbusplus::bus::bus& bus,
+                               const char* objPath,
+                               Probe probe,
+                               Clock clock)
+    : sdbusplus::server::object::object<Interface>(bus, objPath),
+      bus(bus),
+      probe(std::move(probe)),
+      clock(std::move(clock))
+{
+    if (!this->probe)
+    {
+        this->probe = [this]()
+        {
+            return probeTimedated();
+        };
+    }
+    if (!this->clock)
+    {
+        this->clock = []()
+        {
+            return duration_cast<microseconds>(
+                steady_clock::now().time_since_epoch());
+        };
+    }
+    timeout(microseconds(initialTimeout).count());
+}
+
+CircuitBreaker::~CircuitBreaker()
+{
+    sd_bus_slot_unref(probeSlot);
+}
+
+bool CircuitBreaker::allow()
+{
+    if (state() == State::Closed)
+    {
+        return true;
+    }
+    rejected(rejected() + 1);
+    return false;
+}
+
+void CircuitBreaker::record(bool replied, const microseconds& latency)
+{
+    if (replied)
+    {
+        estimate(latency);
+        close(latency);
+        return;
+    }
+
+    // Back off as TCP does on a timeout, the latency is not a sample
+    timeout(std::min<uint64_t>(timeout() * 2,
+                               microseconds(maxTimeout).count()));
+    if (state() == State::HalfOpen)
+    {
+        open();
+    }
+    else if (state() == State::Closed && ++failures >= failureThreshold)
+    {
+        trips(trips() + 1);
+        log<level::ERR>("timedated does not reply, opened the breaker",
+                        entry("FAILURES=%u", failures),
+                        entry("TRIPS=%llu",
+                              static_cast<unsigned long long>(trips())));
+        open();
+    }
+}
+
+void CircuitBreaker::recordProbe(bool replied, const microseconds& latency)
+{
+    if (replied)
+    {
+        // timedated replies again, so the back off of the calls that got
+        // no reply is undone, the timeout is the estimate of the replies
+        resetTimeout();
+        close(latency);
+    }
+    else if (state() == State::HalfOpen)
+    {
+        // The timeout is not backed off either, the calls do that
+        open();
+    }
+}
+
+bool CircuitBreaker::call(sd_bus_message* method)
+{
+    if (!allow())
+    {
+        return false;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+    auto started = now();
+    auto r = sd_bus_call(bus.get(), method, timeout(), &error, &reply);
+    record(replied(r, &error), now() - started);
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return r >= 0;
+}
+
+bool CircuitBreaker::replied(int r, const sd_bus_error* error)
+{
+    if (!error || !sd_bus_error_is_set(error))
+    {
+        return r >= 0;
+    }
+    return std::none_of(std::begin(NO_REPLY_ERRORS),
+                        std::end(NO_REPLY_ERRORS),
+                        [error](const char* name)
+                        {
+                            return sd_bus_error_has_name(error, name);
+                        });
+}
+
+void CircuitBreaker::estimate(const microseconds& latency)
+{
+    if (!sampled)
+    {
+        sampled = true;
+        smoothed = latency;
+        variation = latency / 2;
+    }
+    else
+    {
+        auto diff = smoothed > latency ? smoothed - latency
+                                       : latency - smoothed;
+        variation = (variation * 3 + diff) / 4;
+        smoothed = (smoothed * 7 + latency) / 8;
+    }
+    resetTimeout();
+}
+
+void CircuitBreaker::resetTimeout()
+{
+    if (!sampled)
+    {
+        timeout(microseconds(initialTimeout).count());
+        return;
+    }
+    auto next = std::max<microseconds>(
+        std::min<microseconds>(smoothed + variation * 4, maxTimeout),
+        minTimeout);
+    timeout(next.count());
+}
+
+void CircuitBreaker::close(const microseconds& latency)
+{
+    failures = 0;
+    if (state() != State::Closed)
+    {
+        state(State::Closed);
+        schedule(false);
+        log<level::INFO>("timedated replies again, closed the breaker",
+                         entry("LATENCY_USEC=%lld",
+                               static_cast<long long>(latency.count())));
+    }
+}
+
+void CircuitBreaker::open()
+{
+    failures = 0;
+    state(State::Open);
+    schedule(true);
+}
+
+void CircuitBreaker::schedule(bool enable)
+{
+    if (!enable)
+    {
+        if (probeTimer)
+        {
+            sd_event_source_set_enabled(probeTimer.get(), SD_EVENT_OFF);
+        }
+        return;
+    }
+
+    uint64_t now;
+    auto event = bus.get_event();
+    auto next = microseconds(probeInterval).count();
+    auto r = sd_event_now(event, CLOCK_MONOTONIC, &now);
+    if (r >= 0 && !probeTimer)
+    {
+        sd_event_source* es;
+        r = sd_event_add_time(event, &es, CLOCK_MONOTONIC,
+                              now + next, 0, onProbeTimer, this);
+        if (r >= 0)
+        {
+            probeTimer.reset(es);
+        }
+    }
+    else if (r >= 0)
+    {
+        r = sd_event_source_set_time(probeTimer.get(), now + next);
+        if (r >= 0)
+        {
+            r = sd_event_source_set_enabled(probeTimer.get(),
+                                            SD_EVENT_ONESHOT);
+        }
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to schedule probing timedated",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+}
+
+bool CircuitBreaker::probeTimedated()
+{
+    sd_bus_slot_unref(probeSlot);
+    probeSlot = nullptr;
+
+    sd_bus_message* m = nullptr;
+    auto r = sd_bus_message_new_method_call(bus.get(), &m,
+                                            SYSTEMD_TIME_SERVICE,
+                                            SYSTEMD_TIME_PATH,
+                                            PROPERTIES_INTERFACE,
+                                            METHOD_GET);
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(m, "ss", SYSTEMD_TIME_INTERFACE,
+                                  PROPERTY_NTP);
+    }
+    if (r >= 0)
+    {
+        probeStarted = now();
+        r = sd_bus_call_async(bus.get(), &probeSlot, m, onProbeReply, this,
+                              timeout());
+    }
+    sd_bus_message_unref(m);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to probe timedated",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return false;
+    }
+    return true;
+}
+
+int CircuitBreaker::onProbeTimer(sd_event_source* /* es */,
+                                 uint64_t /* usec */,
+                                 void* userdata)
+{
+    auto breaker = static_cast<CircuitBreaker*>(userdata);
+    breaker->state(State::HalfOpen);
+    auto started = breaker->probe();
+    wakeup::count(wakeup::Source::BreakerProbe, started);
+    if (!started)
+    {
+        breaker->open();
+    }
+    return 0;
+}
+
+int CircuitBreaker::onProbeReply(sd_bus_message* m, void* userdata,
+                                 sd_bus_error* /* error */)
+{
+    auto breaker = static_cast<CircuitBreaker*>(userdata);
+    breaker->recordProbe(replied(0, sd_bus_message_get_error(m)),
+                         breaker->now() - breaker->probeStarted);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "xyz/openbmc_project/Time/Internal/CircuitBreaker/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class CircuitBreaker
+ *  @brief Guard the calls to systemd-timedated with a circuit breaker.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.CircuitBreaker DBus API.
+ *  The calls wait for the reply with a timeout estimated from the observed
+ *  latency, as TCP estimates its retransmission timeout, instead of the
+ *  default timeout of sd-bus. When timedated does not reply to a few calls
+ *  in a row the breaker opens, the calls fail fast, and timedated is
+ *  probed periodically until it replies again.
+ */
+class CircuitBreaker : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::CircuitBreaker >
+{
+    public:
+        friend class TestCircuitBreaker;
+
+        using Interface = sdbusplus::xyz::openbmc_project::Time::Internal::
+                              server::CircuitBreaker;
+        using State = Interface::State;
+
+        /** @brief The function to read the steady time */
+        using Clock = std::function<std::chrono::microseconds()>;
+
+        /** @brief The function to start a probe, recordProbe() shall be
+         *  called when it is done
+         *
+         * @return false if it fails to start
+         */
+        using Probe = std::function<bool()>;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] probe - The function to start a probe, empty to get
+         *                    a property of timedated
+         * @param[in] clock - The function to read the steady time, empty
+         *                    for the steady clock
+         */
+        CircuitBreaker(sdbusplus::bus::bus& bus,
+                       const char* objPath,
+                       Probe probe = nullptr,
+                       Clock clock = nullptr);
+        CircuitBreaker(const CircuitBreaker&) = delete;
+        CircuitBreaker& operator=(const CircuitBreaker&) = delete;
+        CircuitBreaker(CircuitBreaker&&) = delete;
+        CircuitBreaker& operator=(CircuitBreaker&&) = delete;
+        ~CircuitBreaker();
+
+        /** @brief Check if a call may be made, a call that may not is
+         *  counted as rejected
+         *
+         * @return true if the breaker is closed
+         */
+        bool allow();
+
+        /** @brief Record the result of a call that is allowed
+         *
+         * @param[in] replied - Indicate if timedated replied, a method
+         *                      error is a reply
+         * @param[in] latency - The time from the call to its result
+         */
+        void record(bool replied, const std::chrono::microseconds& latency);
+
+        /** @brief Record the result of a probe, it closes the breaker if
+         *  timedated replied, and resets the backed off timeout to the
+         *  estimate of the calls, but its latency is not a sample of the
+         *  timeout, as the probe is a cheap property get rather than a
+         *  SetTime or SetNTP call
+         *
+         * @param[in] replied - Indicate if timedated replied
+         * @param[in] latency - The time from the probe to its result
+         */
+        void recordProbe(bool replied,
+                         const std::chrono::microseconds& latency);
+
+        /** @brief Call timedated synchronously with the current timeout,
+         *  and record the result
+         *
+         * @param[in] method - The method call to make
+         *
+         * @return true if the call is made and succeeds
+         */
+        bool call(sd_bus_message* method);
+
+        /** @brief Read the steady time to measure a latency by */
+        std::chrono::microseconds now() const
+        {
+            return clock();
+        }
+
+        /** @brief Check if the result of a call is a reply of timedated,
+         *  rather than a timeout or a failure of the bus
+         *
+         * @param[in] r - The return value of the call
+         * @param[in] error - The error of the call or of its reply
+         *
+         * @return true if timedated replied
+         */
+        static bool replied(int r, const sd_bus_error* error);
+
+        /** @brief The bounds of the timeout */
+        static constexpr auto minTimeout = std::chrono::seconds(1);
+        static constexpr auto maxTimeout = std::chrono::seconds(25);
+
+        /** @brief The timeout before any latency is observed */
+        static constexpr auto initialTimeout = std::chrono::seconds(5);
+
+        /** @brief The number of calls in a row that get no reply to open
+         *  the breaker
+         */
+        static constexpr unsigned failureThreshold = 3;
+
+        /** @brief The interval of the probes while the breaker is open */
+        static constexpr auto probeInterval = std::chrono::seconds(30);
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The function to start a probe */
+        Probe probe;
+
+        /** @brief The function to read the steady time */
+        Clock clock;
+
+        /** @brief The number of calls in a row that get no reply */
+        unsigned failures = 0;
+
+        /** @brief Indicate if a latency is observed */
+        bool sampled = false;
+
+        /** @brief The smoothed latency */
+        std::chrono::microseconds smoothed{0};
+
+        /** @brief The variation of the latency */
+        std::chrono::microseconds variation{0};
+
+        /** @brief The slot of the pending probe of timedated */
+        sd_bus_slot* probeSlot = nullptr;
+
+        /** @brief The steady time the pending probe is started */
+        std::chrono::microseconds probeStarted{0};
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The timer of the probes */
+        SdEventSource probeTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief Update the timeout by an observed latency
+         *
+         * @param[in] latency - The latency of a reply
+         */
+        void estimate(const std::chrono::microseconds& latency);
+
+        /** @brief Set the timeout to the estimate of the observed
+         *  latencies, within the bounds, or to the initial timeout if
+         *  none is observed
+         */
+        void resetTimeout();
+
+        /** @brief Reset the failures on a reply, and close the breaker
+         *
+         * @param[in] latency - The latency of the reply
+         */
+        void close(const std::chrono::microseconds& latency);
+
+        /** @brief Open the breaker and schedule the next probe */
+        void open();
+
+        /** @brief Schedule the next probe, or stop probing
+         *
+         * @param[in] enable - Indicate if the probe is scheduled
+         */
+        void schedule(bool enable);
+
+        /** @brief Get a property of timedated asynchronously as a probe
+         *
+         * @return false if the call fails to start
+         */
+        bool probeTimedated();
+
+        /** @brief The callback function of the probe timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onProbeTimer(sd_event_source* es, uint64_t usec,
+                                void* userdata);
+
+        /** @brief The callback function of the reply of a timedated probe
+         *
+         * @param[in] m - The reply message
+         * @param[in] userdata - User data pointer
+         * @param[in] error - Not used
+         */
+        static int onProbeReply(sd_bus_message* m, void* userdata,
+                                sd_bus_error* error);
+};
+
+} // namespace time
+} // namespace phosphor
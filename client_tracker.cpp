@@ -0,0 +1,177 @@
+#include "client_tracker.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <cstring>
+
+namespace rules = sdbusplus::bus::match::rules;
+
+namespace // anonymous
+{
+constexpr auto DBUS_SERVICE = "org.freedesktop.DBus";
+constexpr auto DBUS_PATH = "/org/freedesktop/DBus";
+constexpr auto DBUS_INTERFACE = "org.freedesktop.DBus";
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace phosphor::logging;
+
+constexpr size_t ClientTracker::maxUsers;
+
+ClientTracker::ClientTracker(sdbusplus::bus::bus& bus)
+    : bus(bus)
+{
+    sd_event_source* es;
+    auto r = sd_event_add_defer(bus.get_event(), &es, onGoneEvent, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+    else
+    {
+        goneSource.reset(es);
+        sd_event_source_set_enabled(es, SD_EVENT_OFF);
+    }
+
+    // The new owner is empty when a name leaves, the names of the other
+    // clients are filtered out here
+    match = std::make_unique<sdbusplus::bus::match::match>(
+        bus,
+        rules::nameOwnerChanged() + rules::argN(2, ""),
+        [this](sdbusplus::message::message& msg)
+        {
+            std::string name;
+            std::string oldOwner;
+            std::string newOwner;
+            msg.read(name, oldOwner, newOwner);
+            if (newOwner.empty() && clients.find(name) != clients.end())
+            {
+                setGone(name);
+            }
+        });
+}
+
+ClientTracker::User ClientTracker::addUser(Handler onGone)
+{
+    if (handlers.size() >= maxUsers)
+    {
+        using InternalFailure = sdbusplus::xyz::openbmc_project::Common::
+                                    Error::InternalFailure;
+        log<level::ERR>("Too many users of the client tracker");
+        elog<InternalFailure>();
+    }
+    handlers.push_back(std::move(onGone));
+    return handlers.size() - 1;
+}
+
+void ClientTracker::add(User user, const std::string& client)
+{
+    auto it = clients.find(client);
+    if (it != clients.end())
+    {
+        it->second->users |= (1u << user);
+        return;
+    }
+
+    auto tracked = std::make_unique<Client>(this, client);
+    tracked->users = (1u << user);
+
+    // The client may have left before it is tracked, the reply is dropped
+    // with the client if it is removed before the reply
+    auto r = sd_bus_call_method_async(bus.get(), &tracked->check,
+                                      DBUS_SERVICE,
+                                      DBUS_PATH,
+                                      DBUS_INTERFACE,
+                                      "NameHasOwner",
+                                      onNameHasOwner, tracked.get(),
+                                      "s", client.c_str());
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to call NameHasOwner",
+                        entry("CLIENT=%s", client.c_str()),
+                        entry("ERRNO=%d", -r));
+    }
+    clients.emplace(client, std::move(tracked));
+}
+
+void ClientTracker::remove(User user, const std::string& client)
+{
+    auto it = clients.find(client);
+    if (it == clients.end())
+    {
+        return;
+    }
+    it->second->users &= ~(1u << user);
+    if (it->second->users == 0)
+    {
+        clients.erase(it);
+    }
+}
+
+int ClientTracker::onNameHasOwner(sd_bus_message* m, void* userdata,
+                                  sd_bus_error* /* error */)
+{
+    auto client = static_cast<Client*>(userdata);
+    int hasOwner = 1;
+    if (sd_bus_message_is_method_error(m, nullptr) ||
+        sd_bus_message_read(m, "b", &hasOwner) < 0)
+    {
+        // Keep tracking it, the match still sees it leave
+        return 0;
+    }
+    if (!hasOwner)
+    {
+        client->tracker->setGone(client->name);
+    }
+    return 0;
+}
+
+void ClientTracker::setGone(const std::string& client)
+{
+    gone.push_back(client);
+    if (goneSource)
+    {
+        sd_event_source_set_enabled(goneSource.get(), SD_EVENT_ONESHOT);
+    }
+}
+
+int ClientTracker::onGoneEvent(sd_event_source* /* es */, void* userdata)
+{
+    auto tracker = static_cast<ClientTracker*>(userdata);
+    auto gone = std::move(tracker->gone);
+    tracker->gone.clear();
+    bool removed = false;
+    for (const auto& client : gone)
+    {
+        auto it = tracker->clients.find(client);
+        if (it == tracker->clients.end())
+        {
+            continue;
+        }
+        auto users = it->second->users;
+        tracker->clients.erase(it);
+        for (User user = 0; user < tracker->handlers.size(); ++user)
+        {
+            if (users & (1u << user))
+            {
+                tracker->handlers[user](client);
+            }
+        }
+        removed = true;
+    }
+    wakeup::count(wakeup::Source::ClientGone, removed);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class ClientTracker
+ *  @brief Track the bus clients that hold state in this service.
+ *  @details One match of the NameOwnerChanged signals of the names that
+ *  leave the bus is shared by all the tracked clients, and the signals are
+ *  filtered against the tracked names in the process, so tracking a client
+ *  adds no match rule on the bus. A client that left before it is tracked
+ *  is found by an async NameHasOwner call, so that tracking a client never
+ *  blocks the method handler that adds it. The tracker is shared by the
+ *  services that hold the state of clients, each one is a user with its
+ *  own function to drop the state of a client. When a client leaves the
+ *  bus, its state is dropped from a deferred event, outside of the match
+ *  callback.
+ */
+class ClientTracker
+{
+    public:
+        using Handler = std::function<void(const std::string& client)>;
+
+        /** @brief The id of a user of the tracker */
+        using User = size_t;
+
+        /** @brief The max number of users */
+        static constexpr size_t maxUsers = 32;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         */
+        explicit ClientTracker(sdbusplus::bus::bus& bus);
+        ClientTracker(const ClientTracker&) = delete;
+        ClientTracker& operator=(const ClientTracker&) = delete;
+        ClientTracker(ClientTracker&&) = delete;
+        ClientTracker& operator=(ClientTracker&&) = delete;
+        ~ClientTracker() = default;
+
+        /** @brief Add a user of the tracker
+         *
+         * @param[in] onGone - The function called when a client of the
+         *                     user leaves
+         *
+         * @return The id of the user
+         */
+        User addUser(Handler onGone);
+
+        /** @brief Start tracking the client for the user if it is not
+         *  tracked for it yet
+         *
+         * @param[in] user - The id of the user
+         * @param[in] client - The unique bus name of the client
+         */
+        void add(User user, const std::string& client);
+
+        /** @brief Stop tracking the client for the user
+         *
+         * @param[in] user - The id of the user
+         * @param[in] client - The unique bus name of the client
+         */
+        void remove(User user, const std::string& client);
+
+        /** @brief Get the number of the tracked clients */
+        size_t size() const
+        {
+            return clients.size();
+        }
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The functions called when a client leaves, by user */
+        std::vector<Handler> handlers;
+
+        /** @brief The match of the names that leave the bus */
+        std::unique_ptr<sdbusplus::bus::match::match> match;
+
+        /** @struct Client
+         *  @brief The users and the pending NameHasOwner call of a client
+         */
+        struct Client
+        {
+            Client(ClientTracker* tracker, const std::string& name)
+                : tracker(tracker),
+                  name(name)
+            {
+            }
+            Client(const Client&) = delete;
+            Client& operator=(const Client&) = delete;
+            ~Client()
+            {
+                sd_bus_slot_unref(check);
+            }
+
+            ClientTracker* tracker;
+            std::string name;
+
+            /** @brief The bits of the users that track the client */
+            uint32_t users = 0;
+
+            /** @brief The slot of the NameHasOwner call */
+            sd_bus_slot* check = nullptr;
+        };
+
+        /** @brief The tracked clients */
+        std::map<std::string, std::unique_ptr<Client>> clients;
+
+        /** @brief The clients that left the bus */
+        std::vector<std::string> gone;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The deferred event to drop the left clients */
+        SdEventSource goneSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief Queue the client to be dropped
+         *
+         * @param[in] client - The unique bus name of the client
+         */
+        void setGone(const std::string& client);
+
+        /** @brief The callback function of the NameHasOwner reply
+         *
+         * @param[in] m - The reply message
+         * @param[in] userdata - The client that is checked
+         * @param[out] error - Not used
+         */
+        static int onNameHasOwner(sd_bus_message* m, void* userdata,
+                                  sd_bus_error* error);
+
+        /** @brief The callback function of the deferred event
+         *
+         * @param[in] es - Source of the event
+         * @param[in] userdata - User data pointer
+         */
+        static int onGoneEvent(sd_event_source* es, void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
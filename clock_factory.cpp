@@ -0,0 +1,352 @@
+#include "clock_factory.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace // anonymous
+{
+constexpr auto CLOCK_PATH_SUFFIX = "/clock";
+constexpr auto MAX_NAME_LENGTH = 255;
+
+/** @brief The delay to save the changes in a batch */
+constexpr auto SAVE_DELAY_USEC = 1000000;
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using ClockFactoryIntf =
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::ClockFactory;
+using InvalidArgumentError =
+    sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+
+ClockFactory::ClockFactory(sdbusplus::bus::bus& bus,
+                           const char* objPath)
+    : sdbusplus::server::object::object<ClockFactoryIntf>(bus, objPath),
+      bus(bus),
+      clockRoot(std::string(objPath) + CLOCK_PATH_SUFFIX),
+      objManager(bus, clockRoot.c_str())
+{
+    restore();
+}
+
+ClockFactory::~ClockFactory()
+{
+    if (dirty)
+    {
+        save();
+    }
+}
+
+sdbusplus::message::object_path ClockFactory::createClock(std::string name)
+{
+    auto valid = !name.empty() && name.size() <= MAX_NAME_LENGTH &&
+        std::all_of(name.begin(), name.end(),
+                    [](char c)
+                    {
+                        return (c >= 'a' && c <= 'z') ||
+                               (c >= 'A' && c <= 'Z') ||
+                               (c >= '0' && c <= '9') || c == '_';
+                    });
+    if (!valid)
+    {
+        using namespace xyz::openbmc_project::Common;
+        elog<InvalidArgumentError>(
+            InvalidArgument::ARGUMENT_NAME("Name"),
+            InvalidArgument::ARGUMENT_VALUE(name.c_str()));
+        return {};
+    }
+
+    if (clocks.find(name) == clocks.end())
+    {
+        if (clocks.size() >= maxClocks)
+        {
+            using NotAllowed =
+                sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+            using NotAllowedError = xyz::openbmc_project::Common::NotAllowed;
+            elog<NotAllowed>(
+                NotAllowedError::REASON("Too many virtual clocks"));
+            return {};
+        }
+        create(name);
+        scheduleSave();
+    }
+    return clockRoot + "/" + name;
+}
+
+void ClockFactory::deleteClock(std::string name)
+{
+    auto it = clocks.find(name);
+    if (it == clocks.end())
+    {
+        using namespace xyz::openbmc_project::Common;
+        elog<InvalidArgumentError>(
+            InvalidArgument::ARGUMENT_NAME("Name"),
+            InvalidArgument::ARGUMENT_VALUE(name.c_str()));
+        return;
+    }
+    arena.release(it->second->getSlot());
+    clocks.erase(it);
+    scheduleSave();
+}
+
+void ClockFactory::onTimeStateChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::ModeChanged) ||
+        change.has(TimeStateChange::OwnerChanged))
+    {
+        if (change.has(TimeStateChange::ModeChanged))
+        {
+            state.mode = change.mode;
+        }
+        if (change.has(TimeStateChange::OwnerChanged))
+        {
+            state.owner = change.owner;
+        }
+        for (auto& clock : clocks)
+        {
+            clock.second->onTimeStateChanged(change);
+        }
+
+        // Same as the host offset, the offsets are only kept in SPLIT
+        if (change.has(TimeStateChange::OwnerChanged) &&
+            state.owner != Owner::Split)
+        {
+            arena.clear();
+            scheduleSave();
+        }
+    }
+
+    if (change.has(TimeStateChange::BmcTimeJumped) &&
+        state.owner == Owner::Split &&
+        change.jump != microseconds(0))
+    {
+        // The virtual clocks do not step with BMC time
+        arena.shift(-change.jump);
+        scheduleSave();
+    }
+}
+
+void ClockFactory::setOffset(OffsetArena::Slot slot,
+                             const microseconds& offset)
+{
+    arena.set(slot, offset);
+    scheduleSave();
+}
+
+void ClockFactory::useBreaker(CircuitBreaker& timedated)
+{
+    breaker = &timedated;
+    for (auto& clock : clocks)
+    {
+        wire(*clock.second);
+    }
+}
+
+void ClockFactory::usePipeline(SetTimePipeline& setTimes)
+{
+    pipeline = &setTimes;
+    for (auto& clock : clocks)
+    {
+        wire(*clock.second);
+    }
+}
+
+void ClockFactory::useLatency(SetLatency& compensator)
+{
+    latency = &compensator;
+    for (auto& clock : clocks)
+    {
+        wire(*clock.second);
+    }
+}
+
+void ClockFactory::wire(VirtualClock& clock)
+{
+    if (breaker)
+    {
+        clock.useBreaker(*breaker);
+    }
+    if (pipeline)
+    {
+        clock.usePipeline(*pipeline);
+    }
+    if (latency)
+    {
+        clock.useLatency(*latency);
+    }
+}
+
+void ClockFactory::save(HandoffState& saved) const
+{
+    saved.clocks.clear();
+    for (const auto& clock : clocks)
+    {
+        saved.clocks.emplace(clock.first,
+                             arena.get(clock.second->getSlot()));
+    }
+}
+
+void ClockFactory::restore(const HandoffState& handed)
+{
+    for (auto it = clocks.begin(); it != clocks.end();)
+    {
+        if (handed.clocks.find(it->first) == handed.clocks.end())
+        {
+            arena.release(it->second->getSlot());
+            it = clocks.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    for (const auto& c : handed.clocks)
+    {
+        auto it = clocks.find(c.first);
+        if (it == clocks.end() && clocks.size() >= maxClocks)
+        {
+            continue;
+        }
+        auto& clock = (it != clocks.end()) ? *it->second : create(c.first);
+        arena.set(clock.getSlot(), c.second);
+    }
+    scheduleSave();
+}
+
+VirtualClock& ClockFactory::create(const std::string& name)
+{
+    auto path = clockRoot + "/" + name;
+    auto clock = std::make_unique<VirtualClock>(bus, path.c_str(), *this,
+                                                arena.allocate());
+
+    TimeStateChange change = state;
+    change.changed = TimeStateChange::ModeChanged |
+                     TimeStateChange::OwnerChanged;
+    clock->onTimeStateChanged(change);
+    wire(*clock);
+
+    auto& ref = *clock;
+    clocks.emplace(name, std::move(clock));
+    return ref;
+}
+
+void ClockFactory::scheduleSave()
+{
+    dirty = true;
+
+    int enabled = SD_EVENT_OFF;
+    if (saveTimer)
+    {
+        sd_event_source_get_enabled(saveTimer.get(), &enabled);
+    }
+    if (enabled != SD_EVENT_OFF)
+    {
+        // A save is already scheduled, the change goes with it
+        return;
+    }
+
+    uint64_t now;
+    auto event = bus.get_event();
+    auto r = sd_event_now(event, CLOCK_MONOTONIC, &now);
+    if (r >= 0 && !saveTimer)
+    {
+        sd_event_source* es;
+        r = sd_event_add_time(event, &es, CLOCK_MONOTONIC,
+                              now + SAVE_DELAY_USEC, 0, onSaveTimer, this);
+        if (r >= 0)
+        {
+            saveTimer.reset(es);
+        }
+    }
+    else if (r >= 0)
+    {
+        r = sd_event_source_set_time(saveTimer.get(), now + SAVE_DELAY_USEC);
+        if (r >= 0)
+        {
+            r = sd_event_source_set_enabled(saveTimer.get(),
+                                            SD_EVENT_ONESHOT);
+        }
+    }
+    if (r < 0)
+    {
+        // Save it right away if it is not able to be batched
+        log<level::ERR>("Failed to schedule saving virtual clocks",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        save();
+    }
+}
+
+void ClockFactory::save()
+{
+    dirty = false;
+
+    // Write to a temporary file and rename it, so that a crash does not
+    // leave a partial file
+    auto tmpFile = std::string(clocksFile) + ".tmp";
+    {
+        std::ofstream fs(tmpFile, std::ios::out | std::ios::trunc);
+        if (!fs.is_open())
+        {
+            log<level::ERR>("Failed to save virtual clocks",
+                            entry("FILE=%s", tmpFile.c_str()));
+            return;
+        }
+        for (const auto& clock : clocks)
+        {
+            fs << clock.first << ' '
+               << arena.get(clock.second->getSlot()).count() << '\n';
+        }
+    }
+    if (std::rename(tmpFile.c_str(), clocksFile) != 0)
+    {
+        log<level::ERR>("Failed to save virtual clocks",
+                        entry("FILE=%s", clocksFile),
+                        entry("ERRNO=%d", errno));
+    }
+}
+
+void ClockFactory::restore()
+{
+    std::ifstream fs(clocksFile);
+    std::string name;
+    microseconds::rep offset;
+    while (fs >> name >> offset)
+    {
+        if (clocks.find(name) != clocks.end() || clocks.size() >= maxClocks)
+        {
+            continue;
+        }
+        auto& clock = create(name);
+        arena.set(clock.getSlot(), microseconds(offset));
+    }
+}
+
+int ClockFactory::onSaveTimer(sd_event_source* /* es */,
+                              uint64_t /* usec */,
+                              void* userdata)
+{
+    auto factory = static_cast<ClockFactory*>(userdata);
+    wakeup::count(wakeup::Source::VirtualClocksSave, factory->dirty);
+    if (factory->dirty)
+    {
+        factory->save();
+    }
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
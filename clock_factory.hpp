@@ -0,0 +1,220 @@
+#pragma once
+
+#include "config.h"
+#include "circuit_breaker.hpp"
+#include "handoff.hpp"
+#include "offset_arena.hpp"
+#include "set_latency.hpp"
+#include "set_time_pipeline.hpp"
+#include "time_state_change.hpp"
+#include "virtual_clock.hpp"
+#include "xyz/openbmc_project/Time/Internal/ClockFactory/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class ClockFactory
+ *  @brief OpenBMC virtual clock factory implementation.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.ClockFactory DBus API.
+ *  It creates the VirtualClock objects under <objPath>/clock, keeps their
+ *  offsets in one OffsetArena, and compensates the offsets when BMC time
+ *  steps in SPLIT owner. The offsets are saved to VIRTUAL_CLOCKS_FILE in a
+ *  batch, shortly after they are changed.
+ */
+class ClockFactory : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::ClockFactory >
+{
+    public:
+        /** @brief The maximum number of virtual clocks */
+        static constexpr size_t maxClocks = 65536;
+
+        /** @brief Constructor, the saved clocks are restored
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path of the factory
+         */
+        ClockFactory(sdbusplus::bus::bus& bus,
+                     const char* objPath);
+        ClockFactory(const ClockFactory&) = delete;
+        ClockFactory& operator=(const ClockFactory&) = delete;
+        ClockFactory(ClockFactory&&) = delete;
+        ClockFactory& operator=(ClockFactory&&) = delete;
+
+        /** @brief Destructor, the pending changes are saved */
+        ~ClockFactory();
+
+        /** @brief Create a virtual clock
+         *
+         * @param[in] name - The name of the clock
+         *
+         * @return The object path of the clock
+         */
+        sdbusplus::message::object_path createClock(std::string name) override;
+
+        /** @brief Delete a virtual clock
+         *
+         * @param[in] name - The name of the clock
+         */
+        void deleteClock(std::string name) override;
+
+        /** @brief Notified on time state changed
+         *
+         * @param[in] change - The changed time state
+         */
+        void onTimeStateChanged(const TimeStateChange& change);
+
+        /** @brief Get the offset of a virtual clock
+         *
+         * @param[in] slot - The slot of the clock
+         */
+        std::chrono::microseconds getOffset(OffsetArena::Slot slot) const
+        {
+            return arena.get(slot);
+        }
+
+        /** @brief Set the offset of a virtual clock
+         *
+         * @param[in] slot - The slot of the clock
+         * @param[in] offset - The offset to BMC time
+         */
+        void setOffset(OffsetArena::Slot slot,
+                       const std::chrono::microseconds& offset);
+
+        /** @brief Make the synchronous SetTime calls of the clocks through
+         *  the breaker, the ones created later too
+         *
+         * @param[in] timedated - The breaker of the timedated calls
+         */
+        void useBreaker(CircuitBreaker& timedated);
+
+        /** @brief Set the system time through the pipeline on the Elapsed
+         *  sets of the clocks, the ones created later too
+         *
+         * @param[in] setTimes - The pipeline shared by the epoch objects
+         */
+        void usePipeline(SetTimePipeline& setTimes);
+
+        /** @brief Compensate the Elapsed sets of the clocks for the set
+         *  latency, the ones created later too
+         *
+         * @param[in] compensator - The compensator of the set latency
+         */
+        void useLatency(SetLatency& compensator);
+
+        /** @brief Save the clocks and offsets to hand them over to a new
+         *  process
+         *
+         * @param[out] saved - The state to save to
+         */
+        void save(HandoffState& saved) const;
+
+        /** @brief Restore the clocks and offsets handed over by the running
+         *  process, the clocks not in the state are deleted
+         *
+         * @param[in] handed - The handed state
+         */
+        void restore(const HandoffState& handed);
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The object path under which the clocks are created */
+        std::string clockRoot;
+
+        /** @brief The ObjectManager of the clocks */
+        sdbusplus::server::manager::manager objManager;
+
+        /** @brief The offsets of the clocks */
+        OffsetArena arena;
+
+        /** @brief The clocks by name */
+        std::unordered_map<std::string, std::unique_ptr<VirtualClock>> clocks;
+
+        /** @brief The current time mode and owner */
+        TimeStateChange state;
+
+        /** @brief The breaker of the SetTime calls of the clocks, or
+         *  nullptr
+         */
+        CircuitBreaker* breaker = nullptr;
+
+        /** @brief The pipeline of the Elapsed sets of the clocks, or
+         *  nullptr
+         */
+        SetTimePipeline* pipeline = nullptr;
+
+        /** @brief The compensator of the set latency of the clocks, or
+         *  nullptr
+         */
+        SetLatency* latency = nullptr;
+
+        /** @brief Indicate if there are changes to save */
+        bool dirty = false;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The timer to save the changes */
+        SdEventSource saveTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief The file to store the clocks */
+        static constexpr auto clocksFile = VIRTUAL_CLOCKS_FILE;
+
+        /** @brief Create the clock object, wired as the existing ones
+         *
+         * @param[in] name - The name of the clock
+         *
+         * @return The clock
+         */
+        VirtualClock& create(const std::string& name);
+
+        /** @brief Wire a clock to the breaker, the pipeline and the
+         *  compensator in use
+         *
+         * @param[in] clock - The clock
+         */
+        void wire(VirtualClock& clock);
+
+        /** @brief Schedule to save the changes */
+        void scheduleSave();
+
+        /** @brief Save the clocks and offsets to clocksFile */
+        void save();
+
+        /** @brief Restore the clocks and offsets from clocksFile */
+        void restore();
+
+        /** @brief The callback function of the save timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onSaveTimer(sd_event_source* es, uint64_t usec,
+                               void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
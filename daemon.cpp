@@ -0,0 +1,285 @@
+#include "daemon.hpp"
+#include "utils.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <unistd.h>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace phosphor::logging;
+
+Daemon::Daemon(sdbusplus::bus::bus& bus, const HandoffState* handedState)
+    : Daemon(bus, handedState, Paths())
+{
+}
+
+Daemon::Daemon(sdbusplus::bus::bus& bus,
+               const HandoffState* handedState,
+               const Paths& paths,
+               Hook hook)
+    : telemetryFile(paths.telemetryFile)
+{
+    auto enter = [&hook](Part part)
+    {
+        if (hook)
+        {
+            hook(part);
+        }
+    };
+
+    // Add sdbusplus ObjectManager
+    enter(Part::ObjectManagers);
+    bmcObjManager = std::make_unique<ObjectManager>(bus, OBJPATH_BMC);
+    hostObjManager = std::make_unique<ObjectManager>(bus, OBJPATH_HOST);
+
+#ifdef TIME_FLOOR
+    // Set the time forward to the last known good time before anything
+    // reads it. The clock is set directly, as timedated rejects SetTime
+    // once the manager enables NTP
+    enter(Part::Others);
+    timeFloorPtr = std::make_unique<TimeFloor>(bus.get_event(),
+                                               paths.timeFloorFile);
+    timeFloorPtr->apply(utils::now(ClockRead::Precise), utils::setRealtime);
+#endif
+
+    enter(Part::Manager);
+    if (handedState)
+    {
+        managerPtr = std::make_unique<Manager>(bus, *handedState, nullptr,
+                                               paths.modeFile,
+                                               paths.ownerFile);
+    }
+    else
+    {
+        managerPtr = std::make_unique<Manager>(bus, paths.modeFile,
+                                               paths.ownerFile);
+    }
+    auto& manager = *managerPtr;
+
+    enter(Part::Others);
+#ifdef FREQUENCY_KEEPER
+    // Restore the frequency correction early, before NTP adjusts it
+    frequencyKeeper = std::make_unique<FrequencyKeeper>(bus, OBJPATH_TIME,
+                                                        paths.frequencyFile);
+    auto& keeper = *frequencyKeeper;
+    subscriptions.emplace_back(manager.subscribe(
+        [&keeper](const TimeStateChange& change)
+        {
+            keeper.onTimeStateChanged(change);
+        }));
+#endif
+
+    // The timedated calls time out by their observed latency, and fail
+    // fast while timedated does not reply
+    timedated = std::make_unique<CircuitBreaker>(bus, OBJPATH_TIME);
+    manager.useBreaker(*timedated);
+
+    // The BMC and host time sets share one SetTime call in flight
+    setTimes = std::make_unique<SetTimePipeline>(bus);
+    setTimes->useBreaker(*timedated);
+
+    // The sets are advanced by the delay from their requests to the time
+    // being applied
+    latency = std::make_unique<SetLatency>(bus, OBJPATH_TIME);
+    setTimes->useLatency(*latency);
+
+    // Have the requests stamped when they are received where the bus can,
+    // so the delay before they are handled is compensated too
+    auto r = sd_bus_negotiate_timestamp(bus.get(), 1);
+    if (r < 0)
+    {
+        log<level::INFO>("Failed to negotiate the message timestamps",
+                         entry("ERRNO=%d", -r));
+    }
+
+    enter(Part::BmcEpoch);
+    bmc = std::make_unique<BmcEpoch>(bus, OBJPATH_BMC);
+    bmc->useBreaker(*timedated);
+    bmc->useLatency(*latency);
+
+    enter(Part::HostEpoch);
+    hostPtr = std::make_unique<HostEpoch>(bus, OBJPATH_HOST, nullptr,
+                                          paths.hostOffsetFile);
+    auto& host = *hostPtr;
+    bmc->usePipeline(*setTimes);
+    host.usePipeline(*setTimes);
+    host.useBreaker(*timedated);
+    host.useLatency(*latency);
+    using utils::strToClockRead;
+    bmc->setClockRead(strToClockRead(BMC_CLOCK_READ));
+    host.setClockRead(strToClockRead(HOST_CLOCK_READ));
+
+    auto& bmcEpoch = *bmc;
+    subscriptions.emplace_back(manager.subscribe(
+        [&bmcEpoch](const TimeStateChange& change)
+        {
+            bmcEpoch.onTimeStateChanged(change);
+        }));
+    subscriptions.emplace_back(manager.subscribe(
+        [&host](const TimeStateChange& change)
+        {
+            host.onTimeStateChanged(change);
+        }));
+    subscriptions.emplace_back(bmcEpoch.subscribe(
+        [&host](const TimeStateChange& change)
+        {
+            host.onTimeStateChanged(change);
+        }));
+#ifdef TIME_FLOOR
+    auto& floor = *timeFloorPtr;
+    subscriptions.emplace_back(bmcEpoch.subscribe(
+        [&floor](const TimeStateChange& change)
+        {
+            floor.onBmcTimeChanged(change);
+        }));
+#endif
+    if (handedState)
+    {
+        host.restore(*handedState);
+    }
+
+    // Publish the time state for the readers
+    enter(Part::Others);
+    state = std::make_unique<PublishedState>();
+    auto& published = *state;
+    auto publish = [&published](const TimeStateChange& change)
+    {
+        published.publish(change);
+    };
+    subscriptions.emplace_back(manager.subscribe(publish));
+    subscriptions.emplace_back(host.subscribe(publish));
+    snapshot = std::make_unique<TimeSnapshot>(bus, OBJPATH_TIME, published);
+    snapshot->setClockRead(strToClockRead(BMC_CLOCK_READ));
+#ifdef READ_THREAD
+    reader = std::make_unique<ReadServer>(published,
+                                          bmcEpoch.getClockRead(),
+                                          host.getClockRead());
+#endif
+#ifdef QUERY_SOCKET
+    queryServer = std::make_unique<QueryServer>(bus.get_event(),
+                                                paths.querySocket,
+                                                bmcEpoch, host, published);
+#endif
+
+    // Notify the subscribed clients of large time changes. The services of
+    // the clients share one tracker of the clients leaving the bus
+    clientTracker = std::make_unique<ClientTracker>(bus);
+    notifier = std::make_unique<ChangeNotifier>(bus, OBJPATH_TIME,
+                                                *clientTracker);
+    auto& changes = *notifier;
+    if (handedState)
+    {
+        changes.restore(*handedState);
+    }
+    subscriptions.emplace_back(bmcEpoch.subscribe(
+        [&changes](const TimeStateChange& change)
+        {
+            changes.onBmcTimeChanged(change);
+        }));
+    subscriptions.emplace_back(host.subscribe(
+        [&changes](const TimeStateChange& change)
+        {
+            changes.onHostOffsetChanged(change);
+        }));
+
+    // Serve the wall clock alarms of the clients on one timer
+    alarmService = std::make_unique<AlarmService>(bus, OBJPATH_TIME,
+                                                  *clientTracker);
+    auto& alarms = *alarmService;
+    if (handedState)
+    {
+        alarms.restore(*handedState);
+    }
+    subscriptions.emplace_back(bmcEpoch.subscribe(
+        [&alarms](const TimeStateChange& change)
+        {
+            alarms.onBmcTimeChanged(change);
+        }));
+
+    // Record the host offset, the kernel clock and the BMC time jumps. On a
+    // live restart the running process still writes the ring, it is opened
+    // by restore()
+    telemetry = std::make_unique<TelemetryRecorder>(
+        bus, OBJPATH_TIME, handedState ? nullptr : paths.telemetryFile,
+        TELEMETRY_PAGES, TELEMETRY_INTERVAL);
+    auto& recorder = *telemetry;
+    auto record = [&recorder](const TimeStateChange& change)
+    {
+        recorder.onTimeStateChanged(change);
+    };
+    subscriptions.emplace_back(host.subscribe(record));
+    subscriptions.emplace_back(bmcEpoch.subscribe(record));
+
+    // The virtual clocks follow the mode, owner and BMC time as the host does,
+    // and are set through the same breaker, pipeline and compensator
+    clockFactory = std::make_unique<ClockFactory>(bus, OBJPATH_TIME);
+    auto& clocks = *clockFactory;
+    clocks.useBreaker(*timedated);
+    clocks.usePipeline(*setTimes);
+    clocks.useLatency(*latency);
+    if (handedState)
+    {
+        clocks.restore(*handedState);
+    }
+    auto onClockState = [&clocks](const TimeStateChange& change)
+    {
+        clocks.onTimeStateChanged(change);
+    };
+    subscriptions.emplace_back(manager.subscribe(onClockState));
+    subscriptions.emplace_back(bmcEpoch.subscribe(onClockState));
+
+#ifdef REPLICATION
+    // Stream the time state to the standby BMC
+    // On a live restart it keeps the listening socket of the running
+    // process, the address is still bound by it
+    replication = std::make_unique<ReplicationSender>(
+        bus.get_event(), paths.replicationSocket,
+        handedState ? handedState->replicationFd : -1);
+    auto& sender = *replication;
+    auto replicate = [&sender](const TimeStateChange& change)
+    {
+        sender.onTimeStateChanged(change);
+    };
+    subscriptions.emplace_back(manager.subscribe(replicate));
+    subscriptions.emplace_back(host.subscribe(replicate));
+#else
+    if (handedState && handedState->replicationFd >= 0)
+    {
+        close(handedState->replicationFd);
+    }
+#endif
+}
+
+void Daemon::save(HandoffState& saved) const
+{
+    managerPtr->save(saved);
+    hostPtr->save(saved);
+    clockFactory->save(saved);
+    notifier->save(saved);
+    alarmService->save(saved);
+#ifdef REPLICATION
+    saved.replicationFd = replication->getListenFd();
+#endif
+
+    // The new process continues the ring after the last written page
+    telemetry->flush();
+}
+
+void Daemon::restore(const HandoffState* finalState)
+{
+    if (finalState)
+    {
+        hostPtr->restore(*finalState);
+        clockFactory->restore(*finalState);
+        notifier->restore(*finalState);
+        alarmService->restore(*finalState);
+    }
+    telemetry->open(telemetryFile);
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "config.h"
+#include "alarm_service.hpp"
+#include "bmc_epoch.hpp"
+#include "change_notifier.hpp"
+#include "circuit_breaker.hpp"
+#include "clock_factory.hpp"
+#include "handoff.hpp"
+#include "host_epoch.hpp"
+#include "manager.hpp"
+#include "published_state.hpp"
+#include "set_latency.hpp"
+#include "set_time_pipeline.hpp"
+#include "telemetry_recorder.hpp"
+#include "time_snapshot.hpp"
+#ifdef TIME_FLOOR
+#include "time_floor.hpp"
+#endif
+#ifdef FREQUENCY_KEEPER
+#include "frequency_keeper.hpp"
+#endif
+#ifdef READ_THREAD
+#include "read_server.hpp"
+#endif
+#ifdef REPLICATION
+#include "replication.hpp"
+#endif
+#ifdef QUERY_SOCKET
+#include "query_server.hpp"
+#endif
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/manager.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class Daemon
+ *  @brief The objects of phosphor-timemanager, wired together.
+ *  @details main() serves them on the bus, and the footprint bench
+ *  constructs the same objects to measure them, with the files and the
+ *  sockets in its own place.
+ */
+class Daemon
+{
+    public:
+        /** @brief The files and the sockets of the objects */
+        struct Paths
+        {
+#ifdef TIME_FLOOR
+            const char* timeFloorFile = TIME_FLOOR_FILE;
+#endif
+#ifdef FREQUENCY_KEEPER
+            const char* frequencyFile = FREQUENCY_FILE;
+#endif
+            const char* telemetryFile = TELEMETRY_FILE;
+            const char* hostOffsetFile = HostEpoch::defaultOffsetFile;
+            const char* modeFile = Manager::defaultModeFile;
+            const char* ownerFile = Manager::defaultOwnerFile;
+#ifdef QUERY_SOCKET
+            const char* querySocket = QUERY_SOCKET;
+#endif
+#ifdef REPLICATION
+            const char* replicationSocket = REPLICATION_SOCKET;
+#endif
+        };
+
+        /** @brief The parts of the daemon, in the order of construction */
+        enum class Part
+        {
+            ObjectManagers,
+            Manager,
+            BmcEpoch,
+            HostEpoch,
+            Others,
+        };
+
+        /** @brief The function called before the objects of a part are
+         *  constructed, the objects up to the next call belong to it
+         */
+        using Hook = std::function<void(Part)>;
+
+        /** @brief Constructor - construct and wire the objects, with the
+         *  configured files and sockets
+         *
+         * @param[in] bus - The Dbus bus object, attached to its event loop
+         * @param[in] handedState - The state handed over by the running
+         *                          process, or nullptr to start afresh
+         */
+        Daemon(sdbusplus::bus::bus& bus, const HandoffState* handedState);
+
+        /** @brief Constructor - construct and wire the objects
+         *
+         * @param[in] bus - The Dbus bus object, attached to its event loop
+         * @param[in] handedState - The state handed over by the running
+         *                          process, or nullptr to start afresh
+         * @param[in] paths - The files and the sockets of the objects
+         * @param[in] hook - The function called before each part, may be
+         *                   empty
+         */
+        Daemon(sdbusplus::bus::bus& bus,
+               const HandoffState* handedState,
+               const Paths& paths,
+               Hook hook = nullptr);
+        Daemon(const Daemon&) = delete;
+        Daemon& operator=(const Daemon&) = delete;
+        Daemon(Daemon&&) = delete;
+        Daemon& operator=(Daemon&&) = delete;
+        ~Daemon() = default;
+
+        /** @brief Get the manager of the settings */
+        Manager& manager()
+        {
+            return *managerPtr;
+        }
+
+        /** @brief Get the host time */
+        HostEpoch& host()
+        {
+            return *hostPtr;
+        }
+
+#ifdef TIME_FLOOR
+        /** @brief Get the floor of the BMC time */
+        TimeFloor& timeFloor()
+        {
+            return *timeFloorPtr;
+        }
+#endif
+
+        /** @brief Save the state to hand it over to a new process
+         *  @details The files shared with the new process are written
+         *  too, e.g. the telemetry samples.
+         *
+         * @param[out] saved - The state to save to
+         */
+        void save(HandoffState& saved) const;
+
+        /** @brief Take over from the running process once it has handed
+         *  the final state over and stopped serving
+         *  @details The files it writes until then are opened only now.
+         *
+         * @param[in] finalState - The final state, or nullptr if it is not
+         *                         received
+         */
+        void restore(const HandoffState* finalState);
+
+    private:
+        using ObjectManager = sdbusplus::server::manager::manager;
+
+        /** @brief The file of the telemetry ring, opened by restore() on a
+         *  live restart
+         */
+        const char* telemetryFile;
+
+        std::unique_ptr<ObjectManager> bmcObjManager;
+        std::unique_ptr<ObjectManager> hostObjManager;
+#ifdef TIME_FLOOR
+        std::unique_ptr<TimeFloor> timeFloorPtr;
+#endif
+        std::unique_ptr<Manager> managerPtr;
+#ifdef FREQUENCY_KEEPER
+        std::unique_ptr<FrequencyKeeper> frequencyKeeper;
+#endif
+        std::unique_ptr<CircuitBreaker> timedated;
+        std::unique_ptr<SetTimePipeline> setTimes;
+        std::unique_ptr<SetLatency> latency;
+        std::unique_ptr<BmcEpoch> bmc;
+        std::unique_ptr<HostEpoch> hostPtr;
+        std::unique_ptr<PublishedState> state;
+        std::unique_ptr<TimeSnapshot> snapshot;
+#ifdef READ_THREAD
+        std::unique_ptr<ReadServer> reader;
+#endif
+#ifdef QUERY_SOCKET
+        std::unique_ptr<QueryServer> queryServer;
+#endif
+        std::unique_ptr<ClientTracker> clientTracker;
+        std::unique_ptr<ChangeNotifier> notifier;
+        std::unique_ptr<AlarmService> alarmService;
+        std::unique_ptr<TelemetryRecorder> telemetry;
+        std::unique_ptr<ClockFactory> clockFactory;
+#ifdef REPLICATION
+        std::unique_ptr<ReplicationSender> replication;
+#endif
+
+        /** @brief The subscriptions that wire the objects together, they
+         *  are destroyed before the objects
+         */
+        std::vector<TimeStateDispatcher::Subscription> subscriptions;
+};
+
+} // namespace time
+} // namespace phosphor
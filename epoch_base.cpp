@@ -1,7 +1,14 @@
 #include "epoch_base.hpp"
+#include "utils.hpp"
 
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Time/error.hpp>
 
+#include <linux/capability.h>
+
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -11,6 +18,13 @@ constexpr auto SYSTEMD_TIME_SERVICE = "org.freedesktop.timedate1";
 constexpr auto SYSTEMD_TIME_PATH = "/org/freedesktop/timedate1";
 constexpr auto SYSTEMD_TIME_INTERFACE = "org.freedesktop.timedate1";
 constexpr auto METHOD_SET_TIME = "SetTime";
+
+constexpr auto PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+constexpr auto EPOCH_TIME_INTERFACE = "xyz.openbmc_project.Time.EpochTime";
+constexpr auto PROPERTY_ELAPSED = "Elapsed";
+
+/** @brief The privilege sd-bus requires to set a property */
+constexpr auto SET_CAPABILITY = CAP_SYS_ADMIN;
 }
 
 namespace phosphor
@@ -20,11 +34,159 @@ namespace time
 
 using namespace phosphor::logging;
 
+/** @brief The filter of the Elapsed sets on a bus, shared by the epoch
+ *  objects on it, so that a message is looked up once by its path
+ */
+struct EpochBase::SetFilter
+{
+    /** @brief The slot of the filter */
+    sd_bus_slot* slot = nullptr;
+
+    /** @brief The epoch objects that take their sets, by path */
+    std::unordered_map<std::string, EpochBase*> epochs;
+};
+
+std::unordered_map<sd_bus*, EpochBase::SetFilter> EpochBase::setFilters;
+
 EpochBase::EpochBase(sdbusplus::bus::bus& bus,
-                     const char* objPath)
+                     const char* objPath,
+                     SystemClock* systemClock)
     : sdbusplus::server::object::object<EpochTime>(bus, objPath),
-      bus(bus)
+      bus(bus),
+      systemClock(systemClock),
+      objPath(objPath)
+{
+}
+
+EpochBase::~EpochBase()
+{
+    if (!filtered)
+    {
+        return;
+    }
+    auto it = setFilters.find(bus.get());
+    if (it == setFilters.end())
+    {
+        return;
+    }
+    it->second.epochs.erase(objPath);
+    if (it->second.epochs.empty())
+    {
+        sd_bus_slot_unref(it->second.slot);
+        setFilters.erase(it);
+    }
+}
+
+void EpochBase::usePipeline(SetTimePipeline& setTimes)
+{
+    pipeline = &setTimes;
+    if (filtered)
+    {
+        return;
+    }
+
+    auto& filter = setFilters[bus.get()];
+    if (!filter.slot)
+    {
+        auto r = sd_bus_add_filter(bus.get(), &filter.slot, onMessage,
+                                   &filter);
+        if (r < 0)
+        {
+            // The sets are still done by the property setter, which
+            // replies before the time is set
+            log<level::ERR>("Failed to add the filter of the Elapsed sets",
+                            entry("ERRNO=%d", -r),
+                            entry("ERR=%s", strerror(-r)));
+            setFilters.erase(bus.get());
+            return;
+        }
+    }
+    filter.epochs[objPath] = this;
+    filtered = true;
+}
+
+int EpochBase::onMessage(sd_bus_message* m, void* userdata,
+                         sd_bus_error* /* error */)
 {
+    auto filter = static_cast<SetFilter*>(userdata);
+
+    // The filter sees every message, so the cheap checks come first
+    if (sd_bus_message_is_method_call(m, PROPERTIES_INTERFACE, "Set") <= 0)
+    {
+        return 0;
+    }
+    auto path = sd_bus_message_get_path(m);
+    auto it = path ? filter->epochs.find(path) : filter->epochs.end();
+    if (it == filter->epochs.end())
+    {
+        return 0;
+    }
+    auto epoch = it->second;
+    const char* interface = nullptr;
+    const char* property = nullptr;
+    uint64_t value = 0;
+    if (sd_bus_message_read(m, "ss", &interface, &property) < 0 ||
+        strcmp(interface, EPOCH_TIME_INTERFACE) != 0 ||
+        strcmp(property, PROPERTY_ELAPSED) != 0 ||
+        sd_bus_message_read(m, "v", "t", &value) < 0)
+    {
+        // Not an Elapsed set, or a bad one that sd-bus replies an error to
+        sd_bus_message_rewind(m, true);
+        return 0;
+    }
+
+    // The set skips the dispatch of sd-bus, so the sender is checked as
+    // sd-bus does before it sets a property: it has the capability, or it
+    // runs as our user
+    auto r = sd_bus_query_sender_privilege(m, SET_CAPABILITY);
+    if (r <= 0)
+    {
+        sd_bus_reply_method_errorf(m, SD_BUS_ERROR_ACCESS_DENIED,
+                                   "Access to %s.%s not permitted.",
+                                   EPOCH_TIME_INTERFACE, PROPERTY_ELAPSED);
+        return 1;
+    }
+
+    // Stamp the request before anything else delays it
+    auto received = epoch->getReceivedTime();
+    sd_bus_message_ref(m);
+    try
+    {
+        epoch->setElapsed(value, received,
+                          [m](bool ok)
+                          {
+                              if (ok)
+                              {
+                                  sd_bus_reply_method_return(m, nullptr);
+                              }
+                              else
+                              {
+                                  sd_bus_reply_method_errorf(
+                                      m, SD_BUS_ERROR_FAILED,
+                                      "Failed to set the time");
+                              }
+                              sd_bus_message_unref(m);
+                          });
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        // e.g. NotAllowed, raised before anything is set
+        sd_bus_reply_method_errorf(m, e.name(), "%s", e.description());
+        sd_bus_message_unref(m);
+    }
+    return 1;
+}
+
+void EpochBase::onTimeStateChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::ModeChanged))
+    {
+        onModeChanged(change.mode);
+    }
+    if (change.has(TimeStateChange::OwnerChanged))
+    {
+        onOwnerChanged(change.owner);
+    }
 }
 
 void EpochBase::onModeChanged(Mode mode)
@@ -40,6 +202,11 @@ void EpochBase::onOwnerChanged(Owner owner)
 using namespace std::chrono;
 bool EpochBase::setTime(const microseconds& usec)
 {
+    if (systemClock)
+    {
+        return systemClock->setTime(usec);
+    }
+
     auto method = bus.new_method_call(SYSTEMD_TIME_SERVICE,
                                       SYSTEMD_TIME_PATH,
                                       SYSTEMD_TIME_INTERFACE,
@@ -47,6 +214,15 @@ bool EpochBase::setTime(const microseconds& usec)
     method.append(static_cast<int64_t>(usec.count()),
                   false, // relative
                   false); // user_interaction
+    if (breaker)
+    {
+        if (!breaker->call(method.get()))
+        {
+            log<level::ERR>("Error in setting system time");
+            return false;
+        }
+        return true;
+    }
     auto reply = bus.call(method);
     if (reply.is_method_error())
     {
@@ -58,12 +234,74 @@ bool EpochBase::setTime(const microseconds& usec)
     return true;
 }
 
+bool EpochBase::setRequestedTime(const microseconds& time,
+                                 const microseconds& received)
+{
+    if (!latency)
+    {
+        return setTime(time);
+    }
+    if (!setTime(latency->compensateSet(time, received)))
+    {
+        latency->abandon();
+        return false;
+    }
+    latency->settle(time, received);
+    return true;
+}
+
+microseconds EpochBase::getReceivedTime() const
+{
+    return latency ? latency->received() : microseconds(0);
+}
+
+SetAction EpochBase::getSetAction(Clock clock) const
+{
+    const auto& rule = policy::lookup(clock, timeMode, timeOwner);
+    if (rule.action == SetAction::Reject)
+    {
+        using NotAllowed =
+            sdbusplus::xyz::openbmc_project::Time::Error::NotAllowed;
+        using NotAllowedError = xyz::openbmc_project::Time::NotAllowed;
+        log<level::ERR>("Setting time is not allowed",
+                        entry("REASON=%s", rule.reason));
+        elog<NotAllowed>(
+            NotAllowedError::OWNER(utils::ownerToStr(timeOwner).c_str()),
+            NotAllowedError::SYNC_METHOD(utils::modeToStr(timeMode).c_str()),
+            NotAllowedError::REASON(rule.reason));
+    }
+    return rule.action;
+}
+
 microseconds EpochBase::getTime() const
 {
+    if (systemClock)
+    {
+        return systemClock->realtime();
+    }
     auto now = system_clock::now();
     return duration_cast<microseconds>
            (now.time_since_epoch());
 }
 
+microseconds EpochBase::readTime() const
+{
+    if (systemClock)
+    {
+        return systemClock->realtime();
+    }
+    return utils::now(clockRead);
+}
+
+microseconds EpochBase::getSteadyTime() const
+{
+    if (systemClock)
+    {
+        return systemClock->steady();
+    }
+    return duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch());
+}
+
 } // namespace time
 } // namespace phosphor
@@ -1,11 +1,20 @@
 #pragma once
 
-#include "property_change_listener.hpp"
+#include "circuit_breaker.hpp"
+#include "set_latency.hpp"
+#include "set_policy.hpp"
+#include "set_time_pipeline.hpp"
+#include "system_clock.hpp"
+#include "time_state_change.hpp"
+#include "types.hpp"
 
 #include <sdbusplus/bus.hpp>
 #include <xyz/openbmc_project/Time/EpochTime/server.hpp>
 
 #include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
 
 namespace phosphor
 {
@@ -18,22 +27,89 @@ namespace time
  *  DBus API for epoch time.
  */
 class EpochBase : public sdbusplus::server::object::object <
-    sdbusplus::xyz::openbmc_project::Time::server::EpochTime >,
-    public PropertyChangeListner
+    sdbusplus::xyz::openbmc_project::Time::server::EpochTime >
 {
     public:
         friend class TestEpochBase;
 
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] systemClock - The clocks to read and set, or nullptr
+         *                          for the real ones
+         */
         EpochBase(sdbusplus::bus::bus& bus,
-                  const char* objPath);
+                  const char* objPath,
+                  SystemClock* systemClock = nullptr);
+
+        virtual ~EpochBase();
+
+        /** @brief Notified on time state changed
+         *
+         * @param[in] change - The changed time state
+         */
+        virtual void onTimeStateChanged(const TimeStateChange& change);
 
         /** @brief Notified on time mode changed */
-        void onModeChanged(Mode mode) override;
+        virtual void onModeChanged(Mode mode);
 
         /** @brief Notified on time owner changed */
-        void onOwnerChanged(Owner owner) override;
+        virtual void onOwnerChanged(Owner owner);
+
+        /** @brief Set the way to read the clock on Elapsed gets
+         *
+         * @param[in] read - The way to read the clock
+         */
+        void setClockRead(ClockRead read)
+        {
+            clockRead = read;
+        }
+
+        /** @brief Get the way to read the clock on Elapsed gets */
+        ClockRead getClockRead() const
+        {
+            return clockRead;
+        }
+
+        /** @brief Set the system time through the pipeline on Elapsed
+         *  sets, instead of a synchronous SetTime call
+         *  @details The Elapsed sets on the bus are then taken by a filter
+         *  before sd-bus sets the property, and are replied once their
+         *  time is set, with an error if it fails. The filter checks the
+         *  privilege of the sender as sd-bus does, and is shared by the
+         *  epoch objects on the bus.
+         *
+         * @param[in] setTimes - The pipeline shared by the epoch objects
+         */
+        void usePipeline(SetTimePipeline& setTimes);
+
+        /** @brief Make the synchronous SetTime calls through the breaker
+         *
+         * @param[in] timedated - The breaker of the timedated calls
+         */
+        void useBreaker(CircuitBreaker& timedated)
+        {
+            breaker = &timedated;
+        }
+
+        /** @brief Compensate the Elapsed sets for the delay from the
+         *  request to the time being applied
+         *
+         * @param[in] compensator - The compensator of the set latency
+         */
+        void useLatency(SetLatency& compensator)
+        {
+            latency = &compensator;
+        }
 
     protected:
+        /** @brief The function called when an Elapsed set is done
+         *
+         * @param[in] ok - Indicate if the time is set
+         */
+        using SetDone = std::function<void(bool ok)>;
+
         /** @brief Persistent sdbusplus DBus connection */
         sdbusplus::bus::bus& bus;
 
@@ -43,6 +119,27 @@ class EpochBase : public sdbusplus::server::object::object <
         /** @brief The current time owner */
         Owner timeOwner = Owner::Both;
 
+        /** @brief The way to read the clock on Elapsed gets */
+        ClockRead clockRead = ClockRead::Precise;
+
+        /** @brief The pipeline to set the system time, or nullptr to set
+         *  it synchronously
+         */
+        SetTimePipeline* pipeline = nullptr;
+
+        /** @brief The breaker of the synchronous SetTime calls, or nullptr
+         *  to wait for the default timeout of sd-bus
+         */
+        CircuitBreaker* breaker = nullptr;
+
+        /** @brief The compensator of the set latency, or nullptr to apply
+         *  the requested times as they are
+         */
+        SetLatency* latency = nullptr;
+
+        /** @brief The clocks to read and set, or nullptr for the real ones */
+        SystemClock* systemClock;
+
         /** @brief Set current time to system
          *
          * This function set the time to system by invoking systemd
@@ -54,11 +151,94 @@ class EpochBase : public sdbusplus::server::object::object <
          */
         bool setTime(const std::chrono::microseconds& timeOfDayUsec);
 
+        /** @brief Set the time of an Elapsed set to system, compensated
+         *  for the delay since its request is received
+         *
+         * @param[in] time - Microseconds since UTC
+         * @param[in] received - The steady time the request is received
+         *
+         * @return true or false to indicate if it sets time successfully
+         */
+        bool setRequestedTime(const std::chrono::microseconds& time,
+                              const std::chrono::microseconds& received);
+
+        /** @brief Apply an Elapsed set
+         *  @details NotAllowed is raised before anything is set. Through
+         *  the pipeline, done is called when the SetTime call completes,
+         *  otherwise before it returns.
+         *
+         * @param[in] value - The microseconds since UTC to set
+         * @param[in] received - The steady time the request is received
+         * @param[in] done - The function called when it is done, or
+         *                   nullptr
+         */
+        virtual void setElapsed(uint64_t value,
+                                const std::chrono::microseconds& received,
+                                SetDone done) = 0;
+
+        /** @brief Get the steady time the request being handled is
+         *  received at
+         *
+         * @return Microseconds of the steady clock, or 0 if the sets are
+         *         not compensated
+         */
+        std::chrono::microseconds getReceivedTime() const;
+
+        /** @brief Get the action on setting the clock in current mode and
+         *  owner, and raise NotAllowed error if it is not allowed
+         *
+         * @param[in] clock - The clock to set
+         *
+         * @return The action on setting the clock
+         */
+        SetAction getSetAction(Clock clock) const;
+
         /** @brief Get current time
          *
          * @return Microseconds since UTC
          */
         std::chrono::microseconds getTime() const;
+
+        /** @brief Get current time for an Elapsed get, read in the way
+         *  set by setClockRead()
+         *  @details The time that the offsets and the steady clock diffs
+         *  are calculated from is always read by getTime().
+         *
+         * @return Microseconds since UTC
+         */
+        std::chrono::microseconds readTime() const;
+
+        /** @brief Get current steady time
+         *
+         * @return Microseconds of the steady clock
+         */
+        std::chrono::microseconds getSteadyTime() const;
+
+    private:
+        /** @brief The filter of the Elapsed sets on a bus */
+        struct SetFilter;
+
+        /** @brief The filters by bus, shared by the epoch objects on it */
+        static std::unordered_map<sd_bus*, SetFilter> setFilters;
+
+        /** @brief The object path */
+        std::string objPath;
+
+        /** @brief Indicate if the Elapsed sets are taken by the filter */
+        bool filtered = false;
+
+        /** @brief The filter of the messages on the bus, it takes the
+         *  Elapsed sets of the epoch objects to reply them when they are
+         *  done
+         *
+         * @param[in] m - The received message
+         * @param[in] userdata - The SetFilter of the bus
+         * @param[out] error - Not used
+         *
+         * @return 1 if the message is taken, otherwise 0
+         */
+        static int onMessage(sd_bus_message* m, void* userdata,
+                             sd_bus_error* error);
 };
 
 } // namespace time
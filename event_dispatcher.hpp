@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class Dispatcher
+ *  @brief Deliver typed events to any number of subscribers.
+ *  @details The handlers are kept in a flat contiguous array and are called
+ *  in the order they subscribed. subscribe() returns a Subscription which
+ *  removes the handler when it is destroyed, so a subscriber never has to
+ *  unregister itself explicitly. A Subscription may safely outlive its
+ *  Dispatcher.
+ */
+template <typename Event>
+class Dispatcher
+{
+    private:
+        struct Slots;
+
+    public:
+        using Handler = std::function<void(const Event&)>;
+
+        /** @class Subscription
+         *  @brief The handle of a subscribed handler.
+         *  @details The handler is unsubscribed when the handle is destroyed
+         *  or reset.
+         */
+        class Subscription
+        {
+            public:
+                Subscription() = default;
+                Subscription(const Subscription&) = delete;
+                Subscription& operator=(const Subscription&) = delete;
+                Subscription(Subscription&& other) noexcept
+                    : slots(std::move(other.slots)),
+                      id(other.id)
+                {
+                    other.id = 0;
+                }
+                Subscription& operator=(Subscription&& other) noexcept
+                {
+                    if (this != &other)
+                    {
+                        reset();
+                        slots = std::move(other.slots);
+                        id = other.id;
+                        other.id = 0;
+                    }
+                    return *this;
+                }
+                ~Subscription()
+                {
+                    reset();
+                }
+
+                /** @brief Unsubscribe the handler */
+                void reset()
+                {
+                    auto s = slots.lock();
+                    if (s && id != 0)
+                    {
+                        s->remove(id);
+                    }
+                    slots.reset();
+                    id = 0;
+                }
+
+                /** @brief Check if the handler is still subscribed */
+                explicit operator bool() const
+                {
+                    return id != 0 && !slots.expired();
+                }
+
+            private:
+                friend class Dispatcher;
+
+                Subscription(const std::shared_ptr<Slots>& slots,
+                             uint64_t id)
+                    : slots(slots),
+                      id(id)
+                {
+                }
+
+                /** @brief The handlers of the dispatcher */
+                std::weak_ptr<Slots> slots;
+
+                /** @brief The id of the subscribed handler */
+                uint64_t id = 0;
+        };
+
+        Dispatcher()
+            : slots(std::make_shared<Slots>())
+        {
+        }
+        Dispatcher(const Dispatcher&) = delete;
+        Dispatcher& operator=(const Dispatcher&) = delete;
+        Dispatcher(Dispatcher&&) = delete;
+        Dispatcher& operator=(Dispatcher&&) = delete;
+        ~Dispatcher() = default;
+
+        /** @brief Subscribe a handler to the events
+         *
+         * @param[in] handler - The function called on each event
+         *
+         * @return The subscription that keeps the handler subscribed
+         */
+        Subscription subscribe(Handler handler)
+        {
+            auto id = ++slots->lastId;
+            if (slots->depth == 0)
+            {
+                slots->entries.push_back({id, std::move(handler)});
+            }
+            else
+            {
+                // Do not touch the array while it is being walked,
+                // the new handler gets the next event
+                slots->pending.push_back({id, std::move(handler)});
+            }
+            return Subscription(slots, id);
+        }
+
+        /** @brief Deliver the event to all the subscribed handlers
+         *
+         * @param[in] event - The event to deliver
+         */
+        void dispatch(const Event& event) const
+        {
+            // Keep the handlers alive even if the dispatcher is destroyed
+            // by one of them
+            auto s = slots;
+            ++s->depth;
+            for (size_t i = 0; i < s->entries.size(); ++i)
+            {
+                if (s->entries[i].id != 0)
+                {
+                    s->entries[i].handler(event);
+                }
+            }
+            --s->depth;
+            s->settle();
+        }
+
+        /** @brief Get the number of subscribed handlers */
+        size_t size() const
+        {
+            return slots->entries.size() - slots->removed +
+                   slots->pending.size();
+        }
+
+        /** @brief Check if there is no subscribed handler */
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        struct Slot
+        {
+            /** @brief The subscription id, 0 if it is unsubscribed */
+            uint64_t id;
+
+            /** @brief The handler of the subscription */
+            Handler handler;
+        };
+
+        struct Slots
+        {
+            /** @brief The subscribed handlers in subscription order */
+            std::vector<Slot> entries;
+
+            /** @brief The handlers subscribed during dispatching */
+            std::vector<Slot> pending;
+
+            /** @brief The last assigned subscription id */
+            uint64_t lastId = 0;
+
+            /** @brief The number of unsubscribed but not yet erased slots */
+            size_t removed = 0;
+
+            /** @brief The nesting level of dispatch() */
+            unsigned depth = 0;
+
+            /** @brief Unsubscribe the handler with the id
+             *
+             * When it is dispatching, the slot is only marked as removed
+             * so that a handler is able to unsubscribe itself.
+             */
+            void remove(uint64_t id)
+            {
+                for (auto it = pending.begin(); it != pending.end(); ++it)
+                {
+                    if (it->id == id)
+                    {
+                        pending.erase(it);
+                        return;
+                    }
+                }
+                for (auto& slot : entries)
+                {
+                    if (slot.id == id)
+                    {
+                        slot.id = 0;
+                        ++removed;
+                        break;
+                    }
+                }
+                settle();
+            }
+
+            /** @brief Erase the removed slots and append the pending ones
+             *  when it is not dispatching
+             */
+            void settle()
+            {
+                if (depth != 0)
+                {
+                    return;
+                }
+                if (removed != 0)
+                {
+                    auto last = entries.begin();
+                    for (auto it = entries.begin(); it != entries.end(); ++it)
+                    {
+                        if (it->id != 0)
+                        {
+                            if (last != it)
+                            {
+                                *last = std::move(*it);
+                            }
+                            ++last;
+                        }
+                    }
+                    entries.erase(last, entries.end());
+                    removed = 0;
+                }
+                if (!pending.empty())
+                {
+                    for (auto& slot : pending)
+                    {
+                        entries.push_back(std::move(slot));
+                    }
+                    pending.clear();
+                }
+            }
+        };
+
+        /** @brief The subscribed handlers, shared with the subscriptions */
+        std::shared_ptr<Slots> slots;
+};
+
+} // namespace time
+} // namespace phosphor
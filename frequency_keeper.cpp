@@ -0,0 +1,184 @@
+#include "frequency_keeper.hpp"
+#include "utils.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace // anonymous
+{
+/** @brief The interval of the checks until the clock is synchronized */
+constexpr uint64_t SYNC_POLL_USEC = 10 * 1000000ULL;
+
+/** @brief The interval of the checks once the clock is synchronized */
+constexpr uint64_t SAVE_INTERVAL_USEC = 600 * 1000000ULL;
+
+/** @brief The min change of the correction to save, 1 ppm, so that the
+ *  small adjustments of NTP do not wear the flash
+ */
+constexpr long SAVE_THRESHOLD = 1L << 16;
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using FrequencyCorrection = sdbusplus::xyz::openbmc_project::Time::Internal::
+                                server::FrequencyCorrection;
+
+FrequencyKeeper::FrequencyKeeper(sdbusplus::bus::bus& bus,
+                                 const char* objPath,
+                                 const char* file,
+                                 Adjtimex adjtimex)
+    : sdbusplus::server::object::object<FrequencyCorrection>(bus, objPath),
+      bus(bus),
+      file(file),
+      adjtimex(std::move(adjtimex)),
+      saved(utils::readData<long>(file)),
+      started(steady_clock::now())
+{
+}
+
+void FrequencyKeeper::onTimeStateChanged(const TimeStateChange& change)
+{
+    if (!change.has(TimeStateChange::ModeChanged))
+    {
+        return;
+    }
+    timeMode = change.mode;
+    if (!modeKnown)
+    {
+        // Restore it only on start, a later switch to NTP keeps the
+        // correction that the kernel has
+        modeKnown = true;
+        if (timeMode == Mode::NTP)
+        {
+            restore();
+        }
+    }
+    schedule(timeMode == Mode::NTP, false);
+}
+
+void FrequencyKeeper::restore()
+{
+    if (saved == 0 || std::labs(saved) > maxFrequency)
+    {
+        return;
+    }
+
+    struct timex tx{};
+    if (adjtimex(&tx) < 0)
+    {
+        log<level::ERR>("Failed to read the kernel clock",
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+    if (tx.freq != 0)
+    {
+        // NTP has corrected it already
+        return;
+    }
+
+    tx = {};
+    tx.modes = ADJ_FREQUENCY;
+    tx.freq = saved;
+    if (adjtimex(&tx) < 0)
+    {
+        log<level::ERR>("Failed to restore the frequency correction",
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+    restoredFrequency(saved);
+    log<level::INFO>("Restored the frequency correction",
+                     entry("FREQUENCY=%ld", saved));
+}
+
+bool FrequencyKeeper::check()
+{
+    struct timex tx{};
+    auto state = adjtimex(&tx);
+    if (state < 0 || state == TIME_ERROR || (tx.status & STA_UNSYNC))
+    {
+        return false;
+    }
+
+    if (timeToSync() == 0)
+    {
+        auto elapsed = duration_cast<microseconds>(
+            steady_clock::now() - started);
+        timeToSync(std::max<uint64_t>(elapsed.count(), 1));
+        log<level::INFO>("The clock is synchronized",
+                         entry("TIME_TO_SYNC_USEC=%llu",
+                               static_cast<unsigned long long>(
+                                   timeToSync())),
+                         entry("FREQUENCY=%ld", tx.freq));
+    }
+    if (std::labs(tx.freq - saved) >= SAVE_THRESHOLD)
+    {
+        utils::writeData(file.c_str(), tx.freq);
+        saved = tx.freq;
+    }
+    return true;
+}
+
+void FrequencyKeeper::schedule(bool enable, bool synced)
+{
+    if (!enable)
+    {
+        if (checkTimer)
+        {
+            sd_event_source_set_enabled(checkTimer.get(), SD_EVENT_OFF);
+        }
+        return;
+    }
+
+    uint64_t now;
+    auto event = bus.get_event();
+    auto next = synced ? SAVE_INTERVAL_USEC : SYNC_POLL_USEC;
+    auto r = sd_event_now(event, CLOCK_MONOTONIC, &now);
+    if (r >= 0 && !checkTimer)
+    {
+        sd_event_source* es;
+        r = sd_event_add_time(event, &es, CLOCK_MONOTONIC,
+                              now + next, 0, onCheckTimer, this);
+        if (r >= 0)
+        {
+            checkTimer.reset(es);
+        }
+    }
+    else if (r >= 0)
+    {
+        r = sd_event_source_set_time(checkTimer.get(), now + next);
+        if (r >= 0)
+        {
+            r = sd_event_source_set_enabled(checkTimer.get(),
+                                            SD_EVENT_ONESHOT);
+        }
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to schedule checking the frequency",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+}
+
+int FrequencyKeeper::onCheckTimer(sd_event_source* /* es */,
+                                  uint64_t /* usec */,
+                                  void* userdata)
+{
+    auto keeper = static_cast<FrequencyKeeper*>(userdata);
+    auto synced = keeper->check();
+    wakeup::count(wakeup::Source::FrequencyCheck, synced);
+    keeper->schedule(keeper->timeMode == Mode::NTP, synced);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "time_state_change.hpp"
+#include "types.hpp"
+#include "xyz/openbmc_project/Time/Internal/FrequencyCorrection/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <sys/timex.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class FrequencyKeeper
+ *  @brief Keep the kernel frequency correction across BMC boots.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.FrequencyCorrection DBus API.
+ *  The kernel starts with no frequency correction on each boot, and NTP
+ *  takes minutes to find it again, stepping the time meanwhile. The
+ *  correction is saved periodically once the clock is synchronized, and
+ *  restored on start in NTP mode before NTP adjusts it.
+ */
+class FrequencyKeeper : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::
+        FrequencyCorrection >
+{
+    public:
+        friend class TestFrequencyKeeper;
+
+        using Adjtimex = std::function<int(struct timex*)>;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] file - The file to save the frequency correction to
+         * @param[in] adjtimex - The function to read and set the kernel
+         *                       clock, adjtimex() by default
+         */
+        FrequencyKeeper(sdbusplus::bus::bus& bus,
+                        const char* objPath,
+                        const char* file,
+                        Adjtimex adjtimex = ::adjtimex);
+        FrequencyKeeper(const FrequencyKeeper&) = delete;
+        FrequencyKeeper& operator=(const FrequencyKeeper&) = delete;
+        FrequencyKeeper(FrequencyKeeper&&) = delete;
+        FrequencyKeeper& operator=(FrequencyKeeper&&) = delete;
+        ~FrequencyKeeper() = default;
+
+        /** @brief Notified on time state changed
+         *  @details The saved correction is restored on the first mode
+         *  notification if it is NTP, and the correction is checked
+         *  periodically in NTP mode.
+         *
+         * @param[in] change - The changed time state
+         */
+        void onTimeStateChanged(const TimeStateChange& change);
+
+        /** @brief The max correction to restore, i.e. 500 ppm that the
+         *  kernel accepts
+         */
+        static constexpr long maxFrequency = 500L << 16;
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The file to save the frequency correction to */
+        std::string file;
+
+        /** @brief The function to read and set the kernel clock */
+        Adjtimex adjtimex;
+
+        /** @brief The current time mode */
+        Mode timeMode = Mode::Manual;
+
+        /** @brief Indicate if the mode is notified */
+        bool modeKnown = false;
+
+        /** @brief The saved frequency correction */
+        long saved = 0;
+
+        /** @brief The steady time of the start */
+        std::chrono::steady_clock::time_point started;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The timer to check the correction */
+        SdEventSource checkTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief Restore the saved correction, if the kernel has none */
+        void restore();
+
+        /** @brief Check if the clock is synchronized, and save the
+         *  correction if it is
+         *
+         * @return true if the clock is synchronized
+         */
+        bool check();
+
+        /** @brief Schedule the next check, or stop checking
+         *
+         * @param[in] enable - Indicate if the checks are scheduled
+         * @param[in] synced - Indicate if the clock is synchronized, which
+         *                     is checked less often
+         */
+        void schedule(bool enable, bool synced);
+
+        /** @brief The callback function of the check timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onCheckTimer(sd_event_source* es, uint64_t usec,
+                                void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,693 @@
+#include "handoff.hpp"
+
+#include "config.h"
+#include "utils.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace phosphor::logging;
+
+namespace // anonymous
+{
+
+/** @brief The magic of the encoded state, "PTMH" */
+constexpr uint32_t STATE_MAGIC = 0x484d5450;
+
+/** @brief The version of the encoded state */
+constexpr uint32_t STATE_VERSION = 5;
+
+/** @brief The max number of fds in a message, the memfd of the state and
+ *  the listening socket of the replication
+ */
+constexpr size_t MAX_FDS = 2;
+
+/** @brief The tags of the messages on the handoff socket */
+enum class Tag : uint32_t
+{
+    Hello = 1, // new process requests the state
+    State = 2, // running process sends the state in a memfd
+    Ready = 3, // new process is serving, the running process sends the
+               // final state and exits
+};
+
+struct Message
+{
+    Tag tag;
+    uint32_t version;
+    uint64_t size;
+};
+
+/** @brief The timeout to wait for the state */
+constexpr time_t RECEIVE_TIMEOUT_SEC = 5;
+
+void putU32(std::string& out, uint32_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putI64(std::string& out, int64_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value)
+{
+    putU32(out, value.size());
+    out.append(value);
+}
+
+/** @class Decoder
+ *  @brief Read the encoded fields with bounds checking.
+ */
+class Decoder
+{
+    public:
+        explicit Decoder(const std::string& data)
+            : data(data)
+        {
+        }
+
+        bool getU32(uint32_t& value)
+        {
+            return get(&value, sizeof(value));
+        }
+
+        bool getI64(int64_t& value)
+        {
+            return get(&value, sizeof(value));
+        }
+
+        bool getString(std::string& value)
+        {
+            uint32_t size;
+            if (!getU32(size) || size > data.size() - pos)
+            {
+                return false;
+            }
+            value.assign(data, pos, size);
+            pos += size;
+            return true;
+        }
+
+        bool done() const
+        {
+            return pos == data.size();
+        }
+
+    private:
+        bool get(void* value, size_t size)
+        {
+            if (size > data.size() - pos)
+            {
+                return false;
+            }
+            memcpy(value, data.data() + pos, size);
+            pos += size;
+            return true;
+        }
+
+        const std::string& data;
+        size_t pos = 0;
+};
+
+bool sendMessage(int sock, const Message& msg,
+                 const std::vector<int>& fds = {})
+{
+    iovec iov{const_cast<Message*>(&msg), sizeof(msg)};
+    msghdr hdr{};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+
+    char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    if (!fds.empty())
+    {
+        auto size = sizeof(int) * fds.size();
+        hdr.msg_control = control;
+        hdr.msg_controllen = CMSG_SPACE(size);
+        auto cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(size);
+        memcpy(CMSG_DATA(cmsg), fds.data(), size);
+    }
+
+    if (sendmsg(sock, &hdr, MSG_NOSIGNAL) != sizeof(msg))
+    {
+        log<level::ERR>("Failed to send handoff message",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    return true;
+}
+
+/** @brief Close the fds
+ *
+ * @param[in] fds - The fds to close
+ */
+void closeFds(const std::vector<int>& fds)
+{
+    for (auto fd : fds)
+    {
+        close(fd);
+    }
+}
+
+/** @brief Receive a message, and the fds if it carries any
+ *
+ * @return The size of the received message, 0 on EOF, < 0 on error
+ */
+ssize_t receiveMessage(int sock, Message& msg, std::vector<int>& fds)
+{
+    iovec iov{&msg, sizeof(msg)};
+    msghdr hdr{};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    fds.clear();
+    auto r = recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC);
+    if (r <= 0)
+    {
+        return r;
+    }
+    for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+         cmsg = CMSG_NXTHDR(&hdr, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            auto data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+            fds.insert(fds.end(), data, data + count);
+        }
+    }
+    if (r != sizeof(msg))
+    {
+        // Not a message of this protocol
+        return -1;
+    }
+    return r;
+}
+
+} // namespace anonymous
+
+namespace handoff
+{
+
+std::string encode(const HandoffState& state)
+{
+    std::string out;
+    putU32(out, STATE_MAGIC);
+    putU32(out, STATE_VERSION);
+    putString(out, utils::modeToStr(state.mode));
+    putString(out, utils::ownerToStr(state.owner));
+    putU32(out, state.hostOn ? 1 : 0);
+    putString(out, state.requestedMode);
+    putString(out, state.requestedOwner);
+    putI64(out, state.offset.count());
+    putI64(out, state.diffToSteadyClock.count());
+    putString(out, state.timeOwner);
+    putString(out, state.timeSyncMethod);
+    putString(out, state.hostState);
+    putU32(out, state.services.size());
+    for (const auto& s : state.services)
+    {
+        putString(out, s.first);
+        putString(out, s.second);
+    }
+    putU32(out, state.clocks.size());
+    for (const auto& c : state.clocks)
+    {
+        putString(out, c.first);
+        putI64(out, c.second.count());
+    }
+    putU32(out, state.alarms.size());
+    for (const auto& a : state.alarms)
+    {
+        putI64(out, a.id);
+        putString(out, a.client);
+        putI64(out, a.deadline.count());
+    }
+    putI64(out, state.nextAlarmId);
+    putU32(out, state.subscriptions.size());
+    for (const auto& sub : state.subscriptions)
+    {
+        putI64(out, sub.id);
+        putString(out, sub.client);
+        putI64(out, sub.threshold.count());
+    }
+    putI64(out, state.nextSubscriptionId);
+    return out;
+}
+
+bool decode(const std::string& data, HandoffState& state)
+{
+    Decoder d(data);
+    uint32_t magic;
+    uint32_t version;
+    if (!d.getU32(magic) || magic != STATE_MAGIC ||
+        !d.getU32(version) || version != STATE_VERSION)
+    {
+        return false;
+    }
+
+    std::string mode;
+    std::string owner;
+    uint32_t hostOn;
+    int64_t offset;
+    int64_t diffToSteadyClock;
+    uint32_t count;
+    HandoffState s;
+    if (!d.getString(mode) || !d.getString(owner) ||
+        !d.getU32(hostOn) ||
+        !d.getString(s.requestedMode) || !d.getString(s.requestedOwner) ||
+        !d.getI64(offset) || !d.getI64(diffToSteadyClock) ||
+        !d.getString(s.timeOwner) || !d.getString(s.timeSyncMethod) ||
+        !d.getString(s.hostState) ||
+        !d.getU32(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        settings::Path path;
+        settings::Service service;
+        if (!d.getString(path) || !d.getString(service))
+        {
+            return false;
+        }
+        s.services.emplace(std::move(path), std::move(service));
+    }
+    if (!d.getU32(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        std::string name;
+        int64_t clockOffset;
+        if (!d.getString(name) || !d.getI64(clockOffset))
+        {
+            return false;
+        }
+        s.clocks.emplace(std::move(name),
+                         std::chrono::microseconds(clockOffset));
+    }
+    if (!d.getU32(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int64_t id;
+        std::string client;
+        int64_t deadline;
+        if (!d.getI64(id) || !d.getString(client) || !d.getI64(deadline))
+        {
+            return false;
+        }
+        s.alarms.push_back({static_cast<uint64_t>(id), std::move(client),
+                            std::chrono::microseconds(deadline)});
+    }
+    int64_t nextAlarmId;
+    if (!d.getI64(nextAlarmId))
+    {
+        return false;
+    }
+    s.nextAlarmId = nextAlarmId;
+    if (!d.getU32(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int64_t id;
+        std::string client;
+        int64_t threshold;
+        if (!d.getI64(id) || !d.getString(client) || !d.getI64(threshold))
+        {
+            return false;
+        }
+        s.subscriptions.push_back({static_cast<uint64_t>(id),
+                                   std::move(client),
+                                   std::chrono::microseconds(threshold)});
+    }
+    int64_t nextSubscriptionId;
+    if (!d.getI64(nextSubscriptionId))
+    {
+        return false;
+    }
+    s.nextSubscriptionId = nextSubscriptionId;
+    if (!d.done())
+    {
+        return false;
+    }
+
+    try
+    {
+        s.mode = utils::strToMode(mode);
+        s.owner = utils::strToOwner(owner);
+    }
+    catch (const sdbusplus::exception::InvalidEnumString&)
+    {
+        return false;
+    }
+    s.hostOn = (hostOn != 0);
+    s.offset = std::chrono::microseconds(offset);
+    s.diffToSteadyClock = std::chrono::microseconds(diffToSteadyClock);
+    state = std::move(s);
+    return true;
+}
+
+bool sendState(int sock, const HandoffState& state)
+{
+    auto data = encode(state);
+    int fd = memfd_create("phosphor-time-manager-handoff",
+                          MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create memfd",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+
+    bool ok = (write(fd, data.data(), data.size()) ==
+               static_cast<ssize_t>(data.size()));
+    // Seal it so that the receiver is able to trust the content
+    ok = ok && fcntl(fd, F_ADD_SEALS,
+                     F_SEAL_SHRINK | F_SEAL_GROW |
+                     F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+    if (!ok)
+    {
+        log<level::ERR>("Failed to write state to memfd",
+                        entry("ERRNO=%d", errno));
+    }
+    else
+    {
+        std::vector<int> fds{fd};
+        if (state.replicationFd >= 0)
+        {
+            fds.push_back(state.replicationFd);
+        }
+        ok = sendMessage(sock, {Tag::State, STATE_VERSION, data.size()},
+                         fds);
+    }
+    close(fd);
+    return ok;
+}
+
+bool receiveState(int sock, HandoffState& state)
+{
+    Message msg;
+    std::vector<int> fds;
+    if (receiveMessage(sock, msg, fds) <= 0)
+    {
+        log<level::ERR>("Failed to receive handoff state",
+                        entry("ERRNO=%d", errno));
+        closeFds(fds);
+        return false;
+    }
+    if (fds.empty())
+    {
+        log<level::ERR>("No memfd in handoff state");
+        return false;
+    }
+
+    bool ok = false;
+    struct stat st;
+    int fd = fds[0];
+    if (msg.tag == Tag::State && msg.version == STATE_VERSION &&
+        fds.size() <= MAX_FDS &&
+        fstat(fd, &st) == 0 &&
+        static_cast<uint64_t>(st.st_size) == msg.size)
+    {
+        std::string data(msg.size, '\0');
+        ok = (pread(fd, &data[0], data.size(), 0) ==
+              static_cast<ssize_t>(data.size())) &&
+             decode(data, state);
+    }
+    close(fd);
+    if (!ok)
+    {
+        log<level::ERR>("Invalid handoff state");
+        fds.erase(fds.begin());
+        closeFds(fds);
+        return false;
+    }
+    // The listening socket of the replication is owned by the receiver
+    state.replicationFd = (fds.size() > 1) ? fds[1] : -1;
+    return true;
+}
+
+} // namespace handoff
+
+HandoffServer::HandoffServer(sdbusplus::bus::bus& bus,
+                             const char* socketPath,
+                             Provider provider)
+    : bus(bus),
+      provider(std::move(provider))
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        log<level::ERR>("Handoff socket path is too long",
+                        entry("PATH=%s", socketPath));
+        return;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    listenFd = socket(AF_UNIX,
+                      SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+    {
+        log<level::ERR>("Failed to create handoff socket",
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+
+    // The socket of the previous process is not used anymore
+    unlink(socketPath);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+        listen(listenFd, 1) != 0)
+    {
+        log<level::ERR>("Failed to listen on handoff socket",
+                        entry("PATH=%s", socketPath),
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(bus.get_event(), &es,
+                             listenFd, EPOLLIN, onConnect, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    listenSource.reset(es);
+}
+
+HandoffServer::~HandoffServer()
+{
+    closeConnection();
+    listenSource.reset();
+    if (listenFd >= 0)
+    {
+        // Do not unlink the socket, it belongs to the new process
+        // if the state is handed over
+        close(listenFd);
+    }
+}
+
+void HandoffServer::closeConnection()
+{
+    connSource.reset();
+    if (connFd >= 0)
+    {
+        close(connFd);
+        connFd = -1;
+    }
+}
+
+int HandoffServer::onConnect(sd_event_source* /* es */, int fd,
+                             uint32_t /* revents */, void* userdata)
+{
+    auto server = static_cast<HandoffServer*>(userdata);
+
+    int conn = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (conn < 0)
+    {
+        return 0;
+    }
+    if (server->connFd >= 0)
+    {
+        log<level::ERR>("Handoff is already in progress");
+        close(conn);
+        return 0;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(server->bus.get_event(), &es,
+                             conn, EPOLLIN, onMessage, server);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        close(conn);
+        return 0;
+    }
+    server->connFd = conn;
+    server->connSource.reset(es);
+    return 0;
+}
+
+int HandoffServer::onMessage(sd_event_source* /* es */, int fd,
+                             uint32_t /* revents */, void* userdata)
+{
+    auto server = static_cast<HandoffServer*>(userdata);
+
+    Message msg;
+    std::vector<int> msgFds;
+    auto r = receiveMessage(fd, msg, msgFds);
+    closeFds(msgFds);
+    if (r < 0 && (errno == EAGAIN || errno == EINTR))
+    {
+        return 0;
+    }
+    if (r <= 0)
+    {
+        // The new process is gone, keep serving
+        log<level::INFO>("Handoff is aborted");
+        server->closeConnection();
+        return 0;
+    }
+
+    switch (msg.tag)
+    {
+        case Tag::Hello:
+            log<level::INFO>("Handing the state over to the new process");
+            if (!handoff::sendState(fd, server->provider()))
+            {
+                server->closeConnection();
+            }
+            break;
+        case Tag::Ready:
+        {
+            // The new process is serving and queued for the name, send it
+            // the changes since the state, and release the name to move it
+            // to the new process without handling anything in between
+            log<level::INFO>("The new process is ready, exiting");
+            // The new process has taken the sockets with the state
+            auto state = server->provider();
+            state.replicationFd = -1;
+            if (!handoff::sendState(fd, state))
+            {
+                log<level::ERR>("Failed to send the final state");
+            }
+            auto ret = sd_bus_release_name(server->bus.get(), BUSNAME);
+            if (ret < 0)
+            {
+                log<level::ERR>("Failed to release bus name",
+                                entry("ERRNO=%d", -ret));
+            }
+            sd_bus_flush(server->bus.get());
+            server->closeConnection();
+            sd_event_exit(server->bus.get_event(), 0);
+            break;
+        }
+        default:
+            server->closeConnection();
+            break;
+    }
+    return 0;
+}
+
+HandoffClient::HandoffClient(const char* socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        return;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        return;
+    }
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr),
+                sizeof(addr)) != 0)
+    {
+        // No running process, it is a cold start
+        close(sock);
+        sock = -1;
+        return;
+    }
+
+    timeval timeout{RECEIVE_TIMEOUT_SEC, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+HandoffClient::~HandoffClient()
+{
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+}
+
+bool HandoffClient::receive(HandoffState& state)
+{
+    if (sock < 0)
+    {
+        return false;
+    }
+    if (!sendMessage(sock, {Tag::Hello, STATE_VERSION, 0}) ||
+        !handoff::receiveState(sock, state))
+    {
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    log<level::INFO>("Took the state over from the running process");
+    return true;
+}
+
+bool HandoffClient::confirm(HandoffState& state)
+{
+    if (sock < 0)
+    {
+        return false;
+    }
+    bool ok = sendMessage(sock, {Tag::Ready, STATE_VERSION, 0}) &&
+              handoff::receiveState(sock, state);
+    close(sock);
+    sock = -1;
+    return ok;
+}
+
+} // namespace time
+} // namespace phosphor
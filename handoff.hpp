@@ -0,0 +1,280 @@
+#pragma once
+
+#include "settings.hpp"
+#include "types.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @struct HandoffState
+ *  @brief The state handed from the running process to its replacement.
+ */
+struct HandoffState
+{
+    /** @brief The current time mode */
+    Mode mode = Mode::Manual;
+
+    /** @brief The current time owner */
+    Owner owner = Owner::Both;
+
+    /** @brief The value to indicate if host is on */
+    bool hostOn = false;
+
+    /** @brief The requested time mode when host is on */
+    std::string requestedMode;
+
+    /** @brief The requested time owner when host is on */
+    std::string requestedOwner;
+
+    /** @brief The diff between host and BMC time */
+    std::chrono::microseconds offset{0};
+
+    /** @brief The diff between host time and steady clock */
+    std::chrono::microseconds diffToSteadyClock{0};
+
+    /** @brief The time owner settings object */
+    settings::Path timeOwner;
+
+    /** @brief The time sync method settings object */
+    settings::Path timeSyncMethod;
+
+    /** @brief The host state object */
+    settings::Path hostState;
+
+    /** @brief The services of the above objects */
+    std::map<settings::Path, settings::Service> services;
+
+    /** @brief The offsets of the virtual clocks by name */
+    std::map<std::string, std::chrono::microseconds> clocks;
+
+    /** @struct Alarm
+     *  @brief A wall clock alarm of a client
+     */
+    struct Alarm
+    {
+        /** @brief The id of the alarm */
+        uint64_t id;
+
+        /** @brief The unique bus name of the client */
+        std::string client;
+
+        /** @brief The wall clock time since UTC to fire at */
+        std::chrono::microseconds deadline;
+    };
+
+    /** @brief The alarms of the clients, the clients keep their unique
+     *  names on the bus across the restart
+     */
+    std::vector<Alarm> alarms;
+
+    /** @brief The id of the next alarm */
+    uint64_t nextAlarmId = 1;
+
+    /** @struct Subscription
+     *  @brief A subscription of a client to time changes
+     */
+    struct Subscription
+    {
+        /** @brief The id of the subscription */
+        uint64_t id;
+
+        /** @brief The unique bus name of the client */
+        std::string client;
+
+        /** @brief The threshold of the change */
+        std::chrono::microseconds threshold;
+    };
+
+    /** @brief The subscriptions of the clients to time changes */
+    std::vector<Subscription> subscriptions;
+
+    /** @brief The id of the next subscription */
+    uint64_t nextSubscriptionId = 1;
+
+    /** @brief The listening socket of the replication, or -1
+     *  @details It is passed along the memfd of the state rather than
+     *  encoded, so that the new process serves the standby on the same
+     *  socket, without binding the address the running process holds.
+     *  The received one is owned by the receiver.
+     */
+    int replicationFd = -1;
+};
+
+namespace handoff
+{
+
+/** @brief Encode the state to bytes
+ *
+ * @param[in] state - The state to encode
+ *
+ * @return The encoded bytes
+ */
+std::string encode(const HandoffState& state);
+
+/** @brief Decode the state from bytes
+ *
+ * @param[in] data - The encoded bytes
+ * @param[out] state - The decoded state
+ *
+ * @return true if the bytes are a valid encoded state
+ */
+bool decode(const std::string& data, HandoffState& state);
+
+/** @brief Send the state in a memfd over the socket, with the listening
+ *  socket of the replication if there is one
+ *
+ * @param[in] sock - The connected unix socket
+ * @param[in] state - The state to send
+ *
+ * @return true if the state is sent
+ */
+bool sendState(int sock, const HandoffState& state);
+
+/** @brief Receive the state in a memfd from the socket
+ *
+ * @param[in] sock - The connected unix socket
+ * @param[out] state - The received state
+ *
+ * @return true if a valid state is received
+ */
+bool receiveState(int sock, HandoffState& state);
+
+} // namespace handoff
+
+/** @class HandoffServer
+ *  @brief Hand the state over to a new process on request.
+ *  @details It listens on the handoff socket. When a new process connects,
+ *  the current state is sent to it in a memfd. Once the new process reports
+ *  that it is ready to serve, the final state is sent to it, and the bus
+ *  name is released and the event loop exits in the same callback, so that
+ *  nothing handled after the final state is lost, and the name moves to the
+ *  new process without a gap.
+ */
+class HandoffServer
+{
+    public:
+        using Provider = std::function<HandoffState()>;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] socketPath - The path of the handoff socket
+         * @param[in] provider - The function to get the current state
+         */
+        HandoffServer(sdbusplus::bus::bus& bus,
+                      const char* socketPath,
+                      Provider provider);
+        HandoffServer(const HandoffServer&) = delete;
+        HandoffServer& operator=(const HandoffServer&) = delete;
+        HandoffServer(HandoffServer&&) = delete;
+        HandoffServer& operator=(HandoffServer&&) = delete;
+        ~HandoffServer();
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The function to get the current state */
+        Provider provider;
+
+        /** @brief The listening socket */
+        int listenFd = -1;
+
+        /** @brief The connection of the new process */
+        int connFd = -1;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The event source of the listening socket */
+        SdEventSource listenSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief The event source of the connection */
+        SdEventSource connSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief Close the connection of the new process */
+        void closeConnection();
+
+        /** @brief The callback function on new connection
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the listening socket
+         * @param[in] revents - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onConnect(sd_event_source* es, int fd,
+                             uint32_t revents, void* userdata);
+
+        /** @brief The callback function on message from the new process
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the connection
+         * @param[in] revents - The received events
+         * @param[in] userdata - User data pointer
+         */
+        static int onMessage(sd_event_source* es, int fd,
+                             uint32_t revents, void* userdata);
+};
+
+/** @class HandoffClient
+ *  @brief Take the state over from the running process.
+ */
+class HandoffClient
+{
+    public:
+        /** @brief Connect to the running process if there is one
+         *
+         * @param[in] socketPath - The path of the handoff socket
+         */
+        explicit HandoffClient(const char* socketPath);
+        HandoffClient(const HandoffClient&) = delete;
+        HandoffClient& operator=(const HandoffClient&) = delete;
+        HandoffClient(HandoffClient&&) = delete;
+        HandoffClient& operator=(HandoffClient&&) = delete;
+        ~HandoffClient();
+
+        /** @brief Request and receive the state of the running process
+         *
+         * @param[out] state - The received state
+         *
+         * @return true if the state is received, false if there is no
+         *         running process or the handoff fails
+         */
+        bool receive(HandoffState& state);
+
+        /** @brief Tell the running process that this one is serving,
+         *  so that it releases the bus name and exits, and receive its final
+         *  state, which has the changes handled since receive()
+         *
+         * @param[out] state - The received final state
+         *
+         * @return true if the final state is received
+         */
+        bool confirm(HandoffState& state);
+
+    private:
+        /** @brief The connection to the running process */
+        int sock = -1;
+};
+
+} // namespace time
+} // namespace phosphor
@@ -12,19 +12,21 @@ using namespace phosphor::logging;
 using namespace std::chrono;
 
 HostEpoch::HostEpoch(sdbusplus::bus::bus& bus,
-                     const char* objPath)
-    : EpochBase(bus, objPath),
+                     const char* objPath,
+                     SystemClock* systemClock,
+                     const char* offsetFile)
+    : EpochBase(bus, objPath, systemClock),
+      offsetFile(offsetFile),
       offset(utils::readData<decltype(offset)::rep>(offsetFile))
 {
     // Initialize the diffToSteadyClock
-    auto steadyTime = duration_cast<microseconds>(
-        steady_clock::now().time_since_epoch());
+    auto steadyTime = getSteadyTime();
     diffToSteadyClock = getTime() + offset - steadyTime;
 }
 
 uint64_t HostEpoch::elapsed() const
 {
-    auto ret = getTime();
+    auto ret = readTime();
     if (timeOwner == Owner::Split)
     {
         ret += offset;
@@ -34,47 +36,82 @@ uint64_t HostEpoch::elapsed() const
 
 uint64_t HostEpoch::elapsed(uint64_t value)
 {
-    /*
-        Mode  | Owner | Set Host Time
-        ----- | ----- | -------------
-        NTP   | BMC   | Not allowed
-        NTP   | HOST  | Not allowed
-        NTP   | SPLIT | OK, and just save offset
-        NTP   | BOTH  | Not allowed
-        MANUAL| BMC   | Not allowed
-        MANUAL| HOST  | OK, and set time to BMC
-        MANUAL| SPLIT | OK, and just save offset
-        MANUAL| BOTH  | OK, and set time to BMC
-    */
-    if (timeOwner == Owner::BMC ||
-        (timeMode == Mode::NTP
-         && (timeOwner == Owner::Host || timeOwner == Owner::Both)))
-    {
-        log<level::ERR>("Setting HostTime is not allowed");
-        // TODO: throw NotAllowed exception
-        return 0;
-    }
+    // Stamp the request before anything else delays it
+    setElapsed(value, getReceivedTime(), nullptr);
+    return value;
+}
+
+void HostEpoch::setElapsed(uint64_t value, const microseconds& received,
+                           SetDone done)
+{
+    // Raise NotAllowed if setting host time is not allowed
+    auto action = getSetAction(Clock::Host);
 
     auto time = microseconds(value);
-    if (timeOwner == Owner::Split)
+    bool ok = true;
+    if (action == SetAction::StoreOffset)
     {
-        // Calculate the offset between host and bmc time
-        offset = time - getTime();
+        // Calculate the offset between host and bmc time, against the
+        // requested time as of now
+        auto hostTime = latency ? latency->compensate(time, received) : time;
+        offset = hostTime - getTime();
         saveOffset();
 
         // Calculate the diff between host and steady time
-        auto steadyTime = duration_cast<microseconds>(
-            steady_clock::now().time_since_epoch());
-        diffToSteadyClock = time - steadyTime;
+        auto steadyTime = getSteadyTime();
+        diffToSteadyClock = hostTime - steadyTime;
+    }
+    else if (pipeline)
+    {
+        // Set time to BMC, the change is notified by BmcEpoch
+        pipeline->submit(time, received,
+                         [this, done](bool isSet, const microseconds& set)
+                         {
+                             if (isSet)
+                             {
+                                 server::EpochTime::elapsed(set.count());
+                             }
+                             if (done)
+                             {
+                                 done(isSet);
+                             }
+                         });
+        return;
     }
     else
     {
-        // Set time to BMC
-        setTime(time);
+        // Set time to BMC, the change is notified by BmcEpoch
+        ok = setRequestedTime(time, received);
     }
 
     server::EpochTime::elapsed(value);
-    return value;
+    if (done)
+    {
+        done(ok);
+    }
+}
+
+void HostEpoch::onTimeStateChanged(const TimeStateChange& change)
+{
+    EpochBase::onTimeStateChanged(change);
+    if (change.has(TimeStateChange::BmcTimeJumped))
+    {
+        onBmcTimeChanged(change.bmcTime);
+    }
+}
+
+TimeStateDispatcher::Subscription HostEpoch::subscribe(
+    TimeStateDispatcher::Handler handler)
+{
+    // Notify subscriber about the initial value
+    TimeStateChange change;
+    change.changed = TimeStateChange::OffsetChanged;
+    change.mode = timeMode;
+    change.owner = timeOwner;
+    change.offset = offset;
+    handler(change);
+
+    return dispatcher.subscribe(std::move(handler));
 }
 
 void HostEpoch::onOwnerChanged(Owner owner)
@@ -90,17 +127,48 @@ void HostEpoch::onOwnerChanged(Owner owner)
     else
     {
         // In SPLIT, need to re-calculate the diff between
-        // host and steady time
-        auto steadyTime = duration_cast<microseconds>(
-            steady_clock::now().time_since_epoch());
-        diffToSteadyClock = getTime() - steadyTime;
+        // host and steady time, the offset is kept
+        auto steadyTime = getSteadyTime();
+        diffToSteadyClock = getTime() + offset - steadyTime;
+    }
+}
+
+void HostEpoch::save(HandoffState& state) const
+{
+    state.offset = offset;
+    state.diffToSteadyClock = diffToSteadyClock;
+}
+
+void HostEpoch::restore(const HandoffState& state)
+{
+    // The steady clock is shared by the processes, so the diff
+    // is still valid
+    auto changed = (offset != state.offset);
+    offset = state.offset;
+    diffToSteadyClock = state.diffToSteadyClock;
+    if (changed)
+    {
+        // The previous process has saved it to the file already
+        TimeStateChange change;
+        change.changed = TimeStateChange::OffsetChanged;
+        change.mode = timeMode;
+        change.owner = timeOwner;
+        change.offset = offset;
+        dispatcher.dispatch(change);
     }
 }
 
 void HostEpoch::saveOffset()
 {
     // Store the offset to file
-    utils::writeData(offsetFile, offset.count());
+    utils::writeData(offsetFile.c_str(), offset.count());
+
+    TimeStateChange change;
+    change.changed = TimeStateChange::OffsetChanged;
+    change.mode = timeMode;
+    change.owner = timeOwner;
+    change.offset = offset;
+    dispatcher.dispatch(change);
 }
 
 void HostEpoch::onBmcTimeChanged(const microseconds& bmcTime)
@@ -109,8 +177,7 @@ void HostEpoch::onBmcTimeChanged(const microseconds& bmcTime)
     // the offset shall be adjusted
     if (timeOwner == Owner::Split)
     {
-        auto steadyTime = duration_cast<microseconds>(
-            steady_clock::now().time_since_epoch());
+        auto steadyTime = getSteadyTime();
         auto hostTime = steadyTime + diffToSteadyClock;
         offset = hostTime - bmcTime;
 
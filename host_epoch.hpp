@@ -1,10 +1,12 @@
 #pragma once
 
-#include "bmc_time_change_listener.hpp"
 #include "config.h"
 #include "epoch_base.hpp"
+#include "handoff.hpp"
+#include "time_state_change.hpp"
 
 #include <chrono>
+#include <string>
 
 namespace phosphor
 {
@@ -16,12 +18,24 @@ namespace time
  *  @details A concrete implementation for xyz.openbmc_project.Time.EpochTime
  *  DBus API for HOST's epoch time.
  */
-class HostEpoch : public EpochBase, public BmcTimeChangeListener
+class HostEpoch : public EpochBase
 {
     public:
         friend class TestHostEpoch;
+        friend class Simulation;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] systemClock - The clocks to read and set, or nullptr
+         *                          for the real ones
+         * @param[in] offsetFile - The file to store the offset in
+         */
         HostEpoch(sdbusplus::bus::bus& bus,
-                  const char* objPath);
+                  const char* objPath,
+                  SystemClock* systemClock = nullptr,
+                  const char* offsetFile = defaultOffsetFile);
 
         /**
          * @brief Get value of Elapsed property
@@ -39,6 +53,12 @@ class HostEpoch : public EpochBase, public BmcTimeChangeListener
          **/
         uint64_t elapsed(uint64_t value) override;
 
+        /** @brief Notified on time state changed
+         *
+         * @param[in] change - The changed time state
+         */
+        void onTimeStateChanged(const TimeStateChange& change) override;
+
         /** @brief Notified on time owner changed */
         void onOwnerChanged(Owner owner) override;
 
@@ -46,10 +66,48 @@ class HostEpoch : public EpochBase, public BmcTimeChangeListener
          *
          * @param[in] bmcTime - The epoch time in microseconds
          */
-        void onBmcTimeChanged(
-            const std::chrono::microseconds& bmcTime) override;
+        void onBmcTimeChanged(const std::chrono::microseconds& bmcTime);
+
+        /** @brief Subscribe to host offset change
+         *  @details The handler is called with the current offset right
+         *  away, and then each time when it is changed.
+         *
+         * @param[in] handler - The function called when offset is changed
+         *
+         * @return The subscription that keeps the handler subscribed
+         */
+        TimeStateDispatcher::Subscription subscribe(
+            TimeStateDispatcher::Handler handler);
+
+        /** @brief Save the state to hand it over to a new process
+         *
+         * @param[out] state - The state to save to
+         */
+        void save(HandoffState& state) const;
+
+        /** @brief Take the state over from the previous process, the
+         *  subscribers are notified if the offset is changed, e.g. by the
+         *  final state of the previous process
+         *
+         * @param[in] state - The handed over state
+         */
+        void restore(const HandoffState& state);
+
+        /** @brief The default file to store the offset in File System.
+         *  Read back when starts
+         **/
+        static constexpr auto defaultOffsetFile = HOST_OFFSET_FILE;
+
+    protected:
+        /** @brief Apply an Elapsed set of the host time */
+        void setElapsed(uint64_t value,
+                        const std::chrono::microseconds& received,
+                        SetDone done) override;
 
     private:
+        /** @brief The file to store the offset in */
+        std::string offsetFile;
+
         /** @brief The diff between BMC and Host time */
         std::chrono::microseconds offset;
 
@@ -61,13 +119,13 @@ class HostEpoch : public EpochBase, public BmcTimeChangeListener
         */
         std::chrono::microseconds diffToSteadyClock;
 
-        /** @brief Save the offset value into offsetFile */
-        void saveOffset();
+        /** @brief The dispatcher of host offset change */
+        TimeStateDispatcher dispatcher;
 
-        /** @brief The file to store the offset in File System.
-         *  Read back when starts
-         **/
-        static constexpr auto offsetFile = HOST_OFFSET_FILE;
+        /** @brief Save the offset value into offsetFile and notify
+         *  the subscribers
+         */
+        void saveOffset();
 };
 
 } // namespace time
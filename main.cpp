@@ -1,9 +1,42 @@
 #include <sdbusplus/bus.hpp>
 
 #include "config.h"
-#include "bmc_epoch.hpp"
-#include "host_epoch.hpp"
-#include "manager.hpp"
+#include "daemon.hpp"
+#include "utils.hpp"
+#ifdef WAKEUP_AUDIT
+#include "wakeup_audit.hpp"
+#endif
+
+#include <signal.h>
+
+#include <memory>
+
+namespace // anonymous
+{
+
+/** @brief The callback function on SIGTERM, it saves the time floor and
+ *  exits the event loop, so the objects write their files as they are
+ *  destroyed
+ *
+ * @param[in] es - Source of the event
+ * @param[in] si - Not used
+ * @param[in] userdata - The daemon
+ */
+int onTerm(sd_event_source* es, const struct signalfd_siginfo* /* si */,
+           void* userdata)
+{
+#ifdef TIME_FLOOR
+    using namespace phosphor::time;
+    auto daemon = static_cast<Daemon*>(userdata);
+    daemon->timeFloor().save(utils::now(ClockRead::Precise));
+#else
+    (void)userdata;
+#endif
+    sd_event_exit(sd_event_source_get_event(es), 0);
+    return 0;
+}
+
+} // namespace anonymous
 
 int main()
 {
@@ -23,22 +56,60 @@ int main()
     // attach bus to this event loop
     bus.attach_event(sdEvent.get(), SD_EVENT_PRIORITY_NORMAL);
 
-    // Add sdbusplus ObjectManager
-    sdbusplus::server::manager::manager bmcEpochObjManager(bus, OBJPATH_BMC);
-    sdbusplus::server::manager::manager hostEpochObjManager(bus, OBJPATH_HOST);
+#ifdef LIVE_RESTART
+    // Take the state over from the running process if there is one
+    phosphor::time::HandoffClient handoffClient(HANDOFF_SOCKET);
+    phosphor::time::HandoffState handedState;
+    bool handedOver = handoffClient.receive(handedState);
+    phosphor::time::Daemon daemon(bus, handedOver ? &handedState : nullptr);
+#else
+    phosphor::time::Daemon daemon(bus, nullptr);
+#endif
 
-    phosphor::time::Manager manager(bus);
-    phosphor::time::BmcEpoch bmc(bus, OBJPATH_BMC);
-    phosphor::time::HostEpoch host(bus,OBJPATH_HOST);
-
-    manager.addListener(&bmc);
-    manager.addListener(&host);
-    bmc.setBmcTimeChangeListener(&host);
+#ifdef LIVE_RESTART
+    // Queue for the name, the running process releases it once it
+    // is confirmed that this one is serving
+    auto r = sd_bus_request_name(bus.get(), BUSNAME, SD_BUS_NAME_QUEUE);
+    if (r < 0)
+    {
+        return -1;
+    }
+    if (handedOver)
+    {
+        // Take the changes that the running process handled since the
+        // state over, and read the settings again for the ones that
+        // happened before the matches are added
+        phosphor::time::HandoffState finalState;
+        bool confirmed = handoffClient.confirm(finalState);
+        daemon.restore(confirmed ? &finalState : nullptr);
+        daemon.manager().refresh();
+    }
 
+    phosphor::time::HandoffServer handoffServer(
+        bus, HANDOFF_SOCKET,
+        [&daemon]()
+        {
+            phosphor::time::HandoffState state;
+            daemon.save(state);
+            return state;
+        });
+#else
     bus.request_name(BUSNAME);
+#endif
+
+    // SIGTERM shall be blocked to be handled by sd_event
+    sigset_t ss;
+    sigemptyset(&ss);
+    sigaddset(&ss, SIGTERM);
+    sigprocmask(SIG_BLOCK, &ss, nullptr);
+    sd_event_add_signal(bus.get_event(), nullptr, SIGTERM, onTerm, &daemon);
 
     // Start event loop for all sd-bus events and timer event
+#ifdef WAKEUP_AUDIT
+    phosphor::time::wakeup::run(bus.get_event(), WAKEUP_AUDIT_FILE);
+#else
     sd_event_loop(bus.get_event());
+#endif
 
     bus.detach_event();
 
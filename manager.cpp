@@ -1,5 +1,6 @@
 #include "manager.hpp"
 #include "utils.hpp"
+#include "wakeup_audit.hpp"
 
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -29,10 +30,83 @@ using namespace phosphor::logging;
 const std::set<std::string>
 Manager::managedProperties = {PROPERTY_TIME_MODE, PROPERTY_TIME_OWNER};
 
-Manager::Manager(sdbusplus::bus::bus& bus)
-    : bus(bus)
+Manager::Manager(sdbusplus::bus::bus& bus,
+                 const char* modeFile,
+                 const char* ownerFile,
+                 SystemClock* systemClock)
+    : bus(bus),
+      modeFile(modeFile),
+      ownerFile(ownerFile),
+      settings(bus),
+      systemClock(systemClock)
+{
+    addMatches();
+
+    hostOn = readHostOn();
+
+    // Restore settings from persistent storage
+    restoreSettings();
+
+    // Check the settings daemon to process the new settings
+    auto mode = getSetting(settings.timeSyncMethod.c_str(),
+                           settings::timeSyncIntf,
+                           PROPERTY_TIME_MODE);
+    auto owner = getSetting(settings.timeOwner.c_str(),
+                            settings::timeOwnerIntf,
+                            PROPERTY_TIME_OWNER);
+
+    onPropertyChanged(PROPERTY_TIME_MODE, mode);
+    onPropertyChanged(PROPERTY_TIME_OWNER, owner);
+}
+
+Manager::Manager(sdbusplus::bus::bus& bus, const HandoffState& state,
+                 SystemClock* systemClock,
+                 const char* modeFile,
+                 const char* ownerFile)
+    : bus(bus),
+      modeFile(modeFile),
+      ownerFile(ownerFile),
+      settings(bus,
+               state.timeOwner,
+               state.timeSyncMethod,
+               state.hostState,
+               state.services),
+      hostOn(state.hostOn),
+      requestedMode(state.requestedMode),
+      requestedOwner(state.requestedOwner),
+      timeMode(state.mode),
+      timeOwner(state.owner),
+      systemClock(systemClock)
+{
+    // The previous process has been tracking the settings and host state,
+    // keep tracking them from here on
+    addMatches();
+}
+
+void Manager::save(HandoffState& state) const
+{
+    state.mode = timeMode;
+    state.owner = timeOwner;
+    state.hostOn = hostOn;
+    state.requestedMode = requestedMode;
+    state.requestedOwner = requestedOwner;
+    state.timeOwner = settings.timeOwner;
+    state.timeSyncMethod = settings.timeSyncMethod;
+    state.hostState = settings.hostState;
+    state.services = settings.services;
+}
+
+void Manager::addMatches()
+{
+    addObjectMatches();
+    addServiceMatches();
+}
+
+void Manager::addObjectMatches()
 {
     using namespace sdbusplus::bus::match::rules;
+    settingsMatches.clear();
+    interfacesAddedMatches.clear();
     hostStateChangeMatch =
         std::make_unique<decltype(hostStateChangeMatch)::element_type>(
             bus,
@@ -50,59 +124,78 @@ Manager::Manager(sdbusplus::bus::bus& bus)
         std::bind(std::mem_fn(&Manager::onSettingsChanged),
           this, std::placeholders::_1));
 
-    checkHostOn();
-
-    // Restore settings from persistent storage
-    restoreSettings();
-
-    // Check the settings daemon to process the new settings
-    auto mode = getSetting(settings.timeSyncMethod.c_str(),
-                           settings::timeSyncIntf,
-                           PROPERTY_TIME_MODE);
-    auto owner = getSetting(settings.timeOwner.c_str(),
-                            settings::timeOwnerIntf,
-                            PROPERTY_TIME_OWNER);
-
-    onPropertyChanged(PROPERTY_TIME_MODE, mode);
-    onPropertyChanged(PROPERTY_TIME_OWNER, owner);
+    for (const auto& path : {settings.timeOwner,
+                             settings.timeSyncMethod,
+                             settings.hostState})
+    {
+        interfacesAddedMatches.emplace_back(
+            bus,
+            interfacesAdded() + argNpath(0, path),
+            std::bind(std::mem_fn(&Manager::onInterfacesAdded),
+                      this, std::placeholders::_1));
+    }
 }
 
-void Manager::addListener(PropertyChangeListner* listener)
+void Manager::addServiceMatches()
 {
-    // Notify listener about the initial value
-    listener->onModeChanged(timeMode);
-    listener->onOwnerChanged(timeOwner);
+    using namespace sdbusplus::bus::match::rules;
+    for (const auto& s : settings.services)
+    {
+        const auto& service = s.second;
+        if (serviceMatches.find(service) != serviceMatches.end())
+        {
+            continue;
+        }
+        serviceMatches.emplace(
+            service,
+            std::make_unique<sdbusplus::bus::match::match>(
+                bus,
+                nameOwnerChanged() + argN(0, service),
+                std::bind(std::mem_fn(&Manager::onServiceOwnerChanged),
+                          this, std::placeholders::_1)));
+    }
+}
 
-    listeners.insert(listener);
+TimeStateDispatcher::Subscription Manager::subscribe(
+    TimeStateDispatcher::Handler handler)
+{
+    // Notify subscriber about the initial value
+    TimeStateChange change;
+    change.changed =
+        TimeStateChange::ModeChanged | TimeStateChange::OwnerChanged;
+    change.mode = timeMode;
+    change.owner = timeOwner;
+    handler(change);
+
+    return dispatcher.subscribe(std::move(handler));
 }
 
 void Manager::restoreSettings()
 {
-    auto mode = utils::readData<std::string>(modeFile);
+    auto mode = utils::readData<std::string>(modeFile.c_str());
     if (!mode.empty())
     {
         timeMode = utils::strToMode(mode);
     }
-    auto owner = utils::readData<std::string>(ownerFile);
+    auto owner = utils::readData<std::string>(ownerFile.c_str());
     if (!owner.empty())
     {
         timeOwner = utils::strToOwner(owner);
     }
 }
 
-void Manager::checkHostOn()
+bool Manager::readHostOn()
 {
     using Host = sdbusplus::xyz::openbmc_project::State::server::Host;
-    auto hostService = utils::getService(bus,
-                                         settings.hostState.c_str(),
-                                         settings::hostStateIntf);
+    auto hostService = settings.service(settings.hostState,
+                                        settings::hostStateIntf);
     auto stateStr = utils::getProperty<std::string>(bus,
                                                     hostService.c_str(),
                                                     settings.hostState.c_str(),
                                                     settings::hostStateIntf,
                                                     HOST_CURRENT_STATE);
     auto state = Host::convertHostStateFromString(stateStr);
-    hostOn = (state == Host::HostState::Running);
+    return state == Host::HostState::Running;
 }
 
 void Manager::onPropertyChanged(const std::string& key,
@@ -111,21 +204,22 @@ void Manager::onPropertyChanged(const std::string& key,
     if (hostOn)
     {
         // If host is on, set the values as requested time mode/owner.
-        // And when host becomes off, notify the listeners.
+        // And when host becomes off, notify the subscribers.
         setPropertyAsRequested(key, value);
     }
     else
     {
-        // If host is off, notify listeners
+        // If host is off, notify subscribers
         if (key == PROPERTY_TIME_MODE)
         {
             setCurrentTimeMode(value);
             onTimeModeChanged(value);
+            notifyStateChange(TimeStateChange::ModeChanged);
         }
         else if (key == PROPERTY_TIME_OWNER)
         {
             setCurrentTimeOwner(value);
-            onTimeOwnerChanged();
+            notifyStateChange(TimeStateChange::OwnerChanged);
         }
     }
 }
@@ -133,21 +227,181 @@ void Manager::onPropertyChanged(const std::string& key,
 int Manager::onSettingsChanged(sdbusplus::message::message& msg)
 {
     using Interface = std::string;
-    using Property = std::string;
-    using Value = std::string;
-    using Properties = std::map<Property, sdbusplus::message::variant<Value>>;
 
     Interface interface;
     Properties properties;
 
     msg.read(interface, properties);
 
+    auto changed = applySettings(properties);
+    wakeup::count(wakeup::Source::SettingsChanged, changed);
+
+    return 0;
+}
+
+bool Manager::applySettings(const Properties& properties)
+{
+    bool changed = false;
+    for(const auto& p : properties)
+    {
+        const auto& value = p.second.get<std::string>();
+        if (managedProperties.find(p.first) == managedProperties.end() ||
+            !isNewValue(p.first, value))
+        {
+            // Not a time setting, or the same as before
+            continue;
+        }
+        onPropertyChanged(p.first, value);
+        changed = true;
+    }
+    return changed;
+}
+
+bool Manager::applyHostState(const Properties& properties)
+{
+    using Host = sdbusplus::xyz::openbmc_project::State::server::Host;
+
     for(const auto& p : properties)
     {
-        onPropertyChanged(p.first, p.second.get<std::string>());
+        if (p.first == HOST_CURRENT_STATE)
+        {
+            auto state = Host::convertHostStateFromString(p.second.get<std::string>());
+            bool on = (state == Host::HostState::Running);
+            bool changed = (on != hostOn);
+            onHostState(on);
+            return changed;
+        }
     }
+    return false;
+}
 
-    return 0;
+bool Manager::reread(const std::string& interface)
+{
+    const auto& path = settings.pathOf(interface);
+    try
+    {
+        if (interface == settings::hostStateIntf)
+        {
+            onHostState(readHostOn());
+            return true;
+        }
+        auto key = (interface == settings::timeOwnerIntf) ?
+                   PROPERTY_TIME_OWNER : PROPERTY_TIME_MODE;
+        auto value = getSetting(path.c_str(), interface.c_str(), key);
+        if (isNewValue(key, value))
+        {
+            onPropertyChanged(key, value);
+        }
+        return true;
+    }
+    catch (const std::exception&)
+    {
+        // The lookups and the property gets report the errors by elog,
+        // the object is discovered again by the caller
+        log<level::ERR>("Failed to read the object again",
+                        entry("PATH=%s", path.c_str()),
+                        entry("INTERFACE=%s", interface.c_str()));
+        return false;
+    }
+}
+
+void Manager::onServiceOwnerChanged(sdbusplus::message::message& msg)
+{
+    std::string name;
+    std::string oldOwner;
+    std::string newOwner;
+    msg.read(name, oldOwner, newOwner);
+    if (newOwner.empty())
+    {
+        // The objects are read again when it is back
+        log<level::INFO>("Service is gone",
+                         entry("SERVICE=%s", name.c_str()));
+        wakeup::count(wakeup::Source::ServiceRestarted, false);
+        return;
+    }
+
+    log<level::INFO>("Service is started, reading its objects again",
+                     entry("SERVICE=%s", name.c_str()));
+    readObjects(&name);
+    wakeup::count(wakeup::Source::ServiceRestarted, true);
+}
+
+void Manager::refresh()
+{
+    readObjects(nullptr);
+}
+
+void Manager::readObjects(const std::string* service)
+{
+    bool moved = false;
+    for (const auto& interface : {settings::timeOwnerIntf,
+                                  settings::timeSyncIntf,
+                                  settings::hostStateIntf})
+    {
+        auto it = settings.services.find(settings.pathOf(interface));
+        if (service &&
+            (it == settings.services.end() || it->second != *service))
+        {
+            // Not an object of the service
+            continue;
+        }
+        if (reread(interface))
+        {
+            continue;
+        }
+
+        // The object may be at another path now
+        auto path = settings.pathOf(interface);
+        if (settings.rediscover(interface) &&
+            settings.pathOf(interface) != path)
+        {
+            moved = true;
+            reread(interface);
+        }
+    }
+    if (moved)
+    {
+        addObjectMatches();
+        addServiceMatches();
+    }
+}
+
+void Manager::onInterfacesAdded(sdbusplus::message::message& msg)
+{
+    using Interface = std::string;
+
+    sdbusplus::message::object_path path;
+    std::map<Interface, Properties> interfaces;
+    msg.read(path, interfaces);
+
+    bool changed = false;
+    for (const auto& i : interfaces)
+    {
+        if (i.first == settings::hostStateIntf)
+        {
+            changed |= applyHostState(i.second);
+        }
+        else if (i.first == settings::timeOwnerIntf ||
+                 i.first == settings::timeSyncIntf)
+        {
+            changed |= applySettings(i.second);
+        }
+    }
+    wakeup::count(wakeup::Source::ServiceRestarted, changed);
+}
+
+bool Manager::isNewValue(const std::string& key,
+                         const std::string& value) const
+{
+    bool isMode = (key == PROPERTY_TIME_MODE);
+    const auto& requested = isMode ? requestedMode : requestedOwner;
+    if (hostOn && !requested.empty())
+    {
+        return value != requested;
+    }
+    auto current = isMode ? utils::modeToStr(timeMode)
+                          : utils::ownerToStr(timeOwner);
+    return value != current;
 }
 
 void Manager::setPropertyAsRequested(const std::string& key,
@@ -187,14 +441,31 @@ void Manager::updateNtpSetting(const std::string& value)
 {
     bool isNtp =
         (value == "xyz.openbmc_project.Time.Synchronization.Method.NTP");
-    auto method = bus.new_method_call(SYSTEMD_TIME_SERVICE,
-                                      SYSTEMD_TIME_PATH,
-                                      SYSTEMD_TIME_INTERFACE,
-                                      METHOD_SET_NTP);
-    method.append(isNtp, false); // isNtp: 'true/false' means Enable/Disable
-                                 // 'false' meaning no policy-kit
-
-    if (bus.call(method))
+    bool done;
+    if (systemClock)
+    {
+        done = systemClock->setNtp(isNtp);
+    }
+    else
+    {
+        auto method = bus.new_method_call(SYSTEMD_TIME_SERVICE,
+                                          SYSTEMD_TIME_PATH,
+                                          SYSTEMD_TIME_INTERFACE,
+                                          METHOD_SET_NTP);
+        method.append(isNtp, false); // isNtp: 'true/false' means
+                                     // Enable/Disable
+                                     // 'false' meaning no policy-kit
+        if (breaker)
+        {
+            done = breaker->call(method.get());
+        }
+        else
+        {
+            done = static_cast<bool>(bus.call(method));
+        }
+    }
+
+    if (done)
     {
         log<level::INFO>("Updated NTP setting",
                          entry("ENABLED:%d", isNtp));
@@ -208,29 +479,23 @@ void Manager::updateNtpSetting(const std::string& value)
 void Manager::onHostStateChanged(sdbusplus::message::message& msg)
 {
     using Interface = std::string;
-    using Property = std::string;
-    using Value = std::string;
-    using Properties = std::map<Property, sdbusplus::message::variant<Value>>;
-    using Host = sdbusplus::xyz::openbmc_project::State::server::Host;
 
     Interface interface;
     Properties properties;
 
     msg.read(interface, properties);
 
-    for(const auto& p : properties)
-    {
-        if (p.first == HOST_CURRENT_STATE)
-        {
-            auto state = Host::convertHostStateFromString(p.second.get<std::string>());
-            onHostState(state == Host::HostState::Running);
-            break;
-        }
-    }
+    auto changed = applyHostState(properties);
+    wakeup::count(wakeup::Source::HostStateChanged, changed);
 }
 
 void Manager::onHostState(bool on)
 {
+    if (on == hostOn)
+    {
+        // e.g. from Running to Running after a transition is requested
+        return;
+    }
     hostOn = on;
     if (hostOn)
     {
@@ -238,11 +503,13 @@ void Manager::onHostState(bool on)
         return;
     }
     log<level::INFO>("Changing time settings allowed now");
+    uint8_t changed = 0;
     if (!requestedMode.empty())
     {
         if (setCurrentTimeMode(requestedMode))
         {
             onTimeModeChanged(requestedMode);
+            changed |= TimeStateChange::ModeChanged;
         }
         setRequestedMode({}); // Clear requested mode
     }
@@ -250,10 +517,15 @@ void Manager::onHostState(bool on)
     {
         if (setCurrentTimeOwner(requestedOwner))
         {
-            onTimeOwnerChanged();
+            changed |= TimeStateChange::OwnerChanged;
         }
         setRequestedOwner({}); // Clear requested owner
     }
+    if (changed != 0)
+    {
+        // Notify the deferred mode and owner in one event
+        notifyStateChange(changed);
+    }
 }
 
 bool Manager::setCurrentTimeMode(const std::string& mode)
@@ -264,7 +536,7 @@ bool Manager::setCurrentTimeMode(const std::string& mode)
         log<level::INFO>("Time mode is changed",
                          entry("MODE=%s", mode.c_str()));
         timeMode = newMode;
-        utils::writeData(modeFile, mode);
+        utils::writeData(modeFile.c_str(), mode);
         return true;
     }
     else
@@ -281,7 +553,7 @@ bool Manager::setCurrentTimeOwner(const std::string& owner)
         log<level::INFO>("Time owner is changed",
                          entry("OWNER=%s", owner.c_str()));
         timeOwner = newOwner;
-        utils::writeData(ownerFile, owner);
+        utils::writeData(ownerFile.c_str(), owner);
         return true;
     }
     else
@@ -292,27 +564,24 @@ bool Manager::setCurrentTimeOwner(const std::string& owner)
 
 void Manager::onTimeModeChanged(const std::string& mode)
 {
-    for (const auto listener : listeners)
-    {
-        listener->onModeChanged(timeMode);
-    }
     // When time_mode is updated, update the NTP setting
     updateNtpSetting(mode);
 }
 
-void Manager::onTimeOwnerChanged()
+void Manager::notifyStateChange(uint8_t changed)
 {
-    for (const auto& listener : listeners)
-    {
-        listener->onOwnerChanged(timeOwner);
-    }
+    TimeStateChange change;
+    change.changed = changed;
+    change.mode = timeMode;
+    change.owner = timeOwner;
+    dispatcher.dispatch(change);
 }
 
 std::string Manager::getSetting(const char* path,
                                 const char* interface,
                                 const char* setting) const
 {
-    std::string settingManager = utils::getService(bus, path, interface);
+    std::string settingManager = settings.service(path, interface);
     return utils::getProperty<std::string>(bus,
                                            settingManager.c_str(),
                                            path,
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "circuit_breaker.hpp"
+#include "handoff.hpp"
 #include "types.hpp"
-#include "property_change_listener.hpp"
 #include "settings.hpp"
+#include "system_clock.hpp"
+#include "time_state_change.hpp"
 
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/bus/match.hpp>
@@ -19,37 +22,120 @@ namespace time
  *  @brief The manager to handle OpenBMC time.
  *  @details It registers various time related settings and properties signals
  *  on DBus and handle the changes.
- *  For certain properties it also notifies the changed events to listeners.
+ *  For certain properties it also notifies the changed events to subscribers.
  */
 class Manager
 {
     public:
         friend class TestManager;
+        friend class Simulation;
+        friend class HotPaths;
 
-        explicit Manager(sdbusplus::bus::bus& bus);
+        /** @brief Constructor - discover the settings and read them
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] modeFile - The file to save the time mode in
+         * @param[in] ownerFile - The file to save the time owner in
+         * @param[in] systemClock - The clocks to enable NTP on, or nullptr
+         *                          for the real ones
+         */
+        explicit Manager(sdbusplus::bus::bus& bus,
+                         const char* modeFile = defaultModeFile,
+                         const char* ownerFile = defaultOwnerFile,
+                         SystemClock* systemClock = nullptr);
+
+        /** @brief Constructor - take the state over from the previous
+         *  process, without discovering the settings again, they are read
+         *  again by refresh()
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] state - The handed over state
+         * @param[in] systemClock - The clocks to enable NTP on, or nullptr
+         *                          for the real ones
+         * @param[in] modeFile - The file to save the time mode in
+         * @param[in] ownerFile - The file to save the time owner in
+         */
+        Manager(sdbusplus::bus::bus& bus, const HandoffState& state,
+                SystemClock* systemClock = nullptr,
+                const char* modeFile = defaultModeFile,
+                const char* ownerFile = defaultOwnerFile);
         Manager(const Manager&) = delete;
         Manager& operator=(const Manager&) = delete;
         Manager(Manager&&) = delete;
         Manager& operator=(Manager&&) = delete;
         ~Manager() = default;
 
-        /** @brief Add a listener that will be called
-          * when property is changed
-         **/
-        void addListener(PropertyChangeListner* listener);
+        /** @brief Subscribe to time mode and owner change
+         *  @details The handler is called with the current mode and owner
+         *  right away, and then each time when they are changed.
+         *
+         * @param[in] handler - The function called on the change
+         *
+         * @return The subscription that keeps the handler subscribed
+         */
+        TimeStateDispatcher::Subscription subscribe(
+            TimeStateDispatcher::Handler handler);
+
+        /** @brief Save the state to hand it over to a new process
+         *
+         * @param[out] state - The state to save to
+         */
+        void save(HandoffState& state) const;
+
+        /** @brief Read the settings and host state again, and apply the
+         *  changes
+         *  @details A process that takes the state over calls it once its
+         *  matches are added, so that the changes made before that are
+         *  not missed.
+         */
+        void refresh();
+
+        /** @brief Make the SetNTP calls through the breaker
+         *
+         * @param[in] timedated - The breaker of the timedated calls
+         */
+        void useBreaker(CircuitBreaker& timedated)
+        {
+            breaker = &timedated;
+        }
+
+        /** @brief The default file name of saved time mode */
+        static constexpr auto defaultModeFile =
+            "/var/lib/obmc/saved_time_mode";
+
+        /** @brief The default file name of saved time owner */
+        static constexpr auto defaultOwnerFile =
+            "/var/lib/obmc/saved_time_owner";
 
     private:
         /** @brief Persistent sdbusplus DBus connection */
         sdbusplus::bus::bus& bus;
 
+        /** @brief The file name of saved time mode */
+        std::string modeFile;
+
+        /** @brief The file name of saved time owner */
+        std::string ownerFile;
+
         /** @brief The match of settings property change */
         std::vector<sdbusplus::bus::match::match> settingsMatches;
 
         /** @brief The match of host state change */
         std::unique_ptr<sdbusplus::bus::match::match> hostStateChangeMatch;
 
-        /** @brief The container to hold all the listeners */
-        std::set<PropertyChangeListner*> listeners;
+        /** @brief The matches of the settings and host state objects added
+         *  again, e.g. by a restarted service
+         */
+        std::vector<sdbusplus::bus::match::match> interfacesAddedMatches;
+
+        /** @brief The matches of the owner change of the services of the
+         *  objects, by the service
+         */
+        std::map<settings::Service,
+                 std::unique_ptr<sdbusplus::bus::match::match>> serviceMatches;
+
+        /** @brief The dispatcher of mode and owner change */
+        TimeStateDispatcher dispatcher;
 
         /** @brief Settings objects of intereset */
         settings::Objects settings;
@@ -69,11 +155,39 @@ class Manager
         /** @brief The current time owner */
         Owner timeOwner;
 
+        /** @brief The clocks to enable NTP on, or nullptr for the real
+         *  ones
+         */
+        SystemClock* systemClock = nullptr;
+
+        /** @brief The breaker of the SetNTP calls, or nullptr to wait for
+         *  the default timeout of sd-bus
+         */
+        CircuitBreaker* breaker = nullptr;
+
+        /** @brief Add the matches of settings and host state change, and
+         *  of the restart of their services
+         */
+        void addMatches();
+
+        /** @brief Add the matches of the settings and host state objects,
+         *  replacing the ones of the previous objects
+         */
+        void addObjectMatches();
+
+        /** @brief Add the matches of the owner change of the services that
+         *  are not matched yet
+         */
+        void addServiceMatches();
+
         /** @brief Restore saved settings */
         void restoreSettings();
 
-        /** @brief Check if host is on and update hostOn variable */
-        void checkHostOn();
+        /** @brief Read the host state
+         *
+         * @return true if host is on
+         */
+        bool readHostOn();
 
         /** @brief Get setting from settingsd service
          *
@@ -107,17 +221,70 @@ class Manager
 
         /** @brief Called on time mode is changed
          *
-         * Notify listeners that time mode is changed and update ntp setting
+         * Update ntp setting
          *
          * @param[in] mode - The string of time mode
          */
         void onTimeModeChanged(const std::string& mode);
 
-        /** @brief Called on time owner is changed
+        /** @brief Notify the subscribers that time state is changed
+         *
+         * @param[in] changed - The bitmask of TimeStateChange::Changed
+         */
+        void notifyStateChange(uint8_t changed);
+
+        using Properties =
+            std::map<std::string, sdbusplus::message::variant<std::string>>;
+
+        /** @brief Apply the time settings in the properties
+         *
+         * @param[in] properties - The properties of a settings object
+         *
+         * @return true if a setting is new
+         */
+        bool applySettings(const Properties& properties);
+
+        /** @brief Apply the host state in the properties
+         *
+         * @param[in] properties - The properties of the host state object
+         *
+         * @return true if the host state is changed
+         */
+        bool applyHostState(const Properties& properties);
+
+        /** @brief Read the property of the object of an interface again,
+         *  and apply it if it is changed
+         *
+         * @param[in] interface - One of the interfaces of interest
+         *
+         * @return true if it is read
+         */
+        bool reread(const std::string& interface);
+
+        /** @brief Read the objects again, and discover them again if
+         *  they are not found at the known paths
          *
-         * Notify listeners that time owner is changed
+         * @param[in] service - The service to read the objects of, or
+         *                      nullptr for all the objects
          */
-        void onTimeOwnerChanged();
+        void readObjects(const std::string* service);
+
+        /** @brief Notified on the owner of a service of the objects is
+         *  changed
+         *  @details When the service gets a new owner, i.e. it restarts,
+         *  only its objects are read again, and discovered again if they
+         *  are not found at the known paths.
+         *
+         * @param[in] msg - sdbusplus dbusmessage
+         */
+        void onServiceOwnerChanged(sdbusplus::message::message& msg);
+
+        /** @brief Notified on a settings or host state object is added,
+         *  the properties in the signal are applied without reading them
+         *
+         * @param[in] msg - sdbusplus dbusmessage
+         */
+        void onInterfacesAdded(sdbusplus::message::message& msg);
 
         /** @brief Callback to handle change in a setting
          *
@@ -127,6 +294,17 @@ class Manager
          */
         int onSettingsChanged(sdbusplus::message::message& msg);
 
+        /** @brief Check if a setting value is different from the current
+         *  one, or the requested one if host is on
+         *
+         * @param[in] key - The name of the property
+         * @param[in] value - The value of the property
+         *
+         * @return true if the value is new
+         */
+        bool isNewValue(const std::string& key,
+                        const std::string& value) const;
+
         /** @brief Notified on settings property changed
          *
          * @param[in] key - The name of property that is changed
@@ -205,18 +383,12 @@ class Manager
         };
 
         /** @brief The properties that manager shall notify the
-         *  listeners when changed
+         *  subscribers when changed
          */
         static const std::set<std::string> managedProperties;
 
         /** @brief The map that maps the string to Owners */
         static const std::map<std::string, Owner> ownerMap;
-
-        /** @brief The file name of saved time mode */
-        static constexpr auto modeFile = "/var/lib/obmc/saved_time_mode";
-
-        /** @brief The file name of saved time owner */
-        static constexpr auto ownerFile = "/var/lib/obmc/saved_time_owner";
 };
 
 }
@@ -0,0 +1,39 @@
+#include "offset_arena.hpp"
+
+#include <algorithm>
+
+namespace phosphor
+{
+namespace time
+{
+
+OffsetArena::Slot OffsetArena::allocate()
+{
+    Slot slot;
+    if (freeSlots.empty())
+    {
+        slot = raw.size();
+        raw.push_back(bias);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        raw[slot] = bias;
+    }
+    return slot;
+}
+
+void OffsetArena::release(Slot slot)
+{
+    freeSlots.push_back(slot);
+}
+
+void OffsetArena::clear()
+{
+    bias = 0;
+    std::fill(raw.begin(), raw.end(), 0);
+}
+
+} // namespace time
+} // namespace phosphor
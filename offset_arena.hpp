@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class OffsetArena
+ *  @brief The offsets of the virtual clocks to BMC time, in one array.
+ *  @details The slots are allocated and released in O(1). The offsets are
+ *  stored against a shared bias, so that when BMC time steps, all the
+ *  offsets are compensated in O(1) by moving the bias.
+ */
+class OffsetArena
+{
+    public:
+        using Slot = uint32_t;
+
+        /** @brief Allocate a slot with zero offset */
+        Slot allocate();
+
+        /** @brief Release a slot to be reused
+         *
+         * @param[in] slot - The slot to release
+         */
+        void release(Slot slot);
+
+        /** @brief Get the offset of a slot */
+        std::chrono::microseconds get(Slot slot) const
+        {
+            return std::chrono::microseconds(raw[slot] - bias);
+        }
+
+        /** @brief Set the offset of a slot */
+        void set(Slot slot, const std::chrono::microseconds& offset)
+        {
+            raw[slot] = offset.count() + bias;
+        }
+
+        /** @brief Add the delta to the offsets of all slots */
+        void shift(const std::chrono::microseconds& delta)
+        {
+            bias -= delta.count();
+        }
+
+        /** @brief Set the offsets of all slots to zero */
+        void clear();
+
+        /** @brief Get the number of allocated slots */
+        size_t size() const
+        {
+            return raw.size() - freeSlots.size();
+        }
+
+    private:
+        /** @brief The offsets plus the bias */
+        std::vector<int64_t> raw;
+
+        /** @brief The released slots */
+        std::vector<Slot> freeSlots;
+
+        /** @brief The bias of the offsets */
+        int64_t bias = 0;
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,57 @@
+#include "published_state.hpp"
+
+namespace phosphor
+{
+namespace time
+{
+
+void PublishedState::publish(const TimeStateChange& change)
+{
+    if (!change.has(TimeStateChange::ModeChanged) &&
+        !change.has(TimeStateChange::OwnerChanged) &&
+        !change.has(TimeStateChange::OffsetChanged))
+    {
+        return;
+    }
+
+    // Make the sequence odd so that readers retry while it is written
+    auto seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (change.has(TimeStateChange::ModeChanged))
+    {
+        mode.store(change.mode, std::memory_order_relaxed);
+    }
+    if (change.has(TimeStateChange::OwnerChanged))
+    {
+        owner.store(change.owner, std::memory_order_relaxed);
+    }
+    if (change.has(TimeStateChange::OffsetChanged))
+    {
+        offset.store(change.offset.count(), std::memory_order_relaxed);
+    }
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+PublishedState::Value PublishedState::load() const
+{
+    Value value;
+    uint32_t before;
+    uint32_t after;
+    do
+    {
+        before = sequence.load(std::memory_order_acquire);
+        value.mode = mode.load(std::memory_order_relaxed);
+        value.owner = owner.load(std::memory_order_relaxed);
+        value.offset =
+            std::chrono::microseconds(offset.load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return value;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "time_state_change.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class PublishedState
+ *  @brief The time state published for lock free readers.
+ *  @details The main loop is the only writer, it publishes the mode, owner
+ *  and host offset on each time state change. Any other thread is able to
+ *  load a consistent copy of them without blocking the writer.
+ */
+class PublishedState
+{
+    public:
+        /** @brief A consistent copy of the published state */
+        struct Value
+        {
+            Mode mode;
+            Owner owner;
+            std::chrono::microseconds offset;
+
+            /** @brief Get host time from BMC time, the same way as
+             *  HostEpoch does
+             *
+             * @param[in] bmcTime - The BMC time in microseconds since UTC
+             *
+             * @return The host time in microseconds since UTC
+             */
+            std::chrono::microseconds hostTime(
+                const std::chrono::microseconds& bmcTime) const
+            {
+                return owner == Owner::Split ? bmcTime + offset : bmcTime;
+            }
+        };
+
+        PublishedState() = default;
+        PublishedState(const PublishedState&) = delete;
+        PublishedState& operator=(const PublishedState&) = delete;
+        PublishedState(PublishedState&&) = delete;
+        PublishedState& operator=(PublishedState&&) = delete;
+        ~PublishedState() = default;
+
+        /** @brief Publish the changed parts of the time state
+         *  @details It shall be called only from the main loop.
+         *
+         * @param[in] change - The changed time state
+         */
+        void publish(const TimeStateChange& change);
+
+        /** @brief Load a consistent copy of the time state
+         *  @details It is safe to call from any thread.
+         *
+         * @return The published time state
+         */
+        Value load() const;
+
+    private:
+        /** @brief The sequence number, it is odd while publishing */
+        std::atomic<uint32_t> sequence{0};
+
+        /** @brief The time mode */
+        std::atomic<Mode> mode{Mode::Manual};
+
+        /** @brief The time owner */
+        std::atomic<Owner> owner{Owner::Both};
+
+        /** @brief The diff between host and BMC time in microseconds */
+        std::atomic<int64_t> offset{0};
+};
+
+} // namespace time
+} // namespace phosphor
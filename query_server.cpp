@@ -0,0 +1,228 @@
+#include "query_server.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace phosphor::logging;
+
+constexpr size_t QueryServer::maxRequestsPerWakeup;
+
+QueryServer::QueryServer(sd_event* event,
+                         const char* socketPath,
+                         const EpochBase& bmc,
+                         const EpochBase& host,
+                         const PublishedState& state)
+    : event(event),
+      socketPath(socketPath),
+      bmc(bmc),
+      host(host),
+      state(state)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        log<level::ERR>("Query socket path is too long",
+                        entry("PATH=%s", socketPath));
+        return;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    listenFd = socket(AF_UNIX,
+                      SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+    {
+        log<level::ERR>("Failed to create query socket",
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+    unlink(socketPath);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0)
+    {
+        log<level::ERR>("Failed to listen on query socket",
+                        entry("PATH=%s", socketPath),
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+    struct stat st;
+    if (stat(socketPath, &st) == 0)
+    {
+        bound = true;
+        boundDev = st.st_dev;
+        boundIno = st.st_ino;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(event, &es, listenFd, EPOLLIN, onConnect, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    listenSource.reset(es);
+}
+
+QueryServer::~QueryServer()
+{
+    while (!clients.empty())
+    {
+        closeClient(clients.begin()->first);
+    }
+    listenSource.reset();
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+    }
+
+    // On a live restart the new process binds its socket to the path
+    // before this one exits, do not unlink that one
+    struct stat st;
+    if (bound && stat(socketPath.c_str(), &st) == 0 &&
+        st.st_dev == boundDev && st.st_ino == boundIno)
+    {
+        unlink(socketPath.c_str());
+    }
+}
+
+query::Response QueryServer::handle(const void* data, size_t size) const
+{
+    query::Response response{};
+    response.version = query::PROTOCOL_VERSION;
+
+    query::Request request;
+    if (size != sizeof(request))
+    {
+        response.status = -EBADMSG;
+        return response;
+    }
+    memcpy(&request, data, sizeof(request));
+    response.op = request.op;
+    response.id = request.id;
+    if (request.version != query::PROTOCOL_VERSION)
+    {
+        response.status = -EPROTONOSUPPORT;
+        return response;
+    }
+
+    switch (request.op)
+    {
+        case query::Op::GetHostTime:
+            response.hostTime = host.elapsed();
+            break;
+        case query::Op::GetBmcTime:
+            response.bmcTime = bmc.elapsed();
+            break;
+        case query::Op::Snapshot:
+        {
+            // Take host time from the same BMC time, as TimeSnapshot does
+            auto value = state.load();
+            auto bmcTime = std::chrono::microseconds(bmc.elapsed());
+            response.mode = static_cast<uint8_t>(value.mode);
+            response.owner = static_cast<uint8_t>(value.owner);
+            response.offset = value.offset.count();
+            response.bmcTime = bmcTime.count();
+            response.hostTime = value.hostTime(bmcTime).count();
+            break;
+        }
+        default:
+            response.status = -EOPNOTSUPP;
+            break;
+    }
+    return response;
+}
+
+void QueryServer::closeClient(int fd)
+{
+    clients.erase(fd);
+    close(fd);
+}
+
+int QueryServer::onConnect(sd_event_source* /* es */, int fd,
+                           uint32_t /* revents */, void* userdata)
+{
+    auto server = static_cast<QueryServer*>(userdata);
+    int conn = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (conn < 0)
+    {
+        return 0;
+    }
+    if (server->clients.size() >= maxClients)
+    {
+        log<level::ERR>("Too many query clients");
+        close(conn);
+        return 0;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(server->event, &es, conn, EPOLLIN,
+                             onRequest, server);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        close(conn);
+        return 0;
+    }
+    server->clients.emplace(
+        conn, SdEventSource{es, server->sdEventSourceDeleter});
+    return 0;
+}
+
+int QueryServer::onRequest(sd_event_source* /* es */, int fd,
+                           uint32_t /* revents */, void* userdata)
+{
+    auto server = static_cast<QueryServer*>(userdata);
+
+    // Serve the queued requests up to the cap, the socket stays readable
+    // for the rest. A larger message is truncated and then rejected by its
+    // size
+    char buf[sizeof(query::Request) + 1];
+    bool served = false;
+    for (size_t i = 0; i < maxRequestsPerWakeup; ++i)
+    {
+        auto size = recv(fd, buf, sizeof(buf), MSG_TRUNC);
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (size <= 0)
+        {
+            server->closeClient(fd);
+            break;
+        }
+
+        auto response = server->handle(buf, size);
+        if (send(fd, &response, sizeof(response),
+                 MSG_NOSIGNAL | MSG_DONTWAIT) != sizeof(response))
+        {
+            // The client does not read its responses
+            server->closeClient(fd);
+            break;
+        }
+        served = true;
+    }
+    wakeup::count(wakeup::Source::QueryRequest, served);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "epoch_base.hpp"
+#include "published_state.hpp"
+
+#include <systemd/sd-event.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+namespace query
+{
+
+/** @brief The version of the query protocol */
+constexpr uint16_t PROTOCOL_VERSION = 1;
+
+/** @brief The operations of the query protocol */
+enum class Op : uint16_t
+{
+    GetHostTime = 1,
+    GetBmcTime = 2,
+    Snapshot = 3,
+};
+
+/** @struct Request
+ *  @brief The request, sent as one SOCK_SEQPACKET message.
+ */
+struct Request
+{
+    /** @brief The version of the protocol, PROTOCOL_VERSION */
+    uint16_t version;
+
+    /** @brief The operation */
+    Op op;
+
+    /** @brief Reserved, shall be 0 */
+    uint32_t reserved;
+
+    /** @brief The id chosen by the client, echoed in the response */
+    uint64_t id;
+};
+
+/** @struct Response
+ *  @brief The response, sent as one SOCK_SEQPACKET message.
+ */
+struct Response
+{
+    /** @brief The version of the protocol, PROTOCOL_VERSION */
+    uint16_t version;
+
+    /** @brief The operation of the request */
+    Op op;
+
+    /** @brief 0 on success, otherwise a negative errno */
+    int32_t status;
+
+    /** @brief The id of the request */
+    uint64_t id;
+
+    /** @brief The time mode, valid for Snapshot */
+    uint8_t mode;
+
+    /** @brief The time owner, valid for Snapshot */
+    uint8_t owner;
+
+    /** @brief Reserved, 0 */
+    uint8_t reserved[6];
+
+    /** @brief The diff between host and BMC time, valid for Snapshot */
+    int64_t offset;
+
+    /** @brief The BMC elapsed microseconds since UTC,
+     *  valid for GetBmcTime and Snapshot
+     */
+    uint64_t bmcTime;
+
+    /** @brief The host elapsed microseconds since UTC,
+     *  valid for GetHostTime and Snapshot
+     */
+    uint64_t hostTime;
+};
+
+static_assert(sizeof(Request) == 16, "Request is part of the protocol");
+static_assert(sizeof(Response) == 48, "Response is part of the protocol");
+
+} // namespace query
+
+/** @class QueryServer
+ *  @brief Serve time queries on a unix socket.
+ *  @details It is an alternative to the DBus Elapsed gets and the Snapshot
+ *  for latency sensitive clients. Each request and response is one fixed
+ *  size SOCK_SEQPACKET message, served from the main event loop by the
+ *  same BmcEpoch and HostEpoch objects as on DBus.
+ */
+class QueryServer
+{
+    public:
+        /** @brief Constructor
+         *
+         * @param[in] event - The event loop to serve on
+         * @param[in] socketPath - The path of the query socket
+         * @param[in] bmc - The BMC epoch object
+         * @param[in] host - The host epoch object
+         * @param[in] state - The published time state
+         */
+        QueryServer(sd_event* event,
+                    const char* socketPath,
+                    const EpochBase& bmc,
+                    const EpochBase& host,
+                    const PublishedState& state);
+        QueryServer(const QueryServer&) = delete;
+        QueryServer& operator=(const QueryServer&) = delete;
+        QueryServer(QueryServer&&) = delete;
+        QueryServer& operator=(QueryServer&&) = delete;
+        ~QueryServer();
+
+        /** @brief Handle a request
+         *
+         * @param[in] data - The received message
+         * @param[in] size - The size of the received message
+         *
+         * @return The response
+         */
+        query::Response handle(const void* data, size_t size) const;
+
+        /** @brief The max number of connected clients */
+        static constexpr size_t maxClients = 64;
+
+        /** @brief The max number of requests of a client served per
+         *  wakeup, the rest are served on the next iterations of the event
+         *  loop, so that a client that keeps sending does not hold it
+         */
+        static constexpr size_t maxRequestsPerWakeup = 16;
+
+    private:
+        /** @brief The event loop */
+        sd_event* event;
+
+        /** @brief The path of the query socket */
+        std::string socketPath;
+
+        /** @brief The BMC epoch object */
+        const EpochBase& bmc;
+
+        /** @brief The host epoch object */
+        const EpochBase& host;
+
+        /** @brief The published time state */
+        const PublishedState& state;
+
+        /** @brief The listening socket */
+        int listenFd = -1;
+
+        /** @brief Indicate if the socket is bound to the path */
+        bool bound = false;
+
+        /** @brief The device of the bound socket file */
+        dev_t boundDev = 0;
+
+        /** @brief The inode of the bound socket file, the path is unlinked
+         *  on destruction only if it is still this one
+         */
+        ino_t boundIno = 0;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The event source of the listening socket */
+        SdEventSource listenSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief The event sources of the clients, keyed by the fd */
+        std::map<int, SdEventSource> clients;
+
+        /** @brief Close the connection of a client
+         *
+         * @param[in] fd - The fd of the connection
+         */
+        void closeClient(int fd);
+
+        /** @brief The callback function on new connection
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the listening socket
+         * @param[in] revents - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onConnect(sd_event_source* es, int fd,
+                             uint32_t revents, void* userdata);
+
+        /** @brief The callback function on request from a client
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the connection
+         * @param[in] revents - The received events
+         * @param[in] userdata - User data pointer
+         */
+        static int onRequest(sd_event_source* es, int fd,
+                             uint32_t revents, void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,204 @@
+#include "read_server.hpp"
+
+#include "config.h"
+#include "time_snapshot.hpp"
+#include "utils.hpp"
+
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <sdbusplus/server/object.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+#include <xyz/openbmc_project/Time/EpochTime/server.hpp>
+#include <xyz/openbmc_project/Time/error.hpp>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+
+namespace // anonymous
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using EpochTime = sdbusplus::xyz::openbmc_project::Time::server::EpochTime;
+
+/** @class ReadOnlyEpoch
+ *  @brief The EpochTime object served on the read connection.
+ */
+class ReadOnlyEpoch : public sdbusplus::server::object::object<EpochTime>
+{
+    public:
+        ReadOnlyEpoch(sdbusplus::bus::bus& bus,
+                      const char* objPath,
+                      const PublishedState& state,
+                      bool isHost,
+                      ClockRead clockRead)
+            : sdbusplus::server::object::object<EpochTime>(bus, objPath),
+              state(state),
+              isHost(isHost),
+              clockRead(clockRead)
+        {
+        }
+
+        uint64_t elapsed() const override
+        {
+            // The clock is read the same way as on the main connection
+            auto bmcTime = utils::now(clockRead);
+            if (!isHost)
+            {
+                return bmcTime.count();
+            }
+            return state.load().hostTime(bmcTime).count();
+        }
+
+        uint64_t elapsed(uint64_t /* value */) override
+        {
+            using NotAllowed =
+                sdbusplus::xyz::openbmc_project::Time::Error::NotAllowed;
+            using NotAllowedError = xyz::openbmc_project::Time::NotAllowed;
+            auto value = state.load();
+            elog<NotAllowed>(
+                NotAllowedError::OWNER(utils::ownerToStr(value.owner).c_str()),
+                NotAllowedError::SYNC_METHOD(
+                    utils::modeToStr(value.mode).c_str()),
+                NotAllowedError::REASON(
+                    "Setting time on the read-only connection"));
+            return 0;
+        }
+
+    private:
+        /** @brief The published time state */
+        const PublishedState& state;
+
+        /** @brief Indicate if it is the host time */
+        const bool isHost;
+
+        /** @brief The way to read the BMC time */
+        const ClockRead clockRead;
+};
+
+} // namespace anonymous
+
+ReadServer::ReadServer(const PublishedState& state,
+                       ClockRead bmcRead,
+                       ClockRead hostRead)
+    : state(state),
+      bmcRead(bmcRead),
+      hostRead(hostRead)
+{
+    using InternalFailure = sdbusplus::xyz::openbmc_project::Common::
+                                Error::InternalFailure;
+
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd == -1)
+    {
+        log<level::ERR>("Failed to create eventfd",
+                        entry("ERRNO=%d", errno),
+                        entry("ERR=%s", strerror(errno)));
+        elog<InternalFailure>();
+    }
+    thread = std::thread(&ReadServer::run, this);
+}
+
+ReadServer::~ReadServer()
+{
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one))
+    {
+        log<level::ERR>("Failed to stop the read server",
+                        entry("ERRNO=%d", errno));
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    close(stopFd);
+}
+
+void ReadServer::run()
+{
+    sd_event* event = nullptr;
+    auto r = sd_event_new(&event);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to create event loop of the read server",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+
+    sd_event_source* es = nullptr;
+    r = sd_event_add_io(event, &es, stopFd, EPOLLIN, onStop, nullptr);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        sd_event_unref(event);
+        return;
+    }
+
+    try
+    {
+        // A new connection, not shared with the main loop
+        auto bus = sdbusplus::bus::new_default();
+        bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+        {
+            sdbusplus::server::manager::manager bmcObjManager(bus,
+                                                              OBJPATH_BMC);
+            sdbusplus::server::manager::manager hostObjManager(bus,
+                                                               OBJPATH_HOST);
+            ReadOnlyEpoch bmc(bus, OBJPATH_BMC, state, false, bmcRead);
+            ReadOnlyEpoch host(bus, OBJPATH_HOST, state, true, hostRead);
+            TimeSnapshot snapshot(bus, OBJPATH_TIME, state);
+            snapshot.setClockRead(bmcRead);
+
+            // Queue for the name, so that on a live restart the new
+            // process gets it once the previous one exits
+            auto r = sd_bus_request_name(bus.get(), READER_BUSNAME,
+                                         SD_BUS_NAME_QUEUE);
+            if (r < 0)
+            {
+                log<level::ERR>("Failed to request bus name",
+                                entry("ERRNO=%d", -r),
+                                entry("BUSNAME=%s", READER_BUSNAME));
+            }
+            log<level::INFO>("Read server started",
+                             entry("BUSNAME=%s", READER_BUSNAME));
+
+            sd_event_loop(event);
+        }
+        bus.detach_event();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Read server failed",
+                        entry("ERR=%s", e.what()));
+    }
+
+    sd_event_source_unref(es);
+    sd_event_unref(event);
+}
+
+int ReadServer::onStop(sd_event_source* es, int fd,
+                       uint32_t /* revents */, void* /* userdata */)
+{
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0);
+
+    sd_event_exit(sd_event_source_get_event(es), 0);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "published_state.hpp"
+#include "types.hpp"
+
+#include <thread>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class ReadServer
+ *  @brief Serve read-only time queries on a second DBus connection.
+ *  @details It runs its own event loop on its own thread and connection,
+ *  owning READER_BUSNAME. The bmc and host EpochTime objects and the
+ *  Snapshot object on it are answered from the PublishedState only, so the
+ *  gets never wait for the blocking calls and file writes done on the main
+ *  loop. Setting Elapsed on this connection is not allowed, all the writes
+ *  stay on the main connection.
+ */
+class ReadServer
+{
+    public:
+        /** @brief Constructor
+         *
+         * @param[in] state - The published time state
+         * @param[in] bmcRead - The way to read the BMC time, as BmcEpoch
+         *                      and the snapshot do
+         * @param[in] hostRead - The way to read the BMC time for the host
+         *                       time, as HostEpoch does
+         */
+        explicit ReadServer(const PublishedState& state,
+                            ClockRead bmcRead = ClockRead::Precise,
+                            ClockRead hostRead = ClockRead::Precise);
+        ReadServer(const ReadServer&) = delete;
+        ReadServer& operator=(const ReadServer&) = delete;
+        ReadServer(ReadServer&&) = delete;
+        ReadServer& operator=(ReadServer&&) = delete;
+
+        /** @brief Stop the event loop and join the thread */
+        ~ReadServer();
+
+    private:
+        /** @brief The published time state */
+        const PublishedState& state;
+
+        /** @brief The way to read the BMC time */
+        const ClockRead bmcRead;
+
+        /** @brief The way to read the BMC time for the host time */
+        const ClockRead hostRead;
+
+        /** @brief The eventfd to stop the event loop */
+        int stopFd = -1;
+
+        /** @brief The thread that runs the event loop */
+        std::thread thread;
+
+        /** @brief The thread function */
+        void run();
+
+        /** @brief The callback function on stop request
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the eventfd
+         * @param[in] revents - Not used
+         * @param[in] userdata - Not used
+         */
+        static int onStop(sd_event_source* es, int fd,
+                          uint32_t revents, void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,794 @@
+#include "replication.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace phosphor::logging;
+
+namespace // anonymous
+{
+
+/** @brief The interval to reconnect to the active side */
+constexpr uint64_t RETRY_INTERVAL_USEC = 1000000;
+
+/** @brief The idle seconds before the keepalives of a TCP connection */
+constexpr int KEEPALIVE_IDLE_SEC = 5;
+
+/** @brief The interval of the keepalives of a TCP connection */
+constexpr int KEEPALIVE_INTERVAL_SEC = 1;
+
+/** @brief The unanswered keepalives to drop a TCP connection */
+constexpr int KEEPALIVE_COUNT = 3;
+
+/** @brief The max size of a varint of uint64_t */
+constexpr size_t MAX_VARINT_SIZE = 10;
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putSigned(std::string& out, int64_t value)
+{
+    // Zigzag, so that small negative values are short as well
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^
+                   static_cast<uint64_t>(value >> 63));
+}
+
+/** @class Decoder
+ *  @brief Read the encoded fields with bounds checking.
+ */
+class Decoder
+{
+    public:
+        Decoder(const char* data, size_t size)
+            : data(data),
+              size(size)
+        {
+        }
+
+        /** @return 1 if the varint is read, 0 if it is truncated,
+         *          -1 if it is too long
+         */
+        int getVarint(uint64_t& value)
+        {
+            value = 0;
+            for (size_t i = 0; i < MAX_VARINT_SIZE; ++i)
+            {
+                if (pos == size)
+                {
+                    return 0;
+                }
+                auto byte = static_cast<uint8_t>(data[pos++]);
+                value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+                if ((byte & 0x80) == 0)
+                {
+                    return 1;
+                }
+            }
+            return -1;
+        }
+
+        bool getSigned(int64_t& value)
+        {
+            uint64_t raw;
+            if (getVarint(raw) != 1)
+            {
+                return false;
+            }
+            value = static_cast<int64_t>(raw >> 1) ^
+                    -static_cast<int64_t>(raw & 1);
+            return true;
+        }
+
+        bool getByte(uint8_t& value)
+        {
+            if (pos == size)
+            {
+                return false;
+            }
+            value = static_cast<uint8_t>(data[pos++]);
+            return true;
+        }
+
+        size_t position() const
+        {
+            return pos;
+        }
+
+        bool done() const
+        {
+            return pos == size;
+        }
+
+    private:
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+};
+
+bool decodeDelta(Decoder& d, replication::Delta& delta)
+{
+    if (d.getVarint(delta.seq) != 1 || !d.getByte(delta.changed))
+    {
+        return false;
+    }
+    if ((delta.changed & ~(replication::ReplicatedBits |
+                           replication::Snapshot)) != 0)
+    {
+        return false;
+    }
+
+    uint8_t value;
+    if (delta.changed & TimeStateChange::ModeChanged)
+    {
+        if (!d.getByte(value) || value > static_cast<uint8_t>(Mode::Manual))
+        {
+            return false;
+        }
+        delta.mode = static_cast<Mode>(value);
+    }
+    if (delta.changed & TimeStateChange::OwnerChanged)
+    {
+        if (!d.getByte(value) || value > static_cast<uint8_t>(Owner::Both))
+        {
+            return false;
+        }
+        delta.owner = static_cast<Owner>(value);
+    }
+    if (delta.changed & TimeStateChange::OffsetChanged)
+    {
+        int64_t offset;
+        int64_t anchor;
+        if (!d.getSigned(offset) || !d.getSigned(anchor))
+        {
+            return false;
+        }
+        delta.offset = std::chrono::microseconds(offset);
+        delta.anchor = std::chrono::microseconds(anchor);
+    }
+    return true;
+}
+
+/** @brief Send the deltas right away, and drop a TCP connection whose
+ *  peer is gone in seconds
+ */
+void setTcpOptions(int fd)
+{
+    int on = 1;
+    int idle = KEEPALIVE_IDLE_SEC;
+    int interval = KEEPALIVE_INTERVAL_SEC;
+    int count = KEEPALIVE_COUNT;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) != 0 ||
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) != 0 ||
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL,
+                   &interval, sizeof(interval)) != 0 ||
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count)) != 0)
+    {
+        log<level::ERR>("Failed to set the TCP options",
+                        entry("ERRNO=%d", errno));
+    }
+}
+
+} // namespace anonymous
+
+namespace replication
+{
+
+bool parseAddress(const std::string& spec, Address& address)
+{
+    address = {};
+    constexpr auto unixPrefix = "unix:";
+    constexpr auto tcpPrefix = "tcp:";
+    if (spec.compare(0, strlen(tcpPrefix), tcpPrefix) != 0)
+    {
+        auto path = spec.compare(0, strlen(unixPrefix), unixPrefix) == 0 ?
+                    spec.substr(strlen(unixPrefix)) : spec;
+        auto& addr = reinterpret_cast<sockaddr_un&>(address.storage);
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        {
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path.c_str());
+        address.size = sizeof(addr);
+        address.path = path;
+        return true;
+    }
+
+    auto hostPort = spec.substr(strlen(tcpPrefix));
+    auto colon = hostPort.rfind(':');
+    if (colon == std::string::npos || colon + 1 == hostPort.size())
+    {
+        return false;
+    }
+    auto host = hostPort.substr(0, colon);
+    auto port = hostPort.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    {
+        host = host.substr(1, host.size() - 2);
+    }
+
+    // Numeric only, resolving a name may block
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV |
+                     (host.empty() ? AI_PASSIVE : 0);
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(),
+                    &hints, &result) != 0)
+    {
+        return false;
+    }
+    bool ok = (result->ai_addrlen <= sizeof(address.storage));
+    if (ok)
+    {
+        memcpy(&address.storage, result->ai_addr, result->ai_addrlen);
+        address.size = result->ai_addrlen;
+    }
+    freeaddrinfo(result);
+    return ok;
+}
+
+void encode(const std::vector<Delta>& deltas, std::string& out)
+{
+    std::string payload;
+    for (const auto& delta : deltas)
+    {
+        putVarint(payload, delta.seq);
+        payload.push_back(static_cast<char>(delta.changed));
+        if (delta.changed & TimeStateChange::ModeChanged)
+        {
+            payload.push_back(static_cast<char>(delta.mode));
+        }
+        if (delta.changed & TimeStateChange::OwnerChanged)
+        {
+            payload.push_back(static_cast<char>(delta.owner));
+        }
+        if (delta.changed & TimeStateChange::OffsetChanged)
+        {
+            putSigned(payload, delta.offset.count());
+            putSigned(payload, delta.anchor.count());
+        }
+    }
+    putVarint(out, payload.size());
+    out.append(payload);
+}
+
+std::chrono::microseconds localOffset(const ReplicaState& state,
+                                      std::chrono::microseconds bmcTime)
+{
+    auto skew = bmcTime - state.anchor;
+    if (skew > MAX_CLOCK_SKEW || skew < -MAX_CLOCK_SKEW)
+    {
+        // Keep the host time of the active side on this BMC clock
+        return state.offset - skew;
+    }
+    return state.offset;
+}
+
+void FrameReader::feed(const char* data, size_t size)
+{
+    buffer.append(data, size);
+}
+
+int FrameReader::next(std::vector<Delta>& deltas)
+{
+    Decoder header(buffer.data(), buffer.size());
+    uint64_t size;
+    auto r = header.getVarint(size);
+    if (r <= 0)
+    {
+        return r;
+    }
+    if (size > MAX_FRAME_SIZE)
+    {
+        return -1;
+    }
+    auto begin = header.position();
+    if (buffer.size() - begin < size)
+    {
+        return 0;
+    }
+
+    deltas.clear();
+    Decoder d(buffer.data() + begin, size);
+    while (!d.done())
+    {
+        Delta delta;
+        if (!decodeDelta(d, delta))
+        {
+            return -1;
+        }
+        deltas.push_back(delta);
+    }
+    buffer.erase(0, begin + size);
+    return 1;
+}
+
+} // namespace replication
+
+uint8_t ReplicaState::apply(const replication::Delta& delta)
+{
+    if ((delta.changed & replication::Snapshot) == 0 && delta.seq <= seq)
+    {
+        // Already applied
+        return 0;
+    }
+    seq = delta.seq;
+
+    uint8_t changed = 0;
+    if ((delta.changed & TimeStateChange::ModeChanged) && mode != delta.mode)
+    {
+        mode = delta.mode;
+        changed |= TimeStateChange::ModeChanged;
+    }
+    if ((delta.changed & TimeStateChange::OwnerChanged) &&
+        owner != delta.owner)
+    {
+        owner = delta.owner;
+        changed |= TimeStateChange::OwnerChanged;
+    }
+    if ((delta.changed & TimeStateChange::OffsetChanged) &&
+        (offset != delta.offset || anchor != delta.anchor))
+    {
+        offset = delta.offset;
+        anchor = delta.anchor;
+        changed |= TimeStateChange::OffsetChanged;
+    }
+    return changed;
+}
+
+replication::Delta ReplicaState::snapshot() const
+{
+    replication::Delta delta;
+    delta.seq = seq;
+    delta.changed = replication::ReplicatedBits | replication::Snapshot;
+    delta.mode = mode;
+    delta.owner = owner;
+    delta.offset = offset;
+    delta.anchor = anchor;
+    return delta;
+}
+
+ReplicationSender::ReplicationSender(sd_event* event, const char* socketPath,
+                                     int handedFd)
+    : event(event)
+{
+    listenFd = handedFd;
+
+    sd_event_source* es;
+    auto r = sd_event_add_defer(event, &es, onFlush, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    flushSource.reset(es);
+    sd_event_source_set_enabled(es, SD_EVENT_OFF);
+
+    if (!replication::parseAddress(socketPath, address))
+    {
+        log<level::ERR>("Invalid replication socket address",
+                        entry("ADDRESS=%s", socketPath));
+        return;
+    }
+    if (listenFd < 0 && !listenOn(socketPath))
+    {
+        return;
+    }
+
+    r = sd_event_add_io(event, &es, listenFd, EPOLLIN, onConnect, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    listenSource.reset(es);
+}
+
+ReplicationSender::~ReplicationSender()
+{
+    closeConnection();
+    flushSource.reset();
+    listenSource.reset();
+    if (listenFd >= 0)
+    {
+        // Do not unlink a unix socket, it belongs to the new process
+        // if the state is handed over
+        close(listenFd);
+    }
+}
+
+bool ReplicationSender::listenOn(const char* socketPath)
+{
+    listenFd = socket(address.family(),
+                      SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+    {
+        log<level::ERR>("Failed to create replication socket",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    if (!address.path.empty())
+    {
+        unlink(address.path.c_str());
+    }
+    else
+    {
+        // Listen again right away when the service restarts
+        int on = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address.storage),
+             address.size) != 0 ||
+        listen(listenFd, 1) != 0)
+    {
+        log<level::ERR>("Failed to listen on replication socket",
+                        entry("ADDRESS=%s", socketPath),
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    return true;
+}
+
+void ReplicationSender::onTimeStateChanged(const TimeStateChange& change)
+{
+    replication::Delta delta;
+    delta.changed = change.changed & replication::ReplicatedBits;
+    if (delta.changed == 0)
+    {
+        return;
+    }
+    delta.seq = state.seq + 1;
+    delta.mode = change.mode;
+    delta.owner = change.owner;
+    delta.offset = change.offset;
+    state.apply(delta);
+
+    if (connFd >= 0)
+    {
+        pending.push_back(delta);
+        if (flushSource)
+        {
+            // Send all the changes in this loop iteration at once
+            sd_event_source_set_enabled(flushSource.get(), SD_EVENT_ONESHOT);
+        }
+    }
+}
+
+void ReplicationSender::closeConnection()
+{
+    connSource.reset();
+    if (connFd >= 0)
+    {
+        close(connFd);
+        connFd = -1;
+    }
+    pending.clear();
+    outBuffer.clear();
+}
+
+void ReplicationSender::flush()
+{
+    if (pending.empty())
+    {
+        return;
+    }
+
+    // Anchor the offsets to the BMC time when they are sent, so that the
+    // standby is able to tell the skew of the BMC clocks
+    using namespace std::chrono;
+    auto now = duration_cast<microseconds>(
+        system_clock::now().time_since_epoch());
+    for (auto& delta : pending)
+    {
+        delta.anchor = now;
+    }
+    replication::encode(pending, outBuffer);
+    pending.clear();
+    writeOut();
+}
+
+void ReplicationSender::writeOut()
+{
+    while (!outBuffer.empty())
+    {
+        auto r = send(connFd, outBuffer.data(), outBuffer.size(),
+                      MSG_NOSIGNAL);
+        if (r < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Continue when the socket is writable
+                sd_event_source_set_io_events(connSource.get(),
+                                              EPOLLIN | EPOLLOUT);
+                return;
+            }
+            log<level::ERR>("Failed to send to the standby",
+                            entry("ERRNO=%d", errno));
+            closeConnection();
+            return;
+        }
+        outBuffer.erase(0, r);
+    }
+    sd_event_source_set_io_events(connSource.get(), EPOLLIN);
+}
+
+int ReplicationSender::onConnect(sd_event_source* /* es */, int fd,
+                                 uint32_t /* revents */, void* userdata)
+{
+    auto sender = static_cast<ReplicationSender*>(userdata);
+    int conn = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (conn < 0)
+    {
+        return 0;
+    }
+
+    if (sender->address.path.empty())
+    {
+        setTcpOptions(conn);
+    }
+
+    // Only one standby, a new connection replaces the old one
+    sender->closeConnection();
+    sd_event_source* es;
+    auto r = sd_event_add_io(sender->event, &es, conn, EPOLLIN,
+                             onConnection, sender);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        close(conn);
+        return 0;
+    }
+    sender->connFd = conn;
+    sender->connSource.reset(es);
+    log<level::INFO>("Standby connected");
+
+    // Start with the full state
+    sender->pending.push_back(sender->state.snapshot());
+    sender->flush();
+    return 0;
+}
+
+int ReplicationSender::onConnection(sd_event_source* /* es */, int fd,
+                                    uint32_t revents, void* userdata)
+{
+    auto sender = static_cast<ReplicationSender*>(userdata);
+    wakeup::count(wakeup::Source::Replication, true);
+    if (revents & EPOLLIN)
+    {
+        // The standby does not send anything, so it is closed
+        char buf[64];
+        auto r = recv(fd, buf, sizeof(buf), 0);
+        if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            log<level::INFO>("Standby disconnected");
+            sender->closeConnection();
+            return 0;
+        }
+    }
+    if (revents & (EPOLLHUP | EPOLLERR))
+    {
+        sender->closeConnection();
+        return 0;
+    }
+    if (revents & EPOLLOUT)
+    {
+        sender->writeOut();
+    }
+    return 0;
+}
+
+int ReplicationSender::onFlush(sd_event_source* /* es */, void* userdata)
+{
+    auto sender = static_cast<ReplicationSender*>(userdata);
+    wakeup::count(wakeup::Source::Replication, !sender->pending.empty());
+    sender->flush();
+    return 0;
+}
+
+ReplicationReceiver::ReplicationReceiver(sd_event* event,
+                                         const char* socketPath,
+                                         Handler handler)
+    : event(event),
+      socketPath(socketPath),
+      handler(std::move(handler))
+{
+    sd_event_source* es;
+    auto r = sd_event_add_time(event, &es, CLOCK_MONOTONIC, 0, 0,
+                               onRetry, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    retryTimer.reset(es);
+    sd_event_source_set_enabled(es, SD_EVENT_OFF);
+    connect();
+}
+
+ReplicationReceiver::~ReplicationReceiver()
+{
+    retryTimer.reset();
+    sockSource.reset();
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+}
+
+void ReplicationReceiver::connect()
+{
+    replication::Address address;
+    if (!replication::parseAddress(socketPath, address))
+    {
+        log<level::ERR>("Invalid replication socket address",
+                        entry("ADDRESS=%s", socketPath.c_str()));
+        return;
+    }
+    sock = socket(address.family(),
+                  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        log<level::ERR>("Failed to create replication socket",
+                        entry("ERRNO=%d", errno));
+        disconnect();
+        return;
+    }
+    if (address.path.empty())
+    {
+        setTcpOptions(sock);
+    }
+
+    // A unix stream socket connects right away or fails, a TCP one
+    // finishes connecting when it is writable
+    connecting = false;
+    if (::connect(sock, reinterpret_cast<sockaddr*>(&address.storage),
+                  address.size) != 0)
+    {
+        if (errno != EINPROGRESS)
+        {
+            disconnect();
+            return;
+        }
+        connecting = true;
+    }
+
+    sd_event_source* es;
+    auto r = sd_event_add_io(event, &es, sock,
+                             connecting ? EPOLLOUT : EPOLLIN, onData, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        disconnect();
+        return;
+    }
+    sockSource.reset(es);
+    if (!connecting)
+    {
+        connected();
+    }
+}
+
+void ReplicationReceiver::connected()
+{
+    connecting = false;
+    sd_event_source_set_io_events(sockSource.get(), EPOLLIN);
+    log<level::INFO>("Connected to the active side",
+                     entry("ADDRESS=%s", socketPath.c_str()));
+}
+
+void ReplicationReceiver::disconnect()
+{
+    sockSource.reset();
+    if (sock >= 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+    connecting = false;
+    reader = {};
+
+    if (retryTimer)
+    {
+        uint64_t now;
+        sd_event_now(event, CLOCK_MONOTONIC, &now);
+        sd_event_source_set_time(retryTimer.get(), now + RETRY_INTERVAL_USEC);
+        sd_event_source_set_enabled(retryTimer.get(), SD_EVENT_ONESHOT);
+    }
+}
+
+int ReplicationReceiver::onData(sd_event_source* /* es */, int fd,
+                                uint32_t revents, void* userdata)
+{
+    auto receiver = static_cast<ReplicationReceiver*>(userdata);
+    if (receiver->connecting)
+    {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) != 0 ||
+            error != 0 || (revents & (EPOLLERR | EPOLLHUP)))
+        {
+            receiver->disconnect();
+            return 0;
+        }
+        receiver->connected();
+        return 0;
+    }
+    char buf[4096];
+    auto size = recv(fd, buf, sizeof(buf), 0);
+    if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        return 0;
+    }
+    if (size <= 0)
+    {
+        log<level::INFO>("Disconnected from the active side");
+        receiver->disconnect();
+        return 0;
+    }
+    receiver->reader.feed(buf, size);
+
+    std::vector<replication::Delta> deltas;
+    int r;
+    while ((r = receiver->reader.next(deltas)) > 0)
+    {
+        uint8_t changed = 0;
+        for (const auto& delta : deltas)
+        {
+            changed |= receiver->state.apply(delta);
+        }
+        if (changed != 0 && receiver->handler)
+        {
+            receiver->handler(receiver->state, changed);
+        }
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Invalid replication frame");
+        receiver->disconnect();
+    }
+    return 0;
+}
+
+int ReplicationReceiver::onRetry(sd_event_source* /* es */,
+                                 uint64_t /* usec */, void* userdata)
+{
+    static_cast<ReplicationReceiver*>(userdata)->connect();
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,441 @@
+#pragma once
+
+#include "time_state_change.hpp"
+#include "types.hpp"
+
+#include <sys/socket.h>
+#include <systemd/sd-event.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+namespace replication
+{
+
+/** @brief The bit of a full state, it is applied regardless of
+ *  the sequence number, e.g. when the active side is restarted
+ */
+constexpr uint8_t Snapshot = 1 << 7;
+
+/** @brief The bits of the replicated parts of the time state */
+constexpr uint8_t ReplicatedBits = TimeStateChange::ModeChanged |
+                                   TimeStateChange::OwnerChanged |
+                                   TimeStateChange::OffsetChanged;
+
+/** @brief The max size of a frame, larger ones are invalid */
+constexpr size_t MAX_FRAME_SIZE = 64 * 1024;
+
+/** @brief The max skew of the BMC clocks that is taken as the delay of
+ *  the replication, a larger one is taken as a diff of the BMC clocks
+ */
+constexpr std::chrono::microseconds MAX_CLOCK_SKEW = std::chrono::seconds(1);
+
+/** @struct Address
+ *  @brief The address of the replication socket.
+ *  @details "unix:PATH", or a PATH that starts with '/', is a unix stream
+ *  socket, for a link between the BMCs that is forwarded by others.
+ *  "tcp:HOST:PORT" is a TCP socket, e.g. on the link between the BMCs, with
+ *  a numeric IPv4 HOST or an IPv6 one in brackets; the active side listens
+ *  on all the addresses if HOST is empty.
+ */
+struct Address
+{
+    /** @brief The socket address */
+    sockaddr_storage storage{};
+
+    /** @brief The size of the socket address */
+    socklen_t size = 0;
+
+    /** @brief The path of a unix socket, empty for TCP */
+    std::string path;
+
+    /** @brief Get the address family */
+    int family() const
+    {
+        return storage.ss_family;
+    }
+};
+
+/** @brief Parse the address of the replication socket
+ *
+ * @param[in] spec - The address, e.g. "/run/replication.sock" or
+ *                   "tcp:192.168.0.2:4660"
+ * @param[out] address - The parsed address
+ *
+ * @return true if the address is valid
+ */
+bool parseAddress(const std::string& spec, Address& address);
+
+/** @struct Delta
+ *  @brief A change of the replicated time state.
+ */
+struct Delta
+{
+    /** @brief The sequence number of the change on the active side */
+    uint64_t seq = 0;
+
+    /** @brief The bitmask of TimeStateChange::Changed and Snapshot */
+    uint8_t changed = 0;
+
+    /** @brief The time mode, valid if ModeChanged */
+    Mode mode = Mode::Manual;
+
+    /** @brief The time owner, valid if OwnerChanged */
+    Owner owner = Owner::Both;
+
+    /** @brief The diff between host and BMC time, valid if OffsetChanged */
+    std::chrono::microseconds offset{0};
+
+    /** @brief The BMC time of the active side when the delta is sent,
+     *  valid if OffsetChanged
+     */
+    std::chrono::microseconds anchor{0};
+};
+
+/** @brief Encode the deltas into one frame
+ *  @details A frame is a varint of the payload size followed by the
+ *  deltas. A delta is the varint sequence number, the changed byte, and
+ *  only the changed fields, with the signed ones zigzag encoded.
+ *
+ * @param[in] deltas - The deltas to encode
+ * @param[out] out - The string to append the frame to
+ */
+void encode(const std::vector<Delta>& deltas, std::string& out);
+
+/** @class FrameReader
+ *  @brief Split the bytes received from a stream into frames of deltas.
+ */
+class FrameReader
+{
+    public:
+        /** @brief Append the received bytes
+         *
+         * @param[in] data - The received bytes
+         * @param[in] size - The number of the received bytes
+         */
+        void feed(const char* data, size_t size);
+
+        /** @brief Decode the next complete frame
+         *
+         * @param[out] deltas - The decoded deltas
+         *
+         * @return 1 if a frame is decoded, 0 if more bytes are needed,
+         *         -1 if the bytes are not valid frames
+         */
+        int next(std::vector<Delta>& deltas);
+
+    private:
+        /** @brief The received bytes not decoded yet */
+        std::string buffer;
+};
+
+} // namespace replication
+
+/** @struct ReplicaState
+ *  @brief The replicated time state.
+ */
+struct ReplicaState
+{
+    /** @brief The sequence number of the last applied delta */
+    uint64_t seq = 0;
+
+    /** @brief The time mode */
+    Mode mode = Mode::Manual;
+
+    /** @brief The time owner */
+    Owner owner = Owner::Both;
+
+    /** @brief The diff between host and BMC time */
+    std::chrono::microseconds offset{0};
+
+    /** @brief The BMC time of the active side when the offset is sent */
+    std::chrono::microseconds anchor{0};
+
+    /** @brief Apply a delta
+     *  @details A delta not newer than the last applied one is ignored,
+     *  so that a delta received twice is applied once.
+     *
+     * @param[in] delta - The delta to apply
+     *
+     * @return The bitmask of the parts that are changed
+     */
+    uint8_t apply(const replication::Delta& delta);
+
+    /** @brief Get the full state as a delta
+     *
+     * @return The delta with all parts and the Snapshot bit
+     */
+    replication::Delta snapshot() const;
+};
+
+namespace replication
+{
+
+/** @brief Get the offset to keep the host time of the active side
+ *  @details If the BMC clocks of the two sides are apart more than
+ *  MAX_CLOCK_SKEW, the offset is adjusted by the diff, so that the
+ *  host time is the same after the standby takes over.
+ *
+ * @param[in] state - The replicated state, received just now
+ * @param[in] bmcTime - The current BMC time of this side
+ *
+ * @return The offset to the BMC time of this side
+ */
+std::chrono::microseconds localOffset(const ReplicaState& state,
+                                      std::chrono::microseconds bmcTime);
+
+} // namespace replication
+
+/** @class ReplicationSender
+ *  @brief Stream the time state changes to the standby.
+ *  @details It listens on a unix or TCP stream socket. When the standby
+ *  connects, the full state is sent, and then the changes are sent as
+ *  deltas. The changes in one event loop iteration are sent in one frame.
+ *  A TCP connection has keepalives, so that a standby that is gone is
+ *  dropped without waiting for a send to fail. On a live restart the
+ *  listening socket is handed over to the new process, which takes it
+ *  instead of binding the address again.
+ */
+class ReplicationSender
+{
+    public:
+        /** @brief Constructor
+         *
+         * @param[in] event - The event loop to run on
+         * @param[in] socketPath - The address of the replication socket,
+         *                         as parsed by replication::parseAddress()
+         * @param[in] handedFd - The listening socket handed over by the
+         *                       running process, owned by this object, or
+         *                       -1 to listen on the address
+         */
+        ReplicationSender(sd_event* event, const char* socketPath,
+                          int handedFd = -1);
+        ReplicationSender(const ReplicationSender&) = delete;
+        ReplicationSender& operator=(const ReplicationSender&) = delete;
+        ReplicationSender(ReplicationSender&&) = delete;
+        ReplicationSender& operator=(ReplicationSender&&) = delete;
+        ~ReplicationSender();
+
+        /** @brief Notified on time state changed
+         *
+         * @param[in] change - The changed time state
+         */
+        void onTimeStateChanged(const TimeStateChange& change);
+
+        /** @brief Get the listening socket to hand it over
+         *
+         * @return The listening socket, or -1 if it does not listen
+         */
+        int getListenFd() const
+        {
+            return listenFd;
+        }
+
+    private:
+        /** @brief The event loop */
+        sd_event* event;
+
+        /** @brief The address of the replication socket */
+        replication::Address address;
+
+        /** @brief The listening socket */
+        int listenFd = -1;
+
+        /** @brief The connection of the standby */
+        int connFd = -1;
+
+        /** @brief The state as sent to the standby */
+        ReplicaState state;
+
+        /** @brief The deltas to send in the next frame */
+        std::vector<replication::Delta> pending;
+
+        /** @brief The encoded bytes not written yet */
+        std::string outBuffer;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The event source of the listening socket */
+        SdEventSource listenSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief The event source of the connection */
+        SdEventSource connSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief The event source to send the pending deltas */
+        SdEventSource flushSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief Listen on the address of the replication socket
+         *
+         * @param[in] socketPath - The address, for the logs
+         *
+         * @return true if it listens
+         */
+        bool listenOn(const char* socketPath);
+
+        /** @brief Close the connection of the standby */
+        void closeConnection();
+
+        /** @brief Encode the pending deltas and write them */
+        void flush();
+
+        /** @brief Write the encoded bytes as many as the socket takes */
+        void writeOut();
+
+        /** @brief The callback function on new connection
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the listening socket
+         * @param[in] revents - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onConnect(sd_event_source* es, int fd,
+                             uint32_t revents, void* userdata);
+
+        /** @brief The callback function on the connection of the standby
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the connection
+         * @param[in] revents - The received events
+         * @param[in] userdata - User data pointer
+         */
+        static int onConnection(sd_event_source* es, int fd,
+                                uint32_t revents, void* userdata);
+
+        /** @brief The callback function to send the pending deltas
+         *
+         * @param[in] es - Source of the event
+         * @param[in] userdata - User data pointer
+         */
+        static int onFlush(sd_event_source* es, void* userdata);
+};
+
+/** @class ReplicationReceiver
+ *  @brief Receive the time state from the active side.
+ *  @details It connects to the replication socket, and reconnects once a
+ *  second while the active side is not there. A TCP connection has
+ *  keepalives, so that an active side that is gone, e.g. powered off, is
+ *  noticed in seconds.
+ */
+class ReplicationReceiver
+{
+    public:
+        /** @brief The function called with the state and the changed bits
+         *  when a received delta is applied
+         */
+        using Handler = std::function<void(const ReplicaState&, uint8_t)>;
+
+        /** @brief Constructor
+         *
+         * @param[in] event - The event loop to run on
+         * @param[in] socketPath - The address of the replication socket
+         *                         of the active side, as parsed by
+         *                         replication::parseAddress()
+         * @param[in] handler - The function called on applied deltas
+         */
+        ReplicationReceiver(sd_event* event,
+                            const char* socketPath,
+                            Handler handler);
+        ReplicationReceiver(const ReplicationReceiver&) = delete;
+        ReplicationReceiver& operator=(const ReplicationReceiver&) = delete;
+        ReplicationReceiver(ReplicationReceiver&&) = delete;
+        ReplicationReceiver& operator=(ReplicationReceiver&&) = delete;
+        ~ReplicationReceiver();
+
+        /** @brief Get the replicated state
+         *
+         * @return The replicated state
+         */
+        const ReplicaState& getState() const
+        {
+            return state;
+        }
+
+    private:
+        /** @brief The event loop */
+        sd_event* event;
+
+        /** @brief The address of the replication socket */
+        std::string socketPath;
+
+        /** @brief The function called on applied deltas */
+        Handler handler;
+
+        /** @brief The connection to the active side */
+        int sock = -1;
+
+        /** @brief Indicate if a TCP connect is in progress */
+        bool connecting = false;
+
+        /** @brief The replicated state */
+        ReplicaState state;
+
+        /** @brief The reader of the received frames */
+        replication::FrameReader reader;
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The event source of the connection */
+        SdEventSource sockSource {nullptr, sdEventSourceDeleter};
+
+        /** @brief The timer to reconnect */
+        SdEventSource retryTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief Connect to the active side, or arm the retry timer */
+        void connect();
+
+        /** @brief Close the connection and arm the retry timer */
+        void disconnect();
+
+        /** @brief Start receiving on the connection */
+        void connected();
+
+        /** @brief The callback function on received data, or on the end
+         *  of a TCP connect
+         *
+         * @param[in] es - Source of the event
+         * @param[in] fd - File descriptor of the connection
+         * @param[in] revents - The received events
+         * @param[in] userdata - User data pointer
+         */
+        static int onData(sd_event_source* es, int fd,
+                          uint32_t revents, void* userdata);
+
+        /** @brief The callback function of the retry timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - Not used
+         * @param[in] userdata - User data pointer
+         */
+        static int onRetry(sd_event_source* es, uint64_t usec,
+                           void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,162 @@
+#include "set_latency.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+
+namespace // anonymous
+{
+constexpr auto SET_LATENCY_INTERFACE =
+    "xyz.openbmc_project.Time.Internal.SetLatency";
+}
+
+constexpr seconds SetLatency::maxApplyDelay;
+
+SetLatency::SetLatency(sdbusplus::bus::bus& bus,
+                       const char* objPath,
+                       Clock steady,
+                       Clock realtime)
+    : sdbusplus::server::object::object<Interface>(bus, objPath),
+      bus(bus),
+      steady(std::move(steady)),
+      realtime(std::move(realtime)),
+      objPath(objPath)
+{
+    if (!this->steady)
+    {
+        this->steady = []()
+        {
+            return duration_cast<microseconds>(
+                steady_clock::now().time_since_epoch());
+        };
+    }
+    if (!this->realtime)
+    {
+        this->realtime = []()
+        {
+            return duration_cast<microseconds>(
+                system_clock::now().time_since_epoch());
+        };
+    }
+}
+
+microseconds SetLatency::received() const
+{
+    // The timestamp is on CLOCK_MONOTONIC, as the steady clock is, but it
+    // is only there if the bus negotiates it and the transport stamps the
+    // messages, e.g. not on the socket of dbus-daemon
+    uint64_t usec = 0;
+    auto m = sd_bus_get_current_message(bus.get());
+    if (m && sd_bus_message_get_monotonic_usec(m, &usec) >= 0 && usec != 0)
+    {
+        return microseconds(usec);
+    }
+    return steady();
+}
+
+microseconds SetLatency::advance(const microseconds& time,
+                                 const microseconds& received)
+{
+    auto delay = std::max(steady() - received, microseconds(0));
+    sets(sets() + 1, true);
+    changed("Sets", true);
+    changed("LastDelay", lastDelay() != static_cast<uint64_t>(delay.count()));
+    lastDelay(delay.count(), true);
+    return time + delay;
+}
+
+microseconds SetLatency::compensate(const microseconds& time,
+                                    const microseconds& received)
+{
+    auto advanced = advance(time, received);
+    publish();
+    return advanced;
+}
+
+microseconds SetLatency::compensateSet(const microseconds& time,
+                                       const microseconds& received)
+{
+    // Published when the set is settled or abandoned
+    auto applied = advance(time, received) + microseconds(applyDelay());
+    changed("LastDelay", applyDelay() != 0);
+    lastDelay(lastDelay() + applyDelay(), true);
+    return applied;
+}
+
+void SetLatency::settle(const microseconds& time,
+                        const microseconds& received)
+{
+    // The requested time as of now, against the clock that is set
+    auto now = realtime();
+    auto residual = now - (time + (steady() - received));
+    changed("LastResidual", lastResidual() != residual.count());
+    lastResidual(residual.count(), true);
+    auto maxNow = std::max<uint64_t>(maxResidual(),
+                                     residual < microseconds(0) ?
+                                         -residual.count() :
+                                         residual.count());
+    changed("MaxResidual", maxResidual() != maxNow);
+    maxResidual(maxNow, true);
+
+    // The set is advanced by the estimated delay, so the residual is the
+    // error of the estimate
+    auto delay = microseconds(applyDelay()) - residual;
+    if (delay >= microseconds(0) && delay <= maxApplyDelay)
+    {
+        auto estimate = delay;
+        if (sampled)
+        {
+            estimate = (microseconds(applyDelay()) * 7 + delay) / 8;
+        }
+        sampled = true;
+        changed("ApplyDelay",
+                applyDelay() != static_cast<uint64_t>(estimate.count()));
+        applyDelay(estimate.count(), true);
+    }
+    publish();
+}
+
+void SetLatency::abandon()
+{
+    publish();
+}
+
+void SetLatency::changed(const char* property, bool isChanged)
+{
+    if (!isChanged ||
+        std::find_if(pending.begin(), pending.end(),
+                     [property](const char* p)
+                     {
+                         return strcmp(p, property) == 0;
+                     }) != pending.end())
+    {
+        return;
+    }
+    pending.push_back(property);
+}
+
+void SetLatency::publish()
+{
+    if (pending.empty())
+    {
+        return;
+    }
+    std::vector<char*> names;
+    for (auto property : pending)
+    {
+        names.push_back(const_cast<char*>(property));
+    }
+    names.push_back(nullptr);
+    pending.clear();
+    sd_bus_emit_properties_changed_strv(bus.get(), objPath.c_str(),
+                                        SET_LATENCY_INTERFACE, names.data());
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "xyz/openbmc_project/Time/Internal/SetLatency/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class SetLatency
+ *  @brief Compensate the time sets for their latency.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.SetLatency DBus API.
+ *  A set is stamped on the steady clock when its request is received, and
+ *  the time is advanced by the delay since then when it is applied. A set
+ *  by SetTime is advanced also by the estimated delay of timedated to set
+ *  it, which is learned from the residual error of the previous sets.
+ *  The properties of a set are changed together, with one
+ *  PropertiesChanged signal.
+ */
+class SetLatency : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::SetLatency >
+{
+    public:
+        friend class TestSetLatency;
+
+        using Interface = sdbusplus::xyz::openbmc_project::Time::Internal::
+                              server::SetLatency;
+
+        /** @brief The function to read a clock */
+        using Clock = std::function<std::chrono::microseconds()>;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] steady - The function to read the steady clock, empty
+         *                     for CLOCK_MONOTONIC
+         * @param[in] realtime - The function to read the BMC time, empty
+         *                       for CLOCK_REALTIME
+         */
+        SetLatency(sdbusplus::bus::bus& bus,
+                   const char* objPath,
+                   Clock steady = nullptr,
+                   Clock realtime = nullptr);
+        SetLatency(const SetLatency&) = delete;
+        SetLatency& operator=(const SetLatency&) = delete;
+        SetLatency(SetLatency&&) = delete;
+        SetLatency& operator=(SetLatency&&) = delete;
+
+        /** @brief Get the steady time the request being handled is
+         *  received at
+         *  @details It is the receive timestamp of the message if the bus
+         *  negotiates and provides one, otherwise the steady time now,
+         *  which is at the start of the handler when it is called first.
+         *
+         * @return Microseconds of the steady clock
+         */
+        std::chrono::microseconds received() const;
+
+        /** @brief Advance a requested time by the delay since its request
+         *  is received, for a time or an offset applied right away
+         *
+         * @param[in] time - The requested time
+         * @param[in] received - The steady time the request is received
+         *
+         * @return The requested time as of now
+         */
+        std::chrono::microseconds compensate(
+            const std::chrono::microseconds& time,
+            const std::chrono::microseconds& received);
+
+        /** @brief Advance a requested time by the delay since its request
+         *  is received, and by the delay of timedated to set it, for a time
+         *  set by SetTime now
+         *
+         * @param[in] time - The requested time
+         * @param[in] received - The steady time the request is received
+         *
+         * @return The time to call SetTime with
+         */
+        std::chrono::microseconds compensateSet(
+            const std::chrono::microseconds& time,
+            const std::chrono::microseconds& received);
+
+        /** @brief Measure the residual error of a time that is set by
+         *  SetTime, and learn the delay of timedated from it
+         *
+         * @param[in] time - The requested time
+         * @param[in] received - The steady time the request is received
+         */
+        void settle(const std::chrono::microseconds& time,
+                    const std::chrono::microseconds& received);
+
+        /** @brief Publish a set by SetTime that failed, it is not measured
+         */
+        void abandon();
+
+        /** @brief The bound of the estimated delay of timedated, a larger
+         *  residual is not taken as the delay, e.g. if the time is set by
+         *  others meanwhile
+         */
+        static constexpr auto maxApplyDelay = std::chrono::seconds(1);
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The function to read the steady clock */
+        Clock steady;
+
+        /** @brief The function to read the BMC time */
+        Clock realtime;
+
+        /** @brief The object path */
+        std::string objPath;
+
+        /** @brief Indicate if a delay of timedated is measured */
+        bool sampled = false;
+
+        /** @brief The properties changed since they are published */
+        std::vector<const char*> pending;
+
+        /** @brief Advance a requested time by the delay since its request
+         *  is received, without publishing it
+         */
+        std::chrono::microseconds advance(
+            const std::chrono::microseconds& time,
+            const std::chrono::microseconds& received);
+
+        /** @brief Keep a property to publish if its value changes
+         *
+         * @param[in] property - The name of the property
+         * @param[in] isChanged - Indicate if its value changes
+         */
+        void changed(const char* property, bool isChanged);
+
+        /** @brief Emit one PropertiesChanged for the kept properties */
+        void publish();
+};
+
+} // namespace time
+} // namespace phosphor
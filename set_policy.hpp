@@ -0,0 +1,174 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @brief The clocks that are able to be set */
+enum class Clock : uint8_t
+{
+    BMC,
+    Host,
+};
+
+/** @brief The action on setting a clock */
+enum class SetAction : uint8_t
+{
+    /** @brief Setting the clock is not allowed */
+    Reject,
+    /** @brief Set the time to the system */
+    SetSystemTime,
+    /** @brief Store the offset between host and BMC time */
+    StoreOffset,
+};
+
+namespace policy
+{
+
+/** @brief A rule of the set policy */
+struct Rule
+{
+    SetAction action;
+
+    /** @brief The reason of the rejection */
+    const char* reason;
+};
+
+constexpr size_t clockCount = 2;
+constexpr size_t modeCount = 2;
+constexpr size_t ownerCount = 4;
+
+// The table is indexed by the values of the enums, which are the orders of
+// the values in the interface definitions
+static_assert(static_cast<size_t>(Clock::BMC) == 0 &&
+              static_cast<size_t>(Clock::Host) == 1,
+              "Unexpected Clock values");
+static_assert(static_cast<size_t>(Mode::NTP) == 0 &&
+              static_cast<size_t>(Mode::Manual) == 1,
+              "Unexpected Mode values");
+static_assert(static_cast<size_t>(Owner::BMC) == 0 &&
+              static_cast<size_t>(Owner::Host) == 1 &&
+              static_cast<size_t>(Owner::Split) == 2 &&
+              static_cast<size_t>(Owner::Both) == 3,
+              "Unexpected Owner values");
+
+constexpr Rule reject(const char* reason)
+{
+    return Rule{SetAction::Reject, reason};
+}
+constexpr Rule setSystemTime{SetAction::SetSystemTime, ""};
+constexpr Rule storeOffset{SetAction::StoreOffset, ""};
+
+/** @brief The set policy, indexed by [Clock][Mode][Owner]
+ *
+ *  Clock | Mode   | BMC    | Host   | Split  | Both
+ *  ----- | ------ | ------ | ------ | ------ | ------
+ *  BMC   | NTP    | Reject | Reject | Reject | Reject
+ *  BMC   | Manual | System | Reject | System | System
+ *  Host  | NTP    | Reject | Reject | Offset | Reject
+ *  Host  | Manual | Reject | System | Offset | System
+ */
+constexpr Rule table[clockCount][modeCount][ownerCount] = {
+    // Clock::BMC
+    {
+        // Mode::NTP, the time is synced by NTP
+        {
+            reject("BMC time is synced by NTP"),
+            reject("BMC time is owned by host"),
+            reject("BMC time is synced by NTP"),
+            reject("BMC time is synced by NTP"),
+        },
+        // Mode::Manual
+        {
+            setSystemTime,
+            reject("BMC time is owned by host"),
+            setSystemTime,
+            setSystemTime,
+        },
+    },
+    // Clock::Host
+    {
+        // Mode::NTP
+        {
+            reject("Host time is owned by BMC"),
+            reject("Host time is synced by NTP"),
+            storeOffset,
+            reject("Host time is synced by NTP"),
+        },
+        // Mode::Manual
+        {
+            reject("Host time is owned by BMC"),
+            setSystemTime,
+            storeOffset,
+            setSystemTime,
+        },
+    },
+};
+
+/** @brief Look up the rule of setting a clock
+ *
+ * @param[in] clock - The clock to set
+ * @param[in] mode - The current time mode
+ * @param[in] owner - The current time owner
+ *
+ * @return The rule of the set
+ */
+constexpr const Rule& lookup(Clock clock, Mode mode, Owner owner)
+{
+    return table[static_cast<size_t>(clock)]
+                [static_cast<size_t>(mode)]
+                [static_cast<size_t>(owner)];
+}
+
+static_assert(lookup(Clock::BMC, Mode::Manual, Owner::BMC).action ==
+              SetAction::SetSystemTime, "BMC owns BMC time");
+static_assert(lookup(Clock::BMC, Mode::Manual, Owner::Host).action ==
+              SetAction::Reject, "Host owns BMC time");
+static_assert(lookup(Clock::Host, Mode::Manual, Owner::BMC).action ==
+              SetAction::Reject, "BMC owns host time");
+static_assert(lookup(Clock::Host, Mode::Manual, Owner::Host).action ==
+              SetAction::SetSystemTime, "Host owns BMC time");
+static_assert(lookup(Clock::BMC, Mode::Manual, Owner::Split).action ==
+              SetAction::SetSystemTime &&
+              lookup(Clock::Host, Mode::NTP, Owner::Split).action ==
+              SetAction::StoreOffset &&
+              lookup(Clock::Host, Mode::Manual, Owner::Split).action ==
+              SetAction::StoreOffset,
+              "In Split, BMC and host keep their own clocks");
+static_assert(lookup(Clock::BMC, Mode::NTP, Owner::Both).action ==
+              SetAction::Reject &&
+              lookup(Clock::Host, Mode::NTP, Owner::Both).action ==
+              SetAction::Reject,
+              "NTP owns the system time");
+
+/** @brief Check that no clock stores offset out of Split owner */
+constexpr bool offsetOnlyInSplit()
+{
+    for (size_t c = 0; c < clockCount; ++c)
+    {
+        for (size_t m = 0; m < modeCount; ++m)
+        {
+            for (size_t o = 0; o < ownerCount; ++o)
+            {
+                if (table[c][m][o].action == SetAction::StoreOffset &&
+                    (c != static_cast<size_t>(Clock::Host) ||
+                     o != static_cast<size_t>(Owner::Split)))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+static_assert(offsetOnlyInSplit(), "Only host time in Split stores offset");
+
+} // namespace policy
+} // namespace time
+} // namespace phosphor
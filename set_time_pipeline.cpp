@@ -0,0 +1,193 @@
+#include "set_time_pipeline.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <cstring>
+
+namespace // anonymous
+{
+constexpr auto SYSTEMD_TIME_SERVICE = "org.freedesktop.timedate1";
+constexpr auto SYSTEMD_TIME_PATH = "/org/freedesktop/timedate1";
+constexpr auto SYSTEMD_TIME_INTERFACE = "org.freedesktop.timedate1";
+constexpr auto METHOD_SET_TIME = "SetTime";
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+
+SetTimePipeline::SetTimePipeline(sdbusplus::bus::bus& bus)
+    : writer([this](const microseconds& time)
+             {
+                 return callSetTime(time);
+             }),
+      bus(&bus)
+{
+}
+
+SetTimePipeline::SetTimePipeline(Writer writer)
+    : writer(std::move(writer))
+{
+}
+
+SetTimePipeline::~SetTimePipeline()
+{
+    sd_bus_slot_unref(slot);
+}
+
+void SetTimePipeline::submit(const microseconds& time, Callback callback)
+{
+    submit(time, latency ? latency->received() : microseconds(0),
+           std::move(callback));
+}
+
+void SetTimePipeline::submit(const microseconds& time,
+                             const microseconds& received,
+                             Callback callback)
+{
+    ++count.submitted;
+    if (!inFlight)
+    {
+        inFlight.reset(new Write{time, received, {std::move(callback)}, 0});
+        start();
+        return;
+    }
+    if (queued)
+    {
+        // Last writer wins, the replaced caller waits for the new time
+        ++count.collapsed;
+        ++queued->collapsed;
+        queued->time = time;
+        queued->received = received;
+        queued->callbacks.push_back(std::move(callback));
+        return;
+    }
+    queued.reset(new Write{time, received, {std::move(callback)}, 0});
+}
+
+void SetTimePipeline::complete(bool ok)
+{
+    if (!inFlight)
+    {
+        return;
+    }
+    auto done = std::move(inFlight);
+    if (!ok)
+    {
+        ++count.failures;
+        log<level::ERR>("Error in setting system time");
+        if (latency)
+        {
+            latency->abandon();
+        }
+    }
+    else if (latency)
+    {
+        latency->settle(done->time, done->received);
+    }
+    if (done->collapsed != 0)
+    {
+        log<level::INFO>("Collapsed time sets",
+                         entry("COLLAPSED=%llu",
+                               static_cast<unsigned long long>(
+                                   done->collapsed)),
+                         entry("TOTAL=%llu",
+                               static_cast<unsigned long long>(
+                                   count.collapsed)));
+    }
+
+    // Start the next one before the callbacks, which may submit again
+    if (queued)
+    {
+        inFlight = std::move(queued);
+        start();
+    }
+    for (const auto& callback : done->callbacks)
+    {
+        if (callback)
+        {
+            callback(ok, done->time);
+        }
+    }
+}
+
+void SetTimePipeline::start()
+{
+    ++count.writes;
+    auto time = inFlight->time;
+    if (latency)
+    {
+        // The time may have waited in the queue, it is advanced to now
+        time = latency->compensateSet(time, inFlight->received);
+    }
+    if (!writer(time))
+    {
+        complete(false);
+    }
+}
+
+bool SetTimePipeline::callSetTime(const microseconds& time)
+{
+    sd_bus_slot_unref(slot);
+    slot = nullptr;
+    if (breaker && !breaker->allow())
+    {
+        // timedated does not reply, fail fast instead of waiting
+        return false;
+    }
+
+    sd_bus_message* m = nullptr;
+    auto r = sd_bus_message_new_method_call(bus->get(), &m,
+                                            SYSTEMD_TIME_SERVICE,
+                                            SYSTEMD_TIME_PATH,
+                                            SYSTEMD_TIME_INTERFACE,
+                                            METHOD_SET_TIME);
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(m, "xbb",
+                                  static_cast<int64_t>(time.count()),
+                                  false, // relative
+                                  false); // user_interaction
+    }
+    if (r >= 0)
+    {
+        uint64_t timeout = 0;
+        if (breaker)
+        {
+            timeout = breaker->timeout();
+            started = breaker->now();
+        }
+        r = sd_bus_call_async(bus->get(), &slot, m, onReply, this, timeout);
+    }
+    sd_bus_message_unref(m);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to call SetTime",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return false;
+    }
+    return true;
+}
+
+int SetTimePipeline::onReply(sd_bus_message* m, void* userdata,
+                             sd_bus_error* /* error */)
+{
+    auto pipeline = static_cast<SetTimePipeline*>(userdata);
+    if (pipeline->breaker)
+    {
+        auto breaker = pipeline->breaker;
+        breaker->record(CircuitBreaker::replied(0,
+                                                sd_bus_message_get_error(m)),
+                        breaker->now() - pipeline->started);
+    }
+    pipeline->complete(sd_bus_message_is_method_error(m, nullptr) == 0);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "circuit_breaker.hpp"
+#include "set_latency.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class SetTimePipeline
+ *  @brief Set the system time with at most one SetTime call in flight.
+ *  @details A time submitted while a SetTime call is pending is queued, and
+ *  a later one replaces the queued time, as only the latest one matters.
+ *  The callers of the replaced times complete with the result of the time
+ *  that replaced them.
+ */
+class SetTimePipeline
+{
+    public:
+        /** @brief The function called when the submitted time is done
+         *
+         * @param[in] ok - Indicate if the time is set
+         * @param[in] time - The time that is set, which is a later
+         *                   submitted one if the submitted one is replaced
+         */
+        using Callback =
+            std::function<void(bool ok, const std::chrono::microseconds& time)>;
+
+        /** @brief The function to start setting a time, complete() shall be
+         *  called when it is done
+         *
+         * @return false if it fails to start
+         */
+        using Writer = std::function<bool(const std::chrono::microseconds&)>;
+
+        /** @brief The counters of the pipeline */
+        struct Counters
+        {
+            /** @brief The number of submitted times */
+            uint64_t submitted = 0;
+
+            /** @brief The number of started writes */
+            uint64_t writes = 0;
+
+            /** @brief The number of queued times replaced by a later one */
+            uint64_t collapsed = 0;
+
+            /** @brief The number of failed writes */
+            uint64_t failures = 0;
+        };
+
+        /** @brief Constructor - set the time by systemd timedated's SetTime
+         *
+         * @param[in] bus - The Dbus bus object
+         */
+        explicit SetTimePipeline(sdbusplus::bus::bus& bus);
+
+        /** @brief Constructor - set the time by the writer
+         *
+         * @param[in] writer - The function to start setting a time
+         */
+        explicit SetTimePipeline(Writer writer);
+
+        SetTimePipeline(const SetTimePipeline&) = delete;
+        SetTimePipeline& operator=(const SetTimePipeline&) = delete;
+        SetTimePipeline(SetTimePipeline&&) = delete;
+        SetTimePipeline& operator=(SetTimePipeline&&) = delete;
+        ~SetTimePipeline();
+
+        /** @brief Submit a time to set, stamped when it is submitted, i.e.
+         *  the request of the time is being handled
+         *
+         * @param[in] time - Microseconds since UTC
+         * @param[in] callback - The function called when it is done,
+         *                       may be empty
+         */
+        void submit(const std::chrono::microseconds& time, Callback callback);
+
+        /** @brief Submit a time to set, stamped by its caller when its
+         *  request is received
+         *
+         * @param[in] time - Microseconds since UTC
+         * @param[in] received - The steady time the request is received
+         * @param[in] callback - The function called when it is done,
+         *                       may be empty
+         */
+        void submit(const std::chrono::microseconds& time,
+                    const std::chrono::microseconds& received,
+                    Callback callback);
+
+        /** @brief Complete the write in flight
+         *
+         * @param[in] ok - Indicate if the time is set
+         */
+        void complete(bool ok);
+
+        /** @brief Indicate if a write is in flight */
+        bool busy() const
+        {
+            return static_cast<bool>(inFlight);
+        }
+
+        /** @brief Get the counters */
+        const Counters& counters() const
+        {
+            return count;
+        }
+
+        /** @brief Call SetTime through the breaker, with its timeout, and
+         *  fail the writes fast while it is open
+         *
+         * @param[in] timedated - The breaker of the timedated calls
+         */
+        void useBreaker(CircuitBreaker& timedated)
+        {
+            breaker = &timedated;
+        }
+
+        /** @brief Stamp the submitted times when their requests are
+         *  received, and compensate them for the delay until they are set
+         *
+         * @param[in] compensator - The compensator of the set latency
+         */
+        void useLatency(SetLatency& compensator)
+        {
+            latency = &compensator;
+        }
+
+    private:
+        /** @brief A time to set and the callers waiting for it */
+        struct Write
+        {
+            std::chrono::microseconds time;
+
+            /** @brief The steady time the request of the time is received */
+            std::chrono::microseconds received;
+
+            std::vector<Callback> callbacks;
+
+            /** @brief The number of replaced times it carries */
+            uint64_t collapsed;
+        };
+
+        /** @brief The function to start setting a time */
+        Writer writer;
+
+        /** @brief The bus to call SetTime on, if it is the writer */
+        sdbusplus::bus::bus* bus = nullptr;
+
+        /** @brief The slot of the pending SetTime call */
+        sd_bus_slot* slot = nullptr;
+
+        /** @brief The breaker of the SetTime calls, or nullptr */
+        CircuitBreaker* breaker = nullptr;
+
+        /** @brief The compensator of the set latency, or nullptr */
+        SetLatency* latency = nullptr;
+
+        /** @brief The steady time the pending SetTime call is started */
+        std::chrono::microseconds started{0};
+
+        /** @brief The write in flight */
+        std::unique_ptr<Write> inFlight;
+
+        /** @brief The write queued after the one in flight */
+        std::unique_ptr<Write> queued;
+
+        /** @brief The counters */
+        Counters count;
+
+        /** @brief Start the write in flight */
+        void start();
+
+        /** @brief Call timedated's SetTime asynchronously
+         *
+         * @param[in] time - Microseconds since UTC
+         *
+         * @return false if the call fails to start
+         */
+        bool callSetTime(const std::chrono::microseconds& time);
+
+        /** @brief The callback function of the SetTime reply
+         *
+         * @param[in] m - The reply message
+         * @param[in] userdata - User data pointer
+         * @param[in] error - Not used
+         */
+        static int onReply(sd_bus_message* m, void* userdata,
+                           sd_bus_error* error);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -13,9 +13,9 @@ constexpr auto mapperService = "xyz.openbmc_project.ObjectMapper";
 constexpr auto mapperPath = "/xyz/openbmc_project/object_mapper";
 constexpr auto mapperIntf = "xyz.openbmc_project.ObjectMapper";
 
-Objects::Objects()
+Objects::Objects(sdbusplus::bus::bus& bus)
+    : bus(bus)
 {
-    auto bus = sdbusplus::bus::new_default();
     std::vector<std::string> settingsIntfs =
         {timeOwnerIntf, timeSyncIntf, hostStateIntf};
     auto depth = 0;
@@ -47,6 +47,7 @@ Objects::Objects()
     for (const auto& iter : result)
     {
         const Path& path = iter.first;
+        const Service& service = iter.second.begin()->first;
         const Interface& interface = iter.second.begin()->second.front();
 
         if (timeOwnerIntf == interface)
@@ -61,12 +62,93 @@ Objects::Objects()
         {
             hostState = path;
         }
+        else
+        {
+            continue;
+        }
+        services[path] = service;
+    }
+}
+
+Objects::Objects(sdbusplus::bus::bus& bus,
+                 const Path& timeOwner,
+                 const Path& timeSyncMethod,
+                 const Path& hostState,
+                 const std::map<Path, Service>& services)
+    : timeOwner(timeOwner),
+      timeSyncMethod(timeSyncMethod),
+      hostState(hostState),
+      services(services),
+      bus(bus)
+{
+}
+
+const Path& Objects::pathOf(const Interface& interface) const
+{
+    if (interface == timeOwnerIntf)
+    {
+        return timeOwner;
+    }
+    if (interface == timeSyncIntf)
+    {
+        return timeSyncMethod;
+    }
+    return hostState;
+}
+
+bool Objects::rediscover(const Interface& interface)
+{
+    std::vector<std::string> settingsIntfs = {interface};
+    auto depth = 0;
+
+    auto mapperCall = bus.new_method_call(mapperService,
+                                          mapperPath,
+                                          mapperIntf,
+                                          "GetSubTree");
+    mapperCall.append(root);
+    mapperCall.append(depth);
+    mapperCall.append(settingsIntfs);
+    auto response = bus.call(mapperCall);
+    if (response.is_method_error())
+    {
+        log<level::ERR>("Error in mapper GetSubTree",
+                        entry("INTERFACE=%s", interface.c_str()));
+        return false;
     }
+
+    using Interfaces = std::vector<Interface>;
+    using MapperResponse = std::map<Path, std::map<Service, Interfaces>>;
+    MapperResponse result;
+    response.read(result);
+    if (result.empty())
+    {
+        log<level::ERR>("Invalid response from mapper",
+                        entry("INTERFACE=%s", interface.c_str()));
+        return false;
+    }
+
+    const Path& path = result.begin()->first;
+    const Service& service = result.begin()->second.begin()->first;
+    auto& current = (interface == timeOwnerIntf) ? timeOwner :
+                    (interface == timeSyncIntf) ? timeSyncMethod :
+                    hostState;
+    if (current != path)
+    {
+        services.erase(current);
+        current = path;
+    }
+    services[path] = service;
+    return true;
 }
 
 Service Objects::service(const Path& path, const Interface& interface) const
 {
-    auto bus = sdbusplus::bus::new_default();
+    auto it = services.find(path);
+    if (it != services.end())
+    {
+        return it->second;
+    }
+
     using Interfaces = std::vector<Interface>;
     auto mapperCall = bus.new_method_call(mapperService,
                                           mapperPath,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 #include <sdbusplus/bus.hpp>
 
@@ -22,19 +23,34 @@ struct Objects
 {
     public:
         /** @brief Constructor - fetch settings objects
+         *
+         * @param[in] bus - The D-bus bus object, shared by the discovery
+         *                  and the service lookups
+         */
+        explicit Objects(sdbusplus::bus::bus& bus);
+
+        /** @brief Constructor - use known settings objects
          *
          * @param[in] bus - The D-bus bus object
+         * @param[in] timeOwner - The time owner settings object
+         * @param[in] timeSyncMethod - The time sync method settings object
+         * @param[in] hostState - The host state object
+         * @param[in] services - The known services of the objects
          */
-        Objects();
+        Objects(sdbusplus::bus::bus& bus,
+                const Path& timeOwner,
+                const Path& timeSyncMethod,
+                const Path& hostState,
+                const std::map<Path, Service>& services);
         Objects(const Objects&) = default;
-        Objects& operator=(const Objects&) = default;
+        Objects& operator=(const Objects&) = delete;
         Objects(Objects&&) = default;
-        Objects& operator=(Objects&&) = default;
+        Objects& operator=(Objects&&) = delete;
         ~Objects() = default;
 
-        /** @brief Fetch D-bus service, given a path and an interface. The
-         *         service can't be cached because mapper returns unique
-         *         service names.
+        /** @brief Fetch D-bus service, given a path and an interface.
+         *         The service found by the discovery is returned, otherwise
+         *         the mapper is called.
          *
          * @param[in] path - The D-bus object
          * @param[in] interface - The D-bus interface
@@ -43,6 +59,24 @@ struct Objects
          */
         Service service(const Path& path, const Interface& interface) const;
 
+        /** @brief Get the object of an interface of interest
+         *
+         * @param[in] interface - One of the interfaces of interest
+         *
+         * @return The object of the interface
+         */
+        const Path& pathOf(const Interface& interface) const;
+
+        /** @brief Discover the object of one interface again, e.g. after
+         *         its service restarts, and update it and its service
+         *         in place
+         *
+         * @param[in] interface - One of the interfaces of interest
+         *
+         * @return true if the object is found
+         */
+        bool rediscover(const Interface& interface);
+
         /** @brief time owner settings object */
         Path timeOwner;
 
@@ -51,6 +85,13 @@ struct Objects
 
         /** @brief host state object */
         Path hostState;
+
+        /** @brief The services of the above objects found by discovery */
+        std::map<Path, Service> services;
+
+    private:
+        /** @brief The D-bus bus object */
+        sdbusplus::bus::bus& bus;
 };
 
 } // namespace settings
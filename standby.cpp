@@ -0,0 +1,63 @@
+#include "config.h"
+#include "host_epoch.hpp"
+#include "manager.hpp"
+#include "replication.hpp"
+#include "utils.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <chrono>
+#include <memory>
+
+using namespace phosphor::logging;
+
+/** @brief Keep the time state of the active BMC in the files that the time
+ *  manager restores from, so that it takes over with the same state when
+ *  this BMC becomes active.
+ */
+int main()
+{
+    using namespace phosphor::time;
+    sd_event* event = nullptr;
+
+    auto eventDeleter = [](sd_event* e) {
+        e = sd_event_unref(e);
+    };
+    using SdEvent = std::unique_ptr<sd_event, decltype(eventDeleter)>;
+
+    sd_event_default(&event);
+    SdEvent sdEvent {event, eventDeleter};
+    event = nullptr;
+
+    ReplicationReceiver receiver(
+        sdEvent.get(), REPLICATION_PEER,
+        [](const ReplicaState& state, uint8_t changed)
+        {
+            if (changed & TimeStateChange::ModeChanged)
+            {
+                utils::writeData(Manager::defaultModeFile,
+                                 utils::modeToStr(state.mode));
+            }
+            if (changed & TimeStateChange::OwnerChanged)
+            {
+                utils::writeData(Manager::defaultOwnerFile,
+                                 utils::ownerToStr(state.owner));
+            }
+            if (changed & TimeStateChange::OffsetChanged)
+            {
+                using namespace std::chrono;
+                auto bmcTime = duration_cast<microseconds>(
+                    system_clock::now().time_since_epoch());
+                auto offset = replication::localOffset(state, bmcTime);
+                utils::writeData(HostEpoch::defaultOffsetFile, offset.count());
+            }
+            unsigned long long seq = state.seq;
+            log<level::DEBUG>("Replicated time state",
+                              entry("SEQ=%llu", seq),
+                              entry("CHANGED=0x%x", changed));
+        });
+
+    sd_event_loop(sdEvent.get());
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class SystemClock
+ *  @brief The system clocks, and the timedated methods that set them.
+ *  @details The epoch objects and the manager use the real ones unless
+ *  they are given one of this, e.g. by a simulation that runs them on a
+ *  virtual time without the time services.
+ */
+class SystemClock
+{
+    public:
+        virtual ~SystemClock() = default;
+
+        /** @brief Read CLOCK_REALTIME
+         *
+         * @return Microseconds since UTC
+         */
+        virtual std::chrono::microseconds realtime() const = 0;
+
+        /** @brief Read the steady clock
+         *
+         * @return Microseconds since an unspecified start
+         */
+        virtual std::chrono::microseconds steady() const = 0;
+
+        /** @brief Set CLOCK_REALTIME, as timedated's SetTime
+         *
+         * @param[in] time - Microseconds since UTC
+         *
+         * @return true if the time is set
+         */
+        virtual bool setTime(const std::chrono::microseconds& time) = 0;
+
+        /** @brief Enable or disable NTP, as timedated's SetNTP
+         *
+         * @param[in] enabled - Indicate if NTP is enabled
+         *
+         * @return true if it is done
+         */
+        virtual bool setNtp(bool enabled) = 0;
+};
+
+} // namespace time
+} // namespace phosphor
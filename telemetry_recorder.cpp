@@ -0,0 +1,135 @@
+#include "telemetry_recorder.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace // anonymous
+{
+/** @brief The max time the samples are kept in memory, i.e. lost on a
+ *  power loss, as the current page is written at most this often
+ */
+constexpr auto MAX_UNWRITTEN = std::chrono::hours(6);
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+using Telemetry =
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::Telemetry;
+
+TelemetryRecorder::TelemetryRecorder(sdbusplus::bus::bus& bus,
+                                     const char* objPath,
+                                     const char* file,
+                                     size_t pages,
+                                     uint64_t interval,
+                                     Adjtimex adjtimex)
+    : sdbusplus::server::object::object<Telemetry>(bus, objPath),
+      bus(bus),
+      ring(pages),
+      adjtimex(std::move(adjtimex)),
+      written(steady_clock::now())
+{
+    if (file)
+    {
+        ring.open(file);
+    }
+    Telemetry::interval(interval);
+
+    uint64_t now;
+    sd_event_source* es;
+    auto event = bus.get_event();
+    auto r = sd_event_now(event, CLOCK_MONOTONIC, &now);
+    if (r >= 0)
+    {
+        r = sd_event_add_time(event, &es, CLOCK_MONOTONIC,
+                              now + std::max<uint64_t>(interval, 1) * 1000000,
+                              0,
+                              onSampleTimer, this);
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to schedule the telemetry samples",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+        return;
+    }
+    sampleTimer.reset(es);
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    ring.flush();
+}
+
+std::tuple<std::vector<uint8_t>, uint32_t>
+TelemetryRecorder::read(uint32_t start)
+{
+    uint32_t next;
+    auto data = ring.read(start, maxReadPages, next);
+    return std::make_tuple(std::move(data), next);
+}
+
+void TelemetryRecorder::onTimeStateChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::OffsetChanged))
+    {
+        offset = change.offset;
+    }
+    if (change.has(TimeStateChange::BmcTimeJumped))
+    {
+        ++jumps;
+    }
+}
+
+void TelemetryRecorder::sample()
+{
+    struct timex tx{};
+    if (adjtimex(&tx) < 0)
+    {
+        log<level::ERR>("Failed to read the kernel clock",
+                        entry("ERRNO=%d", errno));
+        tx = {};
+    }
+
+    telemetry::Sample s;
+    s.time = duration_cast<seconds>(utils::now(ClockRead::Coarse)).count();
+    s.offset = offset.count();
+    s.frequency = tx.freq;
+    s.error = tx.esterror;
+    s.jumps = jumps;
+    ring.append(s);
+    samples(samples() + 1);
+
+    auto now = steady_clock::now();
+    if (now - written >= MAX_UNWRITTEN)
+    {
+        ring.flush();
+        written = now;
+    }
+}
+
+int TelemetryRecorder::onSampleTimer(sd_event_source* es, uint64_t usec,
+                                     void* userdata)
+{
+    auto recorder = static_cast<TelemetryRecorder*>(userdata);
+    recorder->sample();
+    wakeup::count(wakeup::Source::TelemetrySample, true);
+
+    // The interval may be set on DBus
+    auto interval = std::max<uint64_t>(recorder->interval(), 1);
+    sd_event_source_set_time(es, usec + interval * 1000000);
+    sd_event_source_set_enabled(es, SD_EVENT_ON);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "telemetry_ring.hpp"
+#include "time_state_change.hpp"
+#include "xyz/openbmc_project/Time/Internal/Telemetry/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <sys/timex.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class TelemetryRecorder
+ *  @brief Record the clock telemetry for drift analysis.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.Telemetry DBus API.
+ *  The host offset, the kernel frequency correction and estimated error,
+ *  and the number of BMC time jumps are sampled periodically into a
+ *  telemetry::Ring, which is written in pages, and at most a few hours
+ *  after its last write.
+ */
+class TelemetryRecorder : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::Telemetry >
+{
+    public:
+        friend class TestTelemetryRecorder;
+
+        using Adjtimex = std::function<int(struct timex*)>;
+
+        /** @brief Constructor
+         *
+         * @param[in] bus - The Dbus bus object
+         * @param[in] objPath - The object path
+         * @param[in] file - The file of the ring, or nullptr to open it
+         *                   later by open()
+         * @param[in] pages - The number of pages in the ring
+         * @param[in] interval - The interval of the samples in seconds
+         * @param[in] adjtimex - The function to read the kernel clock,
+         *                       adjtimex() by default
+         */
+        TelemetryRecorder(sdbusplus::bus::bus& bus,
+                          const char* objPath,
+                          const char* file,
+                          size_t pages,
+                          uint64_t interval,
+                          Adjtimex adjtimex = ::adjtimex);
+        TelemetryRecorder(const TelemetryRecorder&) = delete;
+        TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+        TelemetryRecorder(TelemetryRecorder&&) = delete;
+        TelemetryRecorder& operator=(TelemetryRecorder&&) = delete;
+
+        /** @brief Destructor - write the unwritten samples */
+        ~TelemetryRecorder();
+
+        /** @brief Open the file of the ring
+         *  @details On a live restart it is opened once the running
+         *  process has written its last page, so that the two do not write
+         *  the same page.
+         *
+         * @param[in] file - The file of the ring
+         */
+        void open(const char* file)
+        {
+            ring.open(file);
+        }
+
+        /** @brief Write the unwritten samples */
+        void flush()
+        {
+            ring.flush();
+        }
+
+        /** @brief Read the recorded samples in pages
+         *
+         * @param[in] start - The sequence of the page to read from
+         *
+         * @return The pages, and the sequence of the page to read next
+         */
+        std::tuple<std::vector<uint8_t>, uint32_t>
+            read(uint32_t start) override;
+
+        /** @brief Notified on time state changed, it tracks the host
+         *  offset and counts the BMC time jumps
+         *
+         * @param[in] change - The changed time state
+         */
+        void onTimeStateChanged(const TimeStateChange& change);
+
+        /** @brief The max number of pages to read in one call */
+        static constexpr size_t maxReadPages = 16;
+
+    private:
+        /** @brief Persistent sdbusplus DBus connection */
+        sdbusplus::bus::bus& bus;
+
+        /** @brief The ring of the samples */
+        telemetry::Ring ring;
+
+        /** @brief The function to read the kernel clock */
+        Adjtimex adjtimex;
+
+        /** @brief The current host offset */
+        std::chrono::microseconds offset{0};
+
+        /** @brief The number of the BMC time jumps since the start */
+        int64_t jumps = 0;
+
+        /** @brief The steady time the ring is written at */
+        std::chrono::steady_clock::time_point written;
+
+        /** @brief Take a sample into the ring */
+        void sample();
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The timer of the samples */
+        SdEventSource sampleTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief The callback function of the sample timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - The time the timer expires at
+         * @param[in] userdata - User data pointer
+         */
+        static int onSampleTimer(sd_event_source* es, uint64_t usec,
+                                 void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,279 @@
+#include "telemetry_ring.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace // anonymous
+{
+/** @brief The magic of a page, "TMTL" */
+constexpr uint32_t MAGIC = 0x4c544d54;
+
+/** @brief The max encoded size of a sample, 5 fields of 10 bytes */
+constexpr size_t MAX_SAMPLE_SIZE = 50;
+
+void putLe(uint8_t* p, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t getLe(const uint8_t* p, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+/** @brief Encode a signed delta as a zigzag varint
+ *
+ * @return The end of the encoded bytes
+ */
+uint8_t* putDelta(uint8_t* p, int64_t delta)
+{
+    auto v = (static_cast<uint64_t>(delta) << 1) ^
+             static_cast<uint64_t>(delta >> 63);
+    while (v >= 0x80)
+    {
+        *p++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+/** @brief Decode a zigzag varint
+ *
+ * @return The end of the decoded bytes, or nullptr if it is truncated
+ */
+const uint8_t* getDelta(const uint8_t* p, const uint8_t* end, int64_t& delta)
+{
+    uint64_t v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7)
+    {
+        auto b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            delta = static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace anonymous
+
+namespace phosphor
+{
+namespace time
+{
+namespace telemetry
+{
+
+using namespace phosphor::logging;
+
+Ring::Ring(size_t pages)
+    : pages(std::max<size_t>(pages, 1)),
+      page(pageSize)
+{
+}
+
+Ring::Ring(const char* file, size_t pages)
+    : Ring(pages)
+{
+    open(file);
+}
+
+void Ring::open(const char* file)
+{
+    if (fd >= 0)
+    {
+        return;
+    }
+    fd = ::open(file, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to open the telemetry file",
+                        entry("FILE=%s", file),
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+
+    // Continue after the newest page
+    uint8_t header[headerSize];
+    for (size_t i = 0; i < pages; ++i)
+    {
+        if (pread(fd, header, sizeof(header), i * pageSize) !=
+                sizeof(header) ||
+            getLe(header, 4) != MAGIC)
+        {
+            continue;
+        }
+        auto sequence = static_cast<uint32_t>(getLe(header + 4, 4));
+        current = std::max(current, sequence + 1);
+    }
+}
+
+Ring::~Ring()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+void Ring::append(const Sample& sample)
+{
+    uint8_t buf[MAX_SAMPLE_SIZE];
+    auto encode = [&buf, &sample](const Sample& prev)
+    {
+        auto p = putDelta(buf, sample.time - prev.time);
+        p = putDelta(p, sample.offset - prev.offset);
+        p = putDelta(p, sample.frequency - prev.frequency);
+        p = putDelta(p, sample.error - prev.error);
+        p = putDelta(p, sample.jumps - prev.jumps);
+        return static_cast<uint16_t>(p - buf);
+    };
+
+    auto size = encode(count == 0 ? Sample{} : last);
+    if (headerSize + used + size > pageSize)
+    {
+        write();
+        ++current;
+        count = 0;
+        used = 0;
+        size = encode(Sample{});
+    }
+    std::memcpy(page.data() + headerSize + used, buf, size);
+    used += size;
+    ++count;
+    last = sample;
+    dirty = true;
+}
+
+void Ring::flush()
+{
+    if (dirty)
+    {
+        write();
+    }
+}
+
+void Ring::write()
+{
+    dirty = false;
+    if (fd < 0)
+    {
+        return;
+    }
+    putLe(page.data(), MAGIC, 4);
+    putLe(page.data() + 4, current, 4);
+    putLe(page.data() + 8, count, 2);
+    putLe(page.data() + 10, used, 2);
+    std::fill(page.begin() + headerSize + used, page.end(), 0);
+    if (pwrite(fd, page.data(), pageSize, slotOf(current)) !=
+        static_cast<ssize_t>(pageSize))
+    {
+        log<level::ERR>("Failed to write the telemetry page",
+                        entry("ERRNO=%d", errno));
+    }
+}
+
+std::vector<uint8_t> Ring::read(uint32_t start, size_t maxPages,
+                                uint32_t& next) const
+{
+    std::vector<uint8_t> data;
+    uint32_t oldest = current > pages ?
+                      static_cast<uint32_t>(current - pages + 1) : 1;
+    auto sequence = std::max(start, oldest);
+    std::vector<uint8_t> buf(pageSize);
+    for (; sequence < current && maxPages != 0; ++sequence)
+    {
+        if (fd < 0 ||
+            pread(fd, buf.data(), pageSize, slotOf(sequence)) !=
+                static_cast<ssize_t>(pageSize) ||
+            getLe(buf.data(), 4) != MAGIC ||
+            getLe(buf.data() + 4, 4) != sequence)
+        {
+            // Not written, e.g. lost on a power loss
+            continue;
+        }
+        auto size = headerSize + std::min<size_t>(getLe(buf.data() + 10, 2),
+                                                  pageSize - headerSize);
+        data.insert(data.end(), buf.begin(), buf.begin() + size);
+        --maxPages;
+    }
+    if (sequence == current && maxPages != 0)
+    {
+        if (count != 0)
+        {
+            uint8_t header[headerSize];
+            putLe(header, MAGIC, 4);
+            putLe(header + 4, current, 4);
+            putLe(header + 8, count, 2);
+            putLe(header + 10, used, 2);
+            data.insert(data.end(), header, header + headerSize);
+            data.insert(data.end(), page.begin() + headerSize,
+                        page.begin() + headerSize + used);
+        }
+        ++sequence;
+    }
+    next = sequence;
+    return data;
+}
+
+bool decode(const std::vector<uint8_t>& data, std::vector<Sample>& samples)
+{
+    auto p = data.data();
+    auto end = p + data.size();
+    while (p < end)
+    {
+        if (end - p < static_cast<ptrdiff_t>(headerSize) ||
+            getLe(p, 4) != MAGIC)
+        {
+            return false;
+        }
+        auto count = getLe(p + 8, 2);
+        auto used = getLe(p + 10, 2);
+        p += headerSize;
+        if (static_cast<uint64_t>(end - p) < used)
+        {
+            return false;
+        }
+        auto pageEnd = p + used;
+        Sample sample;
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            int64_t* fields[] = {&sample.time, &sample.offset,
+                                 &sample.frequency, &sample.error,
+                                 &sample.jumps};
+            for (auto field : fields)
+            {
+                int64_t delta;
+                p = getDelta(p, pageEnd, delta);
+                if (!p)
+                {
+                    return false;
+                }
+                *field += delta;
+            }
+            samples.push_back(sample);
+        }
+        p = pageEnd;
+    }
+    return true;
+}
+
+} // namespace telemetry
+} // namespace time
+} // namespace phosphor
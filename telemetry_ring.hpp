@@ -0,0 +1,161 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace telemetry
+{
+
+/** @struct Sample
+ *  @brief A sample of the clock telemetry.
+ */
+struct Sample
+{
+    /** @brief The BMC time in seconds since UTC */
+    int64_t time = 0;
+
+    /** @brief The diff between host and BMC time in microseconds */
+    int64_t offset = 0;
+
+    /** @brief The kernel frequency correction, in ppm with 16 bit
+     *  fraction
+     */
+    int64_t frequency = 0;
+
+    /** @brief The kernel estimated error in microseconds */
+    int64_t error = 0;
+
+    /** @brief The number of the BMC time jumps since the start */
+    int64_t jumps = 0;
+};
+
+/** @brief The size of a page, the unit of the writes to the flash */
+constexpr size_t pageSize = 4096;
+
+/** @brief The size of the header of a page
+ *  @details The header is the magic, the sequence, the number of samples,
+ *  and the used bytes after the header, all in little endian.
+ */
+constexpr size_t headerSize = 12;
+
+/** @class Ring
+ *  @brief A fixed-size ring of pages of samples in a file.
+ *  @details The samples in a page are encoded as the zigzag varint deltas
+ *  to the previous sample, and the first one to zeros, so that a page is
+ *  decoded without the others. The samples are collected in the current
+ *  page, which is written when it is full or flushed, to the slot of its
+ *  sequence, overwriting the oldest page.
+ */
+class Ring
+{
+    public:
+        /** @brief Constructor - the samples are kept in the current page
+         *  until the file is opened by open()
+         *
+         * @param[in] pages - The number of pages in the ring
+         */
+        explicit Ring(size_t pages);
+
+        /** @brief Constructor
+         *
+         * @param[in] file - The file of the ring
+         * @param[in] pages - The number of pages in the ring
+         */
+        Ring(const char* file, size_t pages);
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+        Ring(Ring&&) = delete;
+        Ring& operator=(Ring&&) = delete;
+        ~Ring();
+
+        /** @brief Append a sample to the current page, the page is written
+         *  if it is full
+         *
+         * @param[in] sample - The sample
+         */
+        void append(const Sample& sample);
+
+        /** @brief Open the file, and continue after its newest page
+         *
+         * @param[in] file - The file of the ring
+         */
+        void open(const char* file);
+
+        /** @brief Write the current page if it has unwritten samples */
+        void flush();
+
+        /** @brief Read the pages from a sequence, oldest first
+         *  @details A page is read as its header and used bytes. The
+         *  current page is read last, also if it is not written yet.
+         *
+         * @param[in] start - The sequence of the first page, the oldest
+         *                    one is read if it is older than that
+         * @param[in] maxPages - The max number of pages to read
+         * @param[out] next - The sequence to read next
+         *
+         * @return The pages
+         */
+        std::vector<uint8_t> read(uint32_t start, size_t maxPages,
+                                  uint32_t& next) const;
+
+        /** @brief Get the sequence of the current page */
+        uint32_t sequence() const
+        {
+            return current;
+        }
+
+    private:
+        /** @brief The fd of the file */
+        int fd = -1;
+
+        /** @brief The number of pages in the ring */
+        size_t pages;
+
+        /** @brief The sequence of the current page, from 1 */
+        uint32_t current = 1;
+
+        /** @brief The current page */
+        std::vector<uint8_t> page;
+
+        /** @brief The number of samples in the current page */
+        uint16_t count = 0;
+
+        /** @brief The used bytes of the current page after the header */
+        uint16_t used = 0;
+
+        /** @brief Indicate if the current page has unwritten samples */
+        bool dirty = false;
+
+        /** @brief The last sample in the current page */
+        Sample last;
+
+        /** @brief Write the current page to its slot */
+        void write();
+
+        /** @brief Get the offset of the slot of a sequence in the file */
+        off_t slotOf(uint32_t sequence) const
+        {
+            return static_cast<off_t>((sequence - 1) % pages) * pageSize;
+        }
+};
+
+/** @brief Decode the pages read from a ring
+ *
+ * @param[in] data - The pages
+ * @param[out] samples - The decoded samples, appended
+ *
+ * @return true if all the pages are valid
+ */
+bool decode(const std::vector<uint8_t>& data, std::vector<Sample>& samples);
+
+} // namespace telemetry
+} // namespace time
+} // namespace phosphor
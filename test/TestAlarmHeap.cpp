@@ -0,0 +1,163 @@
+#include "alarm_heap.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestAlarmHeap : public testing::Test
+{
+    public:
+        AlarmHeap alarms;
+
+        std::vector<AlarmHeap::Id> expired(const microseconds& now)
+        {
+            std::vector<AlarmHeap::Id> ids;
+            alarms.expire(
+                now,
+                [&ids](AlarmHeap::Id id,
+                       const std::string& /* client */,
+                       const microseconds& /* deadline */)
+                {
+                    ids.push_back(id);
+                });
+            return ids;
+        }
+};
+
+TEST_F(TestAlarmHeap, empty)
+{
+    EXPECT_EQ(0u, alarms.size());
+    EXPECT_TRUE(expired(microseconds::max()).empty());
+}
+
+TEST_F(TestAlarmHeap, expireInOrder)
+{
+    auto id3 = alarms.add(":1.1", 3s);
+    auto id1 = alarms.add(":1.2", 1s);
+    auto id2 = alarms.add(":1.1", 2s);
+    EXPECT_EQ(1s, alarms.next());
+
+    // An alarm fires at its deadline, not before
+    EXPECT_TRUE(expired(999ms).empty());
+    EXPECT_EQ(std::vector<AlarmHeap::Id>{id1}, expired(1s));
+    EXPECT_EQ(2s, alarms.next());
+    EXPECT_EQ((std::vector<AlarmHeap::Id>{id2, id3}), expired(1min));
+    EXPECT_EQ(0u, alarms.size());
+    EXPECT_EQ(0u, alarms.count(":1.1"));
+}
+
+TEST_F(TestAlarmHeap, insertHandedAlarms)
+{
+    // The alarms of the running process keep their ids
+    AlarmHeap running;
+    running.add(":1.1", 2s);
+    auto handed = running.add(":1.2", 1s);
+    running.remove(":1.2", running.add(":1.2", 3s));
+    running.forEach(
+        [this](AlarmHeap::Id id, const std::string& client,
+               const microseconds& deadline)
+        {
+            EXPECT_TRUE(alarms.insert(id, client, deadline));
+        });
+    alarms.setNextId(running.getNextId());
+    EXPECT_FALSE(alarms.insert(handed, ":1.3", 1s));
+    EXPECT_EQ(2u, alarms.size());
+    EXPECT_EQ(1u, alarms.count(":1.2"));
+    EXPECT_TRUE(alarms.remove(":1.2", handed));
+
+    // The id of the removed alarm is not given again
+    EXPECT_EQ(running.getNextId(), alarms.add(":1.3", 1s));
+}
+
+TEST_F(TestAlarmHeap, sameDeadline)
+{
+    auto id1 = alarms.add(":1.1", 1s);
+    auto id2 = alarms.add(":1.2", 1s);
+    auto id3 = alarms.add(":1.3", 1s);
+
+    // The alarms with the same deadline fire in the order of scheduling
+    EXPECT_EQ((std::vector<AlarmHeap::Id>{id1, id2, id3}), expired(1s));
+}
+
+TEST_F(TestAlarmHeap, remove)
+{
+    auto id1 = alarms.add(":1.1", 1s);
+    auto id2 = alarms.add(":1.1", 2s);
+
+    // Only the client of the alarm is able to remove it
+    EXPECT_FALSE(alarms.remove(":1.2", id1));
+    EXPECT_FALSE(alarms.remove(":1.1", 100));
+
+    EXPECT_TRUE(alarms.remove(":1.1", id1));
+    EXPECT_FALSE(alarms.remove(":1.1", id1));
+    EXPECT_EQ(1u, alarms.count(":1.1"));
+    EXPECT_EQ(2s, alarms.next());
+    EXPECT_EQ(std::vector<AlarmHeap::Id>{id2}, expired(1min));
+}
+
+TEST_F(TestAlarmHeap, removeClient)
+{
+    alarms.add(":1.1", 1s);
+    auto id2 = alarms.add(":1.2", 2s);
+    alarms.add(":1.1", 3s);
+    alarms.add(":1.1", 4s);
+
+    EXPECT_EQ(3u, alarms.removeClient(":1.1"));
+    EXPECT_EQ(0u, alarms.removeClient(":1.1"));
+    EXPECT_EQ(1u, alarms.size());
+    EXPECT_EQ(std::vector<AlarmHeap::Id>{id2}, expired(1min));
+}
+
+TEST_F(TestAlarmHeap, manyAlarms)
+{
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int64_t> dist(0, 1000000);
+    std::vector<microseconds> deadlines;
+    std::vector<AlarmHeap::Id> ids;
+    for (int i = 0; i < 1000; ++i)
+    {
+        deadlines.emplace_back(dist(gen));
+        ids.push_back(alarms.add(":1." + std::to_string(i % 10),
+                                 deadlines.back()));
+    }
+
+    // Cancel every third alarm
+    std::vector<microseconds> remaining;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        if (i % 3 == 0)
+        {
+            EXPECT_TRUE(alarms.remove(":1." + std::to_string(i % 10),
+                                      ids[i]));
+        }
+        else
+        {
+            remaining.push_back(deadlines[i]);
+        }
+    }
+    std::sort(remaining.begin(), remaining.end());
+
+    std::vector<microseconds> fired;
+    alarms.expire(microseconds::max(),
+                  [&fired](AlarmHeap::Id /* id */,
+                           const std::string& /* client */,
+                           const microseconds& deadline)
+                  {
+                      fired.push_back(deadline);
+                  });
+    EXPECT_EQ(remaining, fired);
+}
+
+} // namespace time
+} // namespace phosphor
@@ -1,11 +1,14 @@
 #include <sdbusplus/bus.hpp>
 #include <gtest/gtest.h>
+#include <xyz/openbmc_project/Time/error.hpp>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "bmc_epoch.hpp"
 #include "config.h"
 #include "types.hpp"
-#include "mocked_bmc_time_change_listener.hpp"
+#include "mocked_time_state_listener.hpp"
 
 namespace phosphor
 {
@@ -14,14 +17,16 @@ namespace time
 
 using ::testing::_;
 using namespace std::chrono;
+using NotAllowed = sdbusplus::xyz::openbmc_project::Time::Error::NotAllowed;
 
 class TestBmcEpoch : public testing::Test
 {
     public:
         sdbusplus::bus::bus bus;
         sd_event* event;
-        MockBmcTimeChangeListener listener;
+        MockTimeStateListener listener;
         std::unique_ptr<BmcEpoch> bmcEpoch;
+        TimeStateDispatcher::Subscription subscription;
 
         TestBmcEpoch()
             : bus(sdbusplus::bus::new_default())
@@ -30,7 +35,7 @@ class TestBmcEpoch : public testing::Test
             sd_event_default(&event);
             bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
             bmcEpoch = std::make_unique<BmcEpoch>(bus, OBJPATH_BMC);
-            bmcEpoch->setBmcTimeChangeListener(&listener);
+            subscription = bmcEpoch->subscribe(listener.handler());
         }
 
         ~TestBmcEpoch()
@@ -57,6 +62,20 @@ class TestBmcEpoch : public testing::Test
             bmcEpoch->timeMode = mode;
         }
         void triggerTimeChange()
+        {
+            // Make it as if BMC time stepped 10 seconds forward
+            bmcEpoch->diffToSteadyClock -= seconds(10);
+            bmcEpoch->checkTimeJump();
+        }
+        bool checkTimeJump()
+        {
+            return bmcEpoch->checkTimeJump();
+        }
+        void setElapsed(uint64_t value, std::function<void(bool)> done)
+        {
+            bmcEpoch->setElapsed(value, microseconds(0), std::move(done));
+        }
+        void triggerWakeup()
         {
             bmcEpoch->onTimeChange(nullptr,
                                    -1,
@@ -88,8 +107,12 @@ TEST_F(TestBmcEpoch, setElapsedNotAllowed)
     // In Host owner, setting time is not allowed
     setTimeMode(Mode::Manual);
     setTimeOwner(Owner::Host);
-    auto ret = bmcEpoch->elapsed(epochNow);
-    EXPECT_EQ(0, ret);
+    EXPECT_THROW(bmcEpoch->elapsed(epochNow), NotAllowed);
+
+    // In NTP mode, setting time is not allowed
+    setTimeMode(Mode::NTP);
+    setTimeOwner(Owner::BMC);
+    EXPECT_THROW(bmcEpoch->elapsed(epochNow), NotAllowed);
 }
 
 TEST_F(TestBmcEpoch, setElapsedOK)
@@ -99,10 +122,61 @@ TEST_F(TestBmcEpoch, setElapsedOK)
     // But for now we can not test it
 }
 
+TEST_F(TestBmcEpoch, setElapsedDoneWhenSet)
+{
+    std::vector<microseconds> writes;
+    SetTimePipeline pipeline([&writes](const microseconds& time)
+                             {
+                                 writes.push_back(time);
+                                 return true;
+                             });
+    bmcEpoch->usePipeline(pipeline);
+    std::vector<bool> results;
+    auto done = [&results](bool ok)
+    {
+        results.push_back(ok);
+    };
+
+    // The set is done when its time is set, not when it is submitted
+    setElapsed(1000, done);
+    EXPECT_EQ(1u, writes.size());
+    EXPECT_TRUE(results.empty());
+    pipeline.complete(true);
+    EXPECT_EQ(std::vector<bool>{true}, results);
+
+    // A failure is reported to each set of the write, including the one
+    // that is replaced by a later set
+    results.clear();
+    setElapsed(2000, done);
+    setElapsed(3000, done);
+    setElapsed(4000, done);
+    pipeline.complete(true);
+    EXPECT_EQ(std::vector<bool>{true}, results);
+    pipeline.complete(false);
+    EXPECT_EQ((std::vector<bool>{true, false, false}), results);
+    EXPECT_EQ(3u, writes.size());
+}
+
 TEST_F(TestBmcEpoch, onTimeChange)
 {
-    // On BMC time change, the listner is expected to be notified
-    EXPECT_CALL(listener, onBmcTimeChanged(_)).Times(1);
+    // On BMC time change, the subscriber is expected to be notified
+    EXPECT_CALL(listener, onTimeStateChanged(BmcTimeJumped())).Times(1);
+    triggerTimeChange();
+}
+
+TEST_F(TestBmcEpoch, onTimeChangeWithoutJump)
+{
+    // A wakeup without BMC time change is not notified
+    EXPECT_CALL(listener, onTimeStateChanged(_)).Times(0);
+    triggerWakeup();
+    EXPECT_FALSE(checkTimeJump());
+}
+
+TEST_F(TestBmcEpoch, onTimeChangeUnsubscribed)
+{
+    // Once the subscription is reset, the subscriber is not notified
+    subscription.reset();
+    EXPECT_CALL(listener, onTimeStateChanged(_)).Times(0);
     triggerTimeChange();
 }
 
@@ -0,0 +1,219 @@
+#include <sdbusplus/bus.hpp>
+#include <gtest/gtest.h>
+
+#include "circuit_breaker.hpp"
+#include "config.h"
+
+#include <memory>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using State = CircuitBreaker::State;
+
+class TestCircuitBreaker : public testing::Test
+{
+    public:
+        sdbusplus::bus::bus bus;
+        sd_event* event;
+        std::unique_ptr<CircuitBreaker> breaker;
+
+        /** @brief The fake steady time */
+        microseconds steady{0};
+
+        /** @brief The number of started probes */
+        int probes = 0;
+
+        /** @brief The result of a probe on start */
+        bool probeOk = true;
+
+        TestCircuitBreaker()
+            : bus(sdbusplus::bus::new_default())
+        {
+            // CircuitBreaker requires sd_event to schedule the probes
+            sd_event_default(&event);
+            bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+            breaker = std::make_unique<CircuitBreaker>(
+                bus, OBJPATH_TIME,
+                [this]()
+                {
+                    ++probes;
+                    return probeOk;
+                },
+                [this]()
+                {
+                    return steady;
+                });
+        }
+
+        ~TestCircuitBreaker()
+        {
+            breaker.reset();
+            bus.detach_event();
+            sd_event_unref(event);
+        }
+
+        void fail(unsigned times)
+        {
+            for (unsigned i = 0; i < times; ++i)
+            {
+                ASSERT_TRUE(breaker->allow());
+                breaker->record(false, breaker->timeout() * 1us);
+            }
+        }
+
+        // Proxies for CircuitBreaker's private members and functions
+        void onProbeTimer()
+        {
+            CircuitBreaker::onProbeTimer(nullptr, 0, breaker.get());
+        }
+};
+
+TEST_F(TestCircuitBreaker, adaptiveTimeout)
+{
+    EXPECT_EQ(State::Closed, breaker->state());
+    EXPECT_EQ(microseconds(CircuitBreaker::initialTimeout).count(),
+              breaker->timeout());
+
+    // Fast replies go down to the min timeout
+    for (int i = 0; i < 10; ++i)
+    {
+        breaker->record(true, 10ms);
+    }
+    EXPECT_EQ(microseconds(CircuitBreaker::minTimeout).count(),
+              breaker->timeout());
+
+    // Slow replies raise it, by the variation as well
+    breaker->record(true, 2s);
+    EXPECT_GT(breaker->timeout(), microseconds(2s).count());
+    EXPECT_LE(breaker->timeout(),
+              microseconds(CircuitBreaker::maxTimeout).count());
+}
+
+TEST_F(TestCircuitBreaker, backOff)
+{
+    breaker->record(true, 10ms);
+    auto timeout = breaker->timeout();
+    breaker->record(false, 1s);
+    EXPECT_EQ(timeout * 2, breaker->timeout());
+
+    // Up to the max timeout
+    for (int i = 0; i < 10; ++i)
+    {
+        breaker->record(false, 1s);
+    }
+    EXPECT_EQ(microseconds(CircuitBreaker::maxTimeout).count(),
+              breaker->timeout());
+}
+
+TEST_F(TestCircuitBreaker, tripAndFailFast)
+{
+    fail(CircuitBreaker::failureThreshold - 1);
+    EXPECT_EQ(State::Closed, breaker->state());
+
+    // A reply resets the failures in a row
+    breaker->record(true, 10ms);
+    fail(CircuitBreaker::failureThreshold - 1);
+    EXPECT_EQ(State::Closed, breaker->state());
+
+    fail(1);
+    EXPECT_EQ(State::Open, breaker->state());
+    EXPECT_EQ(1u, breaker->trips());
+
+    EXPECT_FALSE(breaker->allow());
+    EXPECT_FALSE(breaker->allow());
+    EXPECT_EQ(2u, breaker->rejected());
+    EXPECT_EQ(0, probes);
+}
+
+TEST_F(TestCircuitBreaker, probeCloses)
+{
+    fail(CircuitBreaker::failureThreshold);
+    onProbeTimer();
+    EXPECT_EQ(1, probes);
+    EXPECT_EQ(State::HalfOpen, breaker->state());
+
+    // Only the probe is in flight
+    EXPECT_FALSE(breaker->allow());
+
+    breaker->recordProbe(true, 20ms);
+    EXPECT_EQ(State::Closed, breaker->state());
+    EXPECT_TRUE(breaker->allow());
+    EXPECT_EQ(1u, breaker->trips());
+}
+
+TEST_F(TestCircuitBreaker, probeResetsBackOff)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        breaker->record(true, 2s);
+    }
+    auto estimated = breaker->timeout();
+    fail(CircuitBreaker::failureThreshold);
+    EXPECT_GT(breaker->timeout(), estimated);
+
+    // The reply of the probe undoes the back off, but its fast reply does
+    // not lower the timeout below the estimate of the calls
+    onProbeTimer();
+    breaker->recordProbe(true, 1ms);
+    EXPECT_EQ(State::Closed, breaker->state());
+    EXPECT_EQ(estimated, breaker->timeout());
+
+    // A probe that gets no reply does not back it off
+    fail(CircuitBreaker::failureThreshold);
+    auto timeout = breaker->timeout();
+    onProbeTimer();
+    breaker->recordProbe(false, 25s);
+    EXPECT_EQ(State::Open, breaker->state());
+    EXPECT_EQ(timeout, breaker->timeout());
+}
+
+TEST_F(TestCircuitBreaker, probeResetsToInitial)
+{
+    // No reply is observed, the back off is undone to the initial timeout
+    fail(CircuitBreaker::failureThreshold);
+    EXPECT_GT(breaker->timeout(),
+              microseconds(CircuitBreaker::initialTimeout).count());
+    onProbeTimer();
+    breaker->recordProbe(true, 20ms);
+    EXPECT_EQ(microseconds(CircuitBreaker::initialTimeout).count(),
+              breaker->timeout());
+}
+
+TEST_F(TestCircuitBreaker, probeFails)
+{
+    fail(CircuitBreaker::failureThreshold);
+    onProbeTimer();
+    breaker->recordProbe(false, 25s);
+    EXPECT_EQ(State::Open, breaker->state());
+
+    // Not a new trip, the next probe is scheduled
+    EXPECT_EQ(1u, breaker->trips());
+    probeOk = false;
+    onProbeTimer();
+    EXPECT_EQ(2, probes);
+    EXPECT_EQ(State::Open, breaker->state());
+}
+
+TEST_F(TestCircuitBreaker, replied)
+{
+    EXPECT_TRUE(CircuitBreaker::replied(0, nullptr));
+    EXPECT_FALSE(CircuitBreaker::replied(-ENOTCONN, nullptr));
+
+    // A method error is a reply
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_error_set(&error, SD_BUS_ERROR_ACCESS_DENIED, "Denied");
+    EXPECT_TRUE(CircuitBreaker::replied(-EACCES, &error));
+    sd_bus_error_free(&error);
+
+    sd_bus_error_set(&error, SD_BUS_ERROR_NO_REPLY, "No reply");
+    EXPECT_FALSE(CircuitBreaker::replied(-ETIMEDOUT, &error));
+    sd_bus_error_free(&error);
+}
+
+} // namespace time
+} // namespace phosphor
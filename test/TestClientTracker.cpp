@@ -0,0 +1,132 @@
+#include "client_tracker.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+class TestClientTracker : public testing::Test
+{
+    public:
+        sdbusplus::bus::bus bus;
+        sd_event* event;
+        std::unique_ptr<ClientTracker> tracker;
+        std::vector<std::string> goneA;
+        std::vector<std::string> goneB;
+        ClientTracker::User userA;
+        ClientTracker::User userB;
+
+        TestClientTracker()
+            : bus(sdbusplus::bus::new_default())
+        {
+            sd_event_default(&event);
+            bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+            tracker = std::make_unique<ClientTracker>(bus);
+            userA = tracker->addUser(
+                [this](const std::string& client)
+                {
+                    goneA.push_back(client);
+                });
+            userB = tracker->addUser(
+                [this](const std::string& client)
+                {
+                    goneB.push_back(client);
+                });
+        }
+
+        ~TestClientTracker()
+        {
+            tracker.reset();
+            bus.detach_event();
+            sd_event_unref(event);
+        }
+
+        /** @brief Connect a client to the bus
+         *
+         * @param[out] name - The unique name of the client
+         *
+         * @return The connection of the client
+         */
+        sd_bus* connect(std::string& name)
+        {
+            sd_bus* client = nullptr;
+            EXPECT_GE(sd_bus_open_system(&client), 0);
+            const char* unique = nullptr;
+            EXPECT_GE(sd_bus_get_unique_name(client, &unique), 0);
+            name = unique ? unique : "";
+            return client;
+        }
+
+        /** @brief Run the event loop until the function returns true */
+        template <typename Func>
+        void runUntil(Func&& done)
+        {
+            for (int i = 0; i < 50 && !done(); ++i)
+            {
+                sd_event_run(event, 100000);
+            }
+        }
+};
+
+TEST_F(TestClientTracker, leaveCallsItsUsers)
+{
+    std::string name;
+    auto client = connect(name);
+    std::string other;
+    auto otherClient = connect(other);
+    tracker->add(userA, name);
+    tracker->add(userB, name);
+    tracker->add(userA, other);
+    EXPECT_EQ(2u, tracker->size());
+
+    // The untracked user is not called
+    sd_bus_flush_close_unref(otherClient);
+    runUntil([this]() { return !goneA.empty(); });
+    EXPECT_EQ(std::vector<std::string>{other}, goneA);
+    EXPECT_TRUE(goneB.empty());
+    EXPECT_EQ(1u, tracker->size());
+
+    goneA.clear();
+    sd_bus_flush_close_unref(client);
+    runUntil([this]() { return !goneA.empty() && !goneB.empty(); });
+    EXPECT_EQ(std::vector<std::string>{name}, goneA);
+    EXPECT_EQ(std::vector<std::string>{name}, goneB);
+    EXPECT_EQ(0u, tracker->size());
+}
+
+TEST_F(TestClientTracker, removeForOneUser)
+{
+    std::string name;
+    auto client = connect(name);
+    tracker->add(userA, name);
+    tracker->add(userB, name);
+    tracker->remove(userA, name);
+    EXPECT_EQ(1u, tracker->size());
+
+    sd_bus_flush_close_unref(client);
+    runUntil([this]() { return !goneB.empty(); });
+    EXPECT_TRUE(goneA.empty());
+    EXPECT_EQ(std::vector<std::string>{name}, goneB);
+
+    tracker->add(userA, "x");
+    tracker->remove(userA, "x");
+    EXPECT_EQ(0u, tracker->size());
+}
+
+TEST_F(TestClientTracker, leftBeforeTracked)
+{
+    // The client is already gone, NameHasOwner finds it
+    tracker->add(userA, ":1.999999");
+    runUntil([this]() { return !goneA.empty(); });
+    EXPECT_EQ(std::vector<std::string>{":1.999999"}, goneA);
+    EXPECT_EQ(0u, tracker->size());
+}
+
+} // namespace time
+} // namespace phosphor
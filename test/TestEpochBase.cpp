@@ -2,18 +2,40 @@
 #include <gtest/gtest.h>
 
 #include "types.hpp"
+#include "bmc_epoch.hpp"
+#include "config.h"
 #include "epoch_base.hpp"
+#include "host_epoch.hpp"
+#include "utils.hpp"
 
 namespace phosphor
 {
 namespace time
 {
 
+/** @brief An epoch that completes the Elapsed sets without setting them */
+class NullEpoch : public EpochBase
+{
+    public:
+        using EpochBase::EpochBase;
+
+    protected:
+        void setElapsed(uint64_t /* value */,
+                        const std::chrono::microseconds& /* received */,
+                        SetDone done) override
+        {
+            if (done)
+            {
+                done(true);
+            }
+        }
+};
+
 class TestEpochBase : public testing::Test
 {
     public:
         sdbusplus::bus::bus bus;
-        EpochBase epochBase;
+        NullEpoch epochBase;
 
         TestEpochBase()
             : bus(sdbusplus::bus::new_default()),
@@ -56,5 +78,48 @@ TEST_F(TestEpochBase, onOwnerChange)
     EXPECT_EQ(Owner::Both, getOwner());
 }
 
+TEST_F(TestEpochBase, clockRead)
+{
+    // Precise by default
+    EXPECT_EQ(ClockRead::Precise, epochBase.getClockRead());
+
+    epochBase.setClockRead(ClockRead::Coarse);
+    EXPECT_EQ(ClockRead::Coarse, epochBase.getClockRead());
+
+    epochBase.setClockRead(ClockRead::Precise);
+    EXPECT_EQ(ClockRead::Precise, epochBase.getClockRead());
+}
+
+TEST_F(TestEpochBase, coarseElapsed)
+{
+    // BmcEpoch requires sd_event to init
+    sd_event* event = nullptr;
+    sd_event_default(&event);
+    bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+    {
+        BmcEpoch bmc(bus, OBJPATH_BMC);
+        HostEpoch host(bus, OBJPATH_HOST);
+        host.onOwnerChanged(Owner::BMC);
+        bmc.setClockRead(ClockRead::Coarse);
+        host.setClockRead(ClockRead::Coarse);
+
+        // A coarse read is the time of the last tick, it is between the
+        // ticks before and after it, where a precise one is past the tick
+        for (int i = 0; i < 100; ++i)
+        {
+            auto before = utils::now(ClockRead::Coarse).count();
+            auto bmcTime = static_cast<int64_t>(bmc.elapsed());
+            auto hostTime = static_cast<int64_t>(host.elapsed());
+            auto after = utils::now(ClockRead::Coarse).count();
+            EXPECT_LE(before, bmcTime);
+            EXPECT_LE(bmcTime, after);
+            EXPECT_LE(before, hostTime);
+            EXPECT_LE(hostTime, after);
+        }
+    }
+    bus.detach_event();
+    sd_event_unref(event);
+}
+
 }
 }
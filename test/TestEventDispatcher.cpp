@@ -0,0 +1,120 @@
+#include "event_dispatcher.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using TestDispatcher = Dispatcher<int>;
+
+TEST(TestEventDispatcher, dispatchInOrder)
+{
+    TestDispatcher dispatcher;
+    std::vector<int> calls;
+
+    auto s1 = dispatcher.subscribe([&calls](int e){ calls.push_back(e); });
+    auto s2 = dispatcher.subscribe([&calls](int e){ calls.push_back(e * 10); });
+    EXPECT_EQ(2u, dispatcher.size());
+
+    dispatcher.dispatch(1);
+    EXPECT_EQ(std::vector<int>({1, 10}), calls);
+}
+
+TEST(TestEventDispatcher, unsubscribeOnDestruction)
+{
+    TestDispatcher dispatcher;
+    int count = 0;
+    {
+        auto s = dispatcher.subscribe([&count](int){ ++count; });
+        dispatcher.dispatch(0);
+        EXPECT_EQ(1, count);
+    }
+    EXPECT_TRUE(dispatcher.empty());
+
+    // The handler is not called after its subscription is gone
+    dispatcher.dispatch(0);
+    EXPECT_EQ(1, count);
+}
+
+TEST(TestEventDispatcher, moveSubscription)
+{
+    TestDispatcher dispatcher;
+    int count = 0;
+
+    TestDispatcher::Subscription s;
+    EXPECT_FALSE(s);
+    {
+        auto tmp = dispatcher.subscribe([&count](int){ ++count; });
+        s = std::move(tmp);
+    }
+    EXPECT_TRUE(s);
+    dispatcher.dispatch(0);
+    EXPECT_EQ(1, count);
+
+    s.reset();
+    EXPECT_FALSE(s);
+    dispatcher.dispatch(0);
+    EXPECT_EQ(1, count);
+}
+
+TEST(TestEventDispatcher, unsubscribeDuringDispatch)
+{
+    TestDispatcher dispatcher;
+    int count1 = 0;
+    int count2 = 0;
+    TestDispatcher::Subscription s1;
+    TestDispatcher::Subscription s2;
+
+    // The first handler unsubscribes itself and the second one
+    s1 = dispatcher.subscribe([&](int)
+    {
+        ++count1;
+        s1.reset();
+        s2.reset();
+    });
+    s2 = dispatcher.subscribe([&](int){ ++count2; });
+
+    dispatcher.dispatch(0);
+    EXPECT_EQ(1, count1);
+    EXPECT_EQ(0, count2);
+    EXPECT_TRUE(dispatcher.empty());
+}
+
+TEST(TestEventDispatcher, subscribeDuringDispatch)
+{
+    TestDispatcher dispatcher;
+    std::vector<TestDispatcher::Subscription> subscriptions;
+    int count = 0;
+
+    subscriptions.emplace_back(dispatcher.subscribe([&](int)
+    {
+        subscriptions.emplace_back(
+            dispatcher.subscribe([&count](int){ ++count; }));
+    }));
+
+    // The handler subscribed during dispatching gets the next event
+    dispatcher.dispatch(0);
+    EXPECT_EQ(0, count);
+    EXPECT_EQ(2u, dispatcher.size());
+    dispatcher.dispatch(0);
+    EXPECT_EQ(1, count);
+}
+
+TEST(TestEventDispatcher, subscriptionOutlivesDispatcher)
+{
+    auto dispatcher = std::make_unique<TestDispatcher>();
+    auto s = dispatcher->subscribe([](int){});
+    dispatcher.reset();
+
+    // Resetting the subscription of a destroyed dispatcher is safe
+    EXPECT_FALSE(s);
+    s.reset();
+}
+
+}
+}
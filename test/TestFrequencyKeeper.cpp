@@ -0,0 +1,157 @@
+#include <sdbusplus/bus.hpp>
+#include <gtest/gtest.h>
+
+#include "config.h"
+#include "frequency_keeper.hpp"
+#include "utils.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+class TestFrequencyKeeper : public testing::Test
+{
+    public:
+        sdbusplus::bus::bus bus;
+        sd_event* event;
+        std::string file;
+        std::unique_ptr<FrequencyKeeper> keeper;
+
+        /** @brief The fake kernel clock */
+        long kernelFreq = 0;
+        int kernelState = TIME_OK;
+        int kernelStatus = 0;
+        int sets = 0;
+
+        TestFrequencyKeeper()
+            : bus(sdbusplus::bus::new_default())
+        {
+            // FrequencyKeeper requires sd_event to schedule the checks
+            sd_event_default(&event);
+            bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+
+            char name[] = "/tmp/saved_frequencyXXXXXX";
+            auto fd = mkstemp(name);
+            close(fd);
+            file = name;
+        }
+
+        ~TestFrequencyKeeper()
+        {
+            keeper.reset();
+            unlink(file.c_str());
+            bus.detach_event();
+            sd_event_unref(event);
+        }
+
+        void create(long savedFreq)
+        {
+            utils::writeData(file.c_str(), savedFreq);
+            keeper = std::make_unique<FrequencyKeeper>(
+                bus, OBJPATH_TIME, file.c_str(),
+                [this](struct timex* tx)
+                {
+                    if (tx->modes & ADJ_FREQUENCY)
+                    {
+                        kernelFreq = tx->freq;
+                        ++sets;
+                    }
+                    tx->freq = kernelFreq;
+                    tx->status = kernelStatus;
+                    return kernelState;
+                });
+        }
+
+        void notifyMode(Mode mode)
+        {
+            TimeStateChange change;
+            change.changed = TimeStateChange::ModeChanged;
+            change.mode = mode;
+            keeper->onTimeStateChanged(change);
+        }
+
+        // Proxies for FrequencyKeeper's private members and functions
+        bool check()
+        {
+            return keeper->check();
+        }
+        long savedFrequency()
+        {
+            return utils::readData<long>(file.c_str());
+        }
+};
+
+TEST_F(TestFrequencyKeeper, restoreInNtp)
+{
+    create(1234567);
+    notifyMode(Mode::NTP);
+    EXPECT_EQ(1234567, kernelFreq);
+    EXPECT_EQ(1234567, keeper->restoredFrequency());
+
+    // Only on start
+    kernelFreq = 0;
+    notifyMode(Mode::Manual);
+    notifyMode(Mode::NTP);
+    EXPECT_EQ(1, sets);
+}
+
+TEST_F(TestFrequencyKeeper, noRestoreInManual)
+{
+    create(1234567);
+    notifyMode(Mode::Manual);
+    notifyMode(Mode::NTP);
+    EXPECT_EQ(0, sets);
+    EXPECT_EQ(0, keeper->restoredFrequency());
+}
+
+TEST_F(TestFrequencyKeeper, noRestoreIfCorrected)
+{
+    create(1234567);
+    kernelFreq = 100000;
+    notifyMode(Mode::NTP);
+    EXPECT_EQ(0, sets);
+    EXPECT_EQ(100000, kernelFreq);
+}
+
+TEST_F(TestFrequencyKeeper, noRestoreOutOfRange)
+{
+    create(FrequencyKeeper::maxFrequency + 1);
+    notifyMode(Mode::NTP);
+    EXPECT_EQ(0, sets);
+}
+
+TEST_F(TestFrequencyKeeper, saveWhenSynced)
+{
+    create(0);
+    notifyMode(Mode::NTP);
+
+    // Not saved until the clock is synchronized
+    kernelFreq = 3000000;
+    kernelState = TIME_ERROR;
+    kernelStatus = STA_UNSYNC;
+    EXPECT_FALSE(check());
+    EXPECT_EQ(0u, keeper->timeToSync());
+    EXPECT_EQ(0, savedFrequency());
+
+    kernelState = TIME_OK;
+    kernelStatus = 0;
+    EXPECT_TRUE(check());
+    EXPECT_NE(0u, keeper->timeToSync());
+    EXPECT_EQ(3000000, savedFrequency());
+
+    // A small change is not saved
+    kernelFreq = 3000100;
+    EXPECT_TRUE(check());
+    EXPECT_EQ(3000000, savedFrequency());
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,160 @@
+#include "handoff.hpp"
+#include "types.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono_literals;
+
+class TestHandoff : public testing::Test
+{
+    public:
+        HandoffState state;
+
+        TestHandoff()
+        {
+            state.mode = Mode::NTP;
+            state.owner = Owner::Split;
+            state.hostOn = true;
+            state.requestedMode =
+                "xyz.openbmc_project.Time.Synchronization.Method.Manual";
+            state.requestedOwner = "";
+            state.offset = -1min;
+            state.diffToSteadyClock = 1234567890s;
+            state.timeOwner = "/xyz/openbmc_project/time/owner";
+            state.timeSyncMethod = "/xyz/openbmc_project/time/sync_method";
+            state.hostState = "/xyz/openbmc_project/state/host0";
+            state.services[state.timeOwner] = "xyz.openbmc_project.Settings";
+            state.services[state.hostState] = "xyz.openbmc_project.State.Host";
+            state.clocks["guest0"] = 5s;
+            state.clocks["guest1"] = -1h;
+            state.alarms.push_back({3, ":1.10", 1500000000s});
+            state.alarms.push_back({7, ":1.11", 0s});
+            state.nextAlarmId = 9;
+            state.subscriptions.push_back({2, ":1.10", 1s});
+            state.nextSubscriptionId = 4;
+        }
+
+        void checkEqual(const HandoffState& s)
+        {
+            EXPECT_EQ(state.mode, s.mode);
+            EXPECT_EQ(state.owner, s.owner);
+            EXPECT_EQ(state.hostOn, s.hostOn);
+            EXPECT_EQ(state.requestedMode, s.requestedMode);
+            EXPECT_EQ(state.requestedOwner, s.requestedOwner);
+            EXPECT_EQ(state.offset, s.offset);
+            EXPECT_EQ(state.diffToSteadyClock, s.diffToSteadyClock);
+            EXPECT_EQ(state.timeOwner, s.timeOwner);
+            EXPECT_EQ(state.timeSyncMethod, s.timeSyncMethod);
+            EXPECT_EQ(state.hostState, s.hostState);
+            EXPECT_EQ(state.services, s.services);
+            EXPECT_EQ(state.clocks, s.clocks);
+            ASSERT_EQ(state.alarms.size(), s.alarms.size());
+            for (size_t i = 0; i < state.alarms.size(); ++i)
+            {
+                EXPECT_EQ(state.alarms[i].id, s.alarms[i].id);
+                EXPECT_EQ(state.alarms[i].client, s.alarms[i].client);
+                EXPECT_EQ(state.alarms[i].deadline, s.alarms[i].deadline);
+            }
+            EXPECT_EQ(state.nextAlarmId, s.nextAlarmId);
+            ASSERT_EQ(state.subscriptions.size(), s.subscriptions.size());
+            for (size_t i = 0; i < state.subscriptions.size(); ++i)
+            {
+                const auto& a = state.subscriptions[i];
+                const auto& b = s.subscriptions[i];
+                EXPECT_EQ(a.id, b.id);
+                EXPECT_EQ(a.client, b.client);
+                EXPECT_EQ(a.threshold, b.threshold);
+            }
+            EXPECT_EQ(state.nextSubscriptionId, s.nextSubscriptionId);
+        }
+};
+
+TEST_F(TestHandoff, encodeAndDecode)
+{
+    HandoffState decoded;
+    EXPECT_TRUE(handoff::decode(handoff::encode(state), decoded));
+    checkEqual(decoded);
+}
+
+TEST_F(TestHandoff, decodeInvalid)
+{
+    HandoffState decoded;
+    auto data = handoff::encode(state);
+
+    // Empty, truncated or extended data is invalid
+    EXPECT_FALSE(handoff::decode("", decoded));
+    EXPECT_FALSE(handoff::decode(data.substr(0, data.size() - 1), decoded));
+    EXPECT_FALSE(handoff::decode(data + "x", decoded));
+
+    // Wrong magic is invalid
+    auto wrong = data;
+    wrong[0] ^= 0xff;
+    EXPECT_FALSE(handoff::decode(wrong, decoded));
+}
+
+TEST_F(TestHandoff, sendAndReceive)
+{
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+
+    EXPECT_TRUE(handoff::sendState(fds[0], state));
+    HandoffState received;
+    EXPECT_TRUE(handoff::receiveState(fds[1], received));
+    checkEqual(received);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_F(TestHandoff, sendAndReceiveReplicationFd)
+{
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+    int pipeFds[2];
+    ASSERT_EQ(0, pipe(pipeFds));
+
+    // The receiver gets its own fd of the same file
+    state.replicationFd = pipeFds[1];
+    EXPECT_TRUE(handoff::sendState(fds[0], state));
+    HandoffState received;
+    EXPECT_TRUE(handoff::receiveState(fds[1], received));
+    checkEqual(received);
+    ASSERT_GE(received.replicationFd, 0);
+    EXPECT_NE(pipeFds[1], received.replicationFd);
+    EXPECT_EQ(1, write(received.replicationFd, "x", 1));
+    char c;
+    EXPECT_EQ(1, read(pipeFds[0], &c, 1));
+
+    close(received.replicationFd);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_F(TestHandoff, receiveWithoutRunningProcess)
+{
+    // There is no running process listening on the socket
+    HandoffClient client("path/to/socket-not-exist");
+    HandoffState received;
+    EXPECT_FALSE(client.receive(received));
+}
+
+TEST_F(TestHandoff, confirmWithoutRunningProcess)
+{
+    HandoffClient client("path/to/socket-not-exist");
+    HandoffState received;
+    EXPECT_FALSE(client.receive(received));
+    EXPECT_FALSE(client.confirm(received));
+}
+
+}
+}
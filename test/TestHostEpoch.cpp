@@ -1,11 +1,14 @@
 #include <sdbusplus/bus.hpp>
 #include <gtest/gtest.h>
+#include <xyz/openbmc_project/Time/error.hpp>
 
 #include "host_epoch.hpp"
 #include "utils.hpp"
 #include "config.h"
 #include "types.hpp"
 
+#include <vector>
+
 namespace phosphor
 {
 namespace time
@@ -13,6 +16,7 @@ namespace time
 
 using namespace std::chrono;
 using namespace std::chrono_literals;
+using NotAllowed = sdbusplus::xyz::openbmc_project::Time::Error::NotAllowed;
 
 const constexpr microseconds USEC_ZERO{0};
 
@@ -73,7 +77,9 @@ class TestHostEpoch : public testing::Test
             // Set time is not allowed,
             // so verify offset is still 0 after set time
             microseconds diff = 1min;
-            hostEpoch.elapsed(hostEpoch.elapsed() + diff.count());
+            EXPECT_THROW(
+                hostEpoch.elapsed(hostEpoch.elapsed() + diff.count()),
+                NotAllowed);
             EXPECT_EQ(0, getOffset().count());
             // TODO: when gmock is ready, check there is no call to timedatectl
         }
@@ -289,5 +295,28 @@ TEST_F(TestHostEpoch, clearOffsetOnOwnerChange)
     EXPECT_EQ(USEC_ZERO, getOffset());
 }
 
+TEST_F(TestHostEpoch, restoreNotifiesChangedOffset)
+{
+    std::vector<microseconds> offsets;
+    auto subscription = hostEpoch.subscribe(
+        [&offsets](const TimeStateChange& change)
+        {
+            offsets.push_back(change.offset);
+        });
+    ASSERT_EQ(1u, offsets.size());
+
+    HandoffState state;
+    state.offset = getOffset();
+    hostEpoch.restore(state);
+    EXPECT_EQ(1u, offsets.size());
+
+    // The final state of the previous process has a new offset
+    state.offset = getOffset() + 1min;
+    hostEpoch.restore(state);
+    ASSERT_EQ(2u, offsets.size());
+    EXPECT_EQ(state.offset, offsets.back());
+    EXPECT_EQ(state.offset, getOffset());
+}
+
 }
 }
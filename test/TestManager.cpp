@@ -3,7 +3,7 @@
 
 #include "types.hpp"
 #include "manager.hpp"
-#include "mocked_property_change_listener.hpp"
+#include "mocked_time_state_listener.hpp"
 
 using ::testing::_;
 
@@ -17,17 +17,19 @@ class TestManager : public testing::Test
     public:
         sdbusplus::bus::bus bus;
         Manager manager;
-        MockPropertyChangeListner listener1;
-        MockPropertyChangeListner listener2;
+        MockTimeStateListener listener1;
+        MockTimeStateListener listener2;
+        TimeStateDispatcher::Subscription subscription1;
+        TimeStateDispatcher::Subscription subscription2;
 
         TestManager()
             : bus(sdbusplus::bus::new_default()),
               manager(bus)
         {
-            // Add two mocked listeners so that we can test
-            // the behavior related to listeners
-            manager.addListener(&listener1);
-            manager.addListener(&listener2);
+            // Add two mocked subscribers so that we can test
+            // the behavior related to subscribers
+            subscription1 = manager.subscribe(listener1.handler());
+            subscription2 = manager.subscribe(listener2.handler());
         }
 
         // Proxies for Manager's private members and functions
@@ -60,6 +62,15 @@ class TestManager : public testing::Test
         {
             manager.onHostState(hostOn);
         }
+        bool notifySettingsAdded(const std::string& key,
+                                 const std::string& value)
+        {
+            return manager.applySettings({{key, value}});
+        }
+        bool notifyHostStateAdded(const std::string& state)
+        {
+            return manager.applyHostState({{"CurrentHostState", state}});
+        }
 };
 
 TEST_F(TestManager, DISABLED_empty)
@@ -84,14 +95,18 @@ TEST_F(TestManager, DISABLED_hostStateChange)
 
 TEST_F(TestManager, DISABLED_propertyChanged)
 {
-    // When host is off, property change will be notified to listeners
+    // When host is off, property change will be notified to subscribers
     EXPECT_FALSE(hostOn());
 
-    // Check mocked listeners shall receive notifications on property changed
-    EXPECT_CALL(listener1, onModeChanged(Mode::Manual)).Times(1);
-    EXPECT_CALL(listener1, onOwnerChanged(Owner::Host)).Times(1);
-    EXPECT_CALL(listener2, onModeChanged(Mode::Manual)).Times(1);
-    EXPECT_CALL(listener2, onOwnerChanged(Owner::Host)).Times(1);
+    // Check mocked subscribers shall receive notifications on property changed
+    EXPECT_CALL(listener1, onTimeStateChanged(ModeChangedTo(Mode::Manual)))
+        .Times(1);
+    EXPECT_CALL(listener1, onTimeStateChanged(OwnerChangedTo(Owner::Host)))
+        .Times(1);
+    EXPECT_CALL(listener2, onTimeStateChanged(ModeChangedTo(Mode::Manual)))
+        .Times(1);
+    EXPECT_CALL(listener2, onTimeStateChanged(OwnerChangedTo(Owner::Host)))
+        .Times(1);
 
     notifyPropertyChanged(
         "TimeSyncMethod",
@@ -106,11 +121,9 @@ TEST_F(TestManager, DISABLED_propertyChanged)
     // When host is on, property changes are saved as requested ones
     notifyOnHostState(true);
 
-    // Check mocked listeners shall not receive notifications
-    EXPECT_CALL(listener1, onModeChanged(Mode::Manual)).Times(0);
-    EXPECT_CALL(listener1, onOwnerChanged(Owner::Host)).Times(0);
-    EXPECT_CALL(listener2, onModeChanged(Mode::Manual)).Times(0);
-    EXPECT_CALL(listener2, onOwnerChanged(Owner::Host)).Times(0);
+    // Check mocked subscribers shall not receive notifications
+    EXPECT_CALL(listener1, onTimeStateChanged(_)).Times(0);
+    EXPECT_CALL(listener2, onTimeStateChanged(_)).Times(0);
 
     notifyPropertyChanged(
         "TimeSyncMethod",
@@ -126,11 +139,13 @@ TEST_F(TestManager, DISABLED_propertyChanged)
 
 
     // When host becomes off, the requested mode/owner shall be notified
-    // to listeners, and be cleared
-    EXPECT_CALL(listener1, onModeChanged(Mode::NTP)).Times(1);
-    EXPECT_CALL(listener1, onOwnerChanged(Owner::Split)).Times(1);
-    EXPECT_CALL(listener2, onModeChanged(Mode::NTP)).Times(1);
-    EXPECT_CALL(listener2, onOwnerChanged(Owner::Split)).Times(1);
+    // to subscribers in one event, and be cleared
+    EXPECT_CALL(listener1, onTimeStateChanged(
+                    ModeAndOwnerChangedTo(Mode::NTP, Owner::Split)))
+        .Times(1);
+    EXPECT_CALL(listener2, onTimeStateChanged(
+                    ModeAndOwnerChangedTo(Mode::NTP, Owner::Split)))
+        .Times(1);
 
     notifyOnHostState(false);
 
@@ -156,11 +171,9 @@ TEST_F(TestManager, DISABLED_propertyChangedAndChangedbackWhenHostOn)
     // Set host on
     notifyOnHostState(true);
 
-    // Check mocked listeners shall not receive notifications
-    EXPECT_CALL(listener1, onModeChanged(_)).Times(0);
-    EXPECT_CALL(listener1, onOwnerChanged(_)).Times(0);
-    EXPECT_CALL(listener2, onModeChanged(_)).Times(0);
-    EXPECT_CALL(listener2, onOwnerChanged(_)).Times(0);
+    // Check mocked subscribers shall not receive notifications
+    EXPECT_CALL(listener1, onTimeStateChanged(_)).Times(0);
+    EXPECT_CALL(listener2, onTimeStateChanged(_)).Times(0);
 
     notifyPropertyChanged(
         "TimeSyncMethod",
@@ -190,12 +203,10 @@ TEST_F(TestManager, DISABLED_propertyChangedAndChangedbackWhenHostOn)
               getRequestedOwner());
 
     // Because the latest mode/owner is the same as when host is off,
-    // The listeners shall not be notified, and requested mode/owner
+    // The subscribers shall not be notified, and requested mode/owner
     // shall be cleared
-    EXPECT_CALL(listener1, onModeChanged(_)).Times(0);
-    EXPECT_CALL(listener1, onOwnerChanged(_)).Times(0);
-    EXPECT_CALL(listener2, onModeChanged(_)).Times(0);
-    EXPECT_CALL(listener2, onOwnerChanged(_)).Times(0);
+    EXPECT_CALL(listener1, onTimeStateChanged(_)).Times(0);
+    EXPECT_CALL(listener2, onTimeStateChanged(_)).Times(0);
 
     notifyOnHostState(false);
 
@@ -206,5 +217,35 @@ TEST_F(TestManager, DISABLED_propertyChangedAndChangedbackWhenHostOn)
 // TODO: if gmock is ready, add case to test
 // updateNtpSetting() and updateNetworkSetting()
 
+TEST_F(TestManager, DISABLED_objectsAddedAgain)
+{
+    // The properties of the objects added by a restarted service are
+    // applied as the changed ones
+    EXPECT_CALL(listener1, onTimeStateChanged(OwnerChangedTo(Owner::Split)))
+        .Times(1);
+    EXPECT_CALL(listener2, onTimeStateChanged(OwnerChangedTo(Owner::Split)))
+        .Times(1);
+    EXPECT_TRUE(notifySettingsAdded(
+        "TimeOwner",
+        "xyz.openbmc_project.Time.Owner.Owners.Split"));
+
+    // The same value is not applied again
+    EXPECT_FALSE(notifySettingsAdded(
+        "TimeOwner",
+        "xyz.openbmc_project.Time.Owner.Owners.Split"));
+
+    // The host state is applied, and the settings are deferred
+    EXPECT_TRUE(notifyHostStateAdded(
+        "xyz.openbmc_project.State.Host.HostState.Running"));
+    EXPECT_TRUE(hostOn());
+    EXPECT_FALSE(notifyHostStateAdded(
+        "xyz.openbmc_project.State.Host.HostState.Running"));
+    EXPECT_TRUE(notifySettingsAdded(
+        "TimeOwner",
+        "xyz.openbmc_project.Time.Owner.Owners.Host"));
+    EXPECT_EQ("xyz.openbmc_project.Time.Owner.Owners.Host",
+              getRequestedOwner());
+}
+
 }
 }
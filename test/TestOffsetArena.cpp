@@ -0,0 +1,73 @@
+#include "offset_arena.hpp"
+
+#include <gtest/gtest.h>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+TEST(TestOffsetArena, allocate)
+{
+    OffsetArena arena;
+    auto s1 = arena.allocate();
+    auto s2 = arena.allocate();
+    EXPECT_NE(s1, s2);
+    EXPECT_EQ(2u, arena.size());
+    EXPECT_EQ(0us, arena.get(s1));
+
+    arena.set(s1, 1min);
+    arena.set(s2, -1s);
+    EXPECT_EQ(1min, arena.get(s1));
+    EXPECT_EQ(-1s, arena.get(s2));
+}
+
+TEST(TestOffsetArena, reuseReleasedSlot)
+{
+    OffsetArena arena;
+    auto s1 = arena.allocate();
+    arena.set(s1, 1min);
+    arena.release(s1);
+    EXPECT_EQ(0u, arena.size());
+
+    // The reused slot starts with zero offset
+    auto s2 = arena.allocate();
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(0us, arena.get(s2));
+}
+
+TEST(TestOffsetArena, shift)
+{
+    OffsetArena arena;
+    auto s1 = arena.allocate();
+    auto s2 = arena.allocate();
+    arena.set(s1, 1min);
+
+    // BMC time steps forward 10s, the offsets are reduced by 10s
+    arena.shift(-10s);
+    EXPECT_EQ(50s, arena.get(s1));
+    EXPECT_EQ(-10s, arena.get(s2));
+
+    // A slot allocated after the shift starts with zero offset
+    auto s3 = arena.allocate();
+    EXPECT_EQ(0us, arena.get(s3));
+
+    arena.set(s2, 1s);
+    EXPECT_EQ(1s, arena.get(s2));
+}
+
+TEST(TestOffsetArena, clear)
+{
+    OffsetArena arena;
+    auto s1 = arena.allocate();
+    arena.set(s1, 1min);
+    arena.shift(1s);
+    arena.clear();
+    EXPECT_EQ(0us, arena.get(s1));
+}
+
+}
+}
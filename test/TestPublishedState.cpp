@@ -0,0 +1,98 @@
+#include "published_state.hpp"
+#include "types.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+TEST(TestPublishedState, empty)
+{
+    PublishedState state;
+    auto value = state.load();
+
+    // Default mode/owner is MANUAL/BOTH
+    EXPECT_EQ(Mode::Manual, value.mode);
+    EXPECT_EQ(Owner::Both, value.owner);
+    EXPECT_EQ(0us, value.offset);
+}
+
+TEST(TestPublishedState, publishChangedPartsOnly)
+{
+    PublishedState state;
+    TimeStateChange change;
+    change.changed = TimeStateChange::ModeChanged |
+                     TimeStateChange::OwnerChanged;
+    change.mode = Mode::NTP;
+    change.owner = Owner::Split;
+    change.offset = 1min;
+    state.publish(change);
+
+    // The offset is not changed
+    auto value = state.load();
+    EXPECT_EQ(Mode::NTP, value.mode);
+    EXPECT_EQ(Owner::Split, value.owner);
+    EXPECT_EQ(0us, value.offset);
+
+    change.changed = TimeStateChange::OffsetChanged;
+    change.mode = Mode::Manual;
+    change.owner = Owner::BMC;
+    state.publish(change);
+
+    // Only the offset is changed
+    value = state.load();
+    EXPECT_EQ(Mode::NTP, value.mode);
+    EXPECT_EQ(Owner::Split, value.owner);
+    EXPECT_EQ(1min, value.offset);
+}
+
+TEST(TestPublishedState, hostTime)
+{
+    PublishedState::Value value{Mode::Manual, Owner::Split, 1min};
+    EXPECT_EQ(microseconds(2min), value.hostTime(1min));
+
+    // The offset only applies in SPLIT
+    value.owner = Owner::Both;
+    EXPECT_EQ(microseconds(1min), value.hostTime(1min));
+}
+
+TEST(TestPublishedState, consistentLoad)
+{
+    PublishedState state;
+    std::atomic<bool> done{false};
+
+    // The reader shall never see a SPLIT owner with a non SPLIT offset,
+    // or the reverse
+    std::thread reader([&state, &done]()
+    {
+        while (!done)
+        {
+            auto value = state.load();
+            EXPECT_EQ(value.owner == Owner::Split, value.offset == 1min);
+        }
+    });
+
+    TimeStateChange change;
+    change.changed = TimeStateChange::OwnerChanged |
+                     TimeStateChange::OffsetChanged;
+    for (int i = 0; i < 100000; ++i)
+    {
+        bool split = (i % 2 == 0);
+        change.owner = split ? Owner::Split : Owner::Both;
+        change.offset = split ? microseconds(1min) : 0us;
+        state.publish(change);
+    }
+    done = true;
+    reader.join();
+}
+
+}
+}
@@ -0,0 +1,216 @@
+#include <sdbusplus/bus.hpp>
+#include <gtest/gtest.h>
+
+#include "bmc_epoch.hpp"
+#include "config.h"
+#include "host_epoch.hpp"
+#include "published_state.hpp"
+#include "query_server.hpp"
+#include "types.hpp"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestQueryServer : public testing::Test
+{
+    public:
+        sdbusplus::bus::bus bus;
+        sd_event* event;
+        std::unique_ptr<BmcEpoch> bmc;
+        std::unique_ptr<HostEpoch> host;
+        PublishedState state;
+        char dir[32] = "/tmp/queryXXXXXX";
+        std::string socketPath;
+        std::unique_ptr<QueryServer> server;
+
+        TestQueryServer()
+            : bus(sdbusplus::bus::new_default())
+        {
+            // BmcEpoch requires sd_event to init
+            sd_event_default(&event);
+            bus.attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+            bmc = std::make_unique<BmcEpoch>(bus, OBJPATH_BMC);
+            host = std::make_unique<HostEpoch>(bus, OBJPATH_HOST);
+
+            mkdtemp(dir);
+            socketPath = std::string(dir) + "/query.sock";
+            server = std::make_unique<QueryServer>(
+                event, socketPath.c_str(), *bmc, *host, state);
+        }
+
+        ~TestQueryServer()
+        {
+            server.reset();
+            host.reset();
+            bmc.reset();
+            bus.detach_event();
+            sd_event_unref(event);
+            rmdir(dir);
+        }
+
+        query::Response handle(query::Op op,
+                               uint16_t version = query::PROTOCOL_VERSION)
+        {
+            query::Request request{version, op, 0, 42};
+            return server->handle(&request, sizeof(request));
+        }
+
+        /** @brief Run the event loop until nothing is pending, the bus is
+         *  attached to it too
+         */
+        void runUntilIdle()
+        {
+            sd_event_run(event, 1000000);
+            while (sd_event_run(event, 0) > 0)
+            {
+            }
+        }
+};
+
+TEST_F(TestQueryServer, handleInvalid)
+{
+    query::Request request{query::PROTOCOL_VERSION, query::Op::GetBmcTime, 0, 42};
+    auto response = server->handle(&request, sizeof(request) - 1);
+    EXPECT_EQ(-EBADMSG, response.status);
+
+    response = handle(query::Op::GetBmcTime, query::PROTOCOL_VERSION + 1);
+    EXPECT_EQ(-EPROTONOSUPPORT, response.status);
+    EXPECT_EQ(42u, response.id);
+
+    response = handle(static_cast<query::Op>(0));
+    EXPECT_EQ(-EOPNOTSUPP, response.status);
+    EXPECT_EQ(42u, response.id);
+}
+
+TEST_F(TestQueryServer, handle)
+{
+    auto before = duration_cast<microseconds>(
+        system_clock::now().time_since_epoch());
+    auto response = handle(query::Op::GetBmcTime);
+    EXPECT_EQ(0, response.status);
+    EXPECT_EQ(query::Op::GetBmcTime, response.op);
+    EXPECT_EQ(42u, response.id);
+    EXPECT_GE(response.bmcTime, static_cast<uint64_t>(before.count()));
+
+    response = handle(query::Op::GetHostTime);
+    EXPECT_EQ(0, response.status);
+    EXPECT_GE(response.hostTime, static_cast<uint64_t>(before.count()));
+
+    TimeStateChange change;
+    change.changed = TimeStateChange::OwnerChanged |
+                     TimeStateChange::OffsetChanged;
+    change.owner = Owner::Split;
+    change.offset = 1h;
+    state.publish(change);
+    response = handle(query::Op::Snapshot);
+    EXPECT_EQ(0, response.status);
+    EXPECT_EQ(static_cast<uint8_t>(Owner::Split), response.owner);
+    EXPECT_EQ(duration_cast<microseconds>(1h).count(), response.offset);
+    EXPECT_EQ(response.bmcTime + duration_cast<microseconds>(1h).count(),
+              response.hostTime);
+}
+
+TEST_F(TestQueryServer, query)
+{
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath.c_str());
+    ASSERT_EQ(0, connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                         sizeof(addr)));
+
+    // Two requests queued are both served
+    query::Request request{query::PROTOCOL_VERSION, query::Op::GetBmcTime,
+                           0, 1};
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(request)),
+              send(fd, &request, sizeof(request), 0));
+    request.id = 2;
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(request)),
+              send(fd, &request, sizeof(request), 0));
+    runUntilIdle();
+
+    query::Response response;
+    for (uint64_t id = 1; id <= 2; ++id)
+    {
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(response)),
+                  recv(fd, &response, sizeof(response), MSG_DONTWAIT));
+        EXPECT_EQ(0, response.status);
+        EXPECT_EQ(id, response.id);
+        EXPECT_NE(0u, response.bmcTime);
+    }
+    close(fd);
+}
+
+TEST_F(TestQueryServer, capRequestsPerWakeup)
+{
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath.c_str());
+    ASSERT_EQ(0, connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                         sizeof(addr)));
+    runUntilIdle();
+
+    constexpr auto queued = QueryServer::maxRequestsPerWakeup + 4;
+    query::Request request{query::PROTOCOL_VERSION, query::Op::GetBmcTime,
+                           0, 0};
+    for (size_t i = 0; i < queued; ++i)
+    {
+        request.id = i;
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(request)),
+                  send(fd, &request, sizeof(request), 0));
+    }
+
+    // One wakeup serves up to the cap, the next one serves the rest
+    auto drain = [fd]()
+    {
+        size_t count = 0;
+        query::Response response;
+        while (recv(fd, &response, sizeof(response), MSG_DONTWAIT) ==
+               static_cast<ssize_t>(sizeof(response)))
+        {
+            ++count;
+        }
+        return count;
+    };
+    sd_event_run(event, 1000000);
+    EXPECT_EQ(QueryServer::maxRequestsPerWakeup, drain());
+    sd_event_run(event, 1000000);
+    EXPECT_EQ(queued - QueryServer::maxRequestsPerWakeup, drain());
+    close(fd);
+}
+
+TEST_F(TestQueryServer, keepSocketOfNewServer)
+{
+    // The new process binds the path before the running one exits
+    auto newServer = std::make_unique<QueryServer>(
+        event, socketPath.c_str(), *bmc, *host, state);
+    struct stat before;
+    ASSERT_EQ(0, stat(socketPath.c_str(), &before));
+    server.reset();
+    struct stat after;
+    ASSERT_EQ(0, stat(socketPath.c_str(), &after));
+    EXPECT_EQ(before.st_ino, after.st_ino);
+
+    // Its own socket is unlinked
+    newServer.reset();
+    EXPECT_NE(0, access(socketPath.c_str(), F_OK));
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,320 @@
+#include "replication.hpp"
+#include "types.hpp"
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono_literals;
+using replication::Delta;
+
+namespace // anonymous
+{
+
+Delta makeDelta(uint64_t seq, uint8_t changed)
+{
+    Delta delta;
+    delta.seq = seq;
+    delta.changed = changed;
+    delta.mode = Mode::NTP;
+    delta.owner = Owner::Split;
+    delta.offset = -90s;
+    delta.anchor = 1500000000s;
+    return delta;
+}
+
+} // namespace anonymous
+
+TEST(TestReplication, encodeAndDecode)
+{
+    std::vector<Delta> deltas = {
+        makeDelta(1, TimeStateChange::ModeChanged),
+        makeDelta(2, TimeStateChange::OffsetChanged),
+        makeDelta(300, replication::ReplicatedBits | replication::Snapshot),
+    };
+    std::string data;
+    replication::encode(deltas, data);
+    replication::encode({makeDelta(301, TimeStateChange::OwnerChanged)},
+                        data);
+
+    // Feed byte by byte, as a stream may split the frames anywhere
+    replication::FrameReader reader;
+    std::vector<Delta> decoded;
+    std::vector<Delta> frame;
+    for (auto c : data)
+    {
+        reader.feed(&c, 1);
+        int r;
+        while ((r = reader.next(frame)) > 0)
+        {
+            decoded.insert(decoded.end(), frame.begin(), frame.end());
+        }
+        ASSERT_EQ(0, r);
+    }
+
+    ASSERT_EQ(4u, decoded.size());
+    EXPECT_EQ(1u, decoded[0].seq);
+    EXPECT_EQ(TimeStateChange::ModeChanged, decoded[0].changed);
+    EXPECT_EQ(Mode::NTP, decoded[0].mode);
+    EXPECT_EQ(2u, decoded[1].seq);
+    EXPECT_EQ(-90s, decoded[1].offset);
+    EXPECT_EQ(1500000000s, decoded[1].anchor);
+    EXPECT_EQ(300u, decoded[2].seq);
+    EXPECT_EQ(Owner::Split, decoded[2].owner);
+    EXPECT_EQ(-90s, decoded[2].offset);
+    EXPECT_EQ(301u, decoded[3].seq);
+    EXPECT_EQ(Owner::Split, decoded[3].owner);
+}
+
+TEST(TestReplication, decodeInvalid)
+{
+    std::vector<Delta> frame;
+
+    // Unknown changed bits
+    replication::FrameReader reader;
+    std::string data;
+    replication::encode({makeDelta(1, TimeStateChange::BmcTimeJumped)},
+                        data);
+    reader.feed(data.data(), data.size());
+    EXPECT_EQ(-1, reader.next(frame));
+
+    // Invalid owner
+    replication::FrameReader reader2;
+    std::string bad = {3, 1, TimeStateChange::OwnerChanged, 9};
+    reader2.feed(bad.data(), bad.size());
+    EXPECT_EQ(-1, reader2.next(frame));
+
+    // Too large frame
+    replication::FrameReader reader3;
+    std::string large = {'\xff', '\xff', '\x7f'};
+    reader3.feed(large.data(), large.size());
+    EXPECT_EQ(-1, reader3.next(frame));
+}
+
+TEST(TestReplication, applyOnce)
+{
+    ReplicaState state;
+    auto delta = makeDelta(1, TimeStateChange::OwnerChanged);
+    EXPECT_EQ(TimeStateChange::OwnerChanged, state.apply(delta));
+    EXPECT_EQ(Owner::Split, state.owner);
+
+    // The same or an older delta is ignored
+    delta.owner = Owner::BMC;
+    EXPECT_EQ(0, state.apply(delta));
+    EXPECT_EQ(Owner::Split, state.owner);
+
+    // A newer delta without any real change
+    auto same = makeDelta(2, TimeStateChange::OwnerChanged);
+    EXPECT_EQ(0, state.apply(same));
+    EXPECT_EQ(2u, state.seq);
+
+    // A snapshot is applied even with a lower sequence number
+    auto snapshot = makeDelta(0, replication::ReplicatedBits |
+                                 replication::Snapshot);
+    snapshot.owner = Owner::Host;
+    EXPECT_EQ(TimeStateChange::ModeChanged |
+              TimeStateChange::OwnerChanged |
+              TimeStateChange::OffsetChanged,
+              state.apply(snapshot));
+    EXPECT_EQ(0u, state.seq);
+    EXPECT_EQ(Owner::Host, state.owner);
+    EXPECT_EQ(-90s, state.offset);
+}
+
+TEST(TestReplication, localOffset)
+{
+    ReplicaState state;
+    state.offset = -90s;
+    state.anchor = 1000s;
+
+    // Small skew is the delay of the replication
+    EXPECT_EQ(-90s, replication::localOffset(state, 1000s + 200ms));
+
+    // Large skew is the diff of BMC clocks
+    EXPECT_EQ(-100s, replication::localOffset(state, 1010s));
+    EXPECT_EQ(-80s, replication::localOffset(state, 990s));
+}
+
+TEST(TestReplication, sendAndReceive)
+{
+    char dir[] = "/tmp/replicationXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    auto socketPath = std::string(dir) + "/replication.sock";
+
+    sd_event* event = nullptr;
+    ASSERT_GE(sd_event_new(&event), 0);
+    {
+        ReplicationSender sender(event, socketPath.c_str());
+
+        // Changes before the standby connects are in the full state
+        TimeStateChange change;
+        change.changed = TimeStateChange::ModeChanged |
+                         TimeStateChange::OwnerChanged;
+        change.mode = Mode::NTP;
+        change.owner = Owner::Split;
+        sender.onTimeStateChanged(change);
+
+        ReplicaState received;
+        int calls = 0;
+        ReplicationReceiver receiver(
+            event, socketPath.c_str(),
+            [&](const ReplicaState& state, uint8_t)
+            {
+                received = state;
+                ++calls;
+            });
+        for (int i = 0; i < 10 && calls == 0; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(1, calls);
+        EXPECT_EQ(Mode::NTP, received.mode);
+        EXPECT_EQ(Owner::Split, received.owner);
+
+        // Changes in one loop iteration are applied together
+        change.changed = TimeStateChange::OffsetChanged;
+        change.offset = 1h;
+        sender.onTimeStateChanged(change);
+        change.offset = 2h;
+        sender.onTimeStateChanged(change);
+        for (int i = 0; i < 10 && calls == 1; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(2, calls);
+        EXPECT_EQ(2h, received.offset);
+        EXPECT_EQ(3u, received.seq);
+    }
+    sd_event_unref(event);
+    rmdir(dir);
+}
+
+TEST(TestReplication, handOverListenFd)
+{
+    char dir[] = "/tmp/replicationXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    auto socketPath = std::string(dir) + "/replication.sock";
+
+    sd_event* event = nullptr;
+    ASSERT_GE(sd_event_new(&event), 0);
+    {
+        // The new process takes the socket while the running one listens,
+        // and the socket stays when the running one exits
+        auto running = std::make_unique<ReplicationSender>(
+            event, socketPath.c_str());
+        ASSERT_GE(running->getListenFd(), 0);
+        ReplicationSender sender(event, socketPath.c_str(),
+                                 dup(running->getListenFd()));
+        running.reset();
+        EXPECT_EQ(0, access(socketPath.c_str(), F_OK));
+
+        TimeStateChange change;
+        change.changed = TimeStateChange::OffsetChanged;
+        change.offset = 1h;
+        sender.onTimeStateChanged(change);
+
+        ReplicaState received;
+        int calls = 0;
+        ReplicationReceiver receiver(
+            event, socketPath.c_str(),
+            [&](const ReplicaState& state, uint8_t)
+            {
+                received = state;
+                ++calls;
+            });
+        for (int i = 0; i < 10 && calls == 0; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(1, calls);
+        EXPECT_EQ(1h, received.offset);
+    }
+    sd_event_unref(event);
+    unlink(socketPath.c_str());
+    rmdir(dir);
+}
+
+TEST(TestReplication, parseAddress)
+{
+    replication::Address address;
+    EXPECT_TRUE(replication::parseAddress("/run/replication.sock", address));
+    EXPECT_EQ(AF_UNIX, address.family());
+    EXPECT_EQ("/run/replication.sock", address.path);
+    EXPECT_TRUE(replication::parseAddress("unix:/run/r.sock", address));
+    EXPECT_EQ("/run/r.sock", address.path);
+
+    EXPECT_TRUE(replication::parseAddress("tcp:192.168.10.1:4660", address));
+    EXPECT_EQ(AF_INET, address.family());
+    EXPECT_TRUE(address.path.empty());
+    auto& in = reinterpret_cast<sockaddr_in&>(address.storage);
+    EXPECT_EQ(4660, ntohs(in.sin_port));
+
+    EXPECT_TRUE(replication::parseAddress("tcp:[fe80::1]:4660", address));
+    EXPECT_EQ(AF_INET6, address.family());
+
+    // Listen on all the addresses
+    EXPECT_TRUE(replication::parseAddress("tcp::4660", address));
+
+    // No port, names are not resolved, and an empty path is invalid
+    EXPECT_FALSE(replication::parseAddress("tcp:192.168.10.1", address));
+    EXPECT_FALSE(replication::parseAddress("tcp:192.168.10.1:", address));
+    EXPECT_FALSE(replication::parseAddress("tcp:bmc1:4660", address));
+    EXPECT_FALSE(replication::parseAddress("unix:", address));
+}
+
+TEST(TestReplication, sendAndReceiveOverTcp)
+{
+    // Find a free port on the loopback
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(probe, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(addr);
+    ASSERT_EQ(0, bind(probe, reinterpret_cast<sockaddr*>(&addr), size));
+    ASSERT_EQ(0, getsockname(probe, reinterpret_cast<sockaddr*>(&addr),
+                             &size));
+    close(probe);
+    auto address = "tcp:127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+
+    sd_event* event = nullptr;
+    ASSERT_GE(sd_event_new(&event), 0);
+    {
+        ReplicationSender sender(event, address.c_str());
+        TimeStateChange change;
+        change.changed = TimeStateChange::OffsetChanged;
+        change.offset = 1h;
+        sender.onTimeStateChanged(change);
+
+        ReplicaState received;
+        int calls = 0;
+        ReplicationReceiver receiver(
+            event, address.c_str(),
+            [&](const ReplicaState& state, uint8_t)
+            {
+                received = state;
+                ++calls;
+            });
+        for (int i = 0; i < 10 && calls == 0; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(1, calls);
+        EXPECT_EQ(1h, received.offset);
+    }
+    sd_event_unref(event);
+}
+
+} // namespace time
+} // namespace phosphor
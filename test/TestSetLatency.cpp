@@ -0,0 +1,301 @@
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <gtest/gtest.h>
+
+#include "set_latency.hpp"
+#include "set_time_pipeline.hpp"
+#include "config.h"
+
+#include <cerrno>
+#include <vector>
+
+namespace // anonymous
+{
+
+/** @brief The receive timestamp of the messages, 0 for none */
+uint64_t messageStamp = 0;
+
+} // namespace anonymous
+
+/** @brief Stamp the received messages as a bus that supports it does, the
+ *  bus of the tests does not
+ */
+extern "C" int sd_bus_message_get_monotonic_usec(sd_bus_message* /* m */,
+                                                 uint64_t* usec)
+{
+    if (messageStamp == 0)
+    {
+        return -ENODATA;
+    }
+    *usec = messageStamp;
+    return 0;
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestSetLatency : public testing::Test
+{
+    public:
+        sdbusplus::bus::bus bus;
+
+        /** @brief The fake steady time */
+        microseconds steady = 1000s;
+
+        /** @brief The fake BMC time minus the steady time */
+        microseconds base = 1500000000s;
+
+        SetLatency latency;
+
+        TestSetLatency()
+            : bus(sdbusplus::bus::new_default()),
+              latency(bus, OBJPATH_TIME,
+                      [this]()
+                      {
+                          return steady;
+                      },
+                      [this]()
+                      {
+                          return steady + base;
+                      })
+        {
+            // Empty
+        }
+
+        /** @brief Set the fake BMC time as timedated does, after a delay
+         *
+         * @param[in] time - The time to set
+         * @param[in] delay - The delay of timedated to set it
+         */
+        void setTime(const microseconds& time, const microseconds& delay)
+        {
+            steady += delay;
+            base = time - steady;
+        }
+
+        /** @brief Set a time by SetTime, with the delays before the call,
+         *  of timedated to set it, and of the reply
+         */
+        void set(const microseconds& time, const microseconds& before,
+                 const microseconds& apply, const microseconds& reply)
+        {
+            auto received = latency.received();
+            steady += before;
+            setTime(latency.compensateSet(time, received), apply);
+            steady += reply;
+            latency.settle(time, received);
+        }
+
+        microseconds realtime() const
+        {
+            return steady + base;
+        }
+
+        /** @brief Call the function while a message sent to this
+         *  connection is being handled
+         */
+        template <typename Func>
+        void handleMessage(Func&& func)
+        {
+            bool handled = false;
+            auto handler = [&func, &handled](sdbusplus::message::message&)
+            {
+                func();
+                handled = true;
+            };
+            sdbusplus::bus::match::match match(
+                bus, "type='signal',interface='org.test.SetLatency'",
+                handler);
+            sd_bus_emit_signal(bus.get(), "/org/test", "org.test.SetLatency",
+                               "Ping", nullptr);
+            for (int i = 0; i < 50 && !handled; ++i)
+            {
+                if (sd_bus_process(bus.get(), nullptr) == 0)
+                {
+                    sd_bus_wait(bus.get(), 100000);
+                }
+            }
+            EXPECT_TRUE(handled);
+        }
+};
+
+TEST_F(TestSetLatency, received)
+{
+    // There is no message being handled, it is the steady time now
+    EXPECT_EQ(steady, latency.received());
+}
+
+TEST_F(TestSetLatency, receivedStamp)
+{
+    // The message is not stamped, it is the steady time now
+    microseconds received{0};
+    handleMessage([this, &received]()
+                  {
+                      received = latency.received();
+                  });
+    EXPECT_EQ(steady, received);
+
+    // The receive stamp of the message is taken
+    messageStamp = (steady - 3ms).count();
+    handleMessage([this, &received]()
+                  {
+                      received = latency.received();
+                  });
+    messageStamp = 0;
+    EXPECT_EQ(steady - 3ms, received);
+}
+
+TEST_F(TestSetLatency, onePropertiesChangedPerSet)
+{
+    size_t signals = 0;
+    sdbusplus::bus::match::match match(
+        bus,
+        "type='signal',member='PropertiesChanged',"
+        "arg0='xyz.openbmc_project.Time.Internal.SetLatency'",
+        [&signals](sdbusplus::message::message&)
+        {
+            ++signals;
+        });
+    auto process = [this]()
+    {
+        sd_bus_flush(bus.get());
+        for (int i = 0; i < 5; ++i)
+        {
+            while (sd_bus_process(bus.get(), nullptr) > 0)
+            {
+            }
+            sd_bus_wait(bus.get(), 20000);
+        }
+    };
+
+    // A set by SetTime changes all the properties, when it is settled
+    set(1h, 1ms, 2ms, 1ms);
+    process();
+    EXPECT_EQ(1u, signals);
+
+    // A failed one is published as it is abandoned
+    latency.compensateSet(2h, latency.received());
+    process();
+    EXPECT_EQ(1u, signals);
+    latency.abandon();
+    process();
+    EXPECT_EQ(2u, signals);
+
+    // An offset is compensated at once
+    latency.compensate(3h, steady - 1ms);
+    process();
+    EXPECT_EQ(3u, signals);
+}
+
+TEST_F(TestSetLatency, compensate)
+{
+    auto received = latency.received();
+    steady += 3ms;
+    EXPECT_EQ(1h + 3ms, latency.compensate(1h, received));
+    EXPECT_EQ(1u, latency.sets());
+    EXPECT_EQ(3000u, latency.lastDelay());
+
+    // A stamp later than now is not a negative delay
+    EXPECT_EQ(1h, latency.compensate(1h, steady + 1ms));
+    EXPECT_EQ(0u, latency.lastDelay());
+}
+
+TEST_F(TestSetLatency, learnApplyDelay)
+{
+    // The first set lags by the delay of timedated
+    set(1h, 2ms, 3ms, 5ms);
+    EXPECT_EQ(-3000, latency.lastResidual());
+    EXPECT_EQ(3000u, latency.maxResidual());
+    EXPECT_EQ(3000u, latency.applyDelay());
+    EXPECT_EQ(2000u, latency.lastDelay());
+
+    // The next one is advanced by it as well
+    auto received = steady;
+    set(2h, 2ms, 3ms, 5ms);
+    EXPECT_EQ(0, latency.lastResidual());
+    EXPECT_EQ(2h + (steady - received), realtime());
+    EXPECT_EQ(3000u, latency.applyDelay());
+
+    // A slower one moves the estimate towards it
+    set(3h, 2ms, 11ms, 5ms);
+    EXPECT_EQ(-8000, latency.lastResidual());
+    EXPECT_EQ(8000u, latency.maxResidual());
+    EXPECT_EQ(4000u, latency.applyDelay());
+    EXPECT_EQ(3u, latency.sets());
+}
+
+TEST_F(TestSetLatency, unboundedResidual)
+{
+    set(1h, 0ms, 3ms, 0ms);
+    EXPECT_EQ(3000u, latency.applyDelay());
+
+    // The time is set by others meanwhile, it is not a delay
+    auto received = latency.received();
+    setTime(latency.compensateSet(2h, received), 3ms);
+    base -= 1min;
+    latency.settle(2h, received);
+    EXPECT_EQ(duration_cast<microseconds>(-1min).count(),
+              latency.lastResidual());
+    EXPECT_EQ(3000u, latency.applyDelay());
+
+    base += 2min;
+    latency.settle(2h, received);
+    EXPECT_EQ(3000u, latency.applyDelay());
+    EXPECT_EQ(microseconds(1min).count(), latency.lastResidual());
+}
+
+TEST_F(TestSetLatency, pipeline)
+{
+    std::vector<microseconds> writes;
+    SetTimePipeline pipeline([&writes](const microseconds& time)
+                             {
+                                 writes.push_back(time);
+                                 return true;
+                             });
+    pipeline.useLatency(latency);
+
+    pipeline.submit(1h, nullptr);
+    steady += 1ms;
+    pipeline.submit(2h, nullptr);
+    setTime(writes.back(), 2ms);
+    pipeline.complete(true);
+    EXPECT_EQ(3000u, latency.applyDelay());
+
+    // The queued time is advanced by the time it waits, and the delay
+    // of timedated
+    ASSERT_EQ(2u, writes.size());
+    EXPECT_EQ(1h, writes[0]);
+    EXPECT_EQ(2h + 2ms + 3ms, writes[1]);
+
+    // The failed set is not measured
+    setTime(writes.back(), 20ms);
+    pipeline.complete(false);
+    EXPECT_EQ(3000u, latency.applyDelay());
+    EXPECT_EQ(2u, latency.sets());
+}
+
+TEST_F(TestSetLatency, pipelineSubmitReceived)
+{
+    std::vector<microseconds> writes;
+    SetTimePipeline pipeline([&writes](const microseconds& time)
+                             {
+                                 writes.push_back(time);
+                                 return true;
+                             });
+    pipeline.useLatency(latency);
+
+    // The time is stamped by the caller, e.g. by the filter of the set
+    // when it is received, not when it is submitted
+    pipeline.submit(1h, steady - 5ms, nullptr);
+    ASSERT_EQ(1u, writes.size());
+    EXPECT_EQ(1h + 5ms, writes[0]);
+    EXPECT_EQ(5000u, latency.lastDelay());
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,133 @@
+#include "set_time_pipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestSetTimePipeline : public testing::Test
+{
+    public:
+        /** @brief The times the writer is started with */
+        std::vector<microseconds> writes;
+
+        /** @brief The result of the writer on start */
+        bool startOk = true;
+
+        SetTimePipeline pipeline;
+
+        /** @brief The results of the callbacks, by the submitted time */
+        std::vector<std::pair<microseconds, std::pair<bool, microseconds>>>
+            results;
+
+        TestSetTimePipeline()
+            : pipeline([this](const microseconds& time)
+                       {
+                           writes.push_back(time);
+                           return startOk;
+                       })
+        {
+            // Empty
+        }
+
+        void submit(const microseconds& time)
+        {
+            pipeline.submit(time,
+                            [this, time](bool ok, const microseconds& set)
+                            {
+                                results.emplace_back(time,
+                                                     std::make_pair(ok, set));
+                            });
+        }
+};
+
+TEST_F(TestSetTimePipeline, oneWrite)
+{
+    submit(1s);
+    EXPECT_TRUE(pipeline.busy());
+    EXPECT_EQ(std::vector<microseconds>{1s}, writes);
+    EXPECT_TRUE(results.empty());
+
+    pipeline.complete(true);
+    EXPECT_FALSE(pipeline.busy());
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(std::make_pair(true, microseconds(1s)), results[0].second);
+    EXPECT_EQ(1u, pipeline.counters().writes);
+    EXPECT_EQ(0u, pipeline.counters().collapsed);
+}
+
+TEST_F(TestSetTimePipeline, lastWriterWins)
+{
+    submit(1s);
+    submit(2s);
+    submit(3s);
+    submit(4s);
+
+    // Only one write is in flight, the queued one is replaced
+    EXPECT_EQ(std::vector<microseconds>{1s}, writes);
+    EXPECT_EQ(4u, pipeline.counters().submitted);
+    EXPECT_EQ(2u, pipeline.counters().collapsed);
+
+    pipeline.complete(true);
+    EXPECT_EQ((std::vector<microseconds>{1s, 4s}), writes);
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(1s, results[0].first);
+
+    // The replaced callers complete with the final time
+    pipeline.complete(true);
+    EXPECT_FALSE(pipeline.busy());
+    ASSERT_EQ(4u, results.size());
+    for (size_t i = 1; i < results.size(); ++i)
+    {
+        EXPECT_EQ(std::make_pair(true, microseconds(4s)),
+                  results[i].second);
+    }
+    EXPECT_EQ(2s, results[1].first);
+    EXPECT_EQ(4s, results[3].first);
+    EXPECT_EQ(2u, pipeline.counters().writes);
+}
+
+TEST_F(TestSetTimePipeline, failure)
+{
+    submit(1s);
+    submit(2s);
+    pipeline.complete(false);
+    EXPECT_EQ(std::make_pair(false, microseconds(1s)), results[0].second);
+    EXPECT_EQ(1u, pipeline.counters().failures);
+
+    // The queued one is still written
+    EXPECT_TRUE(pipeline.busy());
+    pipeline.complete(true);
+    EXPECT_EQ(std::make_pair(true, microseconds(2s)), results[1].second);
+}
+
+TEST_F(TestSetTimePipeline, failToStart)
+{
+    startOk = false;
+    submit(1s);
+    EXPECT_FALSE(pipeline.busy());
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(std::make_pair(false, microseconds(1s)), results[0].second);
+    EXPECT_EQ(1u, pipeline.counters().failures);
+}
+
+TEST_F(TestSetTimePipeline, emptyCallback)
+{
+    pipeline.submit(1s, nullptr);
+    pipeline.submit(2s, nullptr);
+    pipeline.complete(true);
+    pipeline.complete(true);
+    EXPECT_FALSE(pipeline.busy());
+    EXPECT_EQ((std::vector<microseconds>{1s, 2s}), writes);
+}
+
+} // namespace time
+} // namespace phosphor
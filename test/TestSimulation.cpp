@@ -0,0 +1,533 @@
+#include <sdbusplus/bus.hpp>
+#include <gtest/gtest.h>
+#include <xyz/openbmc_project/Time/error.hpp>
+
+#include "bmc_epoch.hpp"
+#include "config.h"
+#include "host_epoch.hpp"
+#include "manager.hpp"
+#include "set_policy.hpp"
+#include "system_clock.hpp"
+#include "types.hpp"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using NotAllowed = sdbusplus::xyz::openbmc_project::Time::Error::NotAllowed;
+
+namespace
+{
+
+constexpr auto PROPERTY_TIME_MODE = "TimeSyncMethod";
+constexpr auto PROPERTY_TIME_OWNER = "TimeOwner";
+
+const char* const MODES[] = {
+    "xyz.openbmc_project.Time.Synchronization.Method.NTP",
+    "xyz.openbmc_project.Time.Synchronization.Method.Manual",
+};
+const Mode MODE_VALUES[] = {Mode::NTP, Mode::Manual};
+
+const char* const OWNERS[] = {
+    "xyz.openbmc_project.Time.Owner.Owners.BMC",
+    "xyz.openbmc_project.Time.Owner.Owners.Host",
+    "xyz.openbmc_project.Time.Owner.Owners.Split",
+    "xyz.openbmc_project.Time.Owner.Owners.Both",
+};
+const Owner OWNER_VALUES[] = {Owner::BMC, Owner::Host, Owner::Split,
+                              Owner::Both};
+
+/** @brief The min BMC time step that BmcEpoch notifies */
+constexpr microseconds STEP_TOLERANCE = 1ms;
+
+constexpr microseconds YEAR = duration_cast<microseconds>(hours(24 * 365));
+
+/** @brief The max step and set, small enough to keep the time positive
+ *  in long scenarios
+ */
+constexpr microseconds MONTH = duration_cast<microseconds>(hours(24 * 30));
+
+} // namespace
+
+/** @class FakeSystemClock
+ *  @brief The virtual clocks of a simulation, and timedated on them.
+ */
+class FakeSystemClock : public SystemClock
+{
+    public:
+        microseconds realtime() const override
+        {
+            return real;
+        }
+
+        microseconds steady() const override
+        {
+            return mono;
+        }
+
+        bool setTime(const microseconds& time) override
+        {
+            real = time;
+            onStep();
+            return true;
+        }
+
+        bool setNtp(bool enabled) override
+        {
+            ntp = enabled;
+            return true;
+        }
+
+        /** @brief Advance both clocks */
+        void advance(const microseconds& d)
+        {
+            real += d;
+            mono += d;
+        }
+
+        /** @brief Step the realtime clock, as if it is set by others */
+        void step(const microseconds& d)
+        {
+            real += d;
+            onStep();
+        }
+
+        /** @brief The virtual CLOCK_REALTIME, about the mid of 2017 */
+        microseconds real = 47 * YEAR;
+
+        /** @brief The virtual steady clock */
+        microseconds mono = 1000s;
+
+        /** @brief Indicate if NTP is enabled */
+        bool ntp = false;
+
+        /** @brief Called when the realtime clock is set, as the timerfd
+         *  that is canceled on set
+         */
+        std::function<void()> onStep;
+};
+
+/** @class Simulation
+ *  @brief Run Manager, BmcEpoch and HostEpoch on virtual clocks with
+ *  random events, and check them against a model after each event.
+ *  @details The objects are wired as in main. The events that the real
+ *  event loop delivers, i.e. the timerfd of BMC time changes, are queued
+ *  and delivered after each event.
+ */
+class Simulation
+{
+    public:
+        Simulation(sdbusplus::bus::bus& bus, uint32_t seed)
+            : random(seed)
+        {
+            clock.real += randomDuration(YEAR);
+            clock.onStep = [this]()
+            {
+                pending.push_back([this]()
+                                  {
+                                      bmc->checkTimeJump();
+                                  });
+            };
+
+            HandoffState state;
+            state.mode = MODE_VALUES[random() % 2];
+            state.owner = OWNER_VALUES[random() % 4];
+            settingMode = mode = state.mode;
+            settingOwner = owner = state.owner;
+            clock.ntp = (mode == Mode::NTP);
+
+            // The saved mode, owner and offset are kept apart from the
+            // ones of the real daemon, and of the other scenarios
+            char name[] = "/tmp/simulationXXXXXX";
+            if (!mkdtemp(name))
+            {
+                throw std::runtime_error("Failed to create the directory");
+            }
+            dir = name;
+
+            // The state is handed over, and the settings and host state
+            // are changed by the private calls below, rather than by the
+            // services in bench/fake_services: those are built only with
+            // --enable-bench, and a bus round trip per event would cut the
+            // scenarios run per second. The discovery and the signals are
+            // covered by TestManager and bench/service_restart
+            manager =std::make_unique<Manager>(bus, state, &clock,
+                                                file("mode").c_str(),
+                                                file("owner").c_str());
+            bmc = std::make_unique<BmcEpoch>(bus, OBJPATH_BMC, &clock);
+            host = std::make_unique<HostEpoch>(bus, OBJPATH_HOST, &clock,
+                                               file("offset").c_str());
+            subscriptions.emplace_back(manager->subscribe(
+                [this](const TimeStateChange& change)
+                {
+                    bmc->onTimeStateChanged(change);
+                }));
+            subscriptions.emplace_back(manager->subscribe(
+                [this](const TimeStateChange& change)
+                {
+                    host->onTimeStateChanged(change);
+                }));
+            subscriptions.emplace_back(bmc->subscribe(
+                [this](const TimeStateChange& change)
+                {
+                    host->onTimeStateChanged(change);
+                }));
+
+            // The host time is kept from the saved offset in SPLIT
+            hostDiff = microseconds(host->elapsed()) - clock.mono;
+        }
+
+        ~Simulation()
+        {
+            subscriptions.clear();
+            for (auto name : {"mode", "owner", "offset"})
+            {
+                unlink(file(name).c_str());
+            }
+            rmdir(dir.c_str());
+        }
+
+        /** @brief Run random events
+         *
+         * @param[in] events - The number of events
+         *
+         * @return The description of the first broken invariant, or empty
+         */
+        std::string run(size_t events)
+        {
+            auto failure = check();
+            for (size_t i = 0; i < events && failure.empty(); ++i)
+            {
+                auto what = step();
+                failure = check();
+                if (!failure.empty())
+                {
+                    failure = "event " + std::to_string(i) + " (" + what +
+                              "): " + failure;
+                }
+            }
+            return failure;
+        }
+
+        /** @brief The number of rejected sets */
+        size_t rejected = 0;
+
+    private:
+        std::mt19937 random;
+        FakeSystemClock clock;
+
+        /** @brief The directory of the saved files of the scenario */
+        std::string dir;
+
+        /** @brief Get the path of a saved file of the scenario */
+        std::string file(const char* name) const
+        {
+            return dir + "/" + name;
+        }
+
+        /** @brief The events queued for the event loop */
+        std::deque<std::function<void()>> pending;
+
+        std::unique_ptr<Manager> manager;
+        std::unique_ptr<BmcEpoch> bmc;
+        std::unique_ptr<HostEpoch> host;
+        std::vector<TimeStateDispatcher::Subscription> subscriptions;
+
+        /** @brief The model: the settings, and the mode and owner in use */
+        Mode settingMode;
+        Owner settingOwner;
+        Mode mode;
+        Owner owner;
+        bool hostOn = false;
+
+        /** @brief The model: the host time minus the steady time in SPLIT */
+        microseconds hostDiff;
+
+        /** @brief Get a random duration in [-max, max] */
+        microseconds randomDuration(const microseconds& max)
+        {
+            std::uniform_int_distribution<int64_t> d(-max.count(),
+                                                     max.count());
+            return microseconds(d(random));
+        }
+
+        /** @brief Run the queued events */
+        void dispatch()
+        {
+            while (!pending.empty())
+            {
+                auto event = std::move(pending.front());
+                pending.pop_front();
+                event();
+            }
+        }
+
+        /** @brief Apply the settings if the host is off */
+        void applySettings()
+        {
+            if (hostOn)
+            {
+                return;
+            }
+            mode = settingMode;
+            if (owner != settingOwner)
+            {
+                if (settingOwner == Owner::Split)
+                {
+                    // The host time is the BMC time when it starts to split
+                    hostDiff = clock.real - clock.mono;
+                }
+                owner = settingOwner;
+            }
+        }
+
+        /** @brief Run a random event, and the events it queues
+         *
+         * @return The name of the event
+         */
+        std::string step()
+        {
+            std::string what;
+            switch (random() % 7)
+            {
+                case 0:
+                {
+                    what = "advance";
+                    clock.advance(microseconds(random() % 3600000000ULL));
+                    break;
+                }
+                case 1:
+                {
+                    what = "step";
+                    auto d = randomDuration(MONTH);
+                    if (d < STEP_TOLERANCE && d > -STEP_TOLERANCE)
+                    {
+                        d = STEP_TOLERANCE;
+                    }
+                    clock.step(d);
+                    break;
+                }
+                case 2:
+                {
+                    what = "host on/off";
+                    hostOn = !hostOn;
+                    manager->onHostState(hostOn);
+                    applySettings();
+                    break;
+                }
+                case 3:
+                {
+                    what = "mode setting";
+                    auto i = random() % 2;
+                    if (manager->isNewValue(PROPERTY_TIME_MODE, MODES[i]))
+                    {
+                        manager->onPropertyChanged(PROPERTY_TIME_MODE,
+                                                   MODES[i]);
+                    }
+                    settingMode = MODE_VALUES[i];
+                    applySettings();
+                    break;
+                }
+                case 4:
+                {
+                    what = "owner setting";
+                    auto i = random() % 4;
+                    if (manager->isNewValue(PROPERTY_TIME_OWNER, OWNERS[i]))
+                    {
+                        manager->onPropertyChanged(PROPERTY_TIME_OWNER,
+                                                   OWNERS[i]);
+                    }
+                    settingOwner = OWNER_VALUES[i];
+                    applySettings();
+                    break;
+                }
+                case 5:
+                {
+                    what = "BMC set";
+                    auto time = clock.real + randomDuration(MONTH);
+                    auto rule = policy::lookup(Clock::BMC, mode, owner);
+                    try
+                    {
+                        bmc->elapsed(time.count());
+                    }
+                    catch (const NotAllowed&)
+                    {
+                        ++rejected;
+                        if (rule.action != SetAction::Reject)
+                        {
+                            return what + ", rejected unexpectedly";
+                        }
+                        break;
+                    }
+                    if (rule.action == SetAction::Reject)
+                    {
+                        return what + ", not rejected";
+                    }
+                    break;
+                }
+                case 6:
+                {
+                    what = "host set";
+                    auto time = clock.real + randomDuration(MONTH);
+                    auto rule = policy::lookup(Clock::Host, mode, owner);
+                    try
+                    {
+                        host->elapsed(time.count());
+                    }
+                    catch (const NotAllowed&)
+                    {
+                        ++rejected;
+                        if (rule.action != SetAction::Reject)
+                        {
+                            return what + ", rejected unexpectedly";
+                        }
+                        break;
+                    }
+                    if (rule.action == SetAction::StoreOffset)
+                    {
+                        hostDiff = time - clock.mono;
+                    }
+                    else if (rule.action == SetAction::Reject)
+                    {
+                        return what + ", not rejected";
+                    }
+                    break;
+                }
+            }
+            dispatch();
+            return what;
+        }
+
+        /** @brief Check the objects against the model
+         *
+         * @return The description of the first broken invariant, or empty
+         */
+        std::string check() const
+        {
+            if (manager->hostOn != hostOn)
+            {
+                return "host state";
+            }
+            if (manager->timeMode != mode || manager->timeOwner != owner)
+            {
+                return "manager mode or owner";
+            }
+            if (bmc->timeMode != mode || bmc->timeOwner != owner ||
+                host->timeMode != mode || host->timeOwner != owner)
+            {
+                return "epoch mode or owner";
+            }
+            if (clock.ntp != (mode == Mode::NTP))
+            {
+                return "NTP setting";
+            }
+            if (microseconds(bmc->elapsed()) != clock.real)
+            {
+                return "BMC time";
+            }
+            auto jump = clock.real - clock.mono - bmc->diffToSteadyClock;
+            if (jump >= STEP_TOLERANCE || jump <= -STEP_TOLERANCE)
+            {
+                return "BMC time step missed";
+            }
+
+            auto hostTime = microseconds(host->elapsed());
+            if (owner != Owner::Split)
+            {
+                if (host->offset != 0us || hostTime != clock.real)
+                {
+                    return "host time is not BMC time";
+                }
+            }
+            else if (hostTime != clock.mono + hostDiff ||
+                     host->offset != hostTime - clock.real)
+            {
+                return "host time is not kept";
+            }
+            return {};
+        }
+};
+
+class TestSimulation : public testing::Test
+{
+    public:
+        sd_event* event = nullptr;
+
+        /** @brief The bus is never started, the objects and matches are
+         *  only added to it, and the calls fail without any service
+         */
+        std::unique_ptr<sdbusplus::bus::bus> bus;
+
+        TestSimulation()
+        {
+            // BmcEpoch requires sd_event to init
+            sd_event_new(&event);
+            sd_bus* b = nullptr;
+            sd_bus_new(&b);
+            bus = std::make_unique<sdbusplus::bus::bus>(b);
+            bus->attach_event(event, SD_EVENT_PRIORITY_NORMAL);
+        }
+
+        ~TestSimulation()
+        {
+            bus->detach_event();
+            bus.reset();
+            sd_event_unref(event);
+        }
+
+        /** @brief Run the scenarios with the seeds from the first one
+         *
+         * @return The number of the scenarios per second
+         */
+        double runScenarios(uint32_t first, size_t scenarios, size_t events)
+        {
+            auto start = steady_clock::now();
+            size_t rejected = 0;
+            for (auto seed = first; seed < first + scenarios; ++seed)
+            {
+                Simulation simulation(*bus, seed);
+                auto failure = simulation.run(events);
+                EXPECT_EQ("", failure) << "seed " << seed;
+                if (!failure.empty())
+                {
+                    return 0;
+                }
+                rejected += simulation.rejected;
+            }
+            // Both the allowed and the rejected sets are exercised
+            EXPECT_NE(0u, rejected);
+            auto elapsed = duration<double>(steady_clock::now() - start);
+            return scenarios / elapsed.count();
+        }
+};
+
+TEST_F(TestSimulation, shortScenarios)
+{
+    auto rate = runScenarios(1, 2000, 20);
+    RecordProperty("ScenariosPerSecond", static_cast<int>(rate));
+}
+
+TEST_F(TestSimulation, longScenarios)
+{
+    auto rate = runScenarios(100000, 50, 2000);
+    RecordProperty("ScenariosPerSecond", static_cast<int>(rate));
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,208 @@
+#include "telemetry_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+namespace telemetry
+{
+
+bool operator==(const Sample& a, const Sample& b)
+{
+    return a.time == b.time && a.offset == b.offset &&
+           a.frequency == b.frequency && a.error == b.error &&
+           a.jumps == b.jumps;
+}
+
+class TestTelemetryRing : public testing::Test
+{
+    public:
+        std::string file;
+        std::mt19937 random{1};
+
+        TestTelemetryRing()
+        {
+            char name[] = "/tmp/clock_telemetryXXXXXX";
+            auto fd = mkstemp(name);
+            close(fd);
+            file = name;
+        }
+
+        ~TestTelemetryRing()
+        {
+            unlink(file.c_str());
+        }
+
+        /** @brief Make samples as a BMC sampled every 10 minutes */
+        std::vector<Sample> makeSamples(size_t n)
+        {
+            std::vector<Sample> samples;
+            std::normal_distribution<double> noise(0, 20);
+            Sample s;
+            s.time = 1500000000;
+            s.frequency = 1234567;
+            s.error = 16;
+            for (size_t i = 0; i < n; ++i)
+            {
+                s.time += 600;
+                s.frequency += static_cast<int64_t>(noise(random)) * 16;
+                s.error = 16 + static_cast<int64_t>(random() % 32);
+                if (random() % 1000 == 0)
+                {
+                    ++s.jumps;
+                    s.offset = static_cast<int64_t>(random());
+                }
+                samples.push_back(s);
+            }
+            return samples;
+        }
+
+        /** @brief Read all the pages, one page per call */
+        std::vector<Sample> readAll(const Ring& ring)
+        {
+            std::vector<Sample> samples;
+            uint32_t next = 0;
+            while (true)
+            {
+                auto data = ring.read(next, 1, next);
+                if (data.empty())
+                {
+                    break;
+                }
+                EXPECT_TRUE(decode(data, samples));
+            }
+            return samples;
+        }
+};
+
+TEST_F(TestTelemetryRing, roundTrip)
+{
+    Ring ring(file.c_str(), 4);
+    auto samples = makeSamples(10);
+    for (const auto& s : samples)
+    {
+        ring.append(s);
+    }
+    EXPECT_EQ(samples, readAll(ring));
+}
+
+TEST_F(TestTelemetryRing, negativeDeltas)
+{
+    Ring ring(file.c_str(), 4);
+    std::vector<Sample> samples(3);
+    samples[0].time = 1500000000;
+    samples[0].offset = -5000000;
+    samples[1].time = 100;
+    samples[1].frequency = -32768000;
+    samples[2].time = INT64_MAX;
+    samples[2].error = INT64_MIN;
+    for (const auto& s : samples)
+    {
+        ring.append(s);
+    }
+    EXPECT_EQ(samples, readAll(ring));
+}
+
+TEST_F(TestTelemetryRing, pagesAreKept)
+{
+    auto samples = makeSamples(2000);
+    uint32_t sequence;
+    {
+        Ring ring(file.c_str(), 16);
+        for (const auto& s : samples)
+        {
+            ring.append(s);
+        }
+        sequence = ring.sequence();
+        EXPECT_LT(1u, sequence);
+        ring.flush();
+    }
+
+    // The flushed page is kept, and a new page is started
+    Ring ring(file.c_str(), 16);
+    EXPECT_EQ(sequence + 1, ring.sequence());
+    EXPECT_EQ(samples, readAll(ring));
+}
+
+TEST_F(TestTelemetryRing, openLater)
+{
+    auto samples = makeSamples(20);
+    {
+        Ring ring(file.c_str(), 16);
+        ring.append(samples[0]);
+        ring.flush();
+    }
+
+    // The samples taken before the file is opened go to the page after
+    // the ones written meanwhile
+    Ring ring(16);
+    ring.append(samples[1]);
+    {
+        Ring running(file.c_str(), 16);
+        running.append(samples[2]);
+        running.flush();
+    }
+    ring.open(file.c_str());
+    EXPECT_EQ(3u, ring.sequence());
+    ring.flush();
+
+    std::vector<Sample> expected{samples[0], samples[2], samples[1]};
+    EXPECT_EQ(expected, readAll(ring));
+}
+
+TEST_F(TestTelemetryRing, oldestIsOverwritten)
+{
+    Ring ring(file.c_str(), 2);
+    auto samples = makeSamples(5000);
+    for (const auto& s : samples)
+    {
+        ring.append(s);
+    }
+    ASSERT_LT(3u, ring.sequence());
+
+    // The last full page and the current page are left
+    auto left = readAll(ring);
+    ASSERT_FALSE(left.empty());
+    ASSERT_LT(left.size(), samples.size());
+    std::vector<Sample> tail(samples.end() - left.size(), samples.end());
+    EXPECT_EQ(tail, left);
+}
+
+TEST_F(TestTelemetryRing, monthsFitInFewPages)
+{
+    // Half a year of samples every 10 minutes
+    Ring ring(file.c_str(), 64);
+    auto samples = makeSamples(6 * 30 * 144);
+    for (const auto& s : samples)
+    {
+        ring.append(s);
+    }
+    EXPECT_GT(64u, ring.sequence());
+    EXPECT_EQ(samples, readAll(ring));
+}
+
+TEST_F(TestTelemetryRing, badData)
+{
+    std::vector<Sample> samples;
+    EXPECT_FALSE(decode({1, 2, 3}, samples));
+
+    Ring ring(file.c_str(), 4);
+    ring.append(makeSamples(1)[0]);
+    uint32_t next;
+    auto data = ring.read(0, 1, next);
+    data.pop_back();
+    EXPECT_FALSE(decode(data, samples));
+}
+
+} // namespace telemetry
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,116 @@
+#include "threshold_subscriptions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestThresholdSubscriptions : public testing::Test
+{
+    public:
+        ThresholdSubscriptions subscriptions;
+
+        std::vector<std::string> notified(const microseconds& delta)
+        {
+            std::vector<std::string> clients;
+            subscriptions.forEachClient(
+                delta,
+                [&clients](const std::string& client)
+                {
+                    clients.push_back(client);
+                });
+            return clients;
+        }
+};
+
+TEST_F(TestThresholdSubscriptions, empty)
+{
+    EXPECT_EQ(0u, subscriptions.size());
+    EXPECT_TRUE(notified(1h).empty());
+}
+
+TEST_F(TestThresholdSubscriptions, notifyAboveThreshold)
+{
+    subscriptions.add(":1.1", 1s);
+    subscriptions.add(":1.2", 1min);
+
+    // The change shall be larger than the threshold
+    EXPECT_TRUE(notified(1s).empty());
+    EXPECT_EQ(std::vector<std::string>{":1.1"}, notified(2s));
+    EXPECT_EQ(std::vector<std::string>{":1.1"}, notified(-2s));
+    EXPECT_EQ((std::vector<std::string>{":1.1", ":1.2"}), notified(-1h));
+}
+
+TEST_F(TestThresholdSubscriptions, notifyClientOnce)
+{
+    subscriptions.add(":1.1", 1s);
+    subscriptions.add(":1.1", 2s);
+    EXPECT_EQ(2u, subscriptions.count(":1.1"));
+    EXPECT_EQ(std::vector<std::string>{":1.1"}, notified(1min));
+}
+
+TEST_F(TestThresholdSubscriptions, remove)
+{
+    auto id1 = subscriptions.add(":1.1", 1s);
+    auto id2 = subscriptions.add(":1.2", 1s);
+    EXPECT_NE(id1, id2);
+
+    // Only the client itself is able to remove its subscription
+    EXPECT_FALSE(subscriptions.remove(":1.2", id1));
+    EXPECT_TRUE(subscriptions.remove(":1.1", id1));
+    EXPECT_FALSE(subscriptions.remove(":1.1", id1));
+
+    EXPECT_EQ(0u, subscriptions.count(":1.1"));
+    EXPECT_EQ(std::vector<std::string>{":1.2"}, notified(1min));
+}
+
+TEST_F(TestThresholdSubscriptions, removeClient)
+{
+    subscriptions.add(":1.1", 1s);
+    subscriptions.add(":1.2", 1s);
+    subscriptions.add(":1.1", 1min);
+
+    EXPECT_EQ(2u, subscriptions.removeClient(":1.1"));
+    EXPECT_EQ(0u, subscriptions.removeClient(":1.1"));
+    EXPECT_EQ(1u, subscriptions.size());
+    EXPECT_EQ(std::vector<std::string>{":1.2"}, notified(1h));
+}
+
+TEST_F(TestThresholdSubscriptions, insertHandedSubscriptions)
+{
+    // The subscriptions of the running process keep their ids
+    ThresholdSubscriptions running;
+    running.add(":1.1", 1s);
+    auto handed = running.add(":1.2", 1min);
+    running.remove(":1.1", running.add(":1.1", 1h));
+    running.forEach(
+        [this](ThresholdSubscriptions::Id id, const std::string& client,
+               const microseconds& threshold)
+        {
+            EXPECT_TRUE(subscriptions.insert(id, client, threshold));
+        });
+    subscriptions.setNextId(running.getNextId());
+    EXPECT_FALSE(subscriptions.insert(handed, ":1.3", 1s));
+    EXPECT_EQ(2u, subscriptions.size());
+    EXPECT_EQ((std::vector<std::string>{":1.1", ":1.2"}), notified(1h));
+    EXPECT_TRUE(subscriptions.remove(":1.2", handed));
+
+    // The id of the removed subscription is not given again
+    EXPECT_EQ(running.getNextId(), subscriptions.add(":1.3", 1s));
+
+    subscriptions.clear();
+    EXPECT_EQ(0u, subscriptions.size());
+    EXPECT_EQ(0u, subscriptions.count(":1.1"));
+    EXPECT_TRUE(notified(1h).empty());
+}
+
+}
+}
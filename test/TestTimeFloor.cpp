@@ -0,0 +1,159 @@
+#include "time_floor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+class TestTimeFloor : public testing::Test
+{
+    public:
+        std::string file;
+
+        /** @brief The times set by the floor */
+        std::vector<microseconds> sets;
+
+        /** @brief The result of the setter */
+        bool setOk = true;
+
+        TestTimeFloor()
+        {
+            char name[] = "/tmp/saved_time_floorXXXXXX";
+            auto fd = mkstemp(name);
+            close(fd);
+            file = name;
+        }
+
+        ~TestTimeFloor()
+        {
+            unlink(file.c_str());
+        }
+
+        bool apply(TimeFloor& timeFloor, const microseconds& now)
+        {
+            return timeFloor.apply(now,
+                                   [this](const microseconds& floor)
+                                   {
+                                       sets.push_back(floor);
+                                       return setOk;
+                                   });
+        }
+};
+
+TEST_F(TestTimeFloor, noFloor)
+{
+    TimeFloor timeFloor(nullptr, file.c_str());
+    EXPECT_EQ(0us, timeFloor.floor());
+    EXPECT_FALSE(apply(timeFloor, 0us));
+    EXPECT_TRUE(sets.empty());
+}
+
+TEST_F(TestTimeFloor, saveAndApply)
+{
+    auto floor = microseconds(hours(24 * 365 * 47));
+    {
+        TimeFloor timeFloor(nullptr, file.c_str());
+        timeFloor.save(floor);
+    }
+
+    TimeFloor timeFloor(nullptr, file.c_str());
+    EXPECT_EQ(floor, timeFloor.floor());
+    EXPECT_TRUE(apply(timeFloor, 10s));
+    EXPECT_EQ(std::vector<microseconds>{floor}, sets);
+    EXPECT_EQ(1u, timeFloor.avoided());
+
+    // The counter is saved with the floor
+    TimeFloor restarted(nullptr, file.c_str());
+    EXPECT_EQ(1u, restarted.avoided());
+    EXPECT_EQ(floor, restarted.floor());
+}
+
+TEST_F(TestTimeFloor, notClearlyBehind)
+{
+    auto floor = microseconds(hours(24 * 365 * 47));
+    TimeFloor timeFloor(nullptr, file.c_str());
+    timeFloor.save(floor);
+
+    // A working RTC may drift a little behind the floor
+    EXPECT_FALSE(apply(timeFloor, floor - 1h));
+    EXPECT_FALSE(apply(timeFloor, floor + 1h));
+    EXPECT_TRUE(sets.empty());
+    EXPECT_EQ(0u, timeFloor.avoided());
+}
+
+TEST_F(TestTimeFloor, failToSet)
+{
+    auto floor = microseconds(hours(24 * 365 * 47));
+    TimeFloor timeFloor(nullptr, file.c_str());
+    timeFloor.save(floor);
+
+    setOk = false;
+    EXPECT_FALSE(apply(timeFloor, 10s));
+    EXPECT_EQ(0u, timeFloor.avoided());
+}
+
+TEST_F(TestTimeFloor, neverLowered)
+{
+    TimeFloor timeFloor(nullptr, file.c_str());
+    timeFloor.save(100s);
+    timeFloor.save(50s);
+    EXPECT_EQ(100s, timeFloor.floor());
+
+    TimeFloor restarted(nullptr, file.c_str());
+    EXPECT_EQ(100s, restarted.floor());
+}
+
+TEST_F(TestTimeFloor, followBackwardSet)
+{
+    // A bogus future time is saved, then the time is set right
+    auto bogus = microseconds(hours(24 * 365 * 60));
+    auto right = microseconds(hours(24 * 365 * 47));
+    TimeFloor timeFloor(nullptr, file.c_str());
+    timeFloor.save(bogus);
+    timeFloor.follow(right);
+    EXPECT_EQ(right, timeFloor.floor());
+
+    TimeFloor restarted(nullptr, file.c_str());
+    EXPECT_EQ(right, restarted.floor());
+    EXPECT_FALSE(apply(restarted, right + 1h));
+    EXPECT_TRUE(sets.empty());
+}
+
+TEST_F(TestTimeFloor, onBmcTimeChanged)
+{
+    TimeFloor timeFloor(nullptr, file.c_str());
+    timeFloor.save(100s);
+
+    TimeStateChange change;
+    change.changed = TimeStateChange::ModeChanged;
+    change.bmcTime = 50s;
+    timeFloor.onBmcTimeChanged(change);
+    EXPECT_EQ(100s, timeFloor.floor());
+
+    change.changed = TimeStateChange::BmcTimeJumped;
+    timeFloor.onBmcTimeChanged(change);
+    EXPECT_EQ(50s, timeFloor.floor());
+}
+
+TEST_F(TestTimeFloor, badFile)
+{
+    std::ofstream(file) << "garbage";
+    TimeFloor timeFloor(nullptr, file.c_str());
+    EXPECT_EQ(0us, timeFloor.floor());
+    EXPECT_EQ(0u, timeFloor.avoided());
+}
+
+} // namespace time
+} // namespace phosphor
@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 #include <xyz/openbmc_project/Common/error.hpp>
 
+#include <time.h>
+
 namespace phosphor
 {
 namespace time
@@ -73,6 +75,34 @@ TEST(TestUtil, ownerToStr)
     EXPECT_ANY_THROW(ownerToStr(static_cast<Owner>(100)));
 }
 
+TEST(TestUtil, strToClockRead)
+{
+    EXPECT_EQ(ClockRead::Coarse, strToClockRead("coarse"));
+    EXPECT_EQ(ClockRead::Precise, strToClockRead("precise"));
+    EXPECT_EQ(ClockRead::Precise, strToClockRead(""));
+}
+
+TEST(TestUtil, now)
+{
+    using namespace std::chrono;
+    timespec res;
+    clock_getres(CLOCK_REALTIME_COARSE, &res);
+    auto tick = duration_cast<microseconds>(
+        seconds(res.tv_sec) + nanoseconds(res.tv_nsec));
+
+    // The coarse time is the time of the last tick, so it is not later
+    // than the precise time, and not earlier by more than a tick
+    auto coarse = now(ClockRead::Coarse);
+    auto precise = now(ClockRead::Precise);
+    EXPECT_LE(coarse, precise);
+    EXPECT_LE(precise - coarse, tick + milliseconds(100));
+
+    auto system = duration_cast<microseconds>(
+        system_clock::now().time_since_epoch());
+    EXPECT_LE(precise, system);
+    EXPECT_LE(system - precise, milliseconds(100));
+}
+
 } // namespace utils
 } // namespace time
 } // namespace phosphor
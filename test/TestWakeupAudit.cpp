@@ -0,0 +1,64 @@
+#include "wakeup_audit.hpp"
+
+#include <gtest/gtest.h>
+
+namespace phosphor
+{
+namespace time
+{
+
+class TestWakeupAudit : public testing::Test
+{
+    public:
+        TestWakeupAudit()
+        {
+            wakeup::reset();
+        }
+        ~TestWakeupAudit()
+        {
+            wakeup::reset();
+        }
+};
+
+TEST_F(TestWakeupAudit, count)
+{
+    wakeup::count(wakeup::Source::SettingsChanged, true);
+    wakeup::count(wakeup::Source::SettingsChanged, false);
+    wakeup::count(wakeup::Source::HostStateChanged, false);
+
+    auto settings = wakeup::get(wakeup::Source::SettingsChanged);
+    EXPECT_EQ(2u, settings.wakeups);
+    EXPECT_EQ(1u, settings.idle);
+    auto host = wakeup::get(wakeup::Source::HostStateChanged);
+    EXPECT_EQ(1u, host.wakeups);
+    EXPECT_EQ(1u, host.idle);
+    auto bmc = wakeup::get(wakeup::Source::BmcTimeChange);
+    EXPECT_EQ(0u, bmc.wakeups);
+
+    wakeup::reset();
+    EXPECT_EQ(0u, wakeup::get(wakeup::Source::SettingsChanged).wakeups);
+}
+
+TEST_F(TestWakeupAudit, report)
+{
+    wakeup::count(wakeup::Source::QueryRequest, true);
+
+    // Without iterations there is no "Other"
+    auto table = wakeup::report();
+    EXPECT_NE(std::string::npos, table.find("Query request"));
+    EXPECT_EQ(std::string::npos, table.find("Other"));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        wakeup::countIteration();
+    }
+    EXPECT_EQ(3u, wakeup::iterations());
+    table = wakeup::report();
+    auto other = table.find("Other");
+    ASSERT_NE(std::string::npos, other);
+    auto line = table.substr(other, table.find('\n', other) - other);
+    EXPECT_NE(std::string::npos, line.find(" 2 "));
+}
+
+} // namespace time
+} // namespace phosphor
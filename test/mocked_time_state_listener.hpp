@@ -0,0 +1,38 @@
+#pragma once
+#include <gmock/gmock.h>
+#include "time_state_change.hpp"
+
+namespace phosphor {
+namespace time {
+
+class MockTimeStateListener {
+ public:
+  MOCK_METHOD1(onTimeStateChanged,
+      void(const TimeStateChange& change));
+
+  TimeStateDispatcher::Handler handler() {
+    return [this](const TimeStateChange& change) {
+      onTimeStateChanged(change);
+    };
+  }
+};
+
+MATCHER_P(ModeChangedTo, mode, "") {
+  return arg.has(TimeStateChange::ModeChanged) && arg.mode == mode;
+}
+
+MATCHER_P(OwnerChangedTo, owner, "") {
+  return arg.has(TimeStateChange::OwnerChanged) && arg.owner == owner;
+}
+
+MATCHER_P2(ModeAndOwnerChangedTo, mode, owner, "") {
+  return arg.has(TimeStateChange::ModeChanged) && arg.mode == mode &&
+         arg.has(TimeStateChange::OwnerChanged) && arg.owner == owner;
+}
+
+MATCHER(BmcTimeJumped, "") {
+  return arg.has(TimeStateChange::BmcTimeJumped);
+}
+
+}  // namespace time
+}  // namespace phosphor
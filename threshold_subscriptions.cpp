@@ -0,0 +1,92 @@
+#include "threshold_subscriptions.hpp"
+
+namespace phosphor
+{
+namespace time
+{
+
+ThresholdSubscriptions::Id ThresholdSubscriptions::add(
+    const std::string& client,
+    const std::chrono::microseconds& threshold)
+{
+    auto id = nextId++;
+    auto it = byThreshold.emplace(threshold, Subscription{id, client});
+    byId.emplace(id, it);
+    ++clients[client];
+    return id;
+}
+
+bool ThresholdSubscriptions::insert(
+    Id id,
+    const std::string& client,
+    const std::chrono::microseconds& threshold)
+{
+    if (byId.find(id) != byId.end())
+    {
+        return false;
+    }
+    auto it = byThreshold.emplace(threshold, Subscription{id, client});
+    byId.emplace(id, it);
+    ++clients[client];
+    setNextId(id + 1);
+    return true;
+}
+
+void ThresholdSubscriptions::clear()
+{
+    byId.clear();
+    byThreshold.clear();
+    clients.clear();
+}
+
+bool ThresholdSubscriptions::remove(const std::string& client, Id id)
+{
+    auto it = byId.find(id);
+    if (it == byId.end() || it->second->second.client != client)
+    {
+        return false;
+    }
+    byThreshold.erase(it->second);
+    byId.erase(it);
+
+    auto c = clients.find(client);
+    if (--c->second == 0)
+    {
+        clients.erase(c);
+    }
+    return true;
+}
+
+size_t ThresholdSubscriptions::removeClient(const std::string& client)
+{
+    auto c = clients.find(client);
+    if (c == clients.end())
+    {
+        return 0;
+    }
+    auto removed = c->second;
+    clients.erase(c);
+
+    for (auto it = byId.begin(); it != byId.end();)
+    {
+        if (it->second->second.client == client)
+        {
+            byThreshold.erase(it->second);
+            it = byId.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+size_t ThresholdSubscriptions::count(const std::string& client) const
+{
+    auto c = clients.find(client);
+    return c == clients.end() ? 0 : c->second;
+}
+
+} // namespace time
+} // namespace phosphor
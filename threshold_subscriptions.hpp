@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class ThresholdSubscriptions
+ *  @brief The subscriptions of clients to time changes above a threshold.
+ *  @details The subscriptions are sorted by threshold, so that on a change
+ *  only the ones with a smaller threshold are visited.
+ */
+class ThresholdSubscriptions
+{
+    public:
+        using Id = uint64_t;
+
+        /** @brief Add a subscription
+         *
+         * @param[in] client - The bus name of the client
+         * @param[in] threshold - The threshold of the change
+         *
+         * @return The id of the subscription
+         */
+        Id add(const std::string& client,
+               const std::chrono::microseconds& threshold);
+
+        /** @brief Add a subscription with the id it was given before, e.g.
+         *  by the running process on a live restart
+         *
+         * @param[in] id - The id of the subscription
+         * @param[in] client - The bus name of the client
+         * @param[in] threshold - The threshold of the change
+         *
+         * @return false if the id is in use
+         */
+        bool insert(Id id, const std::string& client,
+                    const std::chrono::microseconds& threshold);
+
+        /** @brief Remove all subscriptions */
+        void clear();
+
+        /** @brief Get the id of the next subscription */
+        Id getNextId() const
+        {
+            return nextId;
+        }
+
+        /** @brief Set the id of the next subscription, the ids before it
+         *  are not given again
+         *
+         * @param[in] id - The id of the next subscription
+         */
+        void setNextId(Id id)
+        {
+            nextId = std::max(nextId, id);
+        }
+
+        /** @brief Call the function for each subscription, by id
+         *
+         * @param[in] func - The function to call with the id, the client
+         *                   and the threshold of the subscription
+         */
+        template <typename Func>
+        void forEach(Func&& func) const
+        {
+            for (const auto& s : byId)
+            {
+                func(s.first, s.second->second.client, s.second->first);
+            }
+        }
+
+        /** @brief Remove a subscription of the client
+         *
+         * @param[in] client - The bus name of the client
+         * @param[in] id - The id of the subscription
+         *
+         * @return true if the subscription is removed, false if there is
+         *         no such subscription of the client
+         */
+        bool remove(const std::string& client, Id id);
+
+        /** @brief Remove all subscriptions of the client
+         *
+         * @param[in] client - The bus name of the client
+         *
+         * @return The number of removed subscriptions
+         */
+        size_t removeClient(const std::string& client);
+
+        /** @brief Get the number of subscriptions of the client */
+        size_t count(const std::string& client) const;
+
+        /** @brief Get the number of all subscriptions */
+        size_t size() const
+        {
+            return byId.size();
+        }
+
+        /** @brief Call the function once for each client that has a
+         *  subscription with the threshold less than the change
+         *
+         * @param[in] delta - The change, in either direction
+         * @param[in] func - The function to call with the client name
+         */
+        template <typename Func>
+        void forEachClient(const std::chrono::microseconds& delta,
+                           Func&& func) const
+        {
+            auto size = delta < delta.zero() ? -delta : delta;
+            std::set<std::string> notified;
+            for (auto it = byThreshold.begin();
+                 it != byThreshold.end() && it->first < size;
+                 ++it)
+            {
+                if (notified.insert(it->second.client).second)
+                {
+                    func(it->second.client);
+                }
+            }
+        }
+
+    private:
+        /** @brief A subscription */
+        struct Subscription
+        {
+            Id id;
+            std::string client;
+        };
+
+        using Index = std::multimap<std::chrono::microseconds, Subscription>;
+
+        /** @brief The subscriptions sorted by threshold */
+        Index byThreshold;
+
+        /** @brief The subscriptions by id */
+        std::map<Id, Index::iterator> byId;
+
+        /** @brief The number of subscriptions of each client */
+        std::map<std::string, size_t> clients;
+
+        /** @brief The id of the next subscription */
+        Id nextId = 1;
+};
+
+} // namespace time
+} // namespace phosphor
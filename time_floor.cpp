@@ -0,0 +1,146 @@
+#include "time_floor.hpp"
+#include "utils.hpp"
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <cstring>
+#include <fstream>
+
+namespace // anonymous
+{
+/** @brief The interval to save the floor, the floor is at most this
+ *  behind the time of a sudden power loss
+ */
+constexpr uint64_t SAVE_INTERVAL_USEC = 3600 * 1000000ULL;
+}
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+using namespace phosphor::logging;
+
+constexpr hours TimeFloor::minBehind;
+
+TimeFloor::TimeFloor(sd_event* event, const char* file)
+    : file(file)
+{
+    int64_t floor = 0;
+    std::ifstream fs(file);
+    if (fs >> floor >> avoidedJumps)
+    {
+        savedFloor = microseconds(floor);
+    }
+    else
+    {
+        avoidedJumps = 0;
+    }
+
+    if (!event)
+    {
+        return;
+    }
+
+    uint64_t now;
+    sd_event_source* es;
+    auto r = sd_event_now(event, CLOCK_MONOTONIC, &now);
+    if (r >= 0)
+    {
+        r = sd_event_add_time(event, &es, CLOCK_MONOTONIC,
+                              now + SAVE_INTERVAL_USEC, 0, onSaveTimer, this);
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to schedule saving the time floor",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+    else
+    {
+        saveTimer.reset(es);
+    }
+}
+
+bool TimeFloor::apply(const microseconds& now, Setter set)
+{
+    if (savedFloor.count() == 0 || now + minBehind > savedFloor)
+    {
+        return false;
+    }
+    if (!set(savedFloor))
+    {
+        log<level::ERR>("Failed to set the time to the floor",
+                        entry("FLOOR=%lld",
+                              static_cast<long long>(savedFloor.count())));
+        return false;
+    }
+
+    ++avoidedJumps;
+    write();
+    log<level::INFO>("Set the time forward to the floor",
+                     entry("BEHIND_SEC=%lld",
+                           static_cast<long long>(
+                               duration_cast<seconds>(
+                                   savedFloor - now).count())),
+                     entry("AVOIDED=%llu",
+                           static_cast<unsigned long long>(avoidedJumps)));
+    return true;
+}
+
+void TimeFloor::save(const microseconds& now)
+{
+    // A clock behind the floor is not good, e.g. the floor failed to set
+    if (now <= savedFloor)
+    {
+        return;
+    }
+    savedFloor = now;
+    write();
+}
+
+void TimeFloor::follow(const microseconds& time)
+{
+    // The set is accepted, so the time that it replaces, even a later
+    // one, is not a good floor any more
+    savedFloor = time;
+    write();
+}
+
+void TimeFloor::onBmcTimeChanged(const TimeStateChange& change)
+{
+    if (change.has(TimeStateChange::BmcTimeJumped))
+    {
+        follow(change.bmcTime);
+    }
+}
+
+void TimeFloor::write()
+{
+    std::ofstream fs(file, std::ios::trunc);
+    fs << savedFloor.count() << ' ' << avoidedJumps;
+    if (!fs)
+    {
+        log<level::ERR>("Failed to save the time floor",
+                        entry("FILE=%s", file.c_str()));
+    }
+}
+
+int TimeFloor::onSaveTimer(sd_event_source* es, uint64_t usec,
+                           void* userdata)
+{
+    auto timeFloor = static_cast<TimeFloor*>(userdata);
+    auto before = timeFloor->savedFloor;
+    timeFloor->save(utils::now(ClockRead::Precise));
+    wakeup::count(wakeup::Source::TimeFloorSave,
+                  timeFloor->savedFloor != before);
+
+    sd_event_source_set_time(es, usec + SAVE_INTERVAL_USEC);
+    sd_event_source_set_enabled(es, SD_EVENT_ON);
+    return 0;
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "time_state_change.hpp"
+
+#include <systemd/sd-event.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class TimeFloor
+ *  @brief Keep a last known good time, as the floor of the BMC time.
+ *  @details With a dead RTC the BMC boots near 1970, and the time jumps
+ *  forward by decades later, which wakes every time change listener and
+ *  makes a huge host offset in SPLIT owner. The BMC time is saved to a
+ *  file periodically, and by save() on SIGTERM, and on start the clock is
+ *  set forward to the saved floor if it is clearly behind it. The floor
+ *  follows the accepted BMC time changes, backward ones too, so a bogus
+ *  future time is not kept once the time is set right.
+ */
+class TimeFloor
+{
+    public:
+        /** @brief The function to set the BMC time forward
+         *
+         * @return true if the time is set
+         */
+        using Setter = std::function<bool(const std::chrono::microseconds&)>;
+
+        /** @brief Constructor
+         *
+         * @param[in] event - The event loop to save the floor on, or
+         *                    nullptr to save it only by save()
+         * @param[in] file - The file to save the floor to
+         */
+        TimeFloor(sd_event* event, const char* file);
+        TimeFloor(const TimeFloor&) = delete;
+        TimeFloor& operator=(const TimeFloor&) = delete;
+        TimeFloor(TimeFloor&&) = delete;
+        TimeFloor& operator=(TimeFloor&&) = delete;
+        ~TimeFloor() = default;
+
+        /** @brief Set the BMC time forward to the floor if it is clearly
+         *  behind it
+         *
+         * @param[in] now - The current BMC time
+         * @param[in] set - The function to set the BMC time
+         *
+         * @return true if the time is set to the floor
+         */
+        bool apply(const std::chrono::microseconds& now, Setter set);
+
+        /** @brief Save the current time as the floor, unless it is behind
+         *  the saved floor
+         *
+         * @param[in] now - The current BMC time
+         */
+        void save(const std::chrono::microseconds& now);
+
+        /** @brief Save the time that the BMC time is set to as the floor,
+         *  even if it is behind the saved floor
+         *
+         * @param[in] time - The BMC time that is set
+         */
+        void follow(const std::chrono::microseconds& time);
+
+        /** @brief Follow the BMC time changes
+         *
+         * @param[in] change - The time state change of BmcEpoch
+         */
+        void onBmcTimeChanged(const TimeStateChange& change);
+
+        /** @brief Get the saved floor */
+        std::chrono::microseconds floor() const
+        {
+            return savedFloor;
+        }
+
+        /** @brief Get the number of the jumps avoided since the file is
+         *  created, i.e. the starts that set the time to the floor
+         */
+        uint64_t avoided() const
+        {
+            return avoidedJumps;
+        }
+
+        /** @brief The min distance behind the floor to set the time, a
+         *  smaller one is the drift of a working RTC
+         */
+        static constexpr auto minBehind = std::chrono::hours(24);
+
+    private:
+        /** @brief The file to save the floor to */
+        std::string file;
+
+        /** @brief The saved floor */
+        std::chrono::microseconds savedFloor{0};
+
+        /** @brief The number of the avoided jumps */
+        uint64_t avoidedJumps = 0;
+
+        /** @brief Write the floor and the counter to the file */
+        void write();
+
+        /** @brief The deleter of sd_event_source */
+        std::function<void(sd_event_source*)> sdEventSourceDeleter =
+            [] (sd_event_source* p) {
+                if (p)
+                {
+                    sd_event_source_unref(p);
+                }
+            };
+        using SdEventSource = std::unique_ptr<sd_event_source,
+                                              decltype(sdEventSourceDeleter)>;
+
+        /** @brief The timer to save the floor periodically */
+        SdEventSource saveTimer {nullptr, sdEventSourceDeleter};
+
+        /** @brief The callback function of the save timer
+         *
+         * @param[in] es - Source of the event
+         * @param[in] usec - The time the timer expires at
+         * @param[in] userdata - User data pointer
+         */
+        static int onSaveTimer(sd_event_source* es, uint64_t usec,
+                               void* userdata);
+};
+
+} // namespace time
+} // namespace phosphor
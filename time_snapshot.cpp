@@ -0,0 +1,35 @@
+#include "time_snapshot.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace std::chrono;
+
+TimeSnapshot::TimeSnapshot(sdbusplus::bus::bus& bus,
+                           const char* objPath,
+                           const PublishedState& state)
+    : sdbusplus::server::object::object<Snapshot>(bus, objPath),
+      state(state)
+{
+}
+
+std::tuple<std::string, std::string, int64_t, uint64_t, uint64_t>
+TimeSnapshot::get()
+{
+    auto value = state.load();
+    auto bmcTime = utils::now(clockRead);
+    auto hostTime = value.hostTime(bmcTime);
+    return std::make_tuple(utils::modeToStr(value.mode),
+                           utils::ownerToStr(value.owner),
+                           static_cast<int64_t>(value.offset.count()),
+                           static_cast<uint64_t>(bmcTime.count()),
+                           static_cast<uint64_t>(hostTime.count()));
+}
+
+} // namespace time
+} // namespace phosphor
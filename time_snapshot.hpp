@@ -0,0 +1,59 @@
+#pragma once
+
+#include "published_state.hpp"
+#include "types.hpp"
+#include "xyz/openbmc_project/Time/Internal/Snapshot/server.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+
+#include <string>
+#include <tuple>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @class TimeSnapshot
+ *  @brief OpenBMC time state snapshot implementation.
+ *  @details A concrete implementation for
+ *  xyz.openbmc_project.Time.Internal.Snapshot DBus API.
+ *  It only reads the PublishedState, so it is able to be served on any
+ *  thread.
+ */
+class TimeSnapshot : public sdbusplus::server::object::object <
+    sdbusplus::xyz::openbmc_project::Time::Internal::server::Snapshot >
+{
+    public:
+        TimeSnapshot(sdbusplus::bus::bus& bus,
+                     const char* objPath,
+                     const PublishedState& state);
+
+        /** @brief Get the snapshot of the time state
+         *
+         * @return The tuple of mode, owner, offset, BMC and host elapsed
+         *         microseconds since UTC
+         */
+        std::tuple<std::string, std::string, int64_t, uint64_t, uint64_t>
+            get() override;
+
+        /** @brief Set the way to read the BMC clock on snapshots
+         *
+         * @param[in] read - The way to read the clock
+         */
+        void setClockRead(ClockRead read)
+        {
+            clockRead = read;
+        }
+
+    private:
+        /** @brief The published time state */
+        const PublishedState& state;
+
+        /** @brief The way to read the BMC clock on snapshots */
+        ClockRead clockRead = ClockRead::Precise;
+};
+
+} // namespace time
+} // namespace phosphor
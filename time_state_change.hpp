@@ -0,0 +1,63 @@
+#pragma once
+
+#include "event_dispatcher.hpp"
+#include "types.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace phosphor
+{
+namespace time
+{
+
+/** @struct TimeStateChange
+ *  @brief The event of a change of the time state.
+ *  @details One event carries the whole time state as known by its
+ *  publisher, and the changed bitmask tells which parts of it are changed,
+ *  so that a combined change, e.g. mode and owner, is delivered once.
+ */
+struct TimeStateChange
+{
+    /** @brief The bits of the changed parts */
+    enum Changed : uint8_t
+    {
+        ModeChanged = 1 << 0,
+        OwnerChanged = 1 << 1,
+        OffsetChanged = 1 << 2,
+        BmcTimeJumped = 1 << 3,
+    };
+
+    /** @brief Check if a part of the state is changed
+     *
+     * @param[in] bit - The Changed bit to check
+     */
+    bool has(Changed bit) const
+    {
+        return (changed & bit) != 0;
+    }
+
+    /** @brief The bitmask of the changed parts */
+    uint8_t changed = 0;
+
+    /** @brief The time mode */
+    Mode mode = Mode::Manual;
+
+    /** @brief The time owner */
+    Owner owner = Owner::Both;
+
+    /** @brief The diff between host and BMC time */
+    std::chrono::microseconds offset{0};
+
+    /** @brief The step of BMC time, compared to steady clock */
+    std::chrono::microseconds jump{0};
+
+    /** @brief The BMC time after the step */
+    std::chrono::microseconds bmcTime{0};
+};
+
+/** @brief The dispatcher of time state changes */
+using TimeStateDispatcher = Dispatcher<TimeStateChange>;
+
+} // namespace time
+} // namespace phosphor
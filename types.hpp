@@ -44,6 +44,17 @@ namespace time
      *          BMC's time is returned to whoever that asks the time.
      */
     using Owner = OwnerSetting::Owners;
+
+    /** @brief The ways to read the time of day
+     *  Precise  CLOCK_REALTIME, the resolution of the clock source
+     *  Coarse   CLOCK_REALTIME_COARSE, the time of the last tick, which is
+     *           cheaper to read but has the resolution of a tick
+     */
+    enum class ClockRead
+    {
+        Precise,
+        Coarse,
+    };
 }
 }
 
@@ -5,6 +5,7 @@
 #include <phosphor-logging/log.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
 
+#include <time.h>
 
 namespace phosphor
 {
@@ -81,6 +82,32 @@ std::string ownerToStr(Owner owner)
     return sdbusplus::xyz::openbmc_project::Time::server::convertForMessage(owner);
 }
 
+ClockRead strToClockRead(const std::string& read)
+{
+    return read == "coarse" ? ClockRead::Coarse : ClockRead::Precise;
+}
+
+std::chrono::microseconds now(ClockRead read)
+{
+    using namespace std::chrono;
+    timespec ts;
+    clock_gettime(read == ClockRead::Coarse ? CLOCK_REALTIME_COARSE
+                                            : CLOCK_REALTIME,
+                  &ts);
+    return duration_cast<microseconds>(seconds(ts.tv_sec) +
+                                       nanoseconds(ts.tv_nsec));
+}
+
+bool setRealtime(const std::chrono::microseconds& time)
+{
+    using namespace std::chrono;
+    auto sec = duration_cast<seconds>(time);
+    timespec ts;
+    ts.tv_sec = sec.count();
+    ts.tv_nsec = duration_cast<nanoseconds>(time - sec).count();
+    return clock_settime(CLOCK_REALTIME, &ts) == 0;
+}
+
 } // namespace utils
 } // namespace time
 } // namespace phosphor
@@ -8,6 +8,7 @@
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
 
+#include <chrono>
 #include <fstream>
 
 namespace phosphor
@@ -153,6 +154,32 @@ std::string modeToStr(Mode mode);
  */
 std::string ownerToStr(Owner owner);
 
+/** @brief Convert a string to enum ClockRead
+ *
+ * @param[in] read - The string of clock read, "coarse" or "precise"
+ *
+ * @return ClockRead::Coarse if it is "coarse", otherwise ClockRead::Precise
+ */
+ClockRead strToClockRead(const std::string& read);
+
+/** @brief Read the time of day
+ *
+ * @param[in] read - The way to read the clock
+ *
+ * @return Microseconds since UTC
+ */
+std::chrono::microseconds now(ClockRead read);
+
+/** @brief Set CLOCK_REALTIME directly, without timedated
+ *  @details It is not rejected while NTP is enabled, as timedated's
+ *  SetTime is, and it does not set the RTC.
+ *
+ * @param[in] time - Microseconds since UTC
+ *
+ * @return true if the time is set
+ */
+bool setRealtime(const std::chrono::microseconds& time);
+
 } // namespace utils
 } // namespace time
 } // namespace phosphor
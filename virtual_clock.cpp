@@ -0,0 +1,87 @@
+#include "virtual_clock.hpp"
+
+#include "clock_factory.hpp"
+
+namespace phosphor
+{
+namespace time
+{
+
+using namespace sdbusplus::xyz::openbmc_project::Time;
+using namespace std::chrono;
+
+VirtualClock::VirtualClock(sdbusplus::bus::bus& bus,
+                           const char* objPath,
+                           ClockFactory& factory,
+                           OffsetArena::Slot slot)
+    : EpochBase(bus, objPath),
+      factory(factory),
+      slot(slot)
+{
+}
+
+uint64_t VirtualClock::elapsed() const
+{
+    auto ret = readTime();
+    if (timeOwner == Owner::Split)
+    {
+        ret += factory.getOffset(slot);
+    }
+    return ret.count();
+}
+
+uint64_t VirtualClock::elapsed(uint64_t value)
+{
+    // Stamp the request before anything else delays it
+    setElapsed(value, getReceivedTime(), nullptr);
+    return value;
+}
+
+void VirtualClock::setElapsed(uint64_t value, const microseconds& received,
+                              SetDone done)
+{
+    // A virtual clock follows the rules of the host time, raise NotAllowed
+    // if setting it is not allowed
+    auto action = getSetAction(Clock::Host);
+
+    auto time = microseconds(value);
+    bool ok = true;
+    if (action == SetAction::StoreOffset)
+    {
+        auto clockTime = latency ? latency->compensate(time, received) : time;
+        factory.setOffset(slot, clockTime - getTime());
+    }
+    else if (pipeline)
+    {
+        // Set time to BMC, the clock may be deleted before it is done
+        std::weak_ptr<bool> clock = alive;
+        pipeline->submit(time, received,
+                         [this, clock, done](bool isSet,
+                                             const microseconds& set)
+                         {
+                             if (isSet && !clock.expired())
+                             {
+                                 server::EpochTime::elapsed(set.count());
+                             }
+                             if (done)
+                             {
+                                 done(isSet);
+                             }
+                         });
+        return;
+    }
+    else
+    {
+        // Set time to BMC
+        ok = setRequestedTime(time, received);
+    }
+
+    server::EpochTime::elapsed(value);
+    if (done)
+    {
+        done(ok);
+    }
+}
+
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "epoch_base.hpp"
+#include "offset_arena.hpp"
+
+#include <memory>
+
+namespace phosphor
+{
+namespace time
+{
+
+class ClockFactory;
+
+/** @class VirtualClock
+ *  @brief OpenBMC virtual EpochTime implementation.
+ *  @details A concrete implementation for xyz.openbmc_project.Time.EpochTime
+ *  DBus API for a virtual clock. It follows the rules of the host time: in
+ *  SPLIT owner it keeps an offset to BMC time in the OffsetArena of its
+ *  factory, otherwise it is the BMC time.
+ */
+class VirtualClock : public EpochBase
+{
+    public:
+        VirtualClock(sdbusplus::bus::bus& bus,
+                     const char* objPath,
+                     ClockFactory& factory,
+                     OffsetArena::Slot slot);
+
+        /**
+         * @brief Get value of Elapsed property
+         *
+         * @return The elapsed microseconds since UTC
+         **/
+        uint64_t elapsed() const override;
+
+        /**
+         * @brief Set value of Elapsed property
+         *
+         * @param[in] value - The microseconds since UTC to set
+         *
+         * @return The updated elapsed microseconds since UTC
+         **/
+        uint64_t elapsed(uint64_t value) override;
+
+        /** @brief The slot of the offset in the arena */
+        OffsetArena::Slot getSlot() const
+        {
+            return slot;
+        }
+
+    protected:
+        /** @brief Apply an Elapsed set of the virtual clock */
+        void setElapsed(uint64_t value,
+                        const std::chrono::microseconds& received,
+                        SetDone done) override;
+
+    private:
+        /** @brief The factory that owns the clock */
+        ClockFactory& factory;
+
+        /** @brief The slot of the offset in the arena */
+        const OffsetArena::Slot slot;
+
+        /** @brief Expires with the clock, the pipeline callbacks of a
+         *  deleted clock do not touch it
+         */
+        std::shared_ptr<bool> alive = std::make_shared<bool>(true);
+};
+
+} // namespace time
+} // namespace phosphor
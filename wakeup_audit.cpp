@@ -0,0 +1,171 @@
+#include "wakeup_audit.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <signal.h>
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace phosphor
+{
+namespace time
+{
+namespace wakeup
+{
+
+namespace // anonymous
+{
+
+constexpr auto SOURCE_COUNT = static_cast<size_t>(Source::Count);
+
+constexpr const char* SOURCE_NAMES[SOURCE_COUNT] = {
+    "BMC time change",
+    "Settings changed",
+    "Host state changed",
+    "Service restarted",
+    "Client gone",
+    "Virtual clocks save",
+    "Query request",
+    "Replication",
+    "Alarm",
+    "Frequency check",
+    "Telemetry sample",
+    "Time floor save",
+    "Breaker probe",
+};
+
+std::array<Counter, SOURCE_COUNT> counters;
+uint64_t loopIterations = 0;
+
+using namespace phosphor::logging;
+
+void exportTo(const char* file)
+{
+    auto table = report();
+    std::ofstream fs(file, std::ios::out | std::ios::trunc);
+    if (fs.is_open())
+    {
+        fs << table;
+    }
+    log<level::INFO>("Wakeup counters",
+                     entry("FILE=%s", file),
+                     entry("COUNTERS=%s", table.c_str()));
+}
+
+int onExportSignal(sd_event_source* /* es */,
+                   const struct signalfd_siginfo* /* si */,
+                   void* userdata)
+{
+    exportTo(static_cast<const char*>(userdata));
+    return 0;
+}
+
+} // namespace anonymous
+
+void count(Source source, bool done)
+{
+    auto& counter = counters[static_cast<size_t>(source)];
+    ++counter.wakeups;
+    if (!done)
+    {
+        ++counter.idle;
+    }
+}
+
+void countIteration()
+{
+    ++loopIterations;
+}
+
+Counter get(Source source)
+{
+    return counters[static_cast<size_t>(source)];
+}
+
+uint64_t iterations()
+{
+    return loopIterations;
+}
+
+void reset()
+{
+    counters = {};
+    loopIterations = 0;
+}
+
+std::string report()
+{
+    std::string out;
+    char line[80];
+    snprintf(line, sizeof(line), "%-20s %12s %12s\n",
+             "Source", "Wakeups", "Idle");
+    out += line;
+
+    uint64_t counted = 0;
+    for (size_t i = 0; i < SOURCE_COUNT; ++i)
+    {
+        snprintf(line, sizeof(line), "%-20s %12llu %12llu\n",
+                 SOURCE_NAMES[i],
+                 static_cast<unsigned long long>(counters[i].wakeups),
+                 static_cast<unsigned long long>(counters[i].idle));
+        out += line;
+        counted += counters[i].wakeups;
+    }
+    if (loopIterations != 0)
+    {
+        // The matches run in the dispatch of the bus, so an iteration is
+        // counted by one source at most
+        auto other = loopIterations > counted ? loopIterations - counted : 0;
+        snprintf(line, sizeof(line), "%-20s %12llu %12s\n", "Other",
+                 static_cast<unsigned long long>(other), "-");
+        out += line;
+        snprintf(line, sizeof(line), "%-20s %12llu %12s\n", "Total",
+                 static_cast<unsigned long long>(loopIterations), "-");
+        out += line;
+    }
+    return out;
+}
+
+int run(sd_event* event, const char* file)
+{
+    sigset_t ss;
+    sigemptyset(&ss);
+    sigaddset(&ss, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &ss, nullptr);
+
+    sd_event_source* es = nullptr;
+    auto r = sd_event_add_signal(event, &es, SIGUSR1, onExportSignal,
+                                 const_cast<char*>(file));
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to add event",
+                        entry("ERRNO=%d", -r),
+                        entry("ERR=%s", strerror(-r)));
+    }
+
+    while (sd_event_get_state(event) != SD_EVENT_FINISHED)
+    {
+        r = sd_event_run(event, UINT64_MAX);
+        if (r < 0)
+        {
+            break;
+        }
+        countIteration();
+    }
+    int code = r;
+    if (r >= 0 && sd_event_get_exit_code(event, &code) < 0)
+    {
+        code = 0;
+    }
+
+    exportTo(file);
+    sd_event_source_unref(es);
+    return code;
+}
+
+} // namespace wakeup
+} // namespace time
+} // namespace phosphor
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <systemd/sd-event.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace phosphor
+{
+namespace time
+{
+namespace wakeup
+{
+
+/** @brief The sources that wake the daemon up */
+enum class Source : size_t
+{
+    BmcTimeChange,
+    SettingsChanged,
+    HostStateChanged,
+    ServiceRestarted,
+    ClientGone,
+    VirtualClocksSave,
+    QueryRequest,
+    Replication,
+    Alarm,
+    FrequencyCheck,
+    TelemetrySample,
+    TimeFloorSave,
+    BreakerProbe,
+    Count,
+};
+
+/** @struct Counter
+ *  @brief The wakeups of a source.
+ */
+struct Counter
+{
+    /** @brief The number of wakeups */
+    uint64_t wakeups = 0;
+
+    /** @brief The number of wakeups that did nothing, e.g. a signal
+     *  with the same value
+     */
+    uint64_t idle = 0;
+};
+
+/** @brief Count a wakeup by a source
+ *  @details It shall be called only from the main loop.
+ *
+ * @param[in] source - The source that wakes the daemon up
+ * @param[in] done - Indicate if the wakeup did anything, e.g. changed the
+ *                   time state or replied a query
+ */
+void count(Source source, bool done);
+
+/** @brief Count an iteration of the event loop */
+void countIteration();
+
+/** @brief Get the counter of a source
+ *
+ * @param[in] source - The source
+ *
+ * @return The counter of the source
+ */
+Counter get(Source source);
+
+/** @brief Get the number of counted event loop iterations */
+uint64_t iterations();
+
+/** @brief Clear all the counters */
+void reset();
+
+/** @brief Format the counters as a table
+ *  @details The iterations not counted by any source are reported as
+ *  "Other", e.g. DBus method calls, if the iterations are counted.
+ *
+ * @return The table, one source per line
+ */
+std::string report();
+
+/** @brief Run the event loop, counting its iterations
+ *  @details It is the same as sd_event_loop(), besides that the counters
+ *  are written to the file and logged on SIGUSR1 and on exit.
+ *
+ * @param[in] event - The event loop to run
+ * @param[in] file - The file to write the counters to
+ *
+ * @return The exit code of the event loop, or < 0 on failure
+ */
+int run(sd_event* event, const char* file);
+
+} // namespace wakeup
+} // namespace time
+} // namespace phosphor